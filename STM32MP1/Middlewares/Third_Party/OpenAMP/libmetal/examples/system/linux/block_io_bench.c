@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2017, Xilinx Inc. and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * block_io_bench.c
+ * This is a microbenchmark of metal_io_block_write() and metal_io_block_read()
+ * with the METAL_IO_BLOCK_* flags of the I/O region. It copies RPMsg sized
+ * buffers between a memory region and a local buffer, with the buffer aligned
+ * like the region and misaligned by 1 to 3 bytes, and prints the time per
+ * copy and the throughput of each mem_flags setting:
+ *   metal-block-io-bench-static [copies]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <metal/io.h>
+#include <metal/sys.h>
+
+/* Size of the shared memory of the firmware, 32 KB at 0x10040000 */
+#define BENCH_REGION_SIZE	(32 * 1024)
+#define BENCH_COPIES		200000
+
+static const int bench_lens[] = { 16, 64, 256, 496, 512 };
+
+static const struct {
+	const char *name;
+	unsigned int flags;
+} bench_flags[] = {
+	{ "default", 0 },
+	{ "acq_rel", METAL_IO_BLOCK_ACQ_REL },
+	{ "burst", METAL_IO_BLOCK_BURST },
+	{ "burst+acq_rel", METAL_IO_BLOCK_BURST | METAL_IO_BLOCK_ACQ_REL },
+};
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Copies len bytes copies times, walking through the region like the vring */
+static double bench(struct metal_io_region *io, int write, unsigned char *buf,
+		    int len, unsigned long copies)
+{
+	unsigned long long start;
+	unsigned long i, ofs = 0;
+	unsigned long stride = 512;
+
+	start = now_ns();
+	for (i = 0; i < copies; i++) {
+		if (write)
+			metal_io_block_write(io, ofs, buf, len);
+		else
+			metal_io_block_read(io, ofs, buf, len);
+		ofs += stride;
+		if (ofs + stride > io->size)
+			ofs = 0;
+	}
+	return (double)(now_ns() - start) / copies;
+}
+
+int main(int argc, char *argv[])
+{
+	struct metal_init_params init_param = METAL_INIT_DEFAULTS;
+	struct metal_io_region io;
+	unsigned long copies = BENCH_COPIES;
+	unsigned char *region, *buf;
+	unsigned int f, l, skew;
+	int write;
+	double ns;
+
+	if (argc > 1)
+		copies = strtoul(argv[1], NULL, 0);
+	if (!copies) {
+		fprintf(stderr, "usage: %s [copies]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (metal_init(&init_param)) {
+		fprintf(stderr, "Failed to initialize libmetal.\n");
+		return EXIT_FAILURE;
+	}
+	region = malloc(BENCH_REGION_SIZE);
+	buf = malloc(1024);
+	if (!region || !buf) {
+		fprintf(stderr, "Out of memory.\n");
+		return EXIT_FAILURE;
+	}
+	memset(region, 0x5a, BENCH_REGION_SIZE);
+	memset(buf, 0xa5, 1024);
+
+	printf("%lu copies per result, ns per copy (MB/s)\n", copies);
+	printf("%-6s %-14s %5s %18s %18s\n", "", "mem_flags", "bytes",
+	       "aligned", "misaligned");
+	for (write = 1; write >= 0; write--) {
+		for (f = 0; f < sizeof(bench_flags) / sizeof(bench_flags[0]);
+		     f++) {
+			metal_io_init(&io, region, NULL, BENCH_REGION_SIZE,
+				      -1U, bench_flags[f].flags, NULL);
+			for (l = 0; l < sizeof(bench_lens) /
+			     sizeof(bench_lens[0]); l++) {
+				printf("%-6s %-14s %5d", write ? "write" : "read",
+				       bench_flags[f].name, bench_lens[l]);
+				/* aligned, then the average of skew 1 to 3 */
+				ns = bench(&io, write, buf, bench_lens[l],
+					   copies);
+				printf(" %8.1f (%7.1f)", ns, bench_lens[l] / ns *
+				       1000.0);
+				ns = 0;
+				for (skew = 1; skew < 4; skew++)
+					ns += bench(&io, write, buf + skew,
+						    bench_lens[l], copies) / 3;
+				printf(" %8.1f (%7.1f)\n", ns, bench_lens[l] /
+				       ns * 1000.0);
+			}
+			metal_io_finish(&io);
+		}
+	}
+
+	free(buf);
+	free(region);
+	metal_finish();
+	return EXIT_SUCCESS;
+}
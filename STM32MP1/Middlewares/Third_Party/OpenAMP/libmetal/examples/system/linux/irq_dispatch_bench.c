@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2017, Xilinx Inc. and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * irq_dispatch_bench.c
+ * This is a benchmark of the Linux IRQ thread with many IRQs, each one an
+ * eventfd like the file descriptor of a UIO device. It registers and
+ * enables the IRQs, then measures the latency from raising one IRQ to its
+ * handler, and the time per IRQ when a burst of IRQs is raised at once.
+ * The handler thread runs on any CPU or pinned to the given one:
+ *   metal-irq-dispatch-bench-static [irqs [cpu]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <metal/irq.h>
+#include <metal/semaphore.h>
+#include <metal/sys.h>
+
+#define BENCH_IRQS		500
+#define BENCH_SINGLE_ROUNDS	5000
+#define BENCH_BURST_ROUNDS	200
+
+static const int bench_bursts[] = { 1, 8, 64, 0 /* all irqs */ };
+
+static struct metal_sem handled;
+
+static unsigned long long clock_ns(clockid_t clock)
+{
+	struct timespec ts;
+
+	clock_gettime(clock, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int irq_handler(int irq, void *priv)
+{
+	uint64_t val;
+
+	(void)priv;
+	if (read(irq, &val, sizeof(val)) != sizeof(val))
+		return METAL_IRQ_NOT_HANDLED;
+	metal_sem_post(&handled);
+	return METAL_IRQ_HANDLED;
+}
+
+static void raise_irq(int fd)
+{
+	uint64_t val = 1;
+
+	if (write(fd, &val, sizeof(val)) != sizeof(val))
+		perror("write");
+}
+
+/* Raises one irq after the other, spread over all of them */
+static void bench_single(const int *fds, int nirqs)
+{
+	unsigned long long start, cpu, lat, sum = 0, max = 0;
+	int i;
+
+	cpu = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+	for (i = 0; i < BENCH_SINGLE_ROUNDS; i++) {
+		start = clock_ns(CLOCK_MONOTONIC);
+		raise_irq(fds[(i * 7919) % nirqs]);
+		metal_sem_wait(&handled, METAL_SEM_WAIT_FOREVER);
+		lat = clock_ns(CLOCK_MONOTONIC) - start;
+		sum += lat;
+		if (lat > max)
+			max = lat;
+	}
+	cpu = clock_ns(CLOCK_PROCESS_CPUTIME_ID) - cpu;
+	printf("single: %d irqs, average %.1f us, max %.1f us, "
+	       "CPU %.1f us per irq\n", BENCH_SINGLE_ROUNDS,
+	       sum / 1000.0 / BENCH_SINGLE_ROUNDS, max / 1000.0,
+	       cpu / 1000.0 / BENCH_SINGLE_ROUNDS);
+}
+
+/* Raises burst irqs at once and waits until all of them are handled */
+static void bench_burst(const int *fds, int nirqs, int burst)
+{
+	unsigned long long start, cpu, wall;
+	int i, j;
+
+	start = clock_ns(CLOCK_MONOTONIC);
+	cpu = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+	for (i = 0; i < BENCH_BURST_ROUNDS; i++) {
+		for (j = 0; j < burst; j++)
+			raise_irq(fds[(i * burst + j) % nirqs]);
+		for (j = 0; j < burst; j++)
+			metal_sem_wait(&handled, METAL_SEM_WAIT_FOREVER);
+	}
+	wall = clock_ns(CLOCK_MONOTONIC) - start;
+	cpu = clock_ns(CLOCK_PROCESS_CPUTIME_ID) - cpu;
+	printf("burst %4d: %.2f us per irq, CPU %.2f us per irq\n", burst,
+	       wall / 1000.0 / BENCH_BURST_ROUNDS / burst,
+	       cpu / 1000.0 / BENCH_BURST_ROUNDS / burst);
+}
+
+int main(int argc, char *argv[])
+{
+	struct metal_init_params init_param = METAL_INIT_DEFAULTS;
+	int nirqs = BENCH_IRQS;
+	int cpu = -1;
+	unsigned int b;
+	int burst;
+	int *fds;
+	int i;
+
+	if (argc > 1)
+		nirqs = atoi(argv[1]);
+	if (argc > 2)
+		cpu = atoi(argv[2]);
+	if (nirqs <= 0) {
+		fprintf(stderr, "usage: %s [irqs [cpu]]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (metal_init(&init_param)) {
+		fprintf(stderr, "Failed to initialize libmetal.\n");
+		return EXIT_FAILURE;
+	}
+	if (cpu >= 0 && metal_linux_irq_set_affinity(cpu)) {
+		fprintf(stderr, "Failed to pin the IRQ thread to CPU %d.\n",
+			cpu);
+		return EXIT_FAILURE;
+	}
+	fds = calloc(nirqs, sizeof(*fds));
+	if (!fds) {
+		fprintf(stderr, "Out of memory.\n");
+		return EXIT_FAILURE;
+	}
+	metal_sem_init(&handled, 0);
+	for (i = 0; i < nirqs; i++) {
+		fds[i] = eventfd(0, EFD_NONBLOCK);
+		if (fds[i] < 0 || metal_irq_register(fds[i], irq_handler,
+						     NULL)) {
+			fprintf(stderr, "Failed to register irq %d.\n", i);
+			return EXIT_FAILURE;
+		}
+		metal_irq_enable(fds[i]);
+	}
+
+	printf("%d irqs enabled, IRQ thread %s\n", nirqs,
+	       cpu >= 0 ? "pinned" : "on any CPU");
+	bench_single(fds, nirqs);
+	for (b = 0; b < sizeof(bench_bursts) / sizeof(bench_bursts[0]); b++) {
+		burst = bench_bursts[b] ? bench_bursts[b] : nirqs;
+		if (burst <= nirqs)
+			bench_burst(fds, nirqs, burst);
+	}
+
+	for (i = 0; i < nirqs; i++) {
+		metal_irq_disable(fds[i]);
+		metal_irq_unregister(fds[i]);
+		close(fds[i]);
+	}
+	metal_sem_deinit(&handled);
+	free(fds);
+	metal_finish();
+	return EXIT_SUCCESS;
+}
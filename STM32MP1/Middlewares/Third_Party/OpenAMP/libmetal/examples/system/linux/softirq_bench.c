@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2019, Xilinx Inc. and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * softirq_bench.c
+ * This is a microbenchmark of metal_softirq_dispatch(). It allocates and
+ * enables the soft IRQs, then sets a pattern of them pending and dispatches,
+ * from none pending over sparse patterns to all of them, and prints the time
+ * per dispatch, including the metal_softirq_set() calls, and per handled
+ * soft IRQ:
+ *   metal-softirq-bench-static [softirqs [rounds]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <metal/irq.h>
+#include <metal/softirq.h>
+#include <metal/sys.h>
+
+#define BENCH_SOFTIRQS	64
+#define BENCH_ROUNDS	1000000
+
+/* Pending soft IRQs per dispatch, -1 for all of them */
+static const int bench_pending[] = { 0, 1, 2, 4, 16, -1 };
+
+static unsigned long handled;
+
+static unsigned long long now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int softirq_handler(int irq, void *priv)
+{
+	(void)irq;
+	(void)priv;
+
+	handled++;
+	return METAL_IRQ_HANDLED;
+}
+
+/* Sets pending soft IRQs spread over all of them and dispatches */
+static void bench(int base, int num, int pending, unsigned long rounds)
+{
+	unsigned long long start, ns;
+	unsigned long i;
+	int j;
+
+	handled = 0;
+	start = now_ns();
+	for (i = 0; i < rounds; i++) {
+		for (j = 0; j < pending; j++)
+			metal_softirq_set(base +
+					  (int)((i * 7 + j * num / pending) %
+						num));
+		metal_softirq_dispatch();
+	}
+	ns = now_ns() - start;
+	printf("%3d pending: %7.1f ns per dispatch", pending,
+	       (double)ns / rounds);
+	if (pending)
+		printf(", %6.1f ns per soft irq", (double)ns / handled);
+	printf("\n");
+	if (handled != rounds * pending)
+		printf("  %lu soft irqs handled, not %lu\n", handled,
+		       rounds * pending);
+}
+
+int main(int argc, char *argv[])
+{
+	struct metal_init_params init_param = METAL_INIT_DEFAULTS;
+	unsigned long rounds = BENCH_ROUNDS;
+	int num = BENCH_SOFTIRQS;
+	unsigned int p;
+	int base, i;
+
+	if (argc > 1)
+		num = atoi(argv[1]);
+	if (argc > 2)
+		rounds = strtoul(argv[2], NULL, 0);
+	if (num <= 0 || !rounds) {
+		fprintf(stderr, "usage: %s [softirqs [rounds]]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (metal_init(&init_param) || metal_softirq_init()) {
+		fprintf(stderr, "Failed to initialize libmetal.\n");
+		return EXIT_FAILURE;
+	}
+	base = metal_softirq_allocate(num);
+	if (base < 0) {
+		fprintf(stderr, "Failed to allocate %d soft irqs.\n", num);
+		return EXIT_FAILURE;
+	}
+	for (i = 0; i < num; i++) {
+		metal_irq_register(base + i, softirq_handler, NULL);
+		metal_irq_enable(base + i);
+	}
+
+	printf("%d soft irqs, %lu dispatches per result\n", num, rounds);
+	for (p = 0; p < sizeof(bench_pending) / sizeof(bench_pending[0]);
+	     p++) {
+		if (bench_pending[p] <= num)
+			bench(base, num, bench_pending[p] < 0 ? num :
+			      bench_pending[p], rounds);
+	}
+
+	metal_finish();
+	return EXIT_SUCCESS;
+}
@@ -34,7 +34,8 @@ int metal_softirq_init(void);
 /**
  * @brief	metal_softirq_dispatch
  *
- * Dispatch the pending soft IRQs
+ * Dispatch the pending soft IRQs which are enabled, the lowest soft IRQ
+ * first. The soft IRQs allocated first have the highest priority.
  */
 void metal_softirq_dispatch(void);
 
@@ -60,6 +61,16 @@ int metal_softirq_allocate(int num);
  */
 void metal_softirq_set(int irq);
 
+/**
+ * @brief	metal_softirq_get_count
+ *
+ * Get the number of times a soft IRQ was dispatched
+ *
+ * @param[in]  irq soft IRQ ID
+ * @return number of dispatches of the soft IRQ
+ */
+unsigned long metal_softirq_get_count(int irq);
+
 /** @} */
 
 #ifdef __cplusplus
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2016, Xilinx Inc. and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * @file	freertos/semaphore.h
+ * @brief	FreeRTOS semaphore primitives for libmetal.
+ */
+
+#ifndef __METAL_SEMAPHORE__H__
+#error "Include metal/semaphore.h instead of metal/freertos/semaphore.h"
+#endif
+
+#ifndef __METAL_FREERTOS_SEMAPHORE__H__
+#define __METAL_FREERTOS_SEMAPHORE__H__
+
+#include <metal/assert.h>
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct metal_sem {
+	SemaphoreHandle_t s;
+};
+
+static inline void metal_sem_init(struct metal_sem *sem, unsigned int count)
+{
+	metal_assert(sem);
+	sem->s = xSemaphoreCreateCounting((UBaseType_t)-1, count);
+	metal_assert(sem->s);
+}
+
+static inline void metal_sem_deinit(struct metal_sem *sem)
+{
+	metal_assert(sem && sem->s);
+	vSemaphoreDelete(sem->s);
+	sem->s = NULL;
+}
+
+static inline void metal_sem_post(struct metal_sem *sem)
+{
+	BaseType_t woken = pdFALSE;
+
+	metal_assert(sem && sem->s);
+	if (xPortIsInsideInterrupt()) {
+		xSemaphoreGiveFromISR(sem->s, &woken);
+		portYIELD_FROM_ISR(woken);
+	} else {
+		xSemaphoreGive(sem->s);
+	}
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __METAL_FREERTOS_SEMAPHORE__H__ */
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2016, Xilinx Inc. and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * @file	generic/semaphore.h
+ * @brief	Generic semaphore primitives for libmetal.
+ */
+
+#ifndef __METAL_SEMAPHORE__H__
+#error "Include metal/semaphore.h instead of metal/generic/semaphore.h"
+#endif
+
+#ifndef __METAL_GENERIC_SEMAPHORE__H__
+#define __METAL_GENERIC_SEMAPHORE__H__
+
+#include <metal/atomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct metal_sem {
+	atomic_int count; /**< semaphore count. */
+};
+
+static inline void metal_sem_init(struct metal_sem *sem, unsigned int count)
+{
+	atomic_init(&sem->count, (int)count);
+}
+
+static inline void metal_sem_deinit(struct metal_sem *sem)
+{
+	(void)sem;
+}
+
+static inline void metal_sem_post(struct metal_sem *sem)
+{
+	/* the waiter polls the count */
+	atomic_fetch_add(&sem->count, 1);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __METAL_GENERIC_SEMAPHORE__H__ */
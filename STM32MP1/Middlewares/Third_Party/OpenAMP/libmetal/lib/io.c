@@ -9,6 +9,113 @@
 #include <metal/io.h>
 #include <metal/sys.h>
 
+/* Word of the burst copy, may alias the bytes of the buffers */
+#ifdef __GNUC__
+typedef uint32_t __attribute__((__may_alias__)) metal_io_word_t;
+#else
+typedef uint32_t metal_io_word_t;
+#endif
+
+#define METAL_IO_WORD		((int)sizeof(metal_io_word_t))
+/* Words per burst, 4 loads then 4 stores become LDM/STM on Cortex-M */
+#define METAL_IO_BURST		4
+/* Shorter copies are not worth aligning */
+#define METAL_IO_BURST_MIN	(METAL_IO_BURST * METAL_IO_WORD)
+
+/*
+ * Merge the bytes left from the previous source word with the next one, for
+ * a source k bytes past word alignment: lshift is 8 * (4 - k), rshift 8 * k.
+ */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define METAL_IO_MERGE(_carry, _w, _lshift)	((_carry) | ((_w) >> (_lshift)))
+#define METAL_IO_CARRY(_w, _rshift)		((_w) << (_rshift))
+#define METAL_IO_BYTE(_b, _i)	((metal_io_word_t)(_b) << \
+				 (CHAR_BIT * (METAL_IO_WORD - 1 - (_i))))
+#else
+#define METAL_IO_MERGE(_carry, _w, _lshift)	((_carry) | ((_w) << (_lshift)))
+#define METAL_IO_CARRY(_w, _rshift)		((_w) >> (_rshift))
+#define METAL_IO_BYTE(_b, _i)	((metal_io_word_t)(_b) << (CHAR_BIT * (_i)))
+#endif
+
+/*
+ * Copy with aligned word stores. The destination is aligned with byte
+ * copies, then an aligned source is copied in bursts of words and a
+ * misaligned one with aligned word loads merged by shifts. No byte outside
+ * of the source or the destination is accessed.
+ */
+static void metal_io_copy_burst(unsigned char *dst, const unsigned char *src,
+				int len)
+{
+	const metal_io_word_t *s;
+	metal_io_word_t *d;
+	metal_io_word_t w0, w1, w2, w3, carry;
+	int skew, i;
+
+	if (len >= METAL_IO_BURST_MIN) {
+		for (; (uintptr_t)dst % METAL_IO_WORD; dst++, src++, len--)
+			*dst = *src;
+		d = (metal_io_word_t *)dst;
+		skew = (int)((uintptr_t)src % METAL_IO_WORD);
+		if (!skew) {
+			s = (const metal_io_word_t *)src;
+			for (; len >= METAL_IO_BURST_MIN;
+			     d += METAL_IO_BURST, s += METAL_IO_BURST,
+			     len -= METAL_IO_BURST_MIN) {
+				w0 = s[0];
+				w1 = s[1];
+				w2 = s[2];
+				w3 = s[3];
+				d[0] = w0;
+				d[1] = w1;
+				d[2] = w2;
+				d[3] = w3;
+			}
+			for (; len >= METAL_IO_WORD; d++, s++,
+			     len -= METAL_IO_WORD)
+				*d = *s;
+			src = (const unsigned char *)s;
+		} else {
+			/* Start with the bytes up to the next source word */
+			carry = 0;
+			for (i = 0; i < METAL_IO_WORD - skew; i++)
+				carry |= METAL_IO_BYTE(src[i], i);
+			s = (const metal_io_word_t *)(src + i);
+			/* The carried bytes and the whole next word are in */
+			for (; len >= 2 * METAL_IO_WORD - skew; d++, s++,
+			     len -= METAL_IO_WORD) {
+				w0 = *s;
+				*d = METAL_IO_MERGE(carry, w0,
+					CHAR_BIT * (METAL_IO_WORD - skew));
+				carry = METAL_IO_CARRY(w0, CHAR_BIT * skew);
+			}
+			/* Copy the carried bytes again with the tail */
+			src = (const unsigned char *)s -
+			      (METAL_IO_WORD - skew);
+		}
+		dst = (unsigned char *)d;
+	}
+	for (; len != 0; dst++, src++, len--)
+		*dst = *src;
+}
+
+/* Fence before a block read, as METAL_IO_BLOCK_ACQ_REL of the region asks */
+static inline void metal_io_block_acquire(struct metal_io_region *io)
+{
+	if (io->mem_flags & METAL_IO_BLOCK_ACQ_REL)
+		atomic_thread_fence(memory_order_acquire);
+	else
+		atomic_thread_fence(memory_order_seq_cst);
+}
+
+/* Fence after a block write, as METAL_IO_BLOCK_ACQ_REL of the region asks */
+static inline void metal_io_block_release(struct metal_io_region *io)
+{
+	if (io->mem_flags & METAL_IO_BLOCK_ACQ_REL)
+		atomic_thread_fence(memory_order_release);
+	else
+		atomic_thread_fence(memory_order_seq_cst);
+}
+
 void metal_io_init(struct metal_io_region *io, void *virt,
 	      const metal_phys_addr_t *physmap, size_t size,
 	      unsigned int page_shift, unsigned int mem_flags,
@@ -46,9 +153,14 @@ int metal_io_block_read(struct metal_io_region *io, unsigned long offset,
 	retlen = len;
 	if (io->ops.block_read) {
 		retlen = (*io->ops.block_read)(
-			io, offset, dst, memory_order_seq_cst, len);
+			io, offset, dst,
+			io->mem_flags & METAL_IO_BLOCK_ACQ_REL ?
+			memory_order_acquire : memory_order_seq_cst, len);
+	} else if (io->mem_flags & METAL_IO_BLOCK_BURST) {
+		metal_io_block_acquire(io);
+		metal_io_copy_burst(dest, ptr, len);
 	} else {
-		atomic_thread_fence(memory_order_seq_cst);
+		metal_io_block_acquire(io);
 		while ( len && (
 			((uintptr_t)dest % sizeof(int)) ||
 			((uintptr_t)ptr % sizeof(int)))) {
@@ -83,7 +195,12 @@ int metal_io_block_write(struct metal_io_region *io, unsigned long offset,
 	retlen = len;
 	if (io->ops.block_write) {
 		retlen = (*io->ops.block_write)(
-			io, offset, src, memory_order_seq_cst, len);
+			io, offset, src,
+			io->mem_flags & METAL_IO_BLOCK_ACQ_REL ?
+			memory_order_release : memory_order_seq_cst, len);
+	} else if (io->mem_flags & METAL_IO_BLOCK_BURST) {
+		metal_io_copy_burst(ptr, source, len);
+		metal_io_block_release(io);
 	} else {
 		while ( len && (
 			((uintptr_t)ptr % sizeof(int)) ||
@@ -101,7 +218,7 @@ int metal_io_block_write(struct metal_io_region *io, unsigned long offset,
 		for (; len != 0; ptr++, source++, len--)
 			*(unsigned char *)ptr =
 				*(const unsigned char *)source;
-		atomic_thread_fence(memory_order_seq_cst);
+		metal_io_block_release(io);
 	}
 	return retlen;
 }
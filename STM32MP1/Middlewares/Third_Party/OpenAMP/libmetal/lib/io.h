@@ -36,6 +36,25 @@ extern "C" {
 
 struct metal_io_region;
 
+/*
+ * Flags of the I/O region mem_flags for the default metal_io_block_read()
+ * and metal_io_block_write(), used when the region has no block ops. They are
+ * not passed on to metal_machine_io_mem_map().
+ */
+
+/** Copy in unrolled word bursts, with shift-merge for misaligned buffers. */
+#define METAL_IO_BLOCK_BURST	(1U << 30)
+
+/**
+ * Fence a block read with acquire before and a block write with release after
+ * the copy instead of seq_cst. Enough when the data is handed over through
+ * a flag or index read with acquire and written with release, as the vrings.
+ */
+#define METAL_IO_BLOCK_ACQ_REL	(1U << 31)
+
+/** All block copy flags. */
+#define METAL_IO_BLOCK_FLAGS	(METAL_IO_BLOCK_BURST | METAL_IO_BLOCK_ACQ_REL)
+
 /** Generic I/O operations. */
 struct metal_io_ops {
 	uint64_t	(*read)(struct metal_io_region *io,
@@ -79,7 +98,8 @@ struct metal_io_region {
 	unsigned long		page_shift; /**< page shift of I/O region */
 	metal_phys_addr_t	page_mask;  /**< page mask of I/O region */
 	unsigned int		mem_flags;  /**< memory attribute of the
-						 I/O region */
+						 I/O region and
+						 METAL_IO_BLOCK_* flags */
 	struct metal_io_ops	ops;        /**< I/O region operations */
 };
 
@@ -91,7 +111,7 @@ struct metal_io_region {
  * @param[in]		physmap		Array of physical addresses per page.
  * @param[in]		size		Size of region.
  * @param[in]		page_shift	Log2 of page size (-1 for single page).
- * @param[in]		mem_flags	Memory flags
+ * @param[in]		mem_flags	Memory flags and METAL_IO_BLOCK_* flags
  * @param[in]		ops			ops
  */
 void
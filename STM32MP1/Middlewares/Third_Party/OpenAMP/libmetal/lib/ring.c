@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2016, Xilinx Inc. and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <metal/atomic.h>
+#include <metal/errno.h>
+#include <metal/ring.h>
+#include <metal/utilities.h>
+
+/*
+ * Control lines of a ring, one per writer:
+ *   producer line: magic, size, head
+ *   consumer line: tail, wake
+ * head and tail count bytes and wrap at 2^32, the data of byte n is at
+ * n & (size - 1). A record is its length in 32 bits and its bytes, padded
+ * to 32 bits. The consumer sets wake to its tail before it waits, the
+ * producer rings the doorbell when its head passes wake.
+ */
+#define METAL_RING_MAGIC	0x4d52494eU	/* "MRIN" */
+#define METAL_RING_OFF_MAGIC	0
+#define METAL_RING_OFF_SIZE	4
+#define METAL_RING_OFF_HEAD	8
+#define METAL_RING_OFF_TAIL	METAL_RING_LINE
+#define METAL_RING_OFF_WAKE	(METAL_RING_LINE + 4)
+
+#define METAL_RING_ALIGN(len)	(((len) + 3U) & ~3U)
+
+static inline uint32_t metal_ring_ctrl_read(struct metal_ring *ring,
+					    unsigned long off,
+					    memory_order order)
+{
+	return metal_io_read32_explicit(ring->io, ring->ctrl + off, order);
+}
+
+static inline void metal_ring_ctrl_write(struct metal_ring *ring,
+					 unsigned long off, uint32_t val,
+					 memory_order order)
+{
+	metal_io_write32_explicit(ring->io, ring->ctrl + off, val, order);
+}
+
+/* Checks that a ring of size data bytes fits io at offset */
+static int metal_ring_setup(struct metal_ring *ring,
+			    struct metal_io_region *io,
+			    unsigned long offset, uint32_t size)
+{
+	if (!ring || !io || offset % METAL_RING_LINE || size < 16 ||
+	    size > 0x80000000U || size & (size - 1) ||
+	    offset > metal_io_region_size(io) ||
+	    metal_io_region_size(io) - offset < metal_ring_footprint(size))
+		return -EINVAL;
+
+	ring->io = io;
+	ring->ctrl = offset;
+	ring->data = offset + 2 * METAL_RING_LINE;
+	ring->size = size;
+	ring->head = 0;
+	ring->tail = 0;
+	ring->checked = 0;
+	ring->unchecked = 0;
+	ring->doorbells = 0;
+	metal_ring_set_doorbell(ring, NULL, NULL, 0, 1);
+	return 0;
+}
+
+int metal_ring_init(struct metal_ring *ring, struct metal_io_region *io,
+		    unsigned long offset, uint32_t size)
+{
+	int ret;
+
+	ret = metal_ring_setup(ring, io, offset, size);
+	if (ret)
+		return ret;
+
+	metal_ring_ctrl_write(ring, METAL_RING_OFF_HEAD, 0,
+			      memory_order_relaxed);
+	metal_ring_ctrl_write(ring, METAL_RING_OFF_TAIL, 0,
+			      memory_order_relaxed);
+	metal_ring_ctrl_write(ring, METAL_RING_OFF_WAKE, 0,
+			      memory_order_relaxed);
+	metal_ring_ctrl_write(ring, METAL_RING_OFF_SIZE, size,
+			      memory_order_relaxed);
+	metal_ring_ctrl_write(ring, METAL_RING_OFF_MAGIC, METAL_RING_MAGIC,
+			      memory_order_release);
+	return 0;
+}
+
+int metal_ring_attach(struct metal_ring *ring, struct metal_io_region *io,
+		      unsigned long offset)
+{
+	uint32_t size;
+	int ret;
+
+	if (!ring || !io || offset % METAL_RING_LINE ||
+	    offset > metal_io_region_size(io) ||
+	    metal_io_region_size(io) - offset < 2 * METAL_RING_LINE)
+		return -EINVAL;
+	if (metal_io_read32_explicit(io, offset + METAL_RING_OFF_MAGIC,
+				     memory_order_acquire) != METAL_RING_MAGIC)
+		return -EAGAIN;
+	size = metal_io_read32_explicit(io, offset + METAL_RING_OFF_SIZE,
+					memory_order_relaxed);
+	ret = metal_ring_setup(ring, io, offset, size);
+	if (ret)
+		return ret;
+
+	ring->head = metal_ring_ctrl_read(ring, METAL_RING_OFF_HEAD,
+					  memory_order_acquire);
+	ring->tail = metal_ring_ctrl_read(ring, METAL_RING_OFF_TAIL,
+					  memory_order_acquire);
+	ring->checked = ring->head;
+	return 0;
+}
+
+void metal_ring_set_doorbell(struct metal_ring *ring,
+			     int (*notify)(void *priv, uint32_t id),
+			     void *priv, uint32_t id, uint32_t batch)
+{
+	ring->notify = notify;
+	ring->priv = priv;
+	ring->notify_id = id;
+	ring->batch = batch ? batch : 1;
+}
+
+/* Producer: free bytes, reading the tail only if the cached one is short */
+static uint32_t metal_ring_free(struct metal_ring *ring, uint32_t len)
+{
+	if (ring->size - (ring->head - ring->tail) < len)
+		ring->tail = metal_ring_ctrl_read(ring, METAL_RING_OFF_TAIL,
+						  memory_order_acquire);
+	return ring->size - (ring->head - ring->tail);
+}
+
+/* Consumer: used bytes, reading the head only if the cached one is short */
+static uint32_t metal_ring_used(struct metal_ring *ring, uint32_t len)
+{
+	if (ring->head - ring->tail < len)
+		ring->head = metal_ring_ctrl_read(ring, METAL_RING_OFF_HEAD,
+						  memory_order_acquire);
+	return ring->head - ring->tail;
+}
+
+static void metal_ring_copy_in(struct metal_ring *ring, uint32_t pos,
+			       const void *src, uint32_t len)
+{
+	uint32_t ofs = pos & (ring->size - 1);
+	uint32_t first = metal_min(len, ring->size - ofs);
+
+	if (first)
+		metal_io_block_write(ring->io, ring->data + ofs, src, first);
+	if (len > first)
+		metal_io_block_write(ring->io, ring->data,
+				     (const char *)src + first, len - first);
+}
+
+static void metal_ring_copy_out(struct metal_ring *ring, uint32_t pos,
+				void *dst, uint32_t len)
+{
+	uint32_t ofs = pos & (ring->size - 1);
+	uint32_t first = metal_min(len, ring->size - ofs);
+
+	if (first)
+		metal_io_block_read(ring->io, ring->data + ofs, dst, first);
+	if (len > first)
+		metal_io_block_read(ring->io, ring->data, (char *)dst + first,
+				    len - first);
+}
+
+/* Producer: publishes the head and checks the doorbell every batch */
+static void metal_ring_publish(struct metal_ring *ring)
+{
+	metal_ring_ctrl_write(ring, METAL_RING_OFF_HEAD, ring->head,
+			      memory_order_release);
+	if (++ring->unchecked >= ring->batch)
+		metal_ring_flush(ring);
+}
+
+int metal_ring_send(struct metal_ring *ring, const void *data, uint32_t len)
+{
+	uint32_t total = METAL_RING_ALIGN(len) + 4;
+
+	if (len > ring->size - 4)
+		return -EINVAL;
+	if (metal_ring_free(ring, total) < total)
+		return -ENOSPC;
+
+	metal_io_write32_explicit(ring->io, ring->data +
+				  (ring->head & (ring->size - 1)), len,
+				  memory_order_relaxed);
+	metal_ring_copy_in(ring, ring->head + 4, data, len);
+	ring->head += total;
+	metal_ring_publish(ring);
+	return 0;
+}
+
+int metal_ring_recv(struct metal_ring *ring, void *data, uint32_t len)
+{
+	uint32_t rlen;
+
+	if (metal_ring_used(ring, 4) < 4)
+		return -EAGAIN;
+
+	rlen = metal_io_read32_explicit(ring->io, ring->data +
+					(ring->tail & (ring->size - 1)),
+					memory_order_relaxed);
+	/* The length comes from the peer, the record must be in the ring */
+	if (rlen > ring->size - 4 ||
+	    metal_ring_used(ring, METAL_RING_ALIGN(rlen) + 4) <
+	    METAL_RING_ALIGN(rlen) + 4)
+		return -EPROTO;
+	if (rlen > len)
+		return -EMSGSIZE;
+	metal_ring_copy_out(ring, ring->tail + 4, data, rlen);
+	ring->tail += METAL_RING_ALIGN(rlen) + 4;
+	metal_ring_ctrl_write(ring, METAL_RING_OFF_TAIL, ring->tail,
+			      memory_order_release);
+	return (int)rlen;
+}
+
+int metal_ring_write(struct metal_ring *ring, const void *data, uint32_t len)
+{
+	len = metal_min(len, metal_ring_free(ring, len));
+	if (!len)
+		return 0;
+
+	metal_ring_copy_in(ring, ring->head, data, len);
+	ring->head += len;
+	metal_ring_publish(ring);
+	return (int)len;
+}
+
+int metal_ring_read(struct metal_ring *ring, void *data, uint32_t len)
+{
+	len = metal_min(len, metal_ring_used(ring, len));
+	if (!len)
+		return 0;
+
+	metal_ring_copy_out(ring, ring->tail, data, len);
+	ring->tail += len;
+	metal_ring_ctrl_write(ring, METAL_RING_OFF_TAIL, ring->tail,
+			      memory_order_release);
+	return (int)len;
+}
+
+int metal_ring_flush(struct metal_ring *ring)
+{
+	uint32_t wake, old = ring->checked;
+
+	ring->unchecked = 0;
+	if (ring->head == old)
+		return 0;
+	ring->checked = ring->head;
+
+	/* Pairs with the fence of metal_ring_arm(): either side sees the other */
+	atomic_thread_fence(memory_order_seq_cst);
+	wake = metal_ring_ctrl_read(ring, METAL_RING_OFF_WAKE,
+				    memory_order_relaxed);
+	/*
+	 * The consumer waits for the byte at its wake point, wake it if that
+	 * byte is in [old, head), i.e. was published since the last check
+	 */
+	if ((uint32_t)(ring->head - wake - 1) >= (uint32_t)(ring->head - old))
+		return 0;
+	ring->doorbells++;
+	if (ring->notify)
+		ring->notify(ring->priv, ring->notify_id);
+	return 1;
+}
+
+uint32_t metal_ring_arm(struct metal_ring *ring)
+{
+	metal_ring_ctrl_write(ring, METAL_RING_OFF_WAKE, ring->tail,
+			      memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	ring->head = metal_ring_ctrl_read(ring, METAL_RING_OFF_HEAD,
+					  memory_order_acquire);
+	return ring->head - ring->tail;
+}
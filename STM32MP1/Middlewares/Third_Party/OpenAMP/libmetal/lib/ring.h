@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2016, Xilinx Inc. and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * @file	ring.h
+ * @brief	Single producer single consumer ring in shared memory.
+ */
+
+#ifndef __METAL_RING__H__
+#define __METAL_RING__H__
+
+#include <stdint.h>
+#include <metal/io.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \defgroup ring Shared Memory Ring Interfaces
+ *  @{
+ */
+
+/**
+ * Bytes of a control line. The producer and the consumer each write their
+ * own line only, so neither invalidates the cache line of the other.
+ */
+#define METAL_RING_LINE		64
+
+/** Bytes of shared memory used by a ring of size data bytes. */
+#define metal_ring_footprint(size)	(2 * METAL_RING_LINE + (size))
+
+/**
+ * Ring of one producer and one consumer in a shared I/O region, on two
+ * processors or two threads. It carries either a byte stream
+ * (metal_ring_write(), metal_ring_read()) or records (metal_ring_send(),
+ * metal_ring_recv()), not both. Each side keeps its own struct metal_ring.
+ *
+ * The producer rings a doorbell, e.g. a mailbox notification, when the
+ * consumer armed it with metal_ring_arm() before waiting. The doorbell is
+ * checked every batch records and by metal_ring_flush(), so a busy consumer
+ * costs no notification and an idle one one per batch.
+ */
+struct metal_ring {
+	/** I/O region of the ring. */
+	struct metal_io_region *io;
+	/** Offset of the control lines in the region. */
+	unsigned long ctrl;
+	/** Offset of the data in the region. */
+	unsigned long data;
+	/** Data bytes, a power of 2. */
+	uint32_t size;
+	/** Producer: next byte to write. Consumer: last head seen. */
+	uint32_t head;
+	/** Consumer: next byte to read. Producer: last tail seen. */
+	uint32_t tail;
+	/** Producer: head of the last doorbell check. */
+	uint32_t checked;
+	/** Producer: records between doorbell checks. */
+	uint32_t batch;
+	/** Producer: records since the last doorbell check. */
+	uint32_t unchecked;
+	/** Producer: doorbell, e.g. the mailbox notify of OpenAMP. */
+	int (*notify)(void *priv, uint32_t id);
+	/** Producer: first argument of notify. */
+	void *priv;
+	/** Producer: second argument of notify. */
+	uint32_t notify_id;
+	/** Producer: doorbells rung. */
+	unsigned long doorbells;
+};
+
+/**
+ * @brief	Reset a ring in shared memory, done by one side only.
+ * @param[in]	ring	ring to initialize.
+ * @param[in]	io	I/O region of the ring.
+ * @param[in]	offset	offset of the ring in io, a multiple of
+ *			METAL_RING_LINE.
+ * @param[in]	size	data bytes, a power of 2 of at least 16.
+ * @return	0 on success, or -EINVAL if the ring does not fit io.
+ */
+int metal_ring_init(struct metal_ring *ring, struct metal_io_region *io,
+		    unsigned long offset, uint32_t size);
+
+/**
+ * @brief	Attach to a ring reset by the other side.
+ * @param[in]	ring	ring to initialize.
+ * @param[in]	io	I/O region of the ring.
+ * @param[in]	offset	offset of the ring in io.
+ * @return	0 on success, -EAGAIN if the ring is not reset yet, or
+ *		-EINVAL if it does not fit io.
+ */
+int metal_ring_attach(struct metal_ring *ring, struct metal_io_region *io,
+		      unsigned long offset);
+
+/**
+ * @brief	Set the doorbell of the producer, after metal_ring_init() or
+ *		metal_ring_attach().
+ * @param[in]	ring	ring.
+ * @param[in]	notify	doorbell, NULL for none.
+ * @param[in]	priv	first argument of notify.
+ * @param[in]	id	second argument of notify.
+ * @param[in]	batch	records between doorbell checks, at least 1.
+ */
+void metal_ring_set_doorbell(struct metal_ring *ring,
+			     int (*notify)(void *priv, uint32_t id),
+			     void *priv, uint32_t id, uint32_t batch);
+
+/**
+ * @brief	Producer: send a record.
+ * @param[in]	ring	ring.
+ * @param[in]	data	record.
+ * @param[in]	len	bytes of the record.
+ * @return	0 on success, -ENOSPC if the ring is too full, or -EINVAL if
+ *		the record never fits.
+ */
+int metal_ring_send(struct metal_ring *ring, const void *data, uint32_t len);
+
+/**
+ * @brief	Consumer: receive a record.
+ * @param[in]	ring	ring.
+ * @param[out]	data	buffer of the record.
+ * @param[in]	len	bytes of the buffer.
+ * @return	bytes of the record, -EAGAIN if the ring is empty,
+ *		-EMSGSIZE if the record does not fit the buffer, which
+ *		leaves it in the ring, or -EPROTO if the length word of the
+ *		record runs past the published data.
+ */
+int metal_ring_recv(struct metal_ring *ring, void *data, uint32_t len);
+
+/**
+ * @brief	Producer: write bytes of a stream.
+ * @param[in]	ring	ring.
+ * @param[in]	data	bytes.
+ * @param[in]	len	number of bytes.
+ * @return	bytes written, less than len if the ring is full.
+ */
+int metal_ring_write(struct metal_ring *ring, const void *data, uint32_t len);
+
+/**
+ * @brief	Consumer: read bytes of a stream.
+ * @param[in]	ring	ring.
+ * @param[out]	data	buffer.
+ * @param[in]	len	bytes of the buffer.
+ * @return	bytes read, 0 if the ring is empty.
+ */
+int metal_ring_read(struct metal_ring *ring, void *data, uint32_t len);
+
+/**
+ * @brief	Producer: ring the doorbell for the data written since the
+ *		last check if the consumer waits for it, i.e. its wake point
+ *		is among these bytes. Call it at the end of a burst.
+ * @param[in]	ring	ring.
+ * @return	1 if the doorbell was rung, otherwise 0.
+ */
+int metal_ring_flush(struct metal_ring *ring);
+
+/**
+ * @brief	Consumer: ask for the doorbell before waiting for data.
+ *
+ * The consumer waits only if this returns 0, data written before the call
+ * is not signaled.
+ *
+ * @param[in]	ring	ring.
+ * @return	bytes available to read.
+ */
+uint32_t metal_ring_arm(struct metal_ring *ring);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __METAL_RING__H__ */
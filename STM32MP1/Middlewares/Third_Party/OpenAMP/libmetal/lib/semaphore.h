@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2016, Xilinx Inc. and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * @file	semaphore.h
+ * @brief	Counting semaphore for libmetal.
+ */
+
+#ifndef __METAL_SEMAPHORE__H__
+#define __METAL_SEMAPHORE__H__
+
+#include <metal/utilities.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \defgroup semaphore Semaphore Interfaces
+ *  @{
+ */
+
+/** Timeout of metal_sem_wait() which never expires. */
+#define METAL_SEM_WAIT_FOREVER	((unsigned int)-1)
+
+/** Opaque libmetal semaphore data structure. */
+struct metal_sem;
+
+/**
+ * @brief	Initialize a libmetal semaphore.
+ * @param[in]	sem	semaphore to initialize.
+ * @param[in]	count	initial count.
+ */
+static inline void metal_sem_init(struct metal_sem *sem, unsigned int count);
+
+/**
+ * @brief	Release the resources of a libmetal semaphore.
+ * @param[in]	sem	semaphore to deinitialize.
+ */
+static inline void metal_sem_deinit(struct metal_sem *sem);
+
+/**
+ * @brief	Increment the count and wake up one waiter.
+ *		Unlike metal_condition_signal() it needs no mutex and
+ *		may be called from an interrupt handler.
+ * @param[in]	sem	semaphore
+ * @see metal_sem_wait
+ */
+static inline void metal_sem_post(struct metal_sem *sem);
+
+/**
+ * @brief	Block until the count is non-zero and decrement it.
+ * @param[in]	sem		semaphore
+ * @param[in]	timeout_usec	longest time to block, 0 only polls,
+ *				METAL_SEM_WAIT_FOREVER does not time out.
+ * @return	0 on success, -ETIMEDOUT if the timeout expired first.
+ * @see metal_sem_post
+ */
+int metal_sem_wait(struct metal_sem *sem, unsigned int timeout_usec);
+
+#include <metal/system/@PROJECT_SYSTEM@/semaphore.h>
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __METAL_SEMAPHORE__H__ */
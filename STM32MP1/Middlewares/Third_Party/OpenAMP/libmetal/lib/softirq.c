@@ -16,15 +16,38 @@
 
 #define METAL_SOFTIRQ_NUM 64
 
+/*
+ * Soft IRQ n is bit METAL_BITS_PER_ULONG - 1 - n % METAL_BITS_PER_ULONG of
+ * word n / METAL_BITS_PER_ULONG, the leading zeros of a word are the number
+ * of its lowest soft IRQ.
+ */
+#define METAL_SOFTIRQ_BIT(n) \
+	(1UL << (METAL_BITS_PER_ULONG - 1 - (n) % METAL_BITS_PER_ULONG))
+
 #define METAL_SOFTIRQ_ARRAY_DECLARE(num) \
 	static const int metal_softirq_num = num; \
 	static struct metal_irq metal_softirqs[num]; \
-	static atomic_char metal_softirq_pending[num]; \
-	static atomic_char metal_softirq_enabled[num];
+	static unsigned long metal_softirq_count[num]; \
+	static atomic_ulong metal_softirq_pending[metal_bitmap_longs(num)]; \
+	static atomic_ulong metal_softirq_enabled[metal_bitmap_longs(num)];
 
 static int metal_softirq_avail;
 METAL_SOFTIRQ_ARRAY_DECLARE(METAL_SOFTIRQ_NUM)
 
+/* Lowest soft IRQ of a non-zero word, a CLZ instruction on Cortex-M */
+static inline int metal_softirq_first(unsigned long bits)
+{
+#if defined(__GNUC__)
+	return __builtin_clzl(bits);
+#else
+	int n = 0;
+
+	while (!(bits & METAL_SOFTIRQ_BIT(n)))
+		n++;
+	return n;
+#endif
+}
+
 static void metal_softirq_set_enable(struct metal_irq_controller *cntr,
 				     int irq, unsigned int enable)
 {
@@ -35,9 +58,13 @@ static void metal_softirq_set_enable(struct metal_irq_controller *cntr,
 
 	irq -= cntr->irq_base;
 	if (enable ==  METAL_IRQ_ENABLE) {
-		atomic_store(&metal_softirq_enabled[irq], 1);
+		atomic_fetch_or(&metal_softirq_enabled[irq /
+					METAL_BITS_PER_ULONG],
+				METAL_SOFTIRQ_BIT(irq));
 	} else {
-		atomic_store(&metal_softirq_enabled[irq], 0);
+		atomic_fetch_and(&metal_softirq_enabled[irq /
+					 METAL_BITS_PER_ULONG],
+				 ~METAL_SOFTIRQ_BIT(irq));
 	}
 }
 
@@ -59,7 +86,8 @@ void metal_softirq_set(int irq)
 	}
 
 	irq -= cntr->irq_base;
-	atomic_store(&metal_softirq_pending[irq], 1);
+	atomic_fetch_or(&metal_softirq_pending[irq / METAL_BITS_PER_ULONG],
+			METAL_SOFTIRQ_BIT(irq));
 }
 
 int metal_softirq_init(void)
@@ -71,7 +99,7 @@ int metal_softirq_allocate(int num)
 {
 	int irq_base;
 
-	if ((metal_softirq_avail + num) >= metal_softirq_num) {
+	if ((metal_softirq_avail + num) > metal_softirq_num) {
 		metal_log(METAL_LOG_ERROR, "No %d available soft irqs.\r\n",
 			  num);
 		return -EINVAL;
@@ -84,18 +112,46 @@ int metal_softirq_allocate(int num)
 
 void metal_softirq_dispatch(void)
 {
-	int i;
-
-	for (i = 0; i < metal_softirq_num; i++) {
-		struct metal_irq *irq;
-		char is_pending = 1;
-
-		if (atomic_load(&metal_softirq_enabled[i]) != 0 &&
-		    atomic_compare_exchange_strong(&metal_softirq_pending[i],
-						   &is_pending, 0)) {
-			irq = &metal_softirqs[i];
-			(void)metal_irq_handle(irq,
+	unsigned long ready, bit;
+	int word, i;
+
+	/* Lowest soft IRQ first, the ones allocated first have priority */
+	for (word = 0; word < (int)metal_bitmap_longs(METAL_SOFTIRQ_NUM);
+	     word++) {
+		if (atomic_load(&metal_softirq_pending[word]) == 0)
+			continue;
+		/* Takes the enabled ones, a disabled soft IRQ stays pending */
+		ready = atomic_load(&metal_softirq_enabled[word]);
+		ready &= atomic_fetch_and(&metal_softirq_pending[word],
+					  ~ready);
+		while (ready != 0) {
+			i = metal_softirq_first(ready);
+			bit = METAL_SOFTIRQ_BIT(i);
+			ready &= ~bit;
+			/* Disabled by a handler of this dispatch */
+			if ((atomic_load(&metal_softirq_enabled[word]) &
+			     bit) == 0) {
+				atomic_fetch_or(&metal_softirq_pending[word],
+						bit);
+				continue;
+			}
+			i += word * METAL_BITS_PER_ULONG;
+			metal_softirq_count[i]++;
+			(void)metal_irq_handle(&metal_softirqs[i],
 					       i + metal_softirq_cntr.irq_base);
 		}
 	}
 }
+
+unsigned long metal_softirq_get_count(int irq)
+{
+	struct metal_irq_controller *cntr;
+
+	cntr = &metal_softirq_cntr;
+
+	if (irq < cntr->irq_base ||
+	    irq >= (cntr->irq_base + cntr->irq_num)) {
+		return 0;
+	}
+	return metal_softirq_count[irq - cntr->irq_base];
+}
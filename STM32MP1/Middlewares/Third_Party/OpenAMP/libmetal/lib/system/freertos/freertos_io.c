@@ -23,8 +23,9 @@ void metal_sys_io_mem_map(struct metal_io_region *io)
 		if (psize >> io->page_shift)
 			psize = (size_t)1 << io->page_shift;
 		for (p = 0; p <= (io->size >> io->page_shift); p++) {
-			metal_machine_io_mem_map(va, io->physmap[p],
-						 psize, io->mem_flags);
+			metal_machine_io_mem_map(va, io->physmap[p], psize,
+						 io->mem_flags &
+						 ~METAL_IO_BLOCK_FLAGS);
 			va += psize;
 		}
 	}
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2016, Xilinx Inc. and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * @file	freertos/semaphore.c
+ * @brief	FreeRTOS libmetal semaphore handling.
+ */
+
+#include <metal/errno.h>
+#include <metal/semaphore.h>
+
+int metal_sem_wait(struct metal_sem *sem, unsigned int timeout_usec)
+{
+	TickType_t ticks;
+
+	metal_assert(sem && sem->s);
+	if (timeout_usec == METAL_SEM_WAIT_FOREVER) {
+		ticks = portMAX_DELAY;
+	} else {
+		/* round up, a timeout below one tick still blocks */
+		ticks = (TickType_t)(((unsigned long long)timeout_usec *
+				      configTICK_RATE_HZ + 999999) / 1000000);
+	}
+	return xSemaphoreTake(sem->s, ticks) == pdTRUE ? 0 : -ETIMEDOUT;
+}
@@ -39,11 +39,17 @@
 
 void sys_irq_restore_enable(unsigned int flags)
 {
+	__asm__ volatile("msr primask, %0" : : "r"(flags) : "memory");
 }
 
 unsigned int sys_irq_save_disable(void)
 {
-  return 0;
+	unsigned int flags;
+
+	/* PRIMASK, a pending interrupt still ends a wfi */
+	__asm__ volatile("mrs %0, primask\n\tcpsid i" : "=r"(flags) : :
+			 "memory");
+	return flags;
 }
 
 void metal_machine_cache_flush(void *addr, unsigned int len)
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2016, Xilinx Inc. and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * @file	generic/semaphore.c
+ * @brief	Generic libmetal semaphore handling.
+ */
+
+#include <metal/errno.h>
+#include <metal/irq.h>
+#include <metal/semaphore.h>
+#include <metal/time.h>
+
+/*
+ * Period of metal_get_timestamp() in ns, e.g. 1000000 for a millisecond
+ * tick. The clock may tick right after the start of the wait, so the
+ * timeout is rounded up to whole periods plus one.
+ */
+#ifndef METAL_TIMESTAMP_RESOLUTION_NS
+#define METAL_TIMESTAMP_RESOLUTION_NS	1
+#endif
+
+extern void metal_generic_default_poll(void);
+
+int metal_sem_wait(struct metal_sem *sem, unsigned int timeout_usec)
+{
+	unsigned long long start = 0, timeout = 0;
+	unsigned int flags;
+	int count;
+
+	if (timeout_usec && timeout_usec != METAL_SEM_WAIT_FOREVER) {
+		start = metal_get_timestamp();
+		timeout = ((unsigned long long)timeout_usec * 1000 +
+			   METAL_TIMESTAMP_RESOLUTION_NS - 1) /
+			  METAL_TIMESTAMP_RESOLUTION_NS + 1;
+		timeout *= METAL_TIMESTAMP_RESOLUTION_NS;
+	}
+
+	while (1) {
+		count = atomic_load(&sem->count);
+		while (count > 0) {
+			if (atomic_compare_exchange_weak(&sem->count, &count,
+							 count - 1))
+				return 0;
+		}
+
+		/*
+		 * The timeout is measured with metal_get_timestamp() in ns,
+		 * the platform has to provide it, the default never expires.
+		 */
+		if (timeout_usec != METAL_SEM_WAIT_FOREVER &&
+		    metal_get_timestamp() - start >= timeout)
+			return -ETIMEDOUT;
+
+		flags = metal_irq_save_disable();
+		if (!atomic_load(&sem->count))
+			metal_generic_default_poll();
+		metal_irq_restore_enable(flags);
+	}
+}
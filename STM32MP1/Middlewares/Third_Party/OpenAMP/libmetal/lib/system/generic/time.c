@@ -9,9 +9,11 @@
  * @brief	Generic libmetal time handling.
  */
 
+#include <metal/compiler.h>
 #include <metal/time.h>
 
-unsigned long long metal_get_timestamp(void)
+/* Weak, the platform provides a clock for the metal_sem_wait() timeout */
+unsigned long long metal_weak metal_get_timestamp(void)
 {
 	/* TODO: Implement timestamp for generic system */
 	return 0;
@@ -9,6 +9,9 @@
  * @brief	Linux libmetal irq operations
  */
 
+/* pthread_setaffinity_np() */
+#define _GNU_SOURCE
+
 #include <pthread.h>
 #include <sched.h>
 #include <metal/device.h>
@@ -20,22 +23,26 @@
 #include <metal/utilities.h>
 #include <metal/alloc.h>
 #include <sys/time.h>
+#include <sys/epoll.h>
 #include <sys/eventfd.h>
 #include <sched.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
-#include <poll.h>
 #include <unistd.h>
 
 #define MAX_IRQS	(FD_SETSIZE - 1)  /**< maximum number of irqs */
+#define MAX_EVENTS	64  /**< ready irqs handled per wake-up */
 
 static struct metal_device *irqs_devs[MAX_IRQS]; /**< Linux devices for IRQs */
-static int irq_notify_fd; /**< irq handling state change notification file
+static int irq_notify_fd; /**< irq handling stop notification file
 			    *   descriptor
 			    */
+static int irq_epoll_fd; /**< interest set of the enabled irqs */
 static metal_mutex_t irq_lock; /**< irq handling lock */
 
+static bool irq_edge_triggered = true; /**< wait for edges of the irqs */
+
 static bool irq_handling_stop; /**< stop interrupts handling */
 
 static pthread_t irq_pthread; /**< irq handling thread id */
@@ -85,10 +92,23 @@ static int metal_linux_irq_notify(void)
 	return ret;
 }
 
+/* Adds, modifies or removes an irq of the interest set */
+static int metal_linux_irq_watch(int op, int fd)
+{
+	struct epoll_event ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	if (fd != irq_notify_fd && irq_edge_triggered)
+		ev.events |= EPOLLET;
+	ev.data.fd = fd;
+	return epoll_ctl(irq_epoll_fd, op, fd, &ev);
+}
+
 static void metal_linux_irq_set_enable(struct metal_irq_controller *irq_cntr,
 				       int irq, unsigned int state)
 {
-	int offset, ret;
+	int offset, ret = 0;
 
 	if (irq < irq_cntr->irq_base ||
 	    irq >= irq_cntr->irq_base + irq_cntr->irq_num) {
@@ -98,17 +118,23 @@ static void metal_linux_irq_set_enable(struct metal_irq_controller *irq_cntr,
 	}
 	offset = irq - linux_irq_cntr.irq_base;
 	metal_mutex_acquire(&irq_lock);
-	if (state == METAL_IRQ_ENABLE)
-		metal_bitmap_set_bit(irqs_enabled, offset);
-	else
+	/* The interest set only changes with the state of an irq, the IRQ
+	 * thread picks the change up in its current wait */
+	if (state == METAL_IRQ_ENABLE &&
+	    metal_bitmap_is_bit_clear(irqs_enabled, offset)) {
+		ret = metal_linux_irq_watch(EPOLL_CTL_ADD, irq);
+		if (!ret)
+			metal_bitmap_set_bit(irqs_enabled, offset);
+	} else if (state != METAL_IRQ_ENABLE &&
+		   metal_bitmap_is_bit_set(irqs_enabled, offset)) {
 		metal_bitmap_clear_bit(irqs_enabled, offset);
+		ret = metal_linux_irq_watch(EPOLL_CTL_DEL, irq);
+	}
 	metal_mutex_release(&irq_lock);
-	/* Notify IRQ thread that IRQ state has changed */
-	ret = metal_linux_irq_notify();
 	if (ret < 0) {
 		metal_log(METAL_LOG_ERROR,
-			  "%s: failed to notify set %d enable\n",
-			  __func__, irq);
+			  "%s: failed to set %d enable %u: %s\n",
+			  __func__, irq, state, strerror(errno));
 	}
 }
 
@@ -118,21 +144,15 @@ static void metal_linux_irq_set_enable(struct metal_irq_controller *irq_cntr,
  */
 static void *metal_linux_irq_handling(void *args)
 {
+	struct epoll_event events[MAX_EVENTS];
 	struct sched_param param;
+	struct metal_device *dev;
 	uint64_t val;
 	int ret;
-	int i, j, pfds_total;
-	struct pollfd *pfds;
+	int i, fd, nevents;
 
 	(void)args;
 
-	pfds = (struct pollfd *)malloc(FD_SETSIZE * sizeof(struct pollfd));
-	if (!pfds) {
-		metal_log(METAL_LOG_ERROR,
-			  "%s: failed to allocate irq fds mem.\n", __func__);
-		return NULL;
-	}
-
 	param.sched_priority = sched_get_priority_max(SCHED_FIFO);
 	/* Ignore the set scheduler error */
 	ret = sched_setscheduler(0, SCHED_FIFO, &param);
@@ -143,69 +163,48 @@ static void *metal_linux_irq_handling(void *args)
 	}
 
 	while (1) {
+		/* Wait for interrupt */
+		nevents = epoll_wait(irq_epoll_fd, events, MAX_EVENTS, -1);
+		if (nevents < 0) {
+			if (errno == EINTR)
+				continue;
+			metal_log(METAL_LOG_ERROR,
+				  "%s: epoll_wait() failed: %s.\n",
+				  __func__, strerror(errno));
+			break;
+		}
 		metal_mutex_acquire(&irq_lock);
 		if (irq_handling_stop) {
 			/* Killing this IRQ handling thread */
 			metal_mutex_release(&irq_lock);
 			break;
 		}
-
-		/* Get the fdset */
-		memset(pfds, 0, MAX_IRQS * sizeof(struct pollfd));
-		pfds[0].fd = irq_notify_fd;
-		pfds[0].events = POLLIN;
-		j = 1;
-		metal_bitmap_for_each_set_bit(irqs_enabled, i,
-					      linux_irq_cntr.irq_num) {
-			pfds[j].fd = i;
-			pfds[j].events = POLLIN;
-			j++;
-		}
-		metal_mutex_release(&irq_lock);
-		/* Wait for interrupt */
-		ret = poll(pfds, j, -1);
-		if (ret < 0) {
-			metal_log(METAL_LOG_ERROR, "%s: poll() failed: %s.\n",
-				  __func__, strerror(errno));
-			break;
-		}
-		/* Waken up from interrupt */
-		pfds_total = j;
-		for (i = 0; i < pfds_total; i++) {
-			if ((pfds[i].fd == irq_notify_fd) &&
-			    (pfds[i].revents & (POLLIN | POLLRDNORM))) {
-				/* IRQ registration change notification */
-				if (read(pfds[i].fd,
-					 (void *)&val, sizeof(uint64_t)) < 0)
+		/* Waken up from interrupt, the lock covers all ready irqs */
+		for (i = 0; i < nevents; i++) {
+			fd = events[i].data.fd;
+			if (fd == irq_notify_fd) {
+				/* IRQ handling stop notification */
+				if (read(fd, (void *)&val, sizeof(uint64_t)) < 0)
 					metal_log(METAL_LOG_ERROR,
 						  "%s, read irq fd %d failed\n",
-						  __func__, pfds[i].fd);
-			} else if ((pfds[i].revents & (POLLIN | POLLRDNORM))) {
-				struct metal_device *dev = NULL;
-				int irq_handled = 0;
-				int fd;
-
-				fd = pfds[i].fd;
-				dev = irqs_devs[fd];
-				metal_mutex_acquire(&irq_lock);
-				if (metal_irq_handle(&irqs[fd], fd)
-				    == METAL_IRQ_HANDLED)
-					irq_handled = 1;
-				if (irq_handled) {
-					if (dev && dev->bus->ops.dev_irq_ack)
-						dev->bus->ops.dev_irq_ack(
-							dev->bus, dev, fd);
-				}
-				metal_mutex_release(&irq_lock);
-			} else if (pfds[i].revents) {
+						  __func__, fd);
+			} else if (!(events[i].events & EPOLLIN)) {
 				metal_log(METAL_LOG_DEBUG,
-					  "%s: poll unexpected. fd %d: %d\n",
-					  __func__,
-					  pfds[i].fd, pfds[i].revents);
+					  "%s: epoll unexpected. fd %d: %u\n",
+					  __func__, fd, events[i].events);
+			} else if (metal_bitmap_is_bit_set(irqs_enabled,
+					fd - linux_irq_cntr.irq_base)) {
+				/* Not disabled since epoll_wait() returned */
+				dev = irqs_devs[fd];
+				if (metal_irq_handle(&irqs[fd], fd) ==
+				    METAL_IRQ_HANDLED && dev &&
+				    dev->bus->ops.dev_irq_ack)
+					dev->bus->ops.dev_irq_ack(dev->bus,
+								  dev, fd);
 			}
 		}
+		metal_mutex_release(&irq_lock);
 	}
-	free(pfds);
 	return NULL;
 }
 
@@ -225,6 +224,16 @@ int metal_linux_irq_init(void)
 			  "Failed to create eventfd for IRQ handling.\n");
 		return  -EAGAIN;
 	}
+	irq_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (irq_epoll_fd < 0 ||
+	    metal_linux_irq_watch(EPOLL_CTL_ADD, irq_notify_fd) < 0) {
+		metal_log(METAL_LOG_ERROR,
+			  "Failed to create epoll for IRQ handling.\n");
+		if (irq_epoll_fd >= 0)
+			close(irq_epoll_fd);
+		close(irq_notify_fd);
+		return -EAGAIN;
+	}
 
 	metal_mutex_init(&irq_lock);
 	irq_handling_stop = false;
@@ -260,6 +269,7 @@ void metal_linux_irq_shutdown(void)
 		metal_log(METAL_LOG_ERROR, "Failed to join IRQ thread: %d.\n",
 			  ret);
 	}
+	close(irq_epoll_fd);
 	close(irq_notify_fd);
 	metal_mutex_deinit(&irq_lock);
 }
@@ -273,3 +283,36 @@ void metal_linux_irq_register_dev(struct metal_device *dev, int irq)
 	}
 	irqs_devs[irq] = dev;
 }
+
+int metal_linux_irq_set_affinity(int cpu)
+{
+	cpu_set_t cpus;
+	int i;
+
+	if (cpu >= CPU_SETSIZE)
+		return -EINVAL;
+	CPU_ZERO(&cpus);
+	if (cpu >= 0) {
+		CPU_SET(cpu, &cpus);
+	} else {
+		for (i = 0; i < CPU_SETSIZE; i++)
+			CPU_SET(i, &cpus);
+	}
+	return -pthread_setaffinity_np(irq_pthread, sizeof(cpus), &cpus);
+}
+
+int metal_linux_irq_set_edge_triggered(int edge)
+{
+	int i, ret = 0;
+
+	metal_mutex_acquire(&irq_lock);
+	irq_edge_triggered = edge != 0;
+	metal_bitmap_for_each_set_bit(irqs_enabled, i,
+				      linux_irq_cntr.irq_num) {
+		if (metal_linux_irq_watch(EPOLL_CTL_MOD,
+					  i + linux_irq_cntr.irq_base) < 0)
+			ret = -errno;
+	}
+	metal_mutex_release(&irq_lock);
+	return ret;
+}
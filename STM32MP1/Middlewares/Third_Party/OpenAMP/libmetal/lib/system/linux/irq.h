@@ -14,6 +14,38 @@
 #endif
 
 #ifndef __METAL_LINUX_IRQ__H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief	metal_linux_irq_set_affinity
+ *
+ * Pins the IRQ handling thread to a CPU.
+ *
+ * @param[in]	cpu CPU number, or -1 to run on any CPU
+ * @return	0 on success, or -errno on failure.
+ */
+int metal_linux_irq_set_affinity(int cpu);
+
+/**
+ * @brief	metal_linux_irq_set_edge_triggered
+ *
+ * Selects the wait of the IRQ handling thread. Edge-triggered (the
+ * default), an IRQ is handled once per interrupt and has to be consumed by
+ * its handler or the ack of its device. Level-triggered, an IRQ is handled
+ * again as long as its file descriptor is readable.
+ *
+ * @param[in]	edge 1 for edge-triggered, 0 for level-triggered
+ * @return	0 on success, or -errno on failure.
+ */
+int metal_linux_irq_set_edge_triggered(int edge);
+
+#ifdef __cplusplus
+}
+#endif
+
 #ifdef METAL_INTERNAL
 
 #include <metal/device.h>
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2016, Xilinx Inc. and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * @file	linux/semaphore.c
+ * @brief	Linux libmetal semaphore handling.
+ */
+
+#include <time.h>
+#include <metal/errno.h>
+#include <metal/semaphore.h>
+
+#define NS_PER_S	(1000 * 1000 * 1000)
+
+int metal_sem_wait(struct metal_sem *sem, unsigned int timeout_usec)
+{
+	struct timespec deadline, now, rel;
+	long long ns;
+	int count;
+
+	if (timeout_usec != METAL_SEM_WAIT_FOREVER) {
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		ns = deadline.tv_nsec + (long long)timeout_usec * 1000;
+		deadline.tv_sec += ns / NS_PER_S;
+		deadline.tv_nsec = ns % NS_PER_S;
+	}
+
+	while (1) {
+		count = atomic_load(&sem->count);
+		while (count > 0) {
+			if (atomic_compare_exchange_weak(&sem->count, &count,
+							 count - 1))
+				return 0;
+		}
+
+		if (timeout_usec != METAL_SEM_WAIT_FOREVER) {
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			ns = (long long)(deadline.tv_sec - now.tv_sec) *
+			     NS_PER_S + (deadline.tv_nsec - now.tv_nsec);
+			if (ns <= 0)
+				return -ETIMEDOUT;
+			rel.tv_sec = ns / NS_PER_S;
+			rel.tv_nsec = ns % NS_PER_S;
+		}
+
+		/* A post after the count was read fails the wait at once. */
+		atomic_fetch_add(&sem->waiters, 1);
+		syscall(SYS_futex, &sem->count, FUTEX_WAIT, 0,
+			timeout_usec != METAL_SEM_WAIT_FOREVER ? &rel : NULL,
+			NULL, 0);
+		atomic_fetch_sub(&sem->waiters, 1);
+	}
+}
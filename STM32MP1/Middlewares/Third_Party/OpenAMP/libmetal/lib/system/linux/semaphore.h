@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2016, Xilinx Inc. and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * @file	linux/semaphore.h
+ * @brief	Linux semaphore primitives for libmetal.
+ */
+
+#ifndef __METAL_SEMAPHORE__H__
+#error "Include metal/semaphore.h instead of metal/linux/semaphore.h"
+#endif
+
+#ifndef __METAL_LINUX_SEMAPHORE__H__
+#define __METAL_LINUX_SEMAPHORE__H__
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <metal/atomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct metal_sem {
+	atomic_int count;   /**< semaphore count, the futex word. */
+	atomic_int waiters; /**< number of waiters. */
+};
+
+static inline void metal_sem_init(struct metal_sem *sem, unsigned int count)
+{
+	atomic_init(&sem->count, (int)count);
+	atomic_init(&sem->waiters, 0);
+}
+
+static inline void metal_sem_deinit(struct metal_sem *sem)
+{
+	(void)sem;
+}
+
+static inline void metal_sem_post(struct metal_sem *sem)
+{
+	atomic_fetch_add(&sem->count, 1);
+	if (atomic_load(&sem->waiters) > 0)
+		syscall(SYS_futex, &sem->count, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __METAL_LINUX_SEMAPHORE__H__ */
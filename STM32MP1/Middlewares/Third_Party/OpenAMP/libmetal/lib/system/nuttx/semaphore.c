@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2016, Xilinx Inc. and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * @file	nuttx/semaphore.c
+ * @brief	NuttX libmetal semaphore handling.
+ */
+
+#include <metal/errno.h>
+#include <metal/semaphore.h>
+
+int metal_sem_wait(struct metal_sem *sem, unsigned int timeout_usec)
+{
+	int ret;
+
+	if (timeout_usec == METAL_SEM_WAIT_FOREVER)
+		ret = nxsem_wait_uninterruptible(&sem->s);
+	else if (!timeout_usec)
+		ret = nxsem_trywait(&sem->s);
+	else
+		ret = nxsem_tickwait_uninterruptible(&sem->s,
+						     USEC2TICK(timeout_usec));
+	return ret < 0 ? -ETIMEDOUT : 0;
+}
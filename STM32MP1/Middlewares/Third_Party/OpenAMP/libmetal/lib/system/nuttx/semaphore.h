@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2016, Xilinx Inc. and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * @file	nuttx/semaphore.h
+ * @brief	NuttX semaphore primitives for libmetal.
+ */
+
+#ifndef __METAL_SEMAPHORE__H__
+#error "Include metal/semaphore.h instead of metal/nuttx/semaphore.h"
+#endif
+
+#ifndef __METAL_NUTTX_SEMAPHORE__H__
+#define __METAL_NUTTX_SEMAPHORE__H__
+
+#include <nuttx/semaphore.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct metal_sem {
+	sem_t s;
+};
+
+static inline void metal_sem_init(struct metal_sem *sem, unsigned int count)
+{
+	nxsem_init(&sem->s, 0, count);
+	nxsem_set_protocol(&sem->s, SEM_PRIO_NONE);
+}
+
+static inline void metal_sem_deinit(struct metal_sem *sem)
+{
+	nxsem_destroy(&sem->s);
+}
+
+static inline void metal_sem_post(struct metal_sem *sem)
+{
+	nxsem_post(&sem->s);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __METAL_NUTTX_SEMAPHORE__H__ */
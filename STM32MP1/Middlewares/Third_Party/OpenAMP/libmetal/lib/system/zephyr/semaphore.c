@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2016, Xilinx Inc. and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * @file	zephyr/semaphore.c
+ * @brief	Zephyr libmetal semaphore handling.
+ */
+
+#include <metal/errno.h>
+#include <metal/semaphore.h>
+
+int metal_sem_wait(struct metal_sem *sem, unsigned int timeout_usec)
+{
+	k_timeout_t timeout;
+
+	if (timeout_usec == METAL_SEM_WAIT_FOREVER)
+		timeout = K_FOREVER;
+	else
+		timeout = K_USEC(timeout_usec);
+	return k_sem_take(&sem->s, timeout) ? -ETIMEDOUT : 0;
+}
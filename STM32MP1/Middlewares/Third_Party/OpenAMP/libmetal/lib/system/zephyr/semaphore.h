@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2016, Xilinx Inc. and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/*
+ * @file	zephyr/semaphore.h
+ * @brief	Zephyr semaphore primitives for libmetal.
+ */
+
+#ifndef __METAL_SEMAPHORE__H__
+#error "Include metal/semaphore.h instead of metal/zephyr/semaphore.h"
+#endif
+
+#ifndef __METAL_ZEPHYR_SEMAPHORE__H__
+#define __METAL_ZEPHYR_SEMAPHORE__H__
+
+#include <kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct metal_sem {
+	struct k_sem s;
+};
+
+static inline void metal_sem_init(struct metal_sem *sem, unsigned int count)
+{
+	k_sem_init(&sem->s, count, K_SEM_MAX_LIMIT);
+}
+
+static inline void metal_sem_deinit(struct metal_sem *sem)
+{
+	(void)sem;
+}
+
+static inline void metal_sem_post(struct metal_sem *sem)
+{
+	k_sem_give(&sem->s);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __METAL_ZEPHYR_SEMAPHORE__H__ */
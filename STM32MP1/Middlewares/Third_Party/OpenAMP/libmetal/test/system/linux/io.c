@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2016, Xilinx Inc. and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <string.h>
+
+#include "metal-test.h"
+#include <metal/errno.h>
+#include <metal/io.h>
+#include <metal/log.h>
+#include <metal/sys.h>
+
+/* Bytes of the region and of the buffer, both start word aligned */
+#define BLOCK_SIZE	1024
+/* Guard bytes checked around each copy */
+#define GUARD		16
+#define OFFSET_NUM	8
+#define SHORT_LEN_NUM	80
+
+static const int long_lens[] = { 127, 128, 129, 511, 512, 513 };
+
+static const unsigned int flag_sets[] = {
+	0,
+	METAL_IO_BLOCK_BURST,
+	METAL_IO_BLOCK_ACQ_REL,
+	METAL_IO_BLOCK_BURST | METAL_IO_BLOCK_ACQ_REL,
+};
+
+static unsigned int mem[(BLOCK_SIZE + 2 * GUARD) / sizeof(unsigned int)];
+static unsigned int buf[(BLOCK_SIZE + 2 * GUARD) / sizeof(unsigned int)];
+
+static void fill(unsigned char *p, size_t size, unsigned char seed)
+{
+	size_t i;
+
+	for (i = 0; i < size; i++)
+		p[i] = (unsigned char)(seed + i * 7 + (i >> 8));
+}
+
+/* Copies len bytes between the region at ofs and the buffer at bofs */
+static int check_copy(struct metal_io_region *io, int write,
+		      unsigned long ofs, unsigned long bofs, int len)
+{
+	unsigned char *pm = (unsigned char *)mem;
+	unsigned char *pb = (unsigned char *)buf;
+	unsigned char *from, *to, *expect;
+	static unsigned char ref[BLOCK_SIZE + 2 * GUARD];
+	int ret;
+
+	fill(pm, sizeof(mem), 0x11);
+	fill(pb, sizeof(buf), 0xa5);
+	if (write) {
+		from = pb + GUARD + bofs;
+		to = pm + GUARD + ofs;
+		expect = pm;
+	} else {
+		from = pm + GUARD + ofs;
+		to = pb + GUARD + bofs;
+		expect = pb;
+	}
+	memcpy(ref, expect, sizeof(ref));
+	memcpy(ref + (to - expect), from, len);
+
+	if (write)
+		ret = metal_io_block_write(io, ofs, from, len);
+	else
+		ret = metal_io_block_read(io, ofs, to, len);
+	if (ret != len || memcmp(ref, expect, sizeof(ref))) {
+		metal_log(METAL_LOG_ERROR,
+			  "%s flags %#x, offset %lu, buffer offset %lu, "
+			  "%d bytes: %d\n", write ? "write" : "read",
+			  io->mem_flags, ofs, bofs, len, ret);
+		return -EINVAL;
+	}
+	return 0;
+}
+
+static int check_lens(struct metal_io_region *io, unsigned long ofs,
+		      unsigned long bofs)
+{
+	int ret = 0;
+	int len, write;
+	unsigned int i;
+
+	for (write = 0; write < 2 && !ret; write++) {
+		for (len = 0; len < SHORT_LEN_NUM && !ret; len++)
+			ret = check_copy(io, write, ofs, bofs, len);
+		for (i = 0; i < sizeof(long_lens) / sizeof(long_lens[0]) &&
+		     !ret; i++)
+			ret = check_copy(io, write, ofs, bofs, long_lens[i]);
+	}
+	return ret;
+}
+
+static int io_block(void)
+{
+	struct metal_io_region io;
+	unsigned char *pm = (unsigned char *)mem;
+	unsigned char *pb = (unsigned char *)buf;
+	unsigned long ofs, bofs;
+	unsigned int i;
+	int ret = 0;
+
+	for (i = 0; i < sizeof(flag_sets) / sizeof(flag_sets[0]); i++) {
+		metal_io_init(&io, pm + GUARD, NULL, BLOCK_SIZE, -1U,
+			      flag_sets[i], NULL);
+
+		/** TC1 every alignment of region and buffer, every length */
+		for (ofs = 0; ofs < OFFSET_NUM && !ret; ofs++)
+			for (bofs = 0; bofs < OFFSET_NUM && !ret; bofs++)
+				ret = check_lens(&io, ofs, bofs);
+		if (ret)
+			break;
+
+		/** TC2 a copy past the end of the region is cut short */
+		fill(pb, sizeof(buf), 0xa5);
+		ret = metal_io_block_write(&io, BLOCK_SIZE - 5, pb + 3, 64);
+		if (ret != 5 || memcmp(pm + GUARD + BLOCK_SIZE - 5, pb + 3, 5)) {
+			metal_log(METAL_LOG_ERROR,
+				  "Write at the end not cut: %d\n", ret);
+			ret = -EINVAL;
+			break;
+		}
+		ret = metal_io_block_read(&io, BLOCK_SIZE - 37, pb + 1, 100);
+		if (ret != 37 ||
+		    memcmp(pm + GUARD + BLOCK_SIZE - 37, pb + 1, 37)) {
+			metal_log(METAL_LOG_ERROR,
+				  "Read at the end not cut: %d\n", ret);
+			ret = -EINVAL;
+			break;
+		}
+
+		/** TC3 an offset outside of the region is refused */
+		ret = metal_io_block_read(&io, BLOCK_SIZE, pb, 4);
+		if (ret != -ERANGE) {
+			metal_log(METAL_LOG_ERROR,
+				  "Read outside of the region: %d\n", ret);
+			ret = -EINVAL;
+			break;
+		}
+		ret = 0;
+		metal_io_finish(&io);
+	}
+	return ret;
+}
+METAL_ADD_TEST(io_block);
@@ -17,7 +17,9 @@
 #include <metal/log.h>
 #include <metal/sys.h>
 #include <metal/list.h>
+#include <metal/semaphore.h>
 #include <metal/utilities.h>
+#include <unistd.h>
 
 
 static int irq_handler(int irq, void *priv)
@@ -77,3 +79,127 @@ out:
 }
 
 METAL_ADD_TEST(irq);
+
+#define DISPATCH_IRQS 3
+/* Longest wait for the IRQ thread in us */
+#define DISPATCH_WAIT 1000000
+
+static struct metal_sem dispatch_sem;
+static int dispatch_count[DISPATCH_IRQS];
+
+static int dispatch_handler(int irq, void *priv)
+{
+	uint64_t val;
+
+	if (read(irq, &val, sizeof(val)) != sizeof(val))
+		return METAL_IRQ_NOT_HANDLED;
+	dispatch_count[(uintptr_t)priv]++;
+	metal_sem_post(&dispatch_sem);
+	return METAL_IRQ_HANDLED;
+}
+
+static int dispatch_raise(int fd)
+{
+	uint64_t val = 1;
+
+	return write(fd, &val, sizeof(val)) == sizeof(val) ? 0 : -EIO;
+}
+
+static int dispatch_check(int c0, int c1, int c2)
+{
+	if (dispatch_count[0] != c0 || dispatch_count[1] != c1 ||
+	    dispatch_count[2] != c2) {
+		metal_log(METAL_LOG_ERROR, "irqs handled %d %d %d, not %d %d %d\n",
+			  dispatch_count[0], dispatch_count[1],
+			  dispatch_count[2], c0, c1, c2);
+		return -EINVAL;
+	}
+	return 0;
+}
+
+static int irq_dispatch(void)
+{
+	int rc = 0;
+	char *err_msg = "";
+	int i, tst_irq[DISPATCH_IRQS];
+
+	metal_sem_init(&dispatch_sem, 0);
+	for (i = 0; i < DISPATCH_IRQS; i++) {
+		tst_irq[i] = eventfd(0, EFD_NONBLOCK);
+		metal_irq_register(tst_irq[i], dispatch_handler,
+				   (void *)(uintptr_t)i);
+		metal_irq_enable(tst_irq[i]);
+	}
+
+	/** TC1 the ready irqs are handled once each */
+	rc = dispatch_raise(tst_irq[0]) || dispatch_raise(tst_irq[2]);
+	for (i = 0; !rc && i < 2; i++)
+		rc = metal_sem_wait(&dispatch_sem, DISPATCH_WAIT);
+	if (!rc)
+		rc = dispatch_check(1, 0, 1);
+	if (rc) {
+		err_msg = "enabled irqs not handled\n";
+		goto out;
+	}
+
+	/** TC2 a disabled irq stays pending until it is enabled again */
+	metal_irq_disable(tst_irq[0]);
+	rc = dispatch_raise(tst_irq[0]) || dispatch_raise(tst_irq[1]);
+	if (!rc)
+		rc = metal_sem_wait(&dispatch_sem, DISPATCH_WAIT);
+	if (!rc)
+		rc = dispatch_check(1, 1, 1);
+	if (rc) {
+		err_msg = "disabled irq handled\n";
+		goto out;
+	}
+	metal_irq_enable(tst_irq[0]);
+	rc = metal_sem_wait(&dispatch_sem, DISPATCH_WAIT);
+	if (!rc)
+		rc = dispatch_check(2, 1, 1);
+	if (rc) {
+		err_msg = "pending irq not handled once enabled\n";
+		goto out;
+	}
+
+	/** TC3 level-triggered and pinned, the irqs are still handled */
+	rc = metal_linux_irq_set_edge_triggered(0);
+	if (!rc)
+		rc = metal_linux_irq_set_affinity(0);
+	if (!rc)
+		rc = dispatch_raise(tst_irq[2]);
+	if (!rc)
+		rc = metal_sem_wait(&dispatch_sem, DISPATCH_WAIT);
+	if (!rc)
+		rc = dispatch_check(2, 1, 2);
+	if (!rc)
+		rc = metal_linux_irq_set_edge_triggered(1);
+	if (!rc)
+		rc = metal_linux_irq_set_affinity(-1);
+	if (rc) {
+		err_msg = "irq not handled level-triggered\n";
+		goto out;
+	}
+
+	/** nothing else was handled */
+	if (metal_sem_wait(&dispatch_sem, 0) != -ETIMEDOUT) {
+		rc = -EINVAL;
+		err_msg = "irq handled twice\n";
+	}
+
+out:
+	for (i = 0; i < DISPATCH_IRQS; i++) {
+		metal_irq_disable(tst_irq[i]);
+		metal_irq_unregister(tst_irq[i]);
+		close(tst_irq[i]);
+	}
+	metal_linux_irq_set_edge_triggered(1);
+	metal_linux_irq_set_affinity(-1);
+	metal_sem_deinit(&dispatch_sem);
+	if ((err_msg[0] != '\0') && (!rc))
+		rc = -EINVAL;
+	if (rc) metal_log(METAL_LOG_ERROR, "%s", err_msg);
+	return rc;
+}
+
+METAL_ADD_TEST(irq_dispatch);
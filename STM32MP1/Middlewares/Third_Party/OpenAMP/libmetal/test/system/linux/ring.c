@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2016, Xilinx Inc. and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include "metal-test.h"
+#include <metal/errno.h>
+#include <metal/io.h>
+#include <metal/log.h>
+#include <metal/ring.h>
+#include <metal/semaphore.h>
+#include <metal/sys.h>
+
+#define RING_SIZE	1024
+#define RING_RECORDS	20000
+#define RING_MAX_LEN	200
+#define RING_BATCH	8
+
+static uint64_t ring_mem[metal_ring_footprint(RING_SIZE) / sizeof(uint64_t)];
+static struct metal_io_region ring_io;
+static struct metal_sem ring_doorbell;
+
+static void fill(unsigned char *p, uint32_t len, uint32_t seed)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+		p[i] = (unsigned char)(seed * 31 + i);
+}
+
+static int check(const unsigned char *p, uint32_t len, uint32_t seed)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++) {
+		if (p[i] != (unsigned char)(seed * 31 + i))
+			return -EINVAL;
+	}
+	return 0;
+}
+
+static uint32_t record_len(uint32_t i)
+{
+	return (i * 13) % (RING_MAX_LEN + 1);
+}
+
+static int ring_notify(void *priv, uint32_t id)
+{
+	(void)priv;
+	(void)id;
+
+	metal_sem_post(&ring_doorbell);
+	return 0;
+}
+
+static void *ring_producer(void *arg)
+{
+	struct metal_ring *ring = arg;
+	unsigned char buf[RING_MAX_LEN];
+	uint32_t i;
+	int ret;
+
+	for (i = 0; i < RING_RECORDS; i++) {
+		fill(buf, record_len(i), i);
+		do {
+			ret = metal_ring_send(ring, buf, record_len(i));
+			if (ret == -ENOSPC) {
+				metal_ring_flush(ring);
+				sched_yield();
+			}
+		} while (ret == -ENOSPC);
+		if (ret)
+			return (void *)(long)ret;
+	}
+	metal_ring_flush(ring);
+	return NULL;
+}
+
+/* Checks the records of the producer, waiting for the doorbell when empty */
+static int ring_consume(struct metal_ring *ring, unsigned long *waits)
+{
+	unsigned char buf[RING_MAX_LEN];
+	uint32_t i;
+	int ret;
+
+	for (i = 0; i < RING_RECORDS; ) {
+		ret = metal_ring_recv(ring, buf, sizeof(buf));
+		if (ret == -EAGAIN) {
+			if (!metal_ring_arm(ring)) {
+				metal_sem_wait(&ring_doorbell,
+					       METAL_SEM_WAIT_FOREVER);
+				(*waits)++;
+			}
+			continue;
+		}
+		if (ret != (int)record_len(i) || check(buf, ret, i)) {
+			metal_log(METAL_LOG_ERROR, "Record %u corrupt: %d.\n",
+				  i, ret);
+			return -EINVAL;
+		}
+		i++;
+	}
+	return 0;
+}
+
+static int ring(void)
+{
+	struct metal_ring prod, cons;
+	unsigned char in[3 * RING_SIZE / 4], out[3 * RING_SIZE / 4];
+	unsigned long waits = 0;
+	pthread_t tid;
+	void *status;
+	unsigned long pos;
+	uint32_t i, sent;
+	int ret;
+
+	memset(ring_mem, 0, sizeof(ring_mem));
+	metal_io_init(&ring_io, ring_mem, NULL, sizeof(ring_mem),
+		      (unsigned int)-1, 0, NULL);
+
+	/** TC1 the consumer attaches only to an initialized ring */
+	if (metal_ring_attach(&cons, &ring_io, 0) != -EAGAIN ||
+	    metal_ring_init(&prod, &ring_io, 0, RING_SIZE + 4) != -EINVAL ||
+	    metal_ring_init(&prod, &ring_io, 0, 2 * RING_SIZE) != -EINVAL) {
+		metal_log(METAL_LOG_ERROR, "Bad ring accepted.\n");
+		return -EINVAL;
+	}
+	if (metal_ring_init(&prod, &ring_io, 0, RING_SIZE) ||
+	    metal_ring_attach(&cons, &ring_io, 0) || cons.size != RING_SIZE) {
+		metal_log(METAL_LOG_ERROR, "Failed to set up the ring.\n");
+		return -EINVAL;
+	}
+
+	/** TC2 records fill the ring, and keep their order and length */
+	if (metal_ring_recv(&cons, out, sizeof(out)) != -EAGAIN ||
+	    metal_ring_send(&prod, in, RING_SIZE - 3) != -EINVAL) {
+		metal_log(METAL_LOG_ERROR, "Bad record accepted.\n");
+		return -EINVAL;
+	}
+	for (sent = 0; ; sent++) {
+		fill(in, 61, sent);
+		ret = metal_ring_send(&prod, in, 61);
+		if (ret)
+			break;
+	}
+	/* 68 bytes per record with its length */
+	if (ret != -ENOSPC || sent != RING_SIZE / 68) {
+		metal_log(METAL_LOG_ERROR, "%u records fit the ring.\n", sent);
+		return -EINVAL;
+	}
+	if (metal_ring_recv(&cons, out, 60) != -EMSGSIZE) {
+		metal_log(METAL_LOG_ERROR, "Short buffer accepted.\n");
+		return -EINVAL;
+	}
+	for (i = 0; i < sent; i++) {
+		if (metal_ring_recv(&cons, out, sizeof(out)) != 61 ||
+		    check(out, 61, i)) {
+			metal_log(METAL_LOG_ERROR, "Record %u corrupt.\n", i);
+			return -EINVAL;
+		}
+	}
+
+	/** TC3 a length word running past the published data is rejected */
+	fill(in, 8, 0);
+	metal_ring_send(&prod, in, 8);
+	pos = cons.data + (cons.tail & (RING_SIZE - 1));
+	metal_io_write32(&ring_io, pos, RING_SIZE);
+	ret = metal_ring_recv(&cons, out, sizeof(out));
+	metal_io_write32(&ring_io, pos, 9);
+	if (ret != -EPROTO ||
+	    metal_ring_recv(&cons, out, sizeof(out)) != -EPROTO) {
+		metal_log(METAL_LOG_ERROR, "Bad length accepted.\n");
+		return -EINVAL;
+	}
+	metal_io_write32(&ring_io, pos, 8);
+	if (metal_ring_recv(&cons, out, sizeof(out)) != 8 || check(out, 8, 0)) {
+		metal_log(METAL_LOG_ERROR, "Record corrupt.\n");
+		return -EINVAL;
+	}
+
+	/** TC4 a byte stream wraps around the end of the ring */
+	for (i = 0; i < 8; i++) {
+		fill(in, sizeof(in), i);
+		if (metal_ring_write(&prod, in, sizeof(in)) != sizeof(in) ||
+		    metal_ring_write(&prod, in, sizeof(in)) != RING_SIZE / 4 ||
+		    metal_ring_read(&cons, out, sizeof(out)) != sizeof(out) ||
+		    memcmp(in, out, sizeof(out)) ||
+		    metal_ring_read(&cons, out, sizeof(out)) != RING_SIZE / 4 ||
+		    memcmp(in, out, RING_SIZE / 4) ||
+		    metal_ring_read(&cons, out, sizeof(out))) {
+			metal_log(METAL_LOG_ERROR, "Stream corrupt.\n");
+			return -EINVAL;
+		}
+	}
+
+	/** TC5 the doorbell rings if the wake point is in [old, head) of the
+	 *  bytes published since the last check */
+	metal_ring_init(&prod, &ring_io, 0, RING_SIZE);
+	metal_ring_set_doorbell(&prod, NULL, NULL, 0, RING_RECORDS);
+	metal_ring_attach(&cons, &ring_io, 0);
+	metal_ring_send(&prod, in, 8);
+	/* wake point at head: the consumer has read all of it */
+	if (metal_ring_recv(&cons, out, sizeof(out)) != 8 ||
+	    metal_ring_arm(&cons) || metal_ring_flush(&prod)) {
+		metal_log(METAL_LOG_ERROR, "Doorbell rung past head.\n");
+		return -EINVAL;
+	}
+	/* wake point at old: the consumer waits for the first new byte */
+	metal_ring_send(&prod, in, 8);
+	if (metal_ring_flush(&prod) != 1 || prod.doorbells != 1 ||
+	    metal_ring_flush(&prod)) {
+		metal_log(METAL_LOG_ERROR, "Doorbell missed at old.\n");
+		return -EINVAL;
+	}
+
+	/** TC6 a producer thread streams to the consumer, ringing the doorbell
+	 *  only when the consumer waits for it */
+	metal_sem_init(&ring_doorbell, 0);
+	metal_ring_init(&prod, &ring_io, 0, RING_SIZE);
+	metal_ring_set_doorbell(&prod, ring_notify, NULL, 0, RING_BATCH);
+	metal_ring_attach(&cons, &ring_io, 0);
+	if (pthread_create(&tid, NULL, ring_producer, &prod)) {
+		metal_log(METAL_LOG_ERROR, "Failed to start the producer.\n");
+		return -EINVAL;
+	}
+	ret = ring_consume(&cons, &waits);
+	pthread_join(tid, &status);
+	metal_sem_deinit(&ring_doorbell);
+	if (ret || status) {
+		metal_log(METAL_LOG_ERROR, "Stream failed: %d.\n",
+			  ret ? ret : (int)(long)status);
+		return -EINVAL;
+	}
+	if (prod.doorbells < waits || prod.doorbells > RING_RECORDS) {
+		metal_log(METAL_LOG_ERROR, "%lu doorbells for %lu waits.\n",
+			  prod.doorbells, waits);
+		return -EINVAL;
+	}
+	metal_log(METAL_LOG_DEBUG, "%lu doorbells, %lu waits.\n",
+		  prod.doorbells, waits);
+	return 0;
+}
+METAL_ADD_TEST(ring);
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2016, Xilinx Inc. and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <pthread.h>
+
+#include "metal-test.h"
+#include <metal/errno.h>
+#include <metal/log.h>
+#include <metal/sys.h>
+#include <metal/semaphore.h>
+
+#define POSTS_PER_THREAD 1000
+
+#define THREADS 10
+
+static struct metal_sem sem;
+
+static void *post_thread(void *arg)
+{
+	int i;
+
+	(void)arg;
+	for (i = 0; i < POSTS_PER_THREAD; i++)
+		metal_sem_post(&sem);
+
+	return NULL;
+}
+
+static void *wait_thread(void *arg)
+{
+	int i;
+
+	(void)arg;
+	for (i = 0; i < POSTS_PER_THREAD; i++)
+		metal_sem_wait(&sem, METAL_SEM_WAIT_FOREVER);
+
+	return NULL;
+}
+
+static int semaphore(void)
+{
+	int ret;
+	int ts_created;
+	pthread_t tids[THREADS];
+
+	metal_sem_init(&sem, 1);
+
+	/** TC1 an available count is taken without blocking */
+	ret = metal_sem_wait(&sem, 0);
+	if (ret) {
+		metal_log(METAL_LOG_ERROR, "Failed to take the count: %d.\n",
+			  ret);
+		goto out;
+	}
+
+	/** TC2 an empty semaphore times out */
+	ret = metal_sem_wait(&sem, 1000);
+	if (ret != -ETIMEDOUT) {
+		metal_log(METAL_LOG_ERROR, "Wait did not time out: %d.\n",
+			  ret);
+		ret = -EINVAL;
+		goto out;
+	}
+
+	/** TC3 waiters go first and take every post */
+	ret = metal_run_noblock(THREADS, wait_thread, NULL, tids,
+				&ts_created);
+	if (ret < 0) {
+		metal_log(METAL_LOG_ERROR, "Failed to create wait thread: %d.\n",
+			  ret);
+		goto out;
+	}
+
+	ret = metal_run(THREADS, post_thread, NULL);
+	metal_finish_threads(ts_created, (void *)tids);
+	if (ret < 0) {
+		metal_log(METAL_LOG_ERROR, "Failed to create post thread: %d.\n",
+			  ret);
+		goto out;
+	}
+
+	/** all posts are consumed, nothing is left */
+	ret = metal_sem_wait(&sem, 0);
+	if (ret != -ETIMEDOUT) {
+		metal_log(METAL_LOG_ERROR, "Semaphore count left over.\n");
+		ret = -EINVAL;
+		goto out;
+	}
+	ret = 0;
+
+out:
+	metal_sem_deinit(&sem);
+	return ret;
+}
+METAL_ADD_TEST(semaphore);
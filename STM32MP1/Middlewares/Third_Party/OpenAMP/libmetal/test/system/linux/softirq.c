@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2019, Xilinx Inc. and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "metal-test.h"
+#include <metal/errno.h>
+#include <metal/log.h>
+#include <metal/softirq.h>
+#include <metal/sys.h>
+
+/* Every soft IRQ of the controller, across its bitmap words */
+#define SOFTIRQS 64
+
+static int softirq_order[SOFTIRQS];
+static int softirq_handled;
+static int softirq_base;
+
+static int softirq_handler(int irq, void *priv)
+{
+	(void)priv;
+
+	if (softirq_handled < SOFTIRQS)
+		softirq_order[softirq_handled] = irq - softirq_base;
+	softirq_handled++;
+	/* The first soft IRQ disables the last one of this dispatch */
+	if (irq == softirq_base)
+		metal_irq_disable(softirq_base + SOFTIRQS - 1);
+	return METAL_IRQ_HANDLED;
+}
+
+static int softirq(void)
+{
+	int rc, i;
+
+	rc = metal_softirq_init();
+	if (rc) {
+		metal_log(METAL_LOG_ERROR, "Failed to init soft irqs: %d.\n",
+			  rc);
+		return rc;
+	}
+	softirq_base = metal_softirq_allocate(SOFTIRQS);
+	if (softirq_base < 0) {
+		metal_log(METAL_LOG_ERROR, "Failed to allocate soft irqs.\n");
+		return softirq_base;
+	}
+	for (i = 0; i < SOFTIRQS; i++) {
+		metal_irq_register(softirq_base + i, softirq_handler, NULL);
+		if (i != 1)
+			metal_irq_enable(softirq_base + i);
+	}
+
+	/** TC1 nothing pending, nothing handled */
+	metal_softirq_dispatch();
+	if (softirq_handled) {
+		metal_log(METAL_LOG_ERROR, "Soft irq handled, none pending.\n");
+		return -EINVAL;
+	}
+
+	/** TC2 the enabled soft irqs are handled lowest first */
+	for (i = SOFTIRQS - 1; i >= 0; i -= 3)
+		metal_softirq_set(softirq_base + i);
+	metal_softirq_set(softirq_base + 1);
+	metal_softirq_set(softirq_base);
+	metal_softirq_dispatch();
+	/* 0 3 .. 60, 63 disabled by 0, 1 disabled */
+	if (softirq_handled != 21 || softirq_order[0] != 0) {
+		metal_log(METAL_LOG_ERROR, "%d soft irqs handled.\n",
+			  softirq_handled);
+		return -EINVAL;
+	}
+	for (i = 1; i < softirq_handled; i++) {
+		if (softirq_order[i] != 3 * i) {
+			metal_log(METAL_LOG_ERROR,
+				  "Soft irq %d handled as %d.\n",
+				  softirq_order[i], i);
+			return -EINVAL;
+		}
+	}
+
+	/** TC3 disabled soft irqs stay pending until they are enabled */
+	softirq_handled = 0;
+	metal_irq_enable(softirq_base + 1);
+	metal_irq_enable(softirq_base + SOFTIRQS - 1);
+	metal_softirq_dispatch();
+	if (softirq_handled != 2 || softirq_order[0] != 1 ||
+	    softirq_order[1] != SOFTIRQS - 1) {
+		metal_log(METAL_LOG_ERROR, "Pending soft irqs lost.\n");
+		return -EINVAL;
+	}
+
+	/** TC4 each dispatch is counted */
+	if (metal_softirq_get_count(softirq_base) != 1 ||
+	    metal_softirq_get_count(softirq_base + 1) != 1 ||
+	    metal_softirq_get_count(softirq_base + 2) != 0 ||
+	    metal_softirq_get_count(softirq_base + SOFTIRQS - 1) != 1) {
+		metal_log(METAL_LOG_ERROR, "Soft irq counts wrong.\n");
+		return -EINVAL;
+	}
+
+	for (i = 0; i < SOFTIRQS; i++) {
+		metal_irq_disable(softirq_base + i);
+		metal_irq_unregister(softirq_base + i);
+	}
+	return 0;
+}
+METAL_ADD_TEST(softirq);
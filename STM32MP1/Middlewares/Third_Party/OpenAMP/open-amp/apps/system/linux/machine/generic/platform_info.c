@@ -22,17 +22,24 @@
 #include <metal/atomic.h>
 #include <metal/io.h>
 #include <metal/irq.h>
+#include <metal/semaphore.h>
 #include <metal/shmem.h>
 #include <metal/utilities.h>
 #include <openamp/remoteproc.h>
 #include <openamp/rpmsg_virtio.h>
 #include <errno.h>
+#include <limits.h>
 #include <poll.h>
 #include <string.h>
 #include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
 #include <sys/socket.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/un.h>
+#include "platform_info.h"
 #include "rsc_table.h"
 
 #define IPI_CHAN_NUMS 2
@@ -41,22 +48,42 @@
 #define UNIX_PREFIX "unix:"
 #define UNIXS_PREFIX "unixs:"
 
+/* Offsets in the shared memory, its physical address is set by
+ * platform_set_shm_pa() */
 #define RSC_MEM_PA  0x0UL
 #define SHARED_BUF_PA   0x10000UL
-#define SHARED_BUF_SIZE 0x40000UL
+#define SHARED_BUF_SIZE 0x70000UL
 
 #define _rproc_wait() metal_cpu_yield()
 
+#define NS_PER_S	(1000 * 1000 * 1000)
+#define NS_PER_US	1000
+
 struct vring_ipi_info {
 	/* Socket file path */
 	const char *path;
 	int fd;
-	atomic_int sync;
+	/* 1 while a notification is pending, the futex word of platform_poll */
+	atomic_int pending;
+	atomic_int waiters;
+	/* Spin bound of platform_poll in ns, busy never sleeps */
+	int busy;
+	unsigned long spin_max_ns;
+	/* Running average of the recent waits for a notification */
+	unsigned long wait_avg_ns;
+	/* Notifications taken while spinning and after sleeping */
+	unsigned long spin_wakeups;
+	unsigned long sleep_wakeups;
+	/* Number of notifications sent to the peer */
+	unsigned long notified;
+	/* Posted for every notification, wakes senders waiting for buffers */
+	struct metal_sem tx_free;
 };
 
 struct remoteproc_priv {
 	const char *shm_file;
 	int shm_size;
+	metal_phys_addr_t shm_pa;
 	struct metal_io_region *shm_old_io;
 	struct metal_io_region shm_new_io;
 	struct remoteproc_mem shm;
@@ -218,7 +245,13 @@ static int linux_proc_irq_handler(int vect_id, void *data)
 	struct vring_ipi_info *ipi = data;
 
 	read(vect_id, dummy_buf, sizeof(dummy_buf));
-	atomic_flag_clear(&ipi->sync);
+	atomic_store(&ipi->pending, 1);
+	if (atomic_load(&ipi->waiters) > 0)
+		syscall(SYS_futex, &ipi->pending, FUTEX_WAKE, INT_MAX, NULL,
+			NULL, 0);
+	/* The socket does not tell the virtqueue, a spurious post only
+	 * makes a waiting sender check the send virtqueue once more */
+	metal_sem_post(&ipi->tx_free);
 	return 0;
 }
 
@@ -244,8 +277,8 @@ linux_proc_init(struct remoteproc *rproc,
 	}
 	prproc->shm_old_io = io;
 	shm = &prproc->shm;
-	shm->pa = 0;
-	shm->da = 0;
+	shm->pa = prproc->shm_pa;
+	shm->da = prproc->shm_pa;
 	shm->size = prproc->shm_size;
 	metal_io_init(&prproc->shm_new_io, io->virt, &shm->pa,
 		      shm->size, -1, 0, &linux_proc_io_ops);
@@ -265,6 +298,10 @@ linux_proc_init(struct remoteproc *rproc,
 			ipi->path);
 		goto err;
 	}
+	metal_sem_init(&ipi->tx_free, 0);
+	/* The first platform_poll() checks the vrings without waiting */
+	atomic_init(&ipi->pending, 1);
+	atomic_init(&ipi->waiters, 0);
 	metal_irq_register(ipi->fd, linux_proc_irq_handler, ipi);
 	metal_irq_enable(ipi->fd);
 	rproc->ops = ops;
@@ -291,6 +328,7 @@ static void linux_proc_remove(struct remoteproc *rproc)
 		metal_irq_disable(ipi->fd);
 		metal_irq_unregister(ipi->fd);
 		close(ipi->fd);
+		metal_sem_deinit(&ipi->tx_free);
 	}
 
 	/* Close shared memory */
@@ -340,14 +378,16 @@ static int linux_proc_notify(struct remoteproc *rproc, uint32_t id)
 {
 	struct remoteproc_priv *prproc;
 	struct vring_ipi_info *ipi;
-	char dummy = 1;
+	/* The peers of this platform process all vrings for any byte, a
+	 * peer with one channel per vring takes the notify id from it */
+	char notify_id = (char)id;
 
-	(void)id;
 	if (!rproc)
 		return -1;
 	prproc = rproc->priv;
 	ipi = &prproc->ipi;
-	send(ipi->fd, &dummy, 1, MSG_NOSIGNAL);
+	send(ipi->fd, &notify_id, 1, MSG_NOSIGNAL);
+	ipi->notified++;
 	return 0;
 }
 
@@ -366,6 +406,10 @@ static struct remoteproc_ops linux_proc_ops = {
 /* RPMsg virtio shared buffer pool */
 static struct rpmsg_virtio_shm_pool shpool;
 
+/* Vring depth and buffer size of the command line, 0 for the defaults */
+static unsigned long vring_num;
+static struct rpmsg_virtio_config rpmsg_config;
+
 static int platform_slave_setup_resource_table(const char *shm_file,
 					       int shm_size,
 					       void *rsc_table, int rsc_size,
@@ -399,6 +443,12 @@ platform_create_proc(int proc_index, int rsc_index)
 
 	(void)proc_index;
 	rsc_table = get_resource_table(rsc_index, &rsc_size);
+	if (vring_num && set_resource_table_buffers(rsc_table, vring_num,
+						    rpmsg_config.h2r_buf_size)) {
+		printf("%lu descriptors do not fit the vrings\r\n",
+		       vring_num);
+		return NULL;
+	}
 
 	prproc = &rproc_priv_table[proc_index];
 	/* Setup resource table
@@ -420,7 +470,7 @@ platform_create_proc(int proc_index, int rsc_index)
 		return NULL;
 
 	/* Mmap resource table */
-	pa = RSC_MEM_PA;
+	pa = prproc->shm_pa + RSC_MEM_PA;
 	rsc_table_shm = remoteproc_mmap(&rproc_inst, &pa, NULL, rsc_size,
 					0, &rproc_inst.rsc_io);
 
@@ -435,6 +485,15 @@ platform_create_proc(int proc_index, int rsc_index)
 	return &rproc_inst;
 }
 
+void platform_set_shm_pa(metal_phys_addr_t pa)
+{
+	unsigned int i;
+
+	for (i = 0; i < sizeof(rproc_priv_table) / sizeof(rproc_priv_table[0]);
+	     i++)
+		rproc_priv_table[i].shm_pa = pa;
+}
+
 int platform_init(int argc, char *argv[], void **platform)
 {
 	unsigned long proc_id = 0;
@@ -457,6 +516,18 @@ int platform_init(int argc, char *argv[], void **platform)
 		rsc_id = strtoul(argv[2], NULL, 0);
 	}
 
+	/* Optional vring depth and buffer size, both sides need the same */
+	if (argc >= 4) {
+		vring_num = strtoul(argv[3], NULL, 0);
+		rpmsg_config.h2r_buf_size = RPMSG_BUFFER_SIZE;
+		rpmsg_config.r2h_buf_size = RPMSG_BUFFER_SIZE;
+	}
+
+	if (argc >= 5) {
+		rpmsg_config.h2r_buf_size = strtoul(argv[4], NULL, 0);
+		rpmsg_config.r2h_buf_size = rpmsg_config.h2r_buf_size;
+	}
+
 	rproc = platform_create_proc(proc_id, rsc_id);
 	if (!rproc) {
 		fprintf(stderr, "Failed to create remoteproc device.\r\n");
@@ -473,20 +544,22 @@ platform_create_rpmsg_vdev(void *platform, unsigned int vdev_index,
 			   rpmsg_ns_bind_cb ns_bind_cb)
 {
 	struct remoteproc *rproc = platform;
+	struct remoteproc_priv *prproc = rproc->priv;
 	struct rpmsg_virtio_device *rpmsg_vdev;
 	struct virtio_device *vdev;
 	void *shbuf;
 	struct metal_io_region *shbuf_io;
+	metal_phys_addr_t shbuf_pa = prproc->shm_pa + SHARED_BUF_PA;
 	int ret;
 
 	/* Setup resource table */
 	rpmsg_vdev = metal_allocate_memory(sizeof(*rpmsg_vdev));
 	if (!rpmsg_vdev)
 		return NULL;
-	shbuf_io = remoteproc_get_io_with_pa(rproc, SHARED_BUF_PA);
+	shbuf_io = remoteproc_get_io_with_pa(rproc, shbuf_pa);
 	if (!shbuf_io)
 		goto err1;
-	shbuf = metal_io_phys_to_virt(shbuf_io, SHARED_BUF_PA);
+	shbuf = metal_io_phys_to_virt(shbuf_io, shbuf_pa);
 
 	printf("creating remoteproc virtio\r\n");
 	/* TODO: can we have a wrapper for the following two functions? */
@@ -502,13 +575,14 @@ platform_create_rpmsg_vdev(void *platform, unsigned int vdev_index,
 
 	printf("initializing rpmsg vdev\r\n");
 	/* RPMsg virtio slave can set shared buffers pool argument to NULL */
-	ret =  rpmsg_init_vdev(rpmsg_vdev, vdev, ns_bind_cb,
-			       shbuf_io,
-			       &shpool);
+	ret =  rpmsg_init_vdev_with_config(rpmsg_vdev, vdev, ns_bind_cb,
+					   shbuf_io, &shpool,
+					   vring_num ? &rpmsg_config : NULL);
 	if (ret) {
-		printf("failed rpmsg_init_vdev\r\n");
+		printf("failed rpmsg_init_vdev: %d\r\n", ret);
 		goto err2;
 	}
+	rpmsg_virtio_set_tx_free_sem(rpmsg_vdev, &prproc->ipi.tx_free);
 	return rpmsg_virtio_get_rpmsg_device(rpmsg_vdev);
 err2:
 	remoteproc_remove_virtio(rproc, vdev);
@@ -517,28 +591,124 @@ err1:
 	return NULL;
 }
 
-int platform_poll(void *priv)
+static unsigned long long linux_proc_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * NS_PER_S + ts.tv_nsec;
+}
+
+/* Spins up to limit_ns for a notification, returns 1 if one is pending */
+static int linux_proc_spin_notification(struct vring_ipi_info *ipi,
+					unsigned long long start,
+					unsigned long long limit_ns)
+{
+	do {
+		if (atomic_exchange(&ipi->pending, 0))
+			return 1;
+		_rproc_wait();
+	} while (linux_proc_now_ns() - start < limit_ns);
+	return 0;
+}
+
+/* Sleeps on the pending flag, returns -ETIMEDOUT without a notification */
+static int linux_proc_sleep_notification(struct vring_ipi_info *ipi,
+					 unsigned long long start,
+					 unsigned int timeout_usec)
+{
+	unsigned long long deadline, now;
+	struct timespec rel;
+
+	deadline = start + (unsigned long long)timeout_usec * NS_PER_US;
+	while (!atomic_exchange(&ipi->pending, 0)) {
+		if (timeout_usec != PLATFORM_POLL_WAIT_FOREVER) {
+			now = linux_proc_now_ns();
+			if (now >= deadline)
+				return -ETIMEDOUT;
+			rel.tv_sec = (deadline - now) / NS_PER_S;
+			rel.tv_nsec = (deadline - now) % NS_PER_S;
+		}
+		/* A notification after the exchange fails the wait at once */
+		atomic_fetch_add(&ipi->waiters, 1);
+		syscall(SYS_futex, &ipi->pending, FUTEX_WAIT, 0,
+			timeout_usec != PLATFORM_POLL_WAIT_FOREVER ?
+			&rel : NULL, NULL, 0);
+		atomic_fetch_sub(&ipi->waiters, 1);
+	}
+	return 0;
+}
+
+int platform_poll_timeout(void *priv, unsigned int timeout_usec)
 {
 	struct remoteproc *rproc = priv;
 	struct remoteproc_priv *prproc;
 	struct vring_ipi_info *ipi;
-	unsigned int flags;
+	unsigned long long start, limit;
+	int ret;
 
 	prproc = rproc->priv;
 	ipi = &prproc->ipi;
-	while(1) {
-		flags = metal_irq_save_disable();
-		if (!(atomic_flag_test_and_set(&ipi->sync))) {
-			metal_irq_restore_enable(flags);
-			remoteproc_get_notification(rproc, RSC_NOTIFY_ID_ANY);
-			break;
-		}
-		_rproc_wait();
-		metal_irq_restore_enable(flags);
+	start = linux_proc_now_ns();
+	/* Spin up to the bound while the recent waits averaged below it, a
+	 * longer wait is not worth the CPU time */
+	limit = ipi->busy ? ULLONG_MAX : ipi->spin_max_ns;
+	if (timeout_usec != PLATFORM_POLL_WAIT_FOREVER &&
+	    limit > (unsigned long long)timeout_usec * NS_PER_US)
+		limit = (unsigned long long)timeout_usec * NS_PER_US;
+	if ((ipi->busy || (ipi->spin_max_ns &&
+			   ipi->wait_avg_ns <= ipi->spin_max_ns)) &&
+	    linux_proc_spin_notification(ipi, start, limit)) {
+		ipi->spin_wakeups++;
+	} else {
+		ret = linux_proc_sleep_notification(ipi, start, timeout_usec);
+		if (ret)
+			return ret;
+		ipi->sleep_wakeups++;
 	}
+	/* Average of the last 8 waits or so */
+	ipi->wait_avg_ns = ipi->wait_avg_ns - ipi->wait_avg_ns / 8 +
+			   (linux_proc_now_ns() - start) / 8;
+	remoteproc_get_notification(rproc, RSC_NOTIFY_ID_ANY);
 	return 0;
 }
 
+int platform_poll(void *priv)
+{
+	return platform_poll_timeout(priv, PLATFORM_POLL_WAIT_FOREVER);
+}
+
+void platform_set_poll_spin(void *platform, unsigned int max_spin_usec)
+{
+	struct remoteproc *rproc = platform;
+	struct remoteproc_priv *prproc;
+
+	prproc = rproc->priv;
+	prproc->ipi.busy = max_spin_usec == PLATFORM_POLL_BUSY;
+	prproc->ipi.spin_max_ns = (unsigned long)max_spin_usec * NS_PER_US;
+	prproc->ipi.wait_avg_ns = 0;
+}
+
+void platform_get_poll_stats(void *platform, unsigned long *spin_wakeups,
+			     unsigned long *sleep_wakeups)
+{
+	struct remoteproc *rproc = platform;
+	struct remoteproc_priv *prproc;
+
+	prproc = rproc->priv;
+	*spin_wakeups = prproc->ipi.spin_wakeups;
+	*sleep_wakeups = prproc->ipi.sleep_wakeups;
+}
+
+unsigned long platform_get_notifications(void *platform)
+{
+	struct remoteproc *rproc = platform;
+	struct remoteproc_priv *prproc;
+
+	prproc = rproc->priv;
+	return prproc->ipi.notified;
+}
+
 void platform_release_rpmsg_vdev(struct rpmsg_device *rpdev, void *platform)
 {
 	struct rpmsg_virtio_device *rpvdev;
@@ -18,10 +18,17 @@
 extern "C" {
 #endif
 
+/* Timeout of platform_poll_timeout() waiting until a notification */
+#define PLATFORM_POLL_WAIT_FOREVER	((unsigned int)-1)
+/* Spin bound of platform_set_poll_spin() which never sleeps */
+#define PLATFORM_POLL_BUSY		((unsigned int)-1)
+
 /**
  * platform_init - initialize the platform
  *
- * It will initialize the platform.
+ * It will initialize the platform. The arguments are the processor index,
+ * the resource table id, the vring depth and the rpmsg buffer size, all
+ * optional. Both sides have to get the same vring depth and buffer size.
  *
  * @argc: number of arguments
  * @argv: array of the input arguements
@@ -31,6 +38,18 @@ extern "C" {
  */
 int platform_init(int argc, char *argv[], void **platform);
 
+/**
+ * platform_set_shm_pa - set the physical address of the shared memory
+ *
+ * The vring and buffer addresses in the shared memory are physical
+ * addresses, 0 unless a peer expects its own memory map, e.g. a firmware
+ * which places its shared memory at a fixed device address. Both sides
+ * have to set the same address before platform_init().
+ *
+ * @pa: physical address of the start of the shared memory
+ */
+void platform_set_shm_pa(metal_phys_addr_t pa);
+
 /**
  * platform_create_rpmsg_vdev - create rpmsg vdev
  *
@@ -55,12 +74,59 @@ platform_create_rpmsg_vdev(void *platform, unsigned int vdev_index,
 /**
  * platform_poll - platform poll function
  *
+ * It waits for a notification of the peer and processes the vrings. The
+ * wait sleeps on a futex unless platform_set_poll_spin() allows spinning.
+ *
  * @platform: pointer to the platform
  *
  * return negative value for errors, otherwise 0.
  */
 int platform_poll(void *platform);
 
+/**
+ * platform_poll_timeout - platform poll function with a timeout
+ *
+ * @platform: pointer to the platform
+ * @timeout_usec: longest wait for a notification in us, or
+ *                PLATFORM_POLL_WAIT_FOREVER
+ *
+ * return 0 after processing a notification, -ETIMEDOUT without one.
+ */
+int platform_poll_timeout(void *platform, unsigned int timeout_usec);
+
+/**
+ * platform_set_poll_spin - spin before platform_poll() sleeps
+ *
+ * A notification taken while spinning saves the futex wake-up of the
+ * sleep. The poll spins up to max_spin_usec as long as the recent waits
+ * for a notification averaged below that bound, so an idle peer costs no
+ * CPU time. PLATFORM_POLL_BUSY spins without sleeping, 0 (the default)
+ * sleeps at once.
+ *
+ * @platform: pointer to the platform
+ * @max_spin_usec: spin bound in us
+ */
+void platform_set_poll_spin(void *platform, unsigned int max_spin_usec);
+
+/**
+ * platform_get_poll_stats - notifications taken by platform_poll()
+ *
+ * @platform: pointer to the platform
+ * @spin_wakeups: notifications taken while spinning
+ * @sleep_wakeups: notifications taken after sleeping
+ */
+void platform_get_poll_stats(void *platform, unsigned long *spin_wakeups,
+			     unsigned long *sleep_wakeups);
+
+/**
+ * platform_get_notifications - number of notifications sent to the peer
+ *
+ * @platform: pointer to the platform
+ *
+ * return number of vring notifications sent since platform_init()
+ */
+unsigned long platform_get_notifications(void *platform);
+
 /**
  * platform_release_rpmsg_vdev - release rpmsg virtio device
  *
@@ -9,17 +9,16 @@
 /* This file populates resource table for BM remote
  * for use by the Linux Master */
 
+#include <errno.h>
 #include <openamp/open_amp.h>
 #include "rsc_table.h"
 
-#define RPMSG_IPU_C0_FEATURES        1
+#define RPMSG_IPU_C0_FEATURES        (1 << VIRTIO_RPMSG_F_NS | \
+				      1 << VIRTIO_RPMSG_F_BUFSZ)
 
 /* VirtIO rpmsg device id */
 #define VIRTIO_ID_RPMSG_             7
 
-/* Remote supports Name Service announcement */
-#define VIRTIO_RPMSG_F_NS           0
-
 #define NUM_VRINGS                  0x02
 #define VRING_ALIGN                 0x1000
 #define RING_TX                     0x00004000
@@ -44,18 +43,40 @@ struct remote_resource_table resources = {
 
 	/* Virtio device entry */
 	{
-	 RSC_VDEV, VIRTIO_ID_RPMSG_, 0, RPMSG_IPU_C0_FEATURES, 0, 0, 0,
-	 NUM_VRINGS, {0, 0},
+	 RSC_VDEV, VIRTIO_ID_RPMSG_, 0, RPMSG_IPU_C0_FEATURES, 0,
+	 sizeof(struct virtio_rpmsg_config), 0, NUM_VRINGS, {0, 0},
 	 },
 
 	/* Vring rsc entry - part of vdev rsc entry */
 	{RING_TX, VRING_ALIGN, VRING_SIZE, 1, 0},
 	{RING_RX, VRING_ALIGN, VRING_SIZE, 2, 0},
+
+	/* Config space - part of vdev rsc entry */
+	{RPMSG_BUFFER_SIZE, RPMSG_BUFFER_SIZE},
 };
 
 void *get_resource_table (int rsc_id, int *len)
 {
-	(void) rsc_id;
+	/* RSC_ID_EVENT_IDX also offers the vring event index */
+	if (rsc_id == RSC_ID_EVENT_IDX)
+		resources.rpmsg_vdev.dfeatures |= VIRTIO_RING_F_EVENT_IDX;
 	*len = sizeof(resources);
 	return &resources;
 }
+
+int set_resource_table_buffers(void *rsc_table, unsigned int vring_num,
+			       unsigned int buf_size)
+{
+	struct remote_resource_table *table = rsc_table;
+
+	/* Each vring has as much room as the tx one before the rx one */
+	if (!vring_num || vring_num & (vring_num - 1) ||
+	    (unsigned int)vring_size(vring_num, VRING_ALIGN) >
+	    RING_RX - RING_TX)
+		return -EINVAL;
+	table->rpmsg_vring0.num = vring_num;
+	table->rpmsg_vring1.num = vring_num;
+	table->rpmsg_config.h2r_buf_size = buf_size;
+	table->rpmsg_config.r2h_buf_size = buf_size;
+	return 0;
+}
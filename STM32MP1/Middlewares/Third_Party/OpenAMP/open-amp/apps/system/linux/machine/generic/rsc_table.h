@@ -21,6 +21,10 @@ extern "C" {
 
 #define NO_RESOURCE_ENTRIES         1
 
+/* Resource table ids of get_resource_table(), the third argument of the apps */
+#define RSC_ID_DEFAULT              0
+#define RSC_ID_EVENT_IDX            1
+
 /* Resource table for the given remote */
 struct remote_resource_table {
 	unsigned int version;
@@ -31,10 +35,24 @@ struct remote_resource_table {
 	struct fw_rsc_vdev rpmsg_vdev;
 	struct fw_rsc_vdev_vring rpmsg_vring0;
 	struct fw_rsc_vdev_vring rpmsg_vring1;
+	/* rpmsg vdev config space */
+	struct virtio_rpmsg_config rpmsg_config;
 };
 
 void *get_resource_table (int rsc_id, int *len);
 
+/**
+ * set_resource_table_buffers - set the vring depth and the buffer size
+ *
+ * @rsc_table: resource table returned by get_resource_table()
+ * @vring_num: number of descriptors of each vring, a power of 2
+ * @buf_size: size of the rpmsg buffers of both directions
+ *
+ * return 0 for success, -EINVAL if the vrings do not fit their room
+ */
+int set_resource_table_buffers(void *rsc_table, unsigned int vring_num,
+			       unsigned int buf_size);
+
 #if defined __cplusplus
 }
 #endif
@@ -0,0 +1,232 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* This is a throughput benchmark of the batched nocopy send.
+ * The remote (proc 0) sends small messages to the master (proc 1) as fast
+ * as tx buffers are available, once with rpmsg_send_nocopy() and a kick per
+ * message and then with rpmsg_batch_commit() and one kick per batch. It
+ * reports messages/s and notifications per message of each round.
+ */
+
+#include <string.h>
+#include <time.h>
+#include <metal/cpu.h>
+#include "rpmsg-bench.h"
+
+#define BENCH_DATA	1
+#define BENCH_END	2
+#define BENCH_REPORT	3
+#define BENCH_SHUTDOWN	4
+
+/* Size of a data message, about one binary CAN record batch entry */
+#define BENCH_MSG_SIZE	64
+#define BENCH_MSG_NUM	100000
+
+struct bench_msg {
+	uint32_t type;
+	uint32_t seq;
+	uint32_t received;
+	uint32_t errors;
+};
+
+/* Messages per kick, 1 is the rpmsg_send_nocopy() reference */
+static const int batch_sizes[] = { 1, 2, 4, 8, RPMSG_BATCH_SIZE };
+
+/* Globals */
+static struct bench_msg report;
+static int report_received = 0;
+static int shutdown_req = 0;
+static uint32_t expected_seq = 0;
+static uint32_t received = 0;
+static uint32_t err_cnt = 0;
+
+/*-----------------------------------------------------------------------------*
+ *  RPMSG endpoint callbacks
+ *-----------------------------------------------------------------------------*/
+static int rpmsg_sender_cb(struct rpmsg_endpoint *ept, void *data, size_t len,
+			   uint32_t src, void *priv)
+{
+	struct bench_msg *msg = data;
+
+	(void)ept;
+	(void)src;
+	(void)priv;
+
+	if (len >= sizeof(*msg) && msg->type == BENCH_REPORT) {
+		report = *msg;
+		report_received = 1;
+	}
+	return RPMSG_SUCCESS;
+}
+
+static int rpmsg_sink_cb(struct rpmsg_endpoint *ept, void *data, size_t len,
+			 uint32_t src, void *priv)
+{
+	struct bench_msg *msg = data;
+	struct bench_msg reply;
+
+	(void)src;
+	(void)priv;
+
+	if (len < sizeof(*msg)) {
+		err_cnt++;
+		return RPMSG_SUCCESS;
+	}
+	switch (msg->type) {
+	case BENCH_DATA:
+		/* Batches must arrive complete and in order */
+		if (msg->seq != expected_seq || len != BENCH_MSG_SIZE)
+			err_cnt++;
+		expected_seq = msg->seq + 1;
+		received++;
+		break;
+	case BENCH_END:
+		memset(&reply, 0, sizeof(reply));
+		reply.type = BENCH_REPORT;
+		reply.received = received;
+		reply.errors = err_cnt;
+		if (rpmsg_send(ept, &reply, sizeof(reply)) < 0)
+			LPERROR("Failed to send report.\r\n");
+		expected_seq = 0;
+		received = 0;
+		err_cnt = 0;
+		break;
+	case BENCH_SHUTDOWN:
+		shutdown_req = 1;
+		break;
+	default:
+		err_cnt++;
+		break;
+	}
+	return RPMSG_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------*
+ *  Application
+ *-----------------------------------------------------------------------------*/
+static int send_round(int batch_size)
+{
+	struct rpmsg_batch batch;
+	struct bench_msg end;
+	struct bench_msg *msg;
+	struct timespec start, stop;
+	unsigned long notified;
+	uint32_t seq, len;
+	double elapsed;
+	int ret;
+
+	ret = rpmsg_batch_begin(&lept, &batch);
+	if (ret)
+		return ret;
+	report_received = 0;
+	notified = platform_get_notifications(platform);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (seq = 0; seq < BENCH_MSG_NUM && !ept_deleted; ) {
+		msg = rpmsg_get_tx_payload_buffer(&lept, &len, 0);
+		if (!msg) {
+			/* The master holds all buffers, send the collected
+			 * ones. Returned tx buffers are not notified to the
+			 * remote, so spin as rpmsg_send() does. */
+			ret = rpmsg_batch_commit(&batch);
+			if (ret < 0)
+				return ret;
+			metal_cpu_yield();
+			continue;
+		}
+		if (len < BENCH_MSG_SIZE) {
+			LPERROR("Buffer size %u too small.\r\n", len);
+			return RPMSG_ERR_BUFF_SIZE;
+		}
+		memset(msg, 0xA5, BENCH_MSG_SIZE);
+		msg->type = BENCH_DATA;
+		msg->seq = seq;
+		if (batch_size == 1) {
+			ret = rpmsg_send_nocopy(&lept, msg, BENCH_MSG_SIZE);
+		} else {
+			ret = rpmsg_batch_add(&batch, msg, BENCH_MSG_SIZE);
+			if (!ret && batch.num == batch_size)
+				ret = rpmsg_batch_commit(&batch);
+		}
+		if (ret < 0)
+			return ret;
+		seq++;
+	}
+	ret = rpmsg_batch_commit(&batch);
+	if (ret < 0)
+		return ret;
+
+	memset(&end, 0, sizeof(end));
+	end.type = BENCH_END;
+	ret = rpmsg_send(&lept, &end, sizeof(end));
+	if (ret < 0)
+		return ret;
+	while (!report_received && !ept_deleted)
+		platform_poll(platform);
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+	if (ept_deleted)
+		return RPMSG_ERR_DEV_STATE;
+
+	notified = platform_get_notifications(platform) - notified;
+	elapsed = (double)(stop.tv_sec - start.tv_sec) +
+		  (double)(stop.tv_nsec - start.tv_nsec) / 1e9;
+	LPRINTF("batch %2d: %u messages in %.3f s, %.0f messages/s, "
+		"%.3f notifications/message\r\n", batch_size,
+		(unsigned int)report.received, elapsed,
+		report.received / elapsed,
+		(double)notified / BENCH_MSG_NUM);
+	if (report.received != BENCH_MSG_NUM || report.errors) {
+		LPERROR("%u messages received, %u errors\r\n",
+			(unsigned int)report.received,
+			(unsigned int)report.errors);
+		return RPMSG_ERR_PARAM;
+	}
+	return 0;
+}
+
+static int send_app(void)
+{
+	struct bench_msg shutdown;
+	unsigned int i;
+	int ret = 0;
+
+	LPRINTF("%d messages of %d bytes per round\r\n", BENCH_MSG_NUM,
+		BENCH_MSG_SIZE);
+	for (i = 0; i < sizeof(batch_sizes) / sizeof(batch_sizes[0]); i++) {
+		ret = send_round(batch_sizes[i]);
+		if (ret) {
+			LPERROR("Round with batch %d failed: %d\r\n",
+				batch_sizes[i], ret);
+			break;
+		}
+	}
+
+	memset(&shutdown, 0, sizeof(shutdown));
+	shutdown.type = BENCH_SHUTDOWN;
+	(void)rpmsg_send(&lept, &shutdown, sizeof(shutdown));
+	return ret;
+}
+
+static int app(struct rpmsg_device *rdev, unsigned long proc_id)
+{
+	int ret;
+
+	ret = bench_create_ept(rdev, proc_id,
+			       proc_id ? rpmsg_sink_cb : rpmsg_sender_cb);
+	if (ret)
+		return ret;
+	if (proc_id) {
+		while (!shutdown_req && !ept_deleted)
+			platform_poll(platform);
+	} else {
+		ret = send_app();
+	}
+	rpmsg_destroy_ept(&lept);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	return bench_main(argc, argv, app);
+}
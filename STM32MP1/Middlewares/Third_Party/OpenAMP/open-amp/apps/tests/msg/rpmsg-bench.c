@@ -0,0 +1,110 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Common setup of the benchmarks, see rpmsg-bench.h */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "rpmsg-bench.h"
+
+/* Sent by the master to let the remote know its address */
+static const char bench_bind[] = "bench-bind";
+
+/* Globals */
+struct rpmsg_endpoint lept;
+void *platform;
+int ept_deleted = 0;
+static rpmsg_ept_cb bench_cb;
+
+/*-----------------------------------------------------------------------------*
+ *  RPMSG endpoint callbacks
+ *-----------------------------------------------------------------------------*/
+static int rpmsg_endpoint_cb(struct rpmsg_endpoint *ept, void *data,
+			     size_t len, uint32_t src, void *priv)
+{
+	/* The bind message only sets the destination of the remote */
+	if (len == sizeof(bench_bind) && !memcmp(data, bench_bind, len))
+		return RPMSG_SUCCESS;
+	return bench_cb(ept, data, len, src, priv);
+}
+
+static void rpmsg_service_unbind(struct rpmsg_endpoint *ept)
+{
+	(void)ept;
+	ept_deleted = 1;
+}
+
+/*-----------------------------------------------------------------------------*
+ *  Application
+ *-----------------------------------------------------------------------------*/
+int bench_create_ept(struct rpmsg_device *rdev, unsigned long proc_id,
+		     rpmsg_ept_cb cb)
+{
+	int ret;
+
+	bench_cb = cb;
+	ret = rpmsg_create_ept(&lept, rdev, RPMSG_SERVICE_NAME,
+			       proc_id ? APP_EPT_ADDR : RPMSG_ADDR_ANY,
+			       RPMSG_ADDR_ANY, rpmsg_endpoint_cb,
+			       rpmsg_service_unbind);
+	if (ret) {
+		LPERROR("Failed to create endpoint.\r\n");
+		return ret;
+	}
+	while (!is_rpmsg_ept_ready(&lept) && !ept_deleted)
+		platform_poll(platform);
+
+	ret = ept_deleted ? RPMSG_ERR_DEV_STATE : 0;
+	if (!ret && proc_id)
+		ret = rpmsg_send(&lept, bench_bind, sizeof(bench_bind));
+	if (ret < 0) {
+		LPERROR("Failed to bind the endpoint: %d\r\n", ret);
+		rpmsg_destroy_ept(&lept);
+		return ret;
+	}
+	return 0;
+}
+
+unsigned long long bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int bench_main(int argc, char *argv[], bench_app_t app)
+{
+	struct rpmsg_device *rpdev;
+	unsigned long proc_id = 0;
+	int ret;
+
+	if (argc >= 2)
+		proc_id = strtoul(argv[1], NULL, 0);
+
+	/* Initialize platform */
+	ret = platform_init(argc, argv, &platform);
+	if (ret) {
+		LPERROR("Failed to initialize platform.\r\n");
+		ret = -1;
+	} else {
+		rpdev = platform_create_rpmsg_vdev(platform, 0,
+						   proc_id ? VIRTIO_DEV_MASTER :
+						   VIRTIO_DEV_SLAVE,
+						   NULL, NULL);
+		if (!rpdev) {
+			LPERROR("Failed to create rpmsg virtio device.\r\n");
+			ret = -1;
+		} else {
+			ret = app(rpdev, proc_id);
+			platform_release_rpmsg_vdev(rpdev, platform);
+		}
+	}
+
+	LPRINTF("Stopping application...\r\n");
+	platform_cleanup(platform);
+
+	return ret ? -1 : 0;
+}
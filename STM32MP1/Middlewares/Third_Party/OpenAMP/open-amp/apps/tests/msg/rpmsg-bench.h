@@ -0,0 +1,78 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Common setup of the benchmarks between two processes on the Linux generic
+ * platform. Each benchmark runs as a remote (proc 0) and a master (proc 1)
+ * sharing the openamp.shm memory, the remote first:
+ *   msg-test-rpmsg-<name>-static 0 &
+ *   msg-test-rpmsg-<name>-static 1
+ * Further arguments go to platform_init().
+ */
+
+#ifndef RPMSG_BENCH_H
+#define RPMSG_BENCH_H
+
+#include <stdio.h>
+#include <openamp/open_amp.h>
+#include "platform_info.h"
+#include "rpmsg-ping.h"
+
+#define APP_EPT_ADDR    1024
+#define LPRINTF(format, ...) printf(format, ##__VA_ARGS__)
+#define LPERROR(format, ...) LPRINTF("ERROR: " format, ##__VA_ARGS__)
+
+/* Endpoint of the benchmark service */
+extern struct rpmsg_endpoint lept;
+/* Platform of platform_init() */
+extern void *platform;
+/* The peer destroyed its endpoint */
+extern int ept_deleted;
+
+/**
+ * bench_app_t - benchmark run on the rpmsg device
+ *
+ * @rdev: rpmsg device of the platform
+ * @proc_id: 0 on the remote, 1 on the master
+ *
+ * return 0 for success or negative value for failure
+ */
+typedef int (*bench_app_t)(struct rpmsg_device *rdev, unsigned long proc_id);
+
+/**
+ * bench_main - run a benchmark
+ *
+ * It initializes the platform and the rpmsg virtio device of the role of the
+ * first argument, runs the benchmark, then releases them.
+ *
+ * @argc: number of arguments of main()
+ * @argv: arguments of main()
+ * @app: benchmark
+ *
+ * return the exit code of main()
+ */
+int bench_main(int argc, char *argv[], bench_app_t app);
+
+/**
+ * bench_create_ept - create the endpoint of the benchmark service
+ *
+ * It creates lept, at APP_EPT_ADDR on the master, and waits until the peers
+ * know the address of each other: the master sends a bind message to the
+ * remote once the name service announcement is in, the remote waits for
+ * it. The bind message does not reach @cb.
+ *
+ * @rdev: rpmsg device
+ * @proc_id: 0 on the remote, 1 on the master
+ * @cb: endpoint callback of the benchmark
+ *
+ * return 0 for success or negative value for failure
+ */
+int bench_create_ept(struct rpmsg_device *rdev, unsigned long proc_id,
+		     rpmsg_ept_cb cb);
+
+/**
+ * bench_now_ns - CLOCK_MONOTONIC in ns, the same in both processes
+ */
+unsigned long long bench_now_ns(void);
+
+#endif /* RPMSG_BENCH_H */
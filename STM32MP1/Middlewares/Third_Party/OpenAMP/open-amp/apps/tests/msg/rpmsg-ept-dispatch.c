@@ -0,0 +1,262 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* This is a benchmark of the receive dispatch cost versus the number of
+ * endpoints. For each round the master (proc 1) creates filler endpoints
+ * and then a target endpoint, the last one registered. The remote (proc 0)
+ * sends messages to the target as fast as tx buffers are available. The
+ * master measures the time between the callbacks of two messages handled
+ * in the same notification, which is the cost of taking a message from the
+ * vring, looking its endpoint up, the callback and returning the buffer.
+ */
+
+#include <string.h>
+#include <metal/cpu.h>
+#include "rpmsg-bench.h"
+
+#define DSP_ROUND	1
+#define DSP_DATA	2
+#define DSP_END		3
+#define DSP_SHUTDOWN	4
+
+#define DSP_MSG_NUM	50000
+/* Endpoints of the master besides the service one and the target */
+#define DSP_FILLERS_MAX	(RPMSG_ADDR_BMP_SIZE - 2)
+
+struct dsp_msg {
+	uint32_t type;
+	uint32_t seq;
+	uint32_t addr;
+};
+
+/* Endpoints of the master in each round, service and target included */
+static const int ept_counts[] = { 2, 8, 32, 64, RPMSG_ADDR_BMP_SIZE };
+
+/* Globals */
+static struct rpmsg_endpoint target;
+static struct rpmsg_endpoint fillers[DSP_FILLERS_MAX];
+static int shutdown_req = 0;
+/* remote: address of the target of the round, 0 while there is none */
+static uint32_t round_addr = 0;
+/* master */
+static int round_end = 0;
+static uint32_t expected_seq = 0;
+static uint32_t received = 0;
+static uint32_t err_cnt = 0;
+static unsigned long long last_ns = 0;
+static unsigned long long sum_ns = 0;
+static unsigned long sum_num = 0;
+
+/*-----------------------------------------------------------------------------*
+ *  RPMSG endpoint callbacks
+ *-----------------------------------------------------------------------------*/
+static int rpmsg_sender_cb(struct rpmsg_endpoint *ept, void *data, size_t len,
+			   uint32_t src, void *priv)
+{
+	struct dsp_msg *msg = data;
+
+	(void)ept;
+	(void)src;
+	(void)priv;
+
+	if (len < sizeof(*msg))
+		return RPMSG_SUCCESS;
+	if (msg->type == DSP_ROUND)
+		round_addr = msg->addr;
+	else if (msg->type == DSP_SHUTDOWN)
+		shutdown_req = 1;
+	return RPMSG_SUCCESS;
+}
+
+static int rpmsg_control_cb(struct rpmsg_endpoint *ept, void *data,
+			    size_t len, uint32_t src, void *priv)
+{
+	struct dsp_msg *msg = data;
+
+	(void)ept;
+	(void)src;
+	(void)priv;
+
+	if (len >= sizeof(*msg) && msg->type == DSP_END)
+		round_end = 1;
+	else
+		err_cnt++;
+	return RPMSG_SUCCESS;
+}
+
+static int rpmsg_target_cb(struct rpmsg_endpoint *ept, void *data,
+			   size_t len, uint32_t src, void *priv)
+{
+	struct dsp_msg *msg = data;
+	unsigned long long now = bench_now_ns();
+
+	(void)ept;
+	(void)src;
+	(void)priv;
+
+	/* Only the messages after the first of a notification count */
+	if (last_ns) {
+		sum_ns += now - last_ns;
+		sum_num++;
+	}
+	if (len < sizeof(*msg) || msg->type != DSP_DATA ||
+	    msg->seq != expected_seq)
+		err_cnt++;
+	expected_seq++;
+	received++;
+	last_ns = bench_now_ns();
+	return RPMSG_SUCCESS;
+}
+
+static int rpmsg_filler_cb(struct rpmsg_endpoint *ept, void *data,
+			   size_t len, uint32_t src, void *priv)
+{
+	(void)ept;
+	(void)data;
+	(void)len;
+	(void)src;
+	(void)priv;
+
+	err_cnt++;
+	return RPMSG_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------*
+ *  Application
+ *-----------------------------------------------------------------------------*/
+static int send_msg(uint32_t type, uint32_t seq, uint32_t addr)
+{
+	struct dsp_msg msg;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = type;
+	msg.seq = seq;
+	msg.addr = addr;
+	return rpmsg_send(&lept, &msg, sizeof(msg));
+}
+
+/* Master: one round with ept_count endpoints */
+static int receive_round(struct rpmsg_device *rdev, int ept_count)
+{
+	unsigned long long avg;
+	int fillers_num = ept_count - 2;
+	int i, ret;
+
+	for (i = 0; i < fillers_num; i++) {
+		ret = rpmsg_create_ept(&fillers[i], rdev, "", RPMSG_ADDR_ANY,
+				       RPMSG_ADDR_ANY, rpmsg_filler_cb, NULL);
+		if (ret)
+			goto out;
+	}
+	ret = rpmsg_create_ept(&target, rdev, "", RPMSG_ADDR_ANY,
+			       RPMSG_ADDR_ANY, rpmsg_target_cb, NULL);
+	if (ret)
+		goto out;
+
+	round_end = 0;
+	expected_seq = 0;
+	received = 0;
+	sum_ns = 0;
+	sum_num = 0;
+	ret = send_msg(DSP_ROUND, 0, target.addr);
+	while (ret >= 0 && !round_end && !ept_deleted) {
+		last_ns = 0;
+		platform_poll(platform);
+	}
+	rpmsg_destroy_ept(&target);
+	if (ret < 0)
+		goto out;
+
+	avg = sum_num ? sum_ns / sum_num : 0;
+	LPRINTF("%3d endpoints: %lu of %u messages back to back, "
+		"%llu ns per message\r\n", ept_count, sum_num,
+		(unsigned int)received, avg);
+	ret = 0;
+	if (received != DSP_MSG_NUM || err_cnt) {
+		LPERROR("%u messages received, %u errors\r\n",
+			(unsigned int)received, (unsigned int)err_cnt);
+		ret = RPMSG_ERR_PARAM;
+	}
+out:
+	while (i-- > 0)
+		rpmsg_destroy_ept(&fillers[i]);
+	if (ret)
+		LPERROR("Round with %d endpoints failed: %d\r\n", ept_count,
+			ret);
+	return ret;
+}
+
+static int receive_app(struct rpmsg_device *rdev)
+{
+	unsigned int i;
+	int ret = 0;
+
+	LPRINTF("%d messages per round\r\n", DSP_MSG_NUM);
+	for (i = 0; i < sizeof(ept_counts) / sizeof(ept_counts[0]); i++) {
+		ret = receive_round(rdev, ept_counts[i]);
+		if (ret)
+			break;
+	}
+	(void)send_msg(DSP_SHUTDOWN, 0, 0);
+	return ret;
+}
+
+/* Remote: sends the messages of each round to the target */
+static int send_app(void)
+{
+	struct dsp_msg msg;
+	uint32_t seq;
+	int ret;
+
+	while (!shutdown_req && !ept_deleted) {
+		platform_poll(platform);
+		if (!round_addr)
+			continue;
+		memset(&msg, 0, sizeof(msg));
+		msg.type = DSP_DATA;
+		for (seq = 0; seq < DSP_MSG_NUM; ) {
+			msg.seq = seq;
+			ret = rpmsg_trysendto(&lept, &msg, sizeof(msg),
+					      round_addr);
+			if (ret == RPMSG_ERR_NO_BUFF) {
+				/* Let the master take the queued messages */
+				metal_cpu_yield();
+				continue;
+			}
+			if (ret < 0)
+				goto out;
+			seq++;
+		}
+		round_addr = 0;
+		ret = send_msg(DSP_END, 0, 0);
+		if (ret < 0)
+			goto out;
+	}
+	ret = 0;
+out:
+	if (ret)
+		LPERROR("Test failed: %d\r\n", ret);
+	return ret;
+}
+
+static int app(struct rpmsg_device *rdev, unsigned long proc_id)
+{
+	int ret;
+
+	ret = bench_create_ept(rdev, proc_id,
+			       proc_id ? rpmsg_control_cb : rpmsg_sender_cb);
+	if (ret)
+		return ret;
+	if (proc_id)
+		ret = receive_app(rdev);
+	else
+		ret = send_app();
+	rpmsg_destroy_ept(&lept);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	return bench_main(argc, argv, app);
+}
@@ -0,0 +1,194 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* This is a test of the vring event index under load.
+ * The remote (proc 0) sends a burst of messages to the master (proc 1), then
+ * the master sends a burst to the remote. Both sides count the notifications
+ * they raise, the sender prints them per message and the test fails if a
+ * message is lost or out of order. The resource table id, the second
+ * argument of the remote, selects the features it offers:
+ *   msg-test-rpmsg-event-idx-static 0 1 &   (1: with VIRTIO_RING_F_EVENT_IDX)
+ *   msg-test-rpmsg-event-idx-static 1
+ */
+
+#include <string.h>
+#include <metal/cpu.h>
+#include "rpmsg-bench.h"
+
+#define EVT_DATA	1
+#define EVT_END		2
+#define EVT_REPORT	3
+
+#define EVT_MSG_NUM	20000
+
+struct evt_msg {
+	uint32_t type;
+	uint32_t seq;
+	uint32_t received;
+	uint32_t errors;
+	uint32_t notified;
+};
+
+/* Globals */
+static struct evt_msg report;
+static int report_received = 0;
+static int end_received = 0;
+static uint32_t expected_seq = 0;
+static uint32_t received = 0;
+static uint32_t err_cnt = 0;
+static unsigned long notified_start;
+
+/*-----------------------------------------------------------------------------*
+ *  RPMSG endpoint callbacks
+ *-----------------------------------------------------------------------------*/
+static int rpmsg_endpoint_cb(struct rpmsg_endpoint *ept, void *data,
+			     size_t len, uint32_t src, void *priv)
+{
+	struct evt_msg *msg = data;
+
+	(void)ept;
+	(void)src;
+	(void)priv;
+
+	if (len < sizeof(*msg)) {
+		err_cnt++;
+		return RPMSG_SUCCESS;
+	}
+	switch (msg->type) {
+	case EVT_DATA:
+		if (!received)
+			notified_start = platform_get_notifications(platform);
+		if (msg->seq != expected_seq)
+			err_cnt++;
+		expected_seq = msg->seq + 1;
+		received++;
+		break;
+	case EVT_END:
+		end_received = 1;
+		break;
+	case EVT_REPORT:
+		report = *msg;
+		report_received = 1;
+		break;
+	default:
+		err_cnt++;
+		break;
+	}
+	return RPMSG_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------*
+ *  Application
+ *-----------------------------------------------------------------------------*/
+static int send_msg(uint32_t type, uint32_t seq)
+{
+	struct evt_msg msg;
+	int ret;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = type;
+	msg.seq = seq;
+	if (type == EVT_REPORT) {
+		msg.received = received;
+		msg.errors = err_cnt;
+		msg.notified = platform_get_notifications(platform) -
+			       notified_start;
+	}
+	/* Returned tx buffers are not notified, spin as rpmsg_send() does */
+	do {
+		ret = rpmsg_trysend(&lept, &msg, sizeof(msg));
+		if (ret == RPMSG_ERR_NO_BUFF)
+			metal_cpu_yield();
+	} while (ret == RPMSG_ERR_NO_BUFF && !ept_deleted);
+	return ret < 0 ? ret : 0;
+}
+
+/* Sends a burst and prints the notifications of both sides */
+static int send_burst(const char *dir)
+{
+	unsigned long notified;
+	uint32_t seq;
+	int ret;
+
+	report_received = 0;
+	notified = platform_get_notifications(platform);
+	for (seq = 0; seq < EVT_MSG_NUM; seq++) {
+		ret = send_msg(EVT_DATA, seq);
+		if (ret)
+			return ret;
+	}
+	notified = platform_get_notifications(platform) - notified;
+	ret = send_msg(EVT_END, 0);
+	if (ret)
+		return ret;
+	while (!report_received && !ept_deleted)
+		platform_poll(platform);
+	/* The remote destroys its endpoint right after its last report */
+	if (!report_received)
+		return RPMSG_ERR_DEV_STATE;
+
+	LPRINTF("%s: %u messages, %.3f notifications/message by the sender, "
+		"%u by the receiver\r\n", dir, (unsigned int)report.received,
+		(double)notified / EVT_MSG_NUM,
+		(unsigned int)report.notified);
+	if (report.received != EVT_MSG_NUM || report.errors) {
+		LPERROR("%u messages received, %u errors\r\n",
+			(unsigned int)report.received,
+			(unsigned int)report.errors);
+		return RPMSG_ERR_PARAM;
+	}
+	return 0;
+}
+
+/* Receives a burst and reports it to the sender */
+static int receive_burst(void)
+{
+	int ret;
+
+	while (!end_received && !ept_deleted)
+		platform_poll(platform);
+	if (!end_received)
+		return RPMSG_ERR_DEV_STATE;
+	end_received = 0;
+	ret = send_msg(EVT_REPORT, 0);
+	/* The peer's burst may follow in the same rx callback as its report */
+	expected_seq = 0;
+	received = 0;
+	err_cnt = 0;
+	return ret;
+}
+
+static int app(struct rpmsg_device *rdev, unsigned long proc_id)
+{
+	struct rpmsg_virtio_device *rvdev;
+	int ret;
+
+	rvdev = metal_container_of(rdev, struct rpmsg_virtio_device, rdev);
+	LPRINTF("%d messages per burst, event index %s\r\n", EVT_MSG_NUM,
+		rvdev->vdev->features & VIRTIO_RING_F_EVENT_IDX ?
+		"negotiated" : "off");
+
+	ret = bench_create_ept(rdev, proc_id, rpmsg_endpoint_cb);
+	if (ret)
+		return ret;
+
+	if (proc_id) {
+		ret = receive_burst();
+		if (!ret)
+			ret = send_burst("master -> remote");
+	} else {
+		ret = send_burst("remote -> master");
+		if (!ret)
+			ret = receive_burst();
+	}
+	if (ret)
+		LPERROR("Test failed: %d\r\n", ret);
+	rpmsg_destroy_ept(&lept);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	return bench_main(argc, argv, app);
+}
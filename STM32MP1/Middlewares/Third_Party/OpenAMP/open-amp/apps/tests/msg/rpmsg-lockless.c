@@ -0,0 +1,251 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* This is a stress test of the lockless rpmsg virtio device. Both sides
+ * switch their device to single owner virtqueues and send at the same time:
+ * a sender thread owns the send virtqueue and the main thread, which polls
+ * the notifications, owns the receive one. The sender mixes rpmsg_send(),
+ * rpmsg_send_nocopy() and batches, the receiver checks the sequence number
+ * and the pattern of each message and holds some of the rx buffers for a
+ * while. Each side prints its message rate and the number of errors.
+ */
+
+#include <pthread.h>
+#include <string.h>
+#include "rpmsg-bench.h"
+
+#define LL_DATA		1
+#define LL_END		2
+
+/* Messages sent by each side */
+#define LL_MSG_NUM	200000
+/* Every LL_HOLD_EVERY-th rx buffer is held until the next message */
+#define LL_HOLD_EVERY	16
+#define LL_PAYLOAD_MAX	200
+
+struct ll_msg {
+	uint32_t type;
+	uint32_t seq;
+	uint32_t len;
+	uint8_t data[];
+};
+
+/* Globals */
+static pthread_t sender;
+static int peer_end = 0;
+static int send_ret = 0;
+static void *held_buf = NULL;
+static uint32_t expected_seq = 0;
+static uint32_t received = 0;
+static uint32_t err_cnt = 0;
+
+/* Payload length of message seq, the messages take 12 to 211 bytes */
+static uint32_t msg_payload_len(uint32_t seq)
+{
+	return (seq * 7) % LL_PAYLOAD_MAX;
+}
+
+static void msg_fill(struct ll_msg *msg, uint32_t seq)
+{
+	uint32_t i;
+
+	msg->type = LL_DATA;
+	msg->seq = seq;
+	msg->len = msg_payload_len(seq);
+	for (i = 0; i < msg->len; i++)
+		msg->data[i] = (uint8_t)(seq + i);
+}
+
+static int msg_check(const struct ll_msg *msg, size_t len)
+{
+	uint32_t i;
+
+	if (len < sizeof(*msg) || msg->type != LL_DATA ||
+	    msg->seq != expected_seq || msg->len != msg_payload_len(msg->seq) ||
+	    len != sizeof(*msg) + msg->len)
+		return -1;
+	for (i = 0; i < msg->len; i++) {
+		if (msg->data[i] != (uint8_t)(msg->seq + i))
+			return -1;
+	}
+	return 0;
+}
+
+/*-----------------------------------------------------------------------------*
+ *  RPMSG endpoint callbacks, run in the main thread
+ *-----------------------------------------------------------------------------*/
+static int rpmsg_endpoint_cb(struct rpmsg_endpoint *ept, void *data,
+			     size_t len, uint32_t src, void *priv)
+{
+	struct ll_msg *msg = data;
+
+	(void)src;
+	(void)priv;
+
+	/* Buffers are only released from the receive context */
+	if (held_buf) {
+		rpmsg_release_rx_buffer(ept, held_buf);
+		held_buf = NULL;
+	}
+	if (len < sizeof(*msg)) {
+		err_cnt++;
+		return RPMSG_SUCCESS;
+	}
+	if (msg->type == LL_END) {
+		if (msg->seq != LL_MSG_NUM || expected_seq != LL_MSG_NUM)
+			err_cnt++;
+		peer_end = 1;
+	} else {
+		if (msg_check(msg, len))
+			err_cnt++;
+		expected_seq = msg->seq + 1;
+		received++;
+		if (!(msg->seq % LL_HOLD_EVERY)) {
+			rpmsg_hold_rx_buffer(ept, data);
+			held_buf = data;
+		}
+	}
+	return RPMSG_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------*
+ *  Sender thread, the only one which sends once it runs
+ *-----------------------------------------------------------------------------*/
+static int send_copy(uint32_t seq)
+{
+	uint8_t buf[sizeof(struct ll_msg) + LL_PAYLOAD_MAX];
+	struct ll_msg *msg = (struct ll_msg *)buf;
+
+	msg_fill(msg, seq);
+	return rpmsg_send(&lept, msg, sizeof(*msg) + msg->len);
+}
+
+static int send_nocopy(uint32_t seq)
+{
+	struct ll_msg *msg;
+	uint32_t size;
+
+	msg = rpmsg_get_tx_payload_buffer(&lept, &size, 1);
+	if (!msg)
+		return RPMSG_ERR_NO_BUFF;
+	msg_fill(msg, seq);
+	return rpmsg_send_nocopy(&lept, msg, sizeof(*msg) + msg->len);
+}
+
+/* Sends the messages from seq on in batches, returns the number sent */
+static int send_batch(uint32_t seq, uint32_t num)
+{
+	struct rpmsg_batch batch;
+	struct ll_msg *msg;
+	uint32_t size, i;
+	int ret;
+
+	ret = rpmsg_batch_begin(&lept, &batch);
+	for (i = 0; ret >= 0 && i < num && !rpmsg_batch_is_full(&batch); i++) {
+		msg = rpmsg_get_tx_payload_buffer(&lept, &size, 1);
+		if (!msg) {
+			ret = RPMSG_ERR_NO_BUFF;
+			break;
+		}
+		msg_fill(msg, seq + i);
+		ret = rpmsg_batch_add(&batch, msg, sizeof(*msg) + msg->len);
+	}
+	if (ret >= 0)
+		ret = rpmsg_batch_commit(&batch);
+	return ret < 0 ? ret : (int)i;
+}
+
+static void *sender_thread(void *arg)
+{
+	struct ll_msg msg;
+	uint32_t seq = 0;
+	int ret = 0;
+
+	(void)arg;
+	while (seq < LL_MSG_NUM) {
+		switch (seq % 3) {
+		case 0:
+			ret = send_copy(seq);
+			seq++;
+			break;
+		case 1:
+			ret = send_nocopy(seq);
+			seq++;
+			break;
+		default:
+			ret = send_batch(seq, LL_MSG_NUM - seq);
+			if (ret > 0)
+				seq += ret;
+			break;
+		}
+		if (ret < 0)
+			break;
+	}
+	if (ret >= 0) {
+		memset(&msg, 0, sizeof(msg));
+		msg.type = LL_END;
+		msg.seq = seq;
+		ret = rpmsg_send(&lept, &msg, sizeof(msg));
+	}
+	send_ret = ret < 0 ? ret : 0;
+	return NULL;
+}
+
+/*-----------------------------------------------------------------------------*
+ *  Application
+ *-----------------------------------------------------------------------------*/
+static int app(struct rpmsg_device *rdev, unsigned long proc_id)
+{
+	struct rpmsg_virtio_device *rvdev;
+	unsigned long long start, ns;
+	int ret;
+
+	ret = bench_create_ept(rdev, proc_id, rpmsg_endpoint_cb);
+	if (ret)
+		return ret;
+
+	/* From here on the sender thread is the only one to send */
+	rvdev = metal_container_of(rdev, struct rpmsg_virtio_device, rdev);
+	rpmsg_virtio_set_lockless(rvdev, 1);
+
+	start = bench_now_ns();
+	ret = pthread_create(&sender, NULL, sender_thread, NULL);
+	if (ret) {
+		LPERROR("Failed to start the sender thread.\r\n");
+		ret = -1;
+		goto out;
+	}
+	/* The peer keeps receiving until it has our end message, the
+	 * sender therefore always gets its tx buffers back.
+	 */
+	while (!peer_end && !ept_deleted)
+		platform_poll(platform);
+	pthread_join(sender, NULL);
+	ns = bench_now_ns() - start;
+
+	if (held_buf) {
+		rpmsg_release_rx_buffer(&lept, held_buf);
+		held_buf = NULL;
+	}
+	rpmsg_virtio_set_lockless(rvdev, 0);
+
+	LPRINTF("result: sent %d received %u messages in %llu ms, "
+		"%.0f msgs/s each way, %u errors\r\n", LL_MSG_NUM,
+		(unsigned int)received, ns / 1000000ULL,
+		ns ? (double)received * 1e9 / ns : 0.0,
+		(unsigned int)err_cnt);
+	ret = send_ret;
+	if (!ret && (received != LL_MSG_NUM || err_cnt || !peer_end))
+		ret = RPMSG_ERR_PARAM;
+out:
+	if (ret)
+		LPERROR("Test failed: %d\r\n", ret);
+	rpmsg_destroy_ept(&lept);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	return bench_main(argc, argv, app);
+}
@@ -0,0 +1,304 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* This is a ping-pong benchmark of the wait for a notification in
+ * platform_poll(). The master (proc 1) sends a ping after an idle gap, the
+ * remote (proc 0) answers with a pong stamped with the time its callback
+ * ran. Both sides wait in one of three modes set with
+ * platform_set_poll_spin(): busy spinning, blocking on the futex and
+ * adaptive spinning before the futex. Per mode the benchmark reports the
+ * wake-up latency (ping sent to remote callback), the round trip, the CPU
+ * time of each side and the notifications taken while spinning or after
+ * sleeping.
+ */
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "rpmsg-bench.h"
+
+#define PB_MODE		1
+#define PB_PING		2
+#define PB_PONG		3
+#define PB_DONE		4
+#define PB_END		5
+
+#define PB_MODE_BUSY	0
+#define PB_MODE_BLOCK	1
+#define PB_MODE_ADAPT	2
+#define PB_MODE_NUM	3
+
+/* Pings per mode */
+#define PB_PING_NUM	500
+/* Idle time of the master before each ping */
+#define PB_IDLE_USEC	1000
+/* Spin bound of the adaptive mode */
+#define PB_ADAPT_USEC	50
+
+struct pb_msg {
+	uint32_t type;
+	uint32_t seq;
+	uint32_t mode;
+	uint32_t spin_wakeups;
+	uint32_t sleep_wakeups;
+	uint32_t reserved;
+	uint64_t time_ns;
+	uint64_t cpu_ns;
+};
+
+/* Poll statistics of one side over one mode */
+struct pb_side {
+	unsigned long long wall_ns;
+	unsigned long long cpu_ns;
+	unsigned long spin_wakeups;
+	unsigned long sleep_wakeups;
+};
+
+static const char *const mode_names[PB_MODE_NUM] = { "busy spin",
+						     "blocking",
+						     "adaptive spin" };
+static const unsigned int mode_spin[PB_MODE_NUM] = { PLATFORM_POLL_BUSY, 0,
+						     PB_ADAPT_USEC };
+
+/* Globals */
+static struct pb_msg reply;
+static int reply_received = 0;
+static int is_master = 0;
+static struct pb_side remote_start;
+static int end_received = 0;
+static uint32_t err_cnt = 0;
+
+/* Includes the IPI thread of the platform */
+static unsigned long long cpu_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void side_sample(struct pb_side *side)
+{
+	side->wall_ns = bench_now_ns();
+	side->cpu_ns = cpu_ns();
+	platform_get_poll_stats(platform, &side->spin_wakeups,
+				&side->sleep_wakeups);
+}
+
+static void side_since(struct pb_side *side, const struct pb_side *start)
+{
+	side_sample(side);
+	side->wall_ns -= start->wall_ns;
+	side->cpu_ns -= start->cpu_ns;
+	side->spin_wakeups -= start->spin_wakeups;
+	side->sleep_wakeups -= start->sleep_wakeups;
+}
+
+static int send_msg(uint32_t type, uint32_t seq, uint32_t mode,
+		    const struct pb_side *side)
+{
+	struct pb_msg msg;
+	int ret;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = type;
+	msg.seq = seq;
+	msg.mode = mode;
+	msg.time_ns = bench_now_ns();
+	if (side) {
+		msg.cpu_ns = side->cpu_ns;
+		msg.spin_wakeups = side->spin_wakeups;
+		msg.sleep_wakeups = side->sleep_wakeups;
+	}
+	ret = rpmsg_send(&lept, &msg, sizeof(msg));
+	return ret < 0 ? ret : 0;
+}
+
+/*-----------------------------------------------------------------------------*
+ *  RPMSG endpoint callbacks
+ *-----------------------------------------------------------------------------*/
+static int rpmsg_endpoint_cb(struct rpmsg_endpoint *ept, void *data,
+			     size_t len, uint32_t src, void *priv)
+{
+	struct pb_msg *msg = data;
+	struct pb_side side;
+
+	(void)ept;
+	(void)src;
+	(void)priv;
+
+	if (len < sizeof(*msg)) {
+		err_cnt++;
+		return RPMSG_SUCCESS;
+	}
+	if (is_master) {
+		/* The answer of the remote */
+		reply = *msg;
+		reply_received = 1;
+		return RPMSG_SUCCESS;
+	}
+	switch (msg->type) {
+	case PB_MODE:
+		/* Waits the way of the mode from now on */
+		if (msg->mode >= PB_MODE_NUM) {
+			err_cnt++;
+			break;
+		}
+		platform_set_poll_spin(platform, mode_spin[msg->mode]);
+		side_sample(&remote_start);
+		if (send_msg(PB_MODE, 0, msg->mode, NULL))
+			err_cnt++;
+		break;
+	case PB_PING:
+		/* The pong carries the time this callback ran */
+		if (send_msg(PB_PONG, msg->seq, msg->mode, NULL))
+			err_cnt++;
+		break;
+	case PB_DONE:
+		/* Reports the remote side of the mode */
+		side_since(&side, &remote_start);
+		if (send_msg(PB_DONE, 0, msg->mode, &side))
+			err_cnt++;
+		break;
+	case PB_END:
+		end_received = 1;
+		break;
+	default:
+		err_cnt++;
+		break;
+	}
+	return RPMSG_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------*
+ *  Application
+ *-----------------------------------------------------------------------------*/
+/* Master: sends a message and waits for the answer of the remote */
+static int request(uint32_t type, uint32_t seq, uint32_t mode,
+		   unsigned long long *sent_ns)
+{
+	int ret;
+
+	reply_received = 0;
+	*sent_ns = bench_now_ns();
+	ret = send_msg(type, seq, mode, NULL);
+	if (ret)
+		return ret;
+	while (!reply_received && !ept_deleted)
+		platform_poll(platform);
+	if (!reply_received)
+		return RPMSG_ERR_DEV_STATE;
+	if (reply.type != (type == PB_PING ? PB_PONG : type) ||
+	    reply.seq != seq || reply.mode != mode) {
+		err_cnt++;
+		return RPMSG_ERR_PARAM;
+	}
+	return 0;
+}
+
+static void print_side(const char *name, const struct pb_side *side,
+		       unsigned long long wall_ns)
+{
+	LPRINTF("  %s: CPU %llu.%01llu %% of %llu ms, %lu spin and "
+		"%lu sleep wake-ups\r\n", name,
+		side->cpu_ns * 100 / wall_ns,
+		side->cpu_ns * 1000 / wall_ns % 10, wall_ns / 1000000,
+		side->spin_wakeups, side->sleep_wakeups);
+}
+
+/* Master: one round of pings in a mode */
+static int bench_mode(uint32_t mode)
+{
+	unsigned long long sent_ns, rtt, wake;
+	unsigned long long rtt_sum = 0, rtt_max = 0;
+	unsigned long long wake_sum = 0, wake_max = 0;
+	struct pb_side start, local, remote;
+	uint32_t seq;
+	int ret;
+
+	platform_set_poll_spin(platform, mode_spin[mode]);
+	ret = request(PB_MODE, 0, mode, &sent_ns);
+	if (ret)
+		return ret;
+	side_sample(&start);
+	for (seq = 0; seq < PB_PING_NUM; seq++) {
+		usleep(PB_IDLE_USEC);
+		ret = request(PB_PING, seq, mode, &sent_ns);
+		if (ret)
+			return ret;
+		rtt = bench_now_ns() - sent_ns;
+		wake = reply.time_ns > sent_ns ? reply.time_ns - sent_ns : 0;
+		rtt_sum += rtt;
+		wake_sum += wake;
+		if (rtt > rtt_max)
+			rtt_max = rtt;
+		if (wake > wake_max)
+			wake_max = wake;
+	}
+	side_since(&local, &start);
+	ret = request(PB_DONE, 0, mode, &sent_ns);
+	if (ret)
+		return ret;
+	remote.cpu_ns = reply.cpu_ns;
+	remote.spin_wakeups = reply.spin_wakeups;
+	remote.sleep_wakeups = reply.sleep_wakeups;
+
+	LPRINTF("%s:\r\n", mode_names[mode]);
+	LPRINTF("  wake-up average %llu.%03llu us, max %llu.%03llu us\r\n",
+		wake_sum / PB_PING_NUM / 1000, wake_sum / PB_PING_NUM % 1000,
+		wake_max / 1000, wake_max % 1000);
+	LPRINTF("  round trip average %llu.%03llu us, max %llu.%03llu us\r\n",
+		rtt_sum / PB_PING_NUM / 1000, rtt_sum / PB_PING_NUM % 1000,
+		rtt_max / 1000, rtt_max % 1000);
+	print_side("master", &local, local.wall_ns);
+	print_side("remote", &remote, local.wall_ns);
+
+	/* A busy poll never sleeps, a blocking one never spins */
+	if ((mode == PB_MODE_BUSY &&
+	     (local.sleep_wakeups || remote.sleep_wakeups)) ||
+	    (mode == PB_MODE_BLOCK &&
+	     (local.spin_wakeups || remote.spin_wakeups))) {
+		LPERROR("%s: unexpected wake-ups\r\n", mode_names[mode]);
+		return RPMSG_ERR_PARAM;
+	}
+	return 0;
+}
+
+static int app(struct rpmsg_device *rdev, unsigned long proc_id)
+{
+	uint32_t mode;
+	int ret;
+
+	is_master = proc_id != 0;
+	ret = bench_create_ept(rdev, proc_id, rpmsg_endpoint_cb);
+	if (ret)
+		return ret;
+
+	if (proc_id) {
+		LPRINTF("%d pings per mode, %d us idle before each\r\n",
+			PB_PING_NUM, PB_IDLE_USEC);
+		for (mode = 0; !ret && mode < PB_MODE_NUM; mode++)
+			ret = bench_mode(mode);
+		if (!ret)
+			ret = send_msg(PB_END, 0, 0, NULL);
+		if (!ret && err_cnt) {
+			LPERROR("%u errors\r\n", (unsigned int)err_cnt);
+			ret = RPMSG_ERR_PARAM;
+		}
+	} else {
+		while (!end_received && !ept_deleted)
+			platform_poll(platform);
+		if (!end_received || err_cnt)
+			ret = RPMSG_ERR_DEV_STATE;
+	}
+	if (ret)
+		LPERROR("Test failed: %d\r\n", ret);
+	rpmsg_destroy_ept(&lept);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	return bench_main(argc, argv, app);
+}
@@ -0,0 +1,362 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* This is a streaming benchmark of RPMsg against a metal_ring in shared
+ * memory. The remote (proc 0) produces records of each size, like the M4
+ * streams traces, first with rpmsg_send() and then with metal_ring_send(),
+ * ringing the doorbell of the ring through the remoteproc notify of the
+ * platform, every RB_RING_BATCH records if the master waits. The master
+ * (proc 1) consumes and checks them, and reports per transport the
+ * records/s, MB/s and notifications of the remote per 1000 records.
+ *
+ * The ring has a shared memory file of its own, the RPMsg buffer pool of
+ * the platform spans the whole of openamp.shm. A target needs a carve-out
+ * and a doorbell of its own for it, next to the vrings.
+ */
+
+#include <sched.h>
+#include <string.h>
+#include <metal/errno.h>
+#include <metal/ring.h>
+#include <metal/shmem.h>
+#include "rpmsg-bench.h"
+
+#define RB_RUN		1
+#define RB_DATA		2
+#define RB_DONE		3
+#define RB_END		4
+
+#define RB_RPMSG	0
+#define RB_RING		1
+#define RB_TRANSPORTS	2
+
+/* Records per size and transport */
+#define RB_RECORDS	20000
+#define RB_RING_FILE	"openamp.ring.shm"
+#define RB_RING_SIZE	0x10000
+#define RB_RING_SHM	(metal_ring_footprint(RB_RING_SIZE) + 0xf80)
+/* Records between doorbell checks of the producer */
+#define RB_RING_BATCH	16
+/* Any id, the peers process all vrings for a notification */
+#define RB_RING_NOTIFY	0
+/* Longest wait of the consumer for a doorbell */
+#define RB_TIMEOUT_USEC	1000000
+
+/* Head of each record */
+struct rb_record {
+	uint32_t type;
+	uint32_t seq;
+	uint32_t size;
+};
+
+/* Control message */
+struct rb_msg {
+	uint32_t type;
+	uint32_t seq;
+	uint32_t transport;
+	uint32_t size;
+	uint32_t count;
+	uint32_t notified;
+};
+
+/* Record sizes, larger ones than the RPMsg payload are skipped */
+static const uint32_t rb_sizes[] = { 16, 64, 256, 496 };
+
+static const char *const transport_names[RB_TRANSPORTS] = { "rpmsg", "ring" };
+
+/* Globals */
+static struct metal_ring ring;
+static struct rb_msg run;
+static int run_pending = 0;
+static struct rb_msg done;
+static int done_received = 0;
+static uint32_t received = 0;
+static unsigned long long last_ns;
+static int is_master = 0;
+static int end_received = 0;
+static uint32_t err_cnt = 0;
+
+/* A record is its head and a pattern of its sequence */
+static void fill_record(unsigned char *buf, uint32_t size, uint32_t seq)
+{
+	struct rb_record *rec = (struct rb_record *)buf;
+	uint32_t i;
+
+	rec->type = RB_DATA;
+	rec->seq = seq;
+	rec->size = size;
+	for (i = sizeof(*rec); i < size; i++)
+		buf[i] = (unsigned char)(seq * 31 + i);
+}
+
+static int check_record(const unsigned char *buf, uint32_t size,
+			uint32_t seq)
+{
+	const struct rb_record *rec = (const struct rb_record *)buf;
+	uint32_t i;
+
+	if (size < sizeof(*rec) || rec->type != RB_DATA || rec->seq != seq ||
+	    rec->size != size)
+		return -1;
+	for (i = sizeof(*rec); i < size; i++) {
+		if (buf[i] != (unsigned char)(seq * 31 + i))
+			return -1;
+	}
+	return 0;
+}
+
+static int send_msg(uint32_t type, uint32_t transport, uint32_t size,
+		    uint32_t count, uint32_t notified)
+{
+	struct rb_msg msg;
+	int ret;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = type;
+	msg.transport = transport;
+	msg.size = size;
+	msg.count = count;
+	msg.notified = notified;
+	ret = rpmsg_send(&lept, &msg, sizeof(msg));
+	return ret < 0 ? ret : 0;
+}
+
+/* Doorbell of the ring, the same notify the vrings use */
+static int ring_doorbell(void *priv, uint32_t id)
+{
+	struct remoteproc *rproc = priv;
+
+	return rproc->ops->notify(rproc, id);
+}
+
+/*-----------------------------------------------------------------------------*
+ *  RPMSG endpoint callbacks
+ *-----------------------------------------------------------------------------*/
+static int rpmsg_endpoint_cb(struct rpmsg_endpoint *ept, void *data,
+			     size_t len, uint32_t src, void *priv)
+{
+	struct rb_msg *msg = data;
+
+	(void)ept;
+	(void)src;
+	(void)priv;
+
+	if (len < sizeof(msg->type) ||
+	    (msg->type != RB_DATA && len < sizeof(*msg))) {
+		err_cnt++;
+		return RPMSG_SUCCESS;
+	}
+	if (is_master) {
+		if (msg->type == RB_DATA) {
+			if (check_record(data, len, received))
+				err_cnt++;
+			received++;
+			last_ns = bench_now_ns();
+		} else if (msg->type == RB_DONE) {
+			done = *msg;
+			done_received = 1;
+		} else {
+			err_cnt++;
+		}
+		return RPMSG_SUCCESS;
+	}
+	switch (msg->type) {
+	case RB_RUN:
+		/* Produced by the main loop, out of the callback */
+		run = *msg;
+		run_pending = 1;
+		break;
+	case RB_END:
+		end_received = 1;
+		break;
+	default:
+		err_cnt++;
+		break;
+	}
+	return RPMSG_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------*
+ *  Application
+ *-----------------------------------------------------------------------------*/
+/* Remote: produces the records of a run and reports its notifications */
+static int produce(const struct rb_msg *req)
+{
+	unsigned char buf[RPMSG_BUFFER_SIZE];
+	unsigned long notified;
+	uint32_t seq;
+	int ret = 0;
+
+	if (req->size < sizeof(struct rb_record) || req->size > sizeof(buf) ||
+	    req->transport >= RB_TRANSPORTS)
+		return RPMSG_ERR_PARAM;
+	notified = platform_get_notifications(platform);
+	for (seq = 0; !ret && seq < req->count; seq++) {
+		fill_record(buf, req->size, seq);
+		if (req->transport == RB_RPMSG) {
+			ret = rpmsg_send(&lept, buf, req->size);
+			ret = ret < 0 ? ret : 0;
+			continue;
+		}
+		/* The consumer frees space without a notification */
+		while ((ret = metal_ring_send(&ring, buf, req->size)) ==
+		       -ENOSPC) {
+			metal_ring_flush(&ring);
+			sched_yield();
+		}
+	}
+	if (ret)
+		return ret;
+	if (req->transport == RB_RING)
+		metal_ring_flush(&ring);
+	notified = platform_get_notifications(platform) - notified;
+	return send_msg(RB_DONE, req->transport, req->size, req->count,
+			(uint32_t)notified);
+}
+
+/* Master: drains the ring, waiting for the doorbell when it is empty */
+static int consume(uint32_t count)
+{
+	unsigned char buf[RPMSG_BUFFER_SIZE];
+	int ret;
+
+	while (received < count && !ept_deleted) {
+		ret = metal_ring_recv(&ring, buf, sizeof(buf));
+		if (ret == -EAGAIN) {
+			if (!metal_ring_arm(&ring) &&
+			    platform_poll_timeout(platform, RB_TIMEOUT_USEC))
+				return RPMSG_ERR_DEV_STATE;
+			continue;
+		}
+		if (ret < 0 || check_record(buf, ret, received))
+			err_cnt++;
+		received++;
+		last_ns = bench_now_ns();
+	}
+	return received == count ? 0 : RPMSG_ERR_DEV_STATE;
+}
+
+/* Master: one run of a record size over a transport */
+static int bench_run(uint32_t transport, uint32_t size)
+{
+	unsigned long long start_ns, ns;
+	int ret;
+
+	received = 0;
+	done_received = 0;
+	start_ns = bench_now_ns();
+	ret = send_msg(RB_RUN, transport, size, RB_RECORDS, 0);
+	if (ret)
+		return ret;
+	if (transport == RB_RING) {
+		ret = consume(RB_RECORDS);
+		if (ret)
+			return ret;
+	}
+	while (!done_received && !ept_deleted)
+		platform_poll(platform);
+	if (!done_received || received != RB_RECORDS) {
+		LPERROR("%s: %u of %d records\r\n", transport_names[transport],
+			(unsigned int)received, RB_RECORDS);
+		return RPMSG_ERR_DEV_STATE;
+	}
+
+	ns = last_ns - start_ns;
+	if (!ns)
+		ns = 1;
+	LPRINTF("%3u bytes %-5s: %8llu records/s %6llu.%01llu MB/s "
+		"%4u notifications per 1000 records\r\n", (unsigned int)size,
+		transport_names[transport],
+		RB_RECORDS * 1000000000ULL / ns,
+		RB_RECORDS * (unsigned long long)size * 1000 / ns,
+		RB_RECORDS * (unsigned long long)size * 10000 / ns % 10,
+		(unsigned int)(done.notified * 1000ULL / RB_RECORDS));
+	return 0;
+}
+
+/* Opens the ring, reset by the remote before it announces its endpoint */
+static int ring_open(unsigned long proc_id)
+{
+	struct metal_io_region *io;
+	int ret;
+
+	ret = metal_shmem_open(RB_RING_FILE, RB_RING_SHM, &io);
+	if (ret) {
+		LPERROR("Failed to open %s.\r\n", RB_RING_FILE);
+		return ret;
+	}
+	io->mem_flags |= METAL_IO_BLOCK_BURST | METAL_IO_BLOCK_ACQ_REL;
+	if (proc_id)
+		return metal_ring_attach(&ring, io, 0);
+	ret = metal_ring_init(&ring, io, 0, RB_RING_SIZE);
+	if (!ret)
+		metal_ring_set_doorbell(&ring, ring_doorbell, platform,
+					RB_RING_NOTIFY, RB_RING_BATCH);
+	return ret;
+}
+
+static int app(struct rpmsg_device *rdev, unsigned long proc_id)
+{
+	uint32_t transport;
+	unsigned int i;
+	int max, ret;
+
+	is_master = proc_id != 0;
+	if (!is_master) {
+		ret = ring_open(proc_id);
+		if (ret) {
+			LPERROR("Failed to reset the ring: %d\r\n", ret);
+			return ret;
+		}
+	}
+	ret = bench_create_ept(rdev, proc_id, rpmsg_endpoint_cb);
+	if (ret)
+		return ret;
+
+	if (proc_id) {
+		ret = ring_open(proc_id);
+		if (ret)
+			LPERROR("Failed to attach to the ring: %d\r\n", ret);
+		max = rpmsg_virtio_get_buffer_size(rdev);
+		LPRINTF("%d records per run, ring of %d bytes, doorbell "
+			"checked every %d records\r\n", RB_RECORDS,
+			RB_RING_SIZE, RB_RING_BATCH);
+		for (i = 0; !ret && i < sizeof(rb_sizes) / sizeof(rb_sizes[0]);
+		     i++) {
+			if ((int)rb_sizes[i] > max)
+				continue;
+			for (transport = 0; !ret && transport < RB_TRANSPORTS;
+			     transport++)
+				ret = bench_run(transport, rb_sizes[i]);
+		}
+		if (!ret)
+			ret = send_msg(RB_END, 0, 0, 0, 0);
+		if (!ret && err_cnt) {
+			LPERROR("%u errors\r\n", (unsigned int)err_cnt);
+			ret = RPMSG_ERR_PARAM;
+		}
+	} else {
+		while (!end_received && !ept_deleted) {
+			if (run_pending) {
+				run_pending = 0;
+				ret = produce(&run);
+				if (ret)
+					break;
+			} else {
+				platform_poll(platform);
+			}
+		}
+		if (!ret && (!end_received || err_cnt))
+			ret = RPMSG_ERR_DEV_STATE;
+	}
+	if (ret)
+		LPERROR("Test failed: %d\r\n", ret);
+	rpmsg_destroy_ept(&lept);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	return bench_main(argc, argv, app);
+}
@@ -0,0 +1,327 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* This is a test and benchmark of the scatter-gather send rpmsg_sendv().
+ * The remote (proc 0) sends messages made of a header and a payload kept
+ * in separate places to the master (proc 1):
+ * - check: the payload is split into up to SV_FRAGS_MAX fragments of
+ *   random size, including empty ones, for every payload length up to the
+ *   buffer size and beyond it, where the message is cut at the buffer size.
+ *   The master verifies length and content of every message.
+ * - bench: header and payload are copied into a static buffer and sent with
+ *   rpmsg_send(), then gathered by rpmsg_sendv(). It reports messages/s and
+ *   bytes copied per message of each round.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "rpmsg-bench.h"
+
+#define SV_CHECK	1
+#define SV_DATA		2
+#define SV_END		3
+#define SV_REPORT	4
+#define SV_SHUTDOWN	5
+
+#define SV_FRAGS_MAX	8
+/* Check messages per payload length */
+#define SV_CHECK_REPEAT	4
+/* Payload lengths checked beyond the buffer size */
+#define SV_CHECK_OVER	64
+#define SV_BENCH_NUM	100000
+
+struct sv_hdr {
+	uint32_t type;
+	uint32_t seq;
+	uint32_t len;
+	uint32_t errors;
+};
+
+/* Payload sizes of the benchmark, a CAN trace line and a full buffer */
+static const int bench_sizes[] = { 64, 233, RPMSG_BUFFER_SIZE - 16 -
+				   (int)sizeof(struct sv_hdr) };
+
+/* Globals */
+static struct sv_hdr report;
+static int report_received = 0;
+static int shutdown_req = 0;
+static uint32_t expected_seq = 0;
+static uint32_t received = 0;
+static uint32_t err_cnt = 0;
+static unsigned char payload[2 * RPMSG_BUFFER_SIZE];
+static unsigned char tx_msg[RPMSG_BUFFER_SIZE];
+
+static unsigned char pattern(uint32_t seq, size_t i)
+{
+	return (unsigned char)(seq * 7 + i);
+}
+
+/*-----------------------------------------------------------------------------*
+ *  RPMSG endpoint callbacks
+ *-----------------------------------------------------------------------------*/
+static int rpmsg_sender_cb(struct rpmsg_endpoint *ept, void *data, size_t len,
+			   uint32_t src, void *priv)
+{
+	struct sv_hdr *msg = data;
+
+	(void)ept;
+	(void)src;
+	(void)priv;
+
+	if (len >= sizeof(*msg) && msg->type == SV_REPORT) {
+		report = *msg;
+		report_received = 1;
+	}
+	return RPMSG_SUCCESS;
+}
+
+static int rpmsg_sink_cb(struct rpmsg_endpoint *ept, void *data, size_t len,
+			 uint32_t src, void *priv)
+{
+	const unsigned char *bytes = data;
+	struct sv_hdr *msg = data;
+	struct sv_hdr reply;
+	size_t i;
+
+	(void)src;
+	(void)priv;
+
+	if (len < sizeof(*msg)) {
+		err_cnt++;
+		return RPMSG_SUCCESS;
+	}
+	switch (msg->type) {
+	case SV_CHECK:
+		for (i = sizeof(*msg); i < len; i++) {
+			if (bytes[i] != pattern(msg->seq, i - sizeof(*msg)))
+				break;
+		}
+		if (i != len || len != msg->len)
+			err_cnt++;
+		/* fall through */
+	case SV_DATA:
+		if (msg->seq != expected_seq)
+			err_cnt++;
+		expected_seq = msg->seq + 1;
+		received++;
+		break;
+	case SV_END:
+		memset(&reply, 0, sizeof(reply));
+		reply.type = SV_REPORT;
+		reply.len = received;
+		reply.errors = err_cnt;
+		if (rpmsg_send(ept, &reply, sizeof(reply)) < 0)
+			LPERROR("Failed to send report.\r\n");
+		expected_seq = 0;
+		received = 0;
+		err_cnt = 0;
+		break;
+	case SV_SHUTDOWN:
+		shutdown_req = 1;
+		break;
+	default:
+		err_cnt++;
+		break;
+	}
+	return RPMSG_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------*
+ *  Application
+ *-----------------------------------------------------------------------------*/
+/* Ends a round and waits for the number of messages the master received */
+static int end_round(uint32_t sent)
+{
+	struct sv_hdr end;
+	int ret;
+
+	memset(&end, 0, sizeof(end));
+	end.type = SV_END;
+	report_received = 0;
+	ret = rpmsg_send(&lept, &end, sizeof(end));
+	if (ret < 0)
+		return ret;
+	while (!report_received && !ept_deleted)
+		platform_poll(platform);
+	if (ept_deleted)
+		return RPMSG_ERR_DEV_STATE;
+	if (report.len != sent || report.errors) {
+		LPERROR("%u of %u messages received, %u errors\r\n",
+			(unsigned int)report.len, (unsigned int)sent,
+			(unsigned int)report.errors);
+		return RPMSG_ERR_PARAM;
+	}
+	return 0;
+}
+
+/* Invalid fragments are refused before a buffer is taken */
+static int check_params(void)
+{
+	struct rpmsg_iovec iov[2];
+
+	iov[0].base = payload;
+	iov[0].len = 1;
+	iov[1].base = payload;
+	iov[1].len = -1;
+	if (rpmsg_sendv(&lept, NULL, 1) != RPMSG_ERR_PARAM ||
+	    rpmsg_sendv(&lept, iov, -1) != RPMSG_ERR_PARAM ||
+	    rpmsg_sendv(&lept, iov, 2) != RPMSG_ERR_PARAM)
+		return RPMSG_ERR_PARAM;
+	iov[1].base = NULL;
+	iov[1].len = 1;
+	if (rpmsg_sendv(&lept, iov, 2) != RPMSG_ERR_PARAM)
+		return RPMSG_ERR_PARAM;
+	return 0;
+}
+
+static int check_round(int buff_len)
+{
+	struct rpmsg_iovec iov[SV_FRAGS_MAX + 1];
+	struct sv_hdr hdr;
+	int total, left, num, len, max, r, i, ret;
+	uint32_t seq = 0;
+
+	ret = check_params();
+	if (ret) {
+		LPERROR("Invalid fragments accepted.\r\n");
+		return ret;
+	}
+
+	max = buff_len - (int)sizeof(hdr) + SV_CHECK_OVER;
+	srand(1);
+	for (len = 0; len <= max && !ept_deleted; len++) {
+		for (r = 0; r < SV_CHECK_REPEAT; r++, seq++) {
+			for (i = 0; i < len; i++)
+				payload[i] = pattern(seq, i);
+			total = len + (int)sizeof(hdr);
+			hdr.type = SV_CHECK;
+			hdr.seq = seq;
+			hdr.len = total > buff_len ? buff_len : total;
+			hdr.errors = 0;
+			iov[0].base = &hdr;
+			iov[0].len = sizeof(hdr);
+			/* Random splits, empty fragments included */
+			num = 1 + rand() % SV_FRAGS_MAX;
+			for (i = 1, left = len; i < num; i++) {
+				iov[i].base = payload + (len - left);
+				iov[i].len = left ? rand() % (left + 1) : 0;
+				left -= iov[i].len;
+			}
+			iov[i].base = payload + (len - left);
+			iov[i].len = left;
+			ret = rpmsg_sendv(&lept, iov, num + 1);
+			if (ret != (int)hdr.len) {
+				LPERROR("%d bytes in %d fragments, %d sent\r\n",
+					total, num + 1, ret);
+				return ret < 0 ? ret : RPMSG_ERR_PARAM;
+			}
+		}
+	}
+	ret = end_round(seq);
+	if (!ret)
+		LPRINTF("check: %u messages of 0 to %d bytes in up to %d "
+			"fragments\r\n", (unsigned int)seq,
+			max + (int)sizeof(hdr), SV_FRAGS_MAX + 1);
+	return ret;
+}
+
+static int bench_round(int size, int gather)
+{
+	struct rpmsg_iovec iov[2];
+	struct timespec start, stop;
+	struct sv_hdr hdr;
+	double elapsed;
+	uint32_t seq;
+	int ret;
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.type = SV_DATA;
+	iov[0].base = &hdr;
+	iov[0].len = sizeof(hdr);
+	iov[1].base = payload;
+	iov[1].len = size;
+	memset(payload, 0xA5, size);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (seq = 0; seq < SV_BENCH_NUM && !ept_deleted; seq++) {
+		hdr.seq = seq;
+		if (gather) {
+			ret = rpmsg_sendv(&lept, iov, 2);
+		} else {
+			/* The pattern replaced by rpmsg_sendv() */
+			memcpy(tx_msg, &hdr, sizeof(hdr));
+			memcpy(tx_msg + sizeof(hdr), payload, size);
+			ret = rpmsg_send(&lept, tx_msg, sizeof(hdr) + size);
+		}
+		if (ret < 0)
+			return ret;
+	}
+	ret = end_round(SV_BENCH_NUM);
+	if (ret)
+		return ret;
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+
+	elapsed = (double)(stop.tv_sec - start.tv_sec) +
+		  (double)(stop.tv_nsec - start.tv_nsec) / 1e9;
+	LPRINTF("%-14s %3d bytes: %.0f messages/s, %d bytes copied/message\r\n",
+		gather ? "rpmsg_sendv" : "copy and send", size,
+		SV_BENCH_NUM / elapsed,
+		(gather ? 1 : 2) * (int)(sizeof(hdr) + size));
+	return 0;
+}
+
+static int send_app(struct rpmsg_device *rdev)
+{
+	struct sv_hdr shutdown;
+	unsigned int i;
+	int buff_len;
+	int ret;
+
+	buff_len = rpmsg_virtio_get_buffer_size(rdev);
+	if (buff_len <= 0 || buff_len + SV_CHECK_OVER > (int)sizeof(payload)) {
+		LPERROR("Buffer size %d not supported.\r\n", buff_len);
+		ret = RPMSG_ERR_BUFF_SIZE;
+	} else {
+		ret = check_round(buff_len);
+	}
+	if (!ret)
+		LPRINTF("%d messages per round\r\n", SV_BENCH_NUM);
+	for (i = 0; !ret && i < sizeof(bench_sizes) / sizeof(bench_sizes[0]);
+	     i++) {
+		ret = bench_round(bench_sizes[i], 0);
+		if (!ret)
+			ret = bench_round(bench_sizes[i], 1);
+	}
+	if (ret)
+		LPERROR("Test failed: %d\r\n", ret);
+
+	memset(&shutdown, 0, sizeof(shutdown));
+	shutdown.type = SV_SHUTDOWN;
+	(void)rpmsg_send(&lept, &shutdown, sizeof(shutdown));
+	return ret;
+}
+
+static int app(struct rpmsg_device *rdev, unsigned long proc_id)
+{
+	int ret;
+
+	ret = bench_create_ept(rdev, proc_id,
+			       proc_id ? rpmsg_sink_cb : rpmsg_sender_cb);
+	if (ret)
+		return ret;
+	if (proc_id) {
+		while (!shutdown_req && !ept_deleted)
+			platform_poll(platform);
+	} else {
+		ret = send_app(rdev);
+	}
+	rpmsg_destroy_ept(&lept);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	return bench_main(argc, argv, app);
+}
@@ -0,0 +1,346 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* This is a benchmark of the vring depth and the rpmsg buffer size.
+ * The remote (proc 0) sends bursts of CAN-FD sized frames to the master
+ * (proc 1), packing as many frames in a message as the buffer takes, and
+ * waits for the master to acknowledge each burst. The master reports the
+ * throughput, the latency of the frames from the start of their burst and
+ * how often the remote ran out of tx buffers.
+ *
+ * Without arguments, it runs a pair of processes for each depth and buffer
+ * size of the sweep and prints one line per pair:
+ *   msg-test-rpmsg-sizing-static
+ *
+ * One pair, the remote first, with the same vring depth and buffer size:
+ *   msg-test-rpmsg-sizing-static 0 0 <depth> <size> &
+ *   msg-test-rpmsg-sizing-static 1 0 <depth> <size>
+ */
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <metal/cpu.h>
+#include "rpmsg-bench.h"
+
+#define SZ_DATA		1
+#define SZ_ACK		2
+#define SZ_END		3
+#define SZ_SHUTDOWN	4
+
+#define SZ_BURST_FRAMES	256
+#define SZ_BURSTS	64
+#define SZ_FRAME_NUM	(SZ_BURSTS * SZ_BURST_FRAMES)
+/* Seconds a pair of the sweep may run */
+#define SZ_TIMEOUT	60
+/* Prefix of the result line of the master */
+#define SZ_RESULT	"result:"
+
+/* A CAN-FD frame with its identifier and flags */
+struct sz_frame {
+	uint32_t id;
+	uint32_t flags;
+	uint8_t data[64];
+};
+
+struct sz_msg {
+	uint32_t type;
+	uint32_t seq;
+	uint32_t frames;
+	uint32_t stalls;
+	/* Start of the burst, CLOCK_MONOTONIC ns */
+	uint64_t stamp;
+	struct sz_frame frame[0];
+};
+
+static const unsigned int sweep_depths[] = { 4, 16, 64, 256 };
+static const unsigned int sweep_sizes[] = { 512, 1024, 2048, 4096 };
+
+/* Globals */
+static int shutdown_req = 0;
+/* remote */
+static int acked = 0;
+/* master */
+static int end_received = 0;
+static uint32_t expected_seq = 0;
+static uint32_t expected_id = 0;
+static uint32_t burst_frames = 0;
+static uint32_t frames_per_msg = 0;
+static uint32_t stalls = 0;
+static uint32_t err_cnt = 0;
+static unsigned long long busy_ns = 0;
+static uint32_t latency_ns[SZ_FRAME_NUM];
+
+static int send_msg(uint32_t type, uint32_t stall_cnt)
+{
+	struct sz_msg msg;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.type = type;
+	msg.stalls = stall_cnt;
+	return rpmsg_send(&lept, &msg, sizeof(msg));
+}
+
+/*-----------------------------------------------------------------------------*
+ *  RPMSG endpoint callbacks
+ *-----------------------------------------------------------------------------*/
+static int rpmsg_sender_cb(struct rpmsg_endpoint *ept, void *data, size_t len,
+			   uint32_t src, void *priv)
+{
+	struct sz_msg *msg = data;
+
+	(void)ept;
+	(void)src;
+	(void)priv;
+
+	if (len < sizeof(*msg))
+		return RPMSG_SUCCESS;
+	if (msg->type == SZ_ACK)
+		acked = 1;
+	else if (msg->type == SZ_SHUTDOWN)
+		shutdown_req = 1;
+	return RPMSG_SUCCESS;
+}
+
+static int rpmsg_sink_cb(struct rpmsg_endpoint *ept, void *data, size_t len,
+			 uint32_t src, void *priv)
+{
+	struct sz_msg *msg = data;
+	unsigned long long now = bench_now_ns();
+	uint32_t i;
+
+	(void)ept;
+	(void)src;
+	(void)priv;
+
+	if (len < sizeof(*msg)) {
+		err_cnt++;
+		return RPMSG_SUCCESS;
+	}
+	if (msg->type == SZ_END) {
+		stalls = msg->stalls;
+		end_received = 1;
+		return RPMSG_SUCCESS;
+	}
+	if (msg->type != SZ_DATA || msg->seq != expected_seq ||
+	    len != sizeof(*msg) + msg->frames * sizeof(struct sz_frame) ||
+	    burst_frames + msg->frames > SZ_BURST_FRAMES) {
+		err_cnt++;
+		return RPMSG_SUCCESS;
+	}
+	expected_seq++;
+	if (msg->frames > frames_per_msg)
+		frames_per_msg = msg->frames;
+	for (i = 0; i < msg->frames; i++) {
+		if (msg->frame[i].id != expected_id ||
+		    msg->frame[i].data[0] != (uint8_t)expected_id)
+			err_cnt++;
+		latency_ns[expected_id % SZ_FRAME_NUM] =
+			(uint32_t)(now - msg->stamp);
+		expected_id++;
+	}
+	burst_frames += msg->frames;
+	if (burst_frames == SZ_BURST_FRAMES) {
+		busy_ns += now - msg->stamp;
+		burst_frames = 0;
+		if (send_msg(SZ_ACK, 0) < 0)
+			err_cnt++;
+	}
+	return RPMSG_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------*
+ *  Application
+ *-----------------------------------------------------------------------------*/
+static int cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* Remote: sends the bursts, waits for the acknowledge of each one */
+static int send_app(void)
+{
+	struct sz_msg *msg;
+	unsigned long long stamp;
+	uint32_t seq = 0, id = 0, len, n, i, frames, stall_cnt = 0;
+	int burst, ret;
+
+	for (burst = 0; burst < SZ_BURSTS && !ept_deleted; burst++) {
+		stamp = bench_now_ns();
+		acked = 0;
+		for (frames = 0; frames < SZ_BURST_FRAMES; ) {
+			msg = rpmsg_get_tx_payload_buffer(&lept, &len, 0);
+			if (!msg) {
+				/* Out of tx buffers, the burst has to wait */
+				stall_cnt++;
+				metal_cpu_yield();
+				continue;
+			}
+			n = (len - sizeof(*msg)) / sizeof(struct sz_frame);
+			if (n > SZ_BURST_FRAMES - frames)
+				n = SZ_BURST_FRAMES - frames;
+			msg->type = SZ_DATA;
+			msg->seq = seq++;
+			msg->frames = n;
+			msg->stalls = 0;
+			msg->stamp = stamp;
+			for (i = 0; i < n; i++, id++) {
+				msg->frame[i].id = id;
+				msg->frame[i].flags = sizeof(msg->frame[i].data);
+				memset(msg->frame[i].data, (uint8_t)id,
+				       sizeof(msg->frame[i].data));
+			}
+			ret = rpmsg_send_nocopy(&lept, msg, sizeof(*msg) +
+						n * sizeof(struct sz_frame));
+			if (ret < 0)
+				goto out;
+			frames += n;
+		}
+		while (!acked && !ept_deleted)
+			platform_poll(platform);
+	}
+	ret = send_msg(SZ_END, stall_cnt);
+	while (ret >= 0 && !shutdown_req && !ept_deleted)
+		platform_poll(platform);
+	ret = ret < 0 ? ret : 0;
+out:
+	if (ret)
+		LPERROR("Test failed: %d\r\n", ret);
+	return ret;
+}
+
+/* Master: receives the bursts and prints the result line */
+static int sink_app(void)
+{
+	double secs;
+	int ret;
+
+	while (!end_received && !ept_deleted)
+		platform_poll(platform);
+	ret = send_msg(SZ_SHUTDOWN, 0);
+	if (ret < 0)
+		return ret;
+
+	if (expected_id != SZ_FRAME_NUM || err_cnt) {
+		LPERROR("%u frames received, %u errors\r\n",
+			(unsigned int)expected_id, (unsigned int)err_cnt);
+		return RPMSG_ERR_PARAM;
+	}
+	qsort(latency_ns, SZ_FRAME_NUM, sizeof(latency_ns[0]), cmp_u32);
+	secs = busy_ns / 1e9;
+	LPRINTF(SZ_RESULT "%3u frames/msg %7.1f MB/s %8.0f frames/s, "
+		"latency p50 %7.1f p99 %7.1f max %7.1f us, %u stalls\r\n",
+		(unsigned int)frames_per_msg,
+		SZ_FRAME_NUM * sizeof(struct sz_frame) / secs / 1e6,
+		SZ_FRAME_NUM / secs,
+		latency_ns[SZ_FRAME_NUM / 2] / 1e3,
+		latency_ns[SZ_FRAME_NUM * 99 / 100] / 1e3,
+		latency_ns[SZ_FRAME_NUM - 1] / 1e3,
+		(unsigned int)stalls);
+	return 0;
+}
+
+/* Starts one side of a pair with its output on fd, -1 to drop it */
+static pid_t sweep_spawn(const char *proc, const char *depth,
+			 const char *size, int fd)
+{
+	char *args[] = { "msg-test-rpmsg-sizing", (char *)proc, "0",
+			 (char *)depth, (char *)size, NULL };
+	pid_t pid;
+	int null;
+
+	pid = fork();
+	if (pid)
+		return pid;
+	null = open("/dev/null", O_WRONLY);
+	dup2(fd >= 0 ? fd : null, STDOUT_FILENO);
+	dup2(null, STDERR_FILENO);
+	alarm(SZ_TIMEOUT);
+	execv("/proc/self/exe", args);
+	_exit(127);
+}
+
+/* Runs a pair for each depth and size, prints the result of the master or
+ * its first error, a depth and size which do not fit is refused */
+static int sweep(void)
+{
+	char depth[16], size[16], line[256], error[256];
+	unsigned int d, s;
+	int fds[2], found;
+	pid_t remote, master;
+	FILE *out;
+
+	LPRINTF("%u bursts of %u frames of %u bytes\r\n", SZ_BURSTS,
+		SZ_BURST_FRAMES, (unsigned int)sizeof(struct sz_frame));
+	for (d = 0; d < sizeof(sweep_depths) / sizeof(sweep_depths[0]); d++) {
+		for (s = 0; s < sizeof(sweep_sizes) / sizeof(sweep_sizes[0]);
+		     s++) {
+			snprintf(depth, sizeof(depth), "%u", sweep_depths[d]);
+			snprintf(size, sizeof(size), "%u", sweep_sizes[s]);
+			fflush(stdout);
+			if (pipe(fds))
+				return -1;
+			remote = sweep_spawn("0", depth, size, -1);
+			master = sweep_spawn("1", depth, size, fds[1]);
+			close(fds[1]);
+			out = fdopen(fds[0], "r");
+			if (remote < 0 || master < 0 || !out)
+				return -1;
+
+			found = 0;
+			error[0] = 0;
+			while (fgets(line, sizeof(line), out)) {
+				if (!strncmp(line, SZ_RESULT,
+					     strlen(SZ_RESULT)))
+					found = 1;
+				else if (error[0] ||
+					 (strncmp(line, "ERROR", 5) &&
+					  strncmp(line, "failed", 6)))
+					continue;
+				strcpy(error, line);
+			}
+			fclose(out);
+			waitpid(master, NULL, 0);
+			/* A remote whose master gave up waits forever */
+			kill(remote, SIGKILL);
+			waitpid(remote, NULL, 0);
+
+			LPRINTF("depth %3u buffer %4u: %s", sweep_depths[d],
+				sweep_sizes[s], found ?
+				error + strlen(SZ_RESULT) :
+				error[0] ? error : "timed out\r\n");
+		}
+	}
+	return 0;
+}
+
+static int app(struct rpmsg_device *rdev, unsigned long proc_id)
+{
+	int ret;
+
+	ret = bench_create_ept(rdev, proc_id,
+			       proc_id ? rpmsg_sink_cb : rpmsg_sender_cb);
+	if (ret)
+		return ret;
+	if (proc_id)
+		ret = sink_app();
+	else
+		ret = send_app();
+	rpmsg_destroy_ept(&lept);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+		return sweep() ? -1 : 0;
+	return bench_main(argc, argv, app);
+}
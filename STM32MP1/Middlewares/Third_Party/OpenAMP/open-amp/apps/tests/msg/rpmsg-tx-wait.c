@@ -0,0 +1,236 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* This is a test of the wake-up latency of a sender waiting for a tx buffer.
+ * The master (proc 1) holds every message of the remote (proc 0) until the
+ * remote runs out of tx buffers and blocks in rpmsg_get_tx_payload_buffer().
+ * Then the master releases one buffer at a time and the remote stamps the
+ * message it sends with the buffer. The latency is the time from the release
+ * to the return of rpmsg_get_tx_payload_buffer(), once with the 1 ms sleep
+ * loop and once woken by the "buffer free" notification.
+ */
+
+#include <unistd.h>
+#include "rpmsg-bench.h"
+
+#define TXW_DATA	1
+#define TXW_END		2
+
+#define TXW_MODE_SLEEP	0
+#define TXW_MODE_SEM	1
+#define TXW_MODE_NUM	2
+
+/* Messages sent by a blocked remote per mode */
+#define TXW_MSG_NUM	200
+/* Longest number of buffers the master holds */
+#define TXW_HOLD_MAX	1024
+/* Lets the remote wake up and block again before the master polls */
+#define TXW_WAKE_USEC	3000
+
+struct txw_msg {
+	uint32_t type;
+	uint32_t seq;
+	uint32_t mode;
+	uint64_t woken_ns;
+};
+
+struct txw_stats {
+	unsigned int count;
+	unsigned long long sum_ns;
+	unsigned long long max_ns;
+};
+
+static const char *const mode_names[TXW_MODE_NUM] = { "1 ms sleep loop",
+						      "buffer free notification" };
+
+/* Globals */
+static void *held[TXW_HOLD_MAX];
+static unsigned int held_head = 0;
+static unsigned int held_num = 0;
+static unsigned int held_max = 0;
+static unsigned long long released_ns = 0;
+static struct txw_stats stats[TXW_MODE_NUM];
+static int end_received = 0;
+static uint32_t expected_seq = 0;
+static uint32_t err_cnt = 0;
+
+/*-----------------------------------------------------------------------------*
+ *  RPMSG endpoint callbacks
+ *-----------------------------------------------------------------------------*/
+static int rpmsg_endpoint_cb(struct rpmsg_endpoint *ept, void *data,
+			     size_t len, uint32_t src, void *priv)
+{
+	struct txw_msg *msg = data;
+	struct txw_stats *st;
+	unsigned long long lat;
+
+	(void)src;
+	(void)priv;
+
+	if (len < sizeof(*msg)) {
+		err_cnt++;
+		return RPMSG_SUCCESS;
+	}
+	switch (msg->type) {
+	case TXW_END:
+		end_received = 1;
+		break;
+	case TXW_DATA:
+		if (msg->seq != expected_seq || msg->mode >= TXW_MODE_NUM ||
+		    held_num == TXW_HOLD_MAX) {
+			err_cnt++;
+			break;
+		}
+		expected_seq = msg->seq + 1;
+		/* The message took the buffer released last */
+		if (released_ns) {
+			st = &stats[msg->mode];
+			lat = msg->woken_ns - released_ns;
+			st->count++;
+			st->sum_ns += lat;
+			if (lat > st->max_ns)
+				st->max_ns = lat;
+			released_ns = 0;
+		}
+		rpmsg_hold_rx_buffer(ept, data);
+		held[(held_head + held_num) % TXW_HOLD_MAX] = data;
+		held_num++;
+		break;
+	default:
+		err_cnt++;
+		break;
+	}
+	return RPMSG_SUCCESS;
+}
+
+/*-----------------------------------------------------------------------------*
+ *  Application
+ *-----------------------------------------------------------------------------*/
+static void release_oldest(void)
+{
+	rpmsg_release_rx_buffer(&lept, held[held_head]);
+	held_head = (held_head + 1) % TXW_HOLD_MAX;
+	held_num--;
+}
+
+static int send_msg(uint32_t type, uint32_t seq, uint32_t mode)
+{
+	struct txw_msg *msg;
+	uint32_t len;
+	int ret;
+
+	msg = rpmsg_get_tx_payload_buffer(&lept, &len, 1);
+	if (!msg)
+		return RPMSG_ERR_NO_BUFF;
+	msg->woken_ns = bench_now_ns();
+	msg->type = type;
+	msg->seq = seq;
+	msg->mode = mode;
+	ret = rpmsg_send_nocopy(&lept, msg, sizeof(*msg));
+	return ret < 0 ? ret : 0;
+}
+
+/* Remote: fills every buffer of the master, then sends blocked in each mode */
+static int send_all(struct rpmsg_virtio_device *rvdev)
+{
+	struct metal_sem *tx_free = rvdev->tx_free;
+	uint32_t seq = 0, mode, i;
+	int ret;
+
+	for (mode = 0; mode < TXW_MODE_NUM; mode++) {
+		rpmsg_virtio_set_tx_free_sem(rvdev, mode == TXW_MODE_SEM ?
+					     tx_free : NULL);
+		/* The first round also fills the buffers of the master */
+		for (i = 0; i < TXW_MSG_NUM + (mode ? 0 : held_max); i++) {
+			ret = send_msg(TXW_DATA, seq++, mode);
+			if (ret)
+				return ret;
+		}
+	}
+	return send_msg(TXW_END, 0, 0);
+}
+
+/* Master: holds the messages and releases a buffer once the remote blocks */
+static int receive_all(void)
+{
+	unsigned long long avg;
+	uint32_t mode;
+
+	while (!end_received && !ept_deleted) {
+		if (held_num == held_max && !released_ns) {
+			released_ns = bench_now_ns();
+			release_oldest();
+			/* Do not compete with the remote in platform_poll() */
+			usleep(TXW_WAKE_USEC);
+		}
+		platform_poll(platform);
+	}
+	while (held_num)
+		release_oldest();
+	if (!end_received)
+		return RPMSG_ERR_DEV_STATE;
+
+	for (mode = 0; mode < TXW_MODE_NUM; mode++) {
+		avg = stats[mode].count ?
+		      stats[mode].sum_ns / stats[mode].count : 0;
+		LPRINTF("%s: %u wake-ups, average %llu.%03llu us, "
+			"max %llu.%03llu us\r\n", mode_names[mode],
+			stats[mode].count, avg / 1000, avg % 1000,
+			stats[mode].max_ns / 1000, stats[mode].max_ns % 1000);
+	}
+	if (err_cnt || expected_seq != TXW_MODE_NUM * TXW_MSG_NUM + held_max) {
+		LPERROR("%u messages received, %u errors\r\n",
+			(unsigned int)expected_seq, (unsigned int)err_cnt);
+		return RPMSG_ERR_PARAM;
+	}
+	for (mode = 0; mode < TXW_MODE_NUM; mode++) {
+		if (stats[mode].count != TXW_MSG_NUM) {
+			LPERROR("%u wake-ups measured\r\n",
+				stats[mode].count);
+			return RPMSG_ERR_PARAM;
+		}
+	}
+	return 0;
+}
+
+static int app(struct rpmsg_device *rdev, unsigned long proc_id)
+{
+	struct rpmsg_virtio_device *rvdev;
+	int ret;
+
+	rvdev = metal_container_of(rdev, struct rpmsg_virtio_device, rdev);
+	/* Every buffer the master receives into, the remote sends from */
+	held_max = proc_id ? rvdev->rvq->vq_nentries :
+			     rvdev->svq->vq_nentries;
+	if (held_max > TXW_HOLD_MAX) {
+		LPERROR("%u buffers, at most %u supported\r\n", held_max,
+			TXW_HOLD_MAX);
+		return RPMSG_ERR_PARAM;
+	}
+	if (!rvdev->tx_free) {
+		LPERROR("The platform does not notify free buffers.\r\n");
+		return RPMSG_ERR_PARAM;
+	}
+
+	ret = bench_create_ept(rdev, proc_id, rpmsg_endpoint_cb);
+	if (ret)
+		return ret;
+
+	if (proc_id) {
+		LPRINTF("%u buffers, %d wake-ups per mode\r\n", held_max,
+			TXW_MSG_NUM);
+		ret = receive_all();
+	} else {
+		ret = send_all(rvdev);
+	}
+	if (ret)
+		LPERROR("Test failed: %d\r\n", ret);
+	rpmsg_destroy_ept(&lept);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	return bench_main(argc, argv, app);
+}
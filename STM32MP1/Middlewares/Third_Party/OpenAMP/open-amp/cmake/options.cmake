@@ -74,6 +74,12 @@ if (NOT WITH_VIRTIO_SLAVE)
   add_definitions(-DVIRTIO_MASTER_ONLY)
 endif (NOT WITH_VIRTIO_SLAVE)
 
+option (WITH_RPMSG_LOCKLESS "Build with single owner virtqueues, without the rpmsg device lock" OFF)
+
+if (WITH_RPMSG_LOCKLESS)
+  add_definitions(-DRPMSG_VIRTIO_LOCKLESS)
+endif (WITH_RPMSG_LOCKLESS)
+
 # Set the complication flags
 set (CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -Wall -Wextra")
 
@@ -27,6 +27,9 @@ extern "C" {
 /* Configurable parameters */
 #define RPMSG_NAME_SIZE			(32)
 #define RPMSG_ADDR_BMP_SIZE		(128)
+#ifndef RPMSG_BATCH_SIZE
+#define RPMSG_BATCH_SIZE		(16)
+#endif
 
 #define RPMSG_NS_EPT_ADDR		(0x35)
 #define RPMSG_RESERVED_ADDRESSES	(1024)
@@ -45,6 +48,7 @@ extern "C" {
 
 struct rpmsg_endpoint;
 struct rpmsg_device;
+struct rpmsg_batch;
 
 /* Returns positive value on success or negative error value on failure */
 typedef int (*rpmsg_ept_cb)(struct rpmsg_endpoint *ept, void *data,
@@ -80,18 +84,34 @@ struct rpmsg_endpoint {
 	void *priv;
 };
 
+/**
+ * struct rpmsg_iovec - fragment of a message gathered by rpmsg_sendv()
+ * @base: start of the fragment
+ * @len: length of the fragment in bytes
+ */
+struct rpmsg_iovec {
+	const void *base;
+	int len;
+};
+
 /**
  * struct rpmsg_device_ops - RPMsg device operations
  * @send_offchannel_raw: send RPMsg data
+ * @send_offchannel_iov: send RPMsg data gathered from fragments
  * @hold_rx_buffer: hold RPMsg RX buffer
  * @release_rx_buffer: release RPMsg RX buffer
  * @get_tx_payload_buffer: get RPMsg TX buffer
  * @send_offchannel_nocopy: send RPMsg data without copy
+ * @send_batch_nocopy: send a batch of RPMsg data without copy
  */
 struct rpmsg_device_ops {
 	int (*send_offchannel_raw)(struct rpmsg_device *rdev,
 				   uint32_t src, uint32_t dst,
 				   const void *data, int len, int wait);
+	int (*send_offchannel_iov)(struct rpmsg_device *rdev,
+				   uint32_t src, uint32_t dst,
+				   const struct rpmsg_iovec *iov, int iovcnt,
+				   int wait);
 	void (*hold_rx_buffer)(struct rpmsg_device *rdev, void *rxbuf);
 	void (*release_rx_buffer)(struct rpmsg_device *rdev, void *rxbuf);
 	void *(*get_tx_payload_buffer)(struct rpmsg_device *rdev,
@@ -99,6 +119,8 @@ struct rpmsg_device_ops {
 	int (*send_offchannel_nocopy)(struct rpmsg_device *rdev,
 				      uint32_t src, uint32_t dst,
 				       const void *data, int len);
+	int (*send_batch_nocopy)(struct rpmsg_device *rdev,
+				 const struct rpmsg_batch *batch);
 };
 
 /**
@@ -106,6 +128,8 @@ struct rpmsg_device_ops {
  * @endpoints: list of endpoints
  * @ns_ept: name service endpoint
  * @bitmap: table endpoint address allocation.
+ * @ept_table: endpoints of the addresses of @bitmap, indexed like @bitmap,
+ *             for the lookup of the destination of received messages
  * @lock: mutex lock for rpmsg management
  * @ns_bind_cb: callback handler for name service announcement without local
  *              endpoints waiting to bind.
@@ -116,12 +140,32 @@ struct rpmsg_device {
 	struct metal_list endpoints;
 	struct rpmsg_endpoint ns_ept;
 	unsigned long bitmap[metal_bitmap_longs(RPMSG_ADDR_BMP_SIZE)];
+	struct rpmsg_endpoint *ept_table[RPMSG_ADDR_BMP_SIZE];
 	metal_mutex_t lock;
 	rpmsg_ns_bind_cb ns_bind_cb;
 	struct rpmsg_device_ops ops;
 	bool support_ns;
 };
 
+/**
+ * struct rpmsg_batch - tx buffers sent with a single notification
+ * @ept: the rpmsg endpoint, messages are sent from its local address
+ * @dst: destination address of each message
+ * @data: tx buffer of each message, reserved by rpmsg_get_tx_payload_buffer()
+ * @len: payload length of each message
+ * @num: number of messages in the batch
+ *
+ * Set up by rpmsg_batch_begin(), filled by rpmsg_batch_add() and sent by
+ * rpmsg_batch_commit().
+ */
+struct rpmsg_batch {
+	struct rpmsg_endpoint *ept;
+	uint32_t dst[RPMSG_BATCH_SIZE];
+	const void *data[RPMSG_BATCH_SIZE];
+	int len[RPMSG_BATCH_SIZE];
+	int num;
+};
+
 /**
  * rpmsg_send_offchannel_raw() - send a message across to the remote processor,
  * specifying source and destination address.
@@ -276,6 +320,85 @@ static inline int rpmsg_trysend_offchannel(struct rpmsg_endpoint *ept,
 	return rpmsg_send_offchannel_raw(ept, src, dst, data, len, false);
 }
 
+/**
+ * rpmsg_send_offchannel_iov() - send a message gathered from fragments,
+ * specifying source and destination address.
+ * @ept: the rpmsg endpoint
+ * @src: source address
+ * @dst: destination address
+ * @iov: fragments of the payload, in order
+ * @iovcnt: number of fragments
+ * @wait: boolean, wait or not for a TX buffer to become available
+ *
+ * This function copies the @iovcnt fragments of @iov one after the other
+ * into a single TX buffer and sends it as one message to the remote @dst
+ * address from the source @src address, like rpmsg_send_offchannel_raw()
+ * with the fragments concatenated first. Fragments that do not fit the
+ * buffer are cut off.
+ *
+ * Returns number of bytes it has sent or negative error value on failure.
+ */
+int rpmsg_send_offchannel_iov(struct rpmsg_endpoint *ept, uint32_t src,
+			      uint32_t dst, const struct rpmsg_iovec *iov,
+			      int iovcnt, int wait);
+
+/**
+ * rpmsg_sendv() - send a message gathered from fragments
+ * @ept: the rpmsg endpoint
+ * @iov: fragments of the payload, in order
+ * @iovcnt: number of fragments
+ *
+ * This function sends the fragments of @iov as one message based on the
+ * @ept, see rpmsg_send().
+ *
+ * Returns number of bytes it has sent or negative error value on failure.
+ */
+static inline int rpmsg_sendv(struct rpmsg_endpoint *ept,
+			      const struct rpmsg_iovec *iov, int iovcnt)
+{
+	return rpmsg_send_offchannel_iov(ept, ept->addr, ept->dest_addr, iov,
+					 iovcnt, true);
+}
+
+/**
+ * rpmsg_sendtov() - send a message gathered from fragments, specify dst
+ * @ept: the rpmsg endpoint
+ * @iov: fragments of the payload, in order
+ * @iovcnt: number of fragments
+ * @dst: destination address
+ *
+ * This function sends the fragments of @iov as one message to the remote
+ * @dst address, see rpmsg_sendto().
+ *
+ * Returns number of bytes it has sent or negative error value on failure.
+ */
+static inline int rpmsg_sendtov(struct rpmsg_endpoint *ept,
+				const struct rpmsg_iovec *iov, int iovcnt,
+				uint32_t dst)
+{
+	return rpmsg_send_offchannel_iov(ept, ept->addr, dst, iov, iovcnt,
+					 true);
+}
+
+/**
+ * rpmsg_trysendv() - send a message gathered from fragments
+ * @ept: the rpmsg endpoint
+ * @iov: fragments of the payload, in order
+ * @iovcnt: number of fragments
+ *
+ * This function sends the fragments of @iov as one message based on the
+ * @ept, see rpmsg_trysend(). In case there are no TX buffers available,
+ * the function returns immediately.
+ *
+ * Returns number of bytes it has sent or negative error value on failure.
+ */
+static inline int rpmsg_trysendv(struct rpmsg_endpoint *ept,
+				 const struct rpmsg_iovec *iov, int iovcnt)
+{
+	return rpmsg_send_offchannel_iov(ept, ept->addr, ept->dest_addr, iov,
+					 iovcnt, false);
+}
+
 /**
  * @brief Holds the rx buffer for usage outside the receive callback.
  *
@@ -436,6 +559,88 @@ static inline int rpmsg_send_nocopy(struct rpmsg_endpoint *ept,
 					    ept->dest_addr, data, len);
 }
 
+/**
+ * rpmsg_batch_begin() - start a batch of tx buffers for the ept endpoint
+ *
+ * The batch collects tx buffers reserved by rpmsg_get_tx_payload_buffer() and
+ * filled by the application. rpmsg_batch_commit() places all of them on the
+ * virtqueue under one lock and notifies the remote processor once, instead of
+ * once per message as rpmsg_send_nocopy() does.
+ *
+ * @ept:   The rpmsg endpoint
+ * @batch: The batch to initialize
+ *
+ * @return RPMSG_SUCCESS or RPMSG_ERR_PARAM.
+ *
+ * @see rpmsg_batch_addto
+ * @see rpmsg_batch_commit
+ */
+int rpmsg_batch_begin(struct rpmsg_endpoint *ept, struct rpmsg_batch *batch);
+
+/**
+ * rpmsg_batch_addto() - add a filled tx buffer to a batch, specify dst
+ *
+ * The tx buffer is not sent before rpmsg_batch_commit(). Until then it is
+ * still owned by the application and must not be released.
+ *
+ * @batch: The batch started by rpmsg_batch_begin()
+ * @data:  TX buffer with message filled
+ * @len:   Length of payload
+ * @dst:   Destination address
+ *
+ * @return RPMSG_SUCCESS, RPMSG_ERR_NO_MEM when the batch already holds
+ *         RPMSG_BATCH_SIZE messages or RPMSG_ERR_PARAM.
+ *
+ * @see rpmsg_batch_add
+ */
+int rpmsg_batch_addto(struct rpmsg_batch *batch, const void *data, int len,
+		      uint32_t dst);
+
+/**
+ * rpmsg_batch_add() - add a filled tx buffer to a batch
+ *
+ * Same as rpmsg_batch_addto() with the destination address of the endpoint.
+ *
+ * @batch: The batch started by rpmsg_batch_begin()
+ * @data:  TX buffer with message filled
+ * @len:   Length of payload
+ *
+ * @return RPMSG_SUCCESS or negative error value on failure.
+ */
+static inline int rpmsg_batch_add(struct rpmsg_batch *batch,
+				  const void *data, int len)
+{
+	if (!batch || !batch->ept)
+		return RPMSG_ERR_PARAM;
+	return rpmsg_batch_addto(batch, data, len, batch->ept->dest_addr);
+}
+
+/**
+ * rpmsg_batch_is_full() - check whether a batch takes no more messages
+ *
+ * @batch: The batch started by rpmsg_batch_begin()
+ *
+ * @return true if rpmsg_batch_commit() has to be called before the next add.
+ */
+static inline bool rpmsg_batch_is_full(const struct rpmsg_batch *batch)
+{
+	return batch->num >= RPMSG_BATCH_SIZE;
+}
+
+/**
+ * rpmsg_batch_commit() - send all tx buffers of a batch
+ *
+ * The buffers are sent in the order they were added, with a single
+ * notification of the remote processor. Afterwards the buffers are no more
+ * owned by the application and the batch is empty and can be filled again.
+ * An empty batch is not notified.
+ *
+ * @batch: The batch started by rpmsg_batch_begin()
+ *
+ * @return number of bytes sent or negative error value on failure.
+ */
+int rpmsg_batch_commit(struct rpmsg_batch *batch);
+
 /**
  * rpmsg_init_ept - initialize rpmsg endpoint
  *
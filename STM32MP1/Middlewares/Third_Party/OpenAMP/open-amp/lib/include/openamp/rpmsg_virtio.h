@@ -14,6 +14,7 @@
 
 #include <metal/io.h>
 #include <metal/mutex.h>
+#include <metal/semaphore.h>
 #include <openamp/rpmsg.h>
 #include <openamp/virtio.h>
 
@@ -28,6 +29,37 @@ extern "C" {
 
 /* The feature bitmap for virtio rpmsg */
 #define VIRTIO_RPMSG_F_NS	0 /* RP supports name service notifications */
+#define VIRTIO_RPMSG_F_BUFSZ	2 /* RP gives buffer sizes in config space */
+
+/**
+ * struct virtio_rpmsg_config - config space of the rpmsg virtio device
+ *
+ * The remote fills it in the vdev resource entry with VIRTIO_RPMSG_F_BUFSZ
+ * to accept buffers larger than RPMSG_BUFFER_SIZE. A master without the
+ * feature keeps RPMSG_BUFFER_SIZE for both directions.
+ *
+ * @h2r_buf_size: largest master to remote buffer the remote accepts
+ * @r2h_buf_size: largest remote to master buffer the remote asks for
+ */
+struct virtio_rpmsg_config {
+	uint32_t h2r_buf_size;
+	uint32_t r2h_buf_size;
+};
+
+/**
+ * struct rpmsg_virtio_config - buffer sizes wanted by the rpmsg virtio master
+ *
+ * The master uses the smaller of its own and the remote sizes, if the remote
+ * offers VIRTIO_RPMSG_F_BUFSZ. The sizes include the rpmsg header and are
+ * multiples of 4 bytes.
+ *
+ * @h2r_buf_size: size of the buffers the master sends to the remote
+ * @r2h_buf_size: size of the buffers the master receives from the remote
+ */
+struct rpmsg_virtio_config {
+	uint32_t h2r_buf_size;
+	uint32_t r2h_buf_size;
+};
 
 /**
  * struct rpmsg_virtio_shm_pool - shared memory pool used for rpmsg buffers
@@ -49,6 +81,15 @@ struct rpmsg_virtio_shm_pool {
  * @svq: pointer to send virtqueue
  * @shbuf_io: pointer to the shared buffer I/O region
  * @shpool: pointer to the shared buffers pool
+ * @tx_free: semaphore the platform posts when the peer notifies returned tx
+ *           buffers, NULL to poll for them
+ * @tx_free_armed: the peer was asked to notify returned tx buffers
+ * @rx_draining: the rx callback drains the receive virtqueue and notifies
+ *               the returned rx buffers once it is empty
+ * @h2r_buf_size: size of the master to remote buffers, master only
+ * @r2h_buf_size: size of the remote to master buffers, master only
+ * @tx_bufs: tx buffers taken from the shared buffers pool, master only
+ * @lockless: each virtqueue has a single owner, see rpmsg_virtio_set_lockless()
  */
 struct rpmsg_virtio_device {
 	struct rpmsg_device rdev;
@@ -57,6 +98,13 @@ struct rpmsg_virtio_device {
 	struct virtqueue *svq;
 	struct metal_io_region *shbuf_io;
 	struct rpmsg_virtio_shm_pool *shpool;
+	struct metal_sem *tx_free;
+	int tx_free_armed;
+	int rx_draining;
+	uint32_t h2r_buf_size;
+	uint32_t r2h_buf_size;
+	uint16_t tx_bufs;
+	int lockless;
 };
 
 #define RPMSG_REMOTE	VIRTIO_DEV_SLAVE
@@ -109,6 +157,56 @@ rpmsg_virtio_create_virtqueues(struct rpmsg_virtio_device *rvdev,
 					callbacks);
 }
 
+/**
+ * rpmsg_virtio_set_tx_free_sem - wait for returned tx buffers on a semaphore
+ *
+ * Senders waiting for a tx buffer block on @sem instead of sleeping 1 ms
+ * between polls, and a sender which finds no tx buffer asks the peer to
+ * notify the next returned one. The platform has to post @sem when the
+ * peer notifies the send virtqueue, in most cases from the mailbox
+ * interrupt. Call it after rpmsg_init_vdev().
+ *
+ * @rvdev - pointer to the rpmsg virtio device
+ * @sem   - semaphore posted for the send virtqueue, NULL to poll again
+ */
+static inline void
+rpmsg_virtio_set_tx_free_sem(struct rpmsg_virtio_device *rvdev,
+			     struct metal_sem *sem)
+{
+	rvdev->tx_free = sem;
+}
+
+/**
+ * rpmsg_virtio_set_lockless - use the virtqueues without the device lock
+ *
+ * Each virtqueue gets a single owner: the receive one belongs to the context
+ * which handles the notifications of the peer and the send one to the
+ * context which sends. The two may run concurrently, the vring indexes and
+ * their fences order the owner and the peer. The receive and the send paths
+ * then no longer take rdev->lock, which saves several lock round trips per
+ * message. Only a message to a reserved address, e.g. the name service,
+ * takes it to look its endpoint up in the list of the device.
+ *
+ * With @lockless set:
+ * - rpmsg_get_tx_payload_buffer() and all sends, the name service messages
+ *   of rpmsg_create_ept() and rpmsg_destroy_ept() included, have to be
+ *   called from one context.
+ * - rpmsg_release_rx_buffer() has to be called from the receive context.
+ * - an endpoint must not be destroyed while a message for it is handled.
+ *
+ * Building with RPMSG_VIRTIO_LOCKLESS defined makes every device lockless
+ * and removes the lock from these paths at compile time. Call it after
+ * rpmsg_init_vdev(), before any message is sent.
+ *
+ * @rvdev    - pointer to the rpmsg virtio device
+ * @lockless - 1 for single owner virtqueues, 0 to lock them again
+ */
+static inline void rpmsg_virtio_set_lockless(struct rpmsg_virtio_device *rvdev,
+					     int lockless)
+{
+	rvdev->lockless = lockless;
+}
+
 /**
  * rpmsg_virtio_get_buffer_size - get rpmsg virtio buffer size
  *
@@ -145,6 +243,33 @@ int rpmsg_init_vdev(struct rpmsg_virtio_device *rvdev,
 		    struct metal_io_region *shm_io,
 		    struct rpmsg_virtio_shm_pool *shpool);
 
+/**
+ * rpmsg_init_vdev_with_config - initialize rpmsg virtio device with config
+ *
+ * Same as rpmsg_init_vdev(), the master also takes the buffer sizes from
+ * @config, see struct rpmsg_virtio_config. The master checks that the
+ * buffers of both virtqueues fit in @shpool before it gives any buffer to
+ * the remote. The slave ignores @config, its buffer sizes are in the vdev
+ * resource entry.
+ *
+ * @param rvdev  - pointer to the rpmsg virtio device
+ * @param vdev   - pointer to the virtio device
+ * @param ns_bind_cb  - callback handler for name service announcement without
+ *                      local endpoints waiting to bind.
+ * @param shm_io - pointer to the share memory I/O region.
+ * @param shpool - pointer to shared memory pool. rpmsg_virtio_init_shm_pool has
+ *                 to be called first to fill this structure.
+ * @param config - buffer sizes of the master, NULL for RPMSG_BUFFER_SIZE
+ *
+ * @return - status of function execution
+ */
+int rpmsg_init_vdev_with_config(struct rpmsg_virtio_device *rvdev,
+				struct virtio_device *vdev,
+				rpmsg_ns_bind_cb ns_bind_cb,
+				struct metal_io_region *shm_io,
+				struct rpmsg_virtio_shm_pool *shpool,
+				const struct rpmsg_virtio_config *config);
+
 /**
  * rpmsg_deinit_vdev - deinitialize rpmsg virtio device
  *
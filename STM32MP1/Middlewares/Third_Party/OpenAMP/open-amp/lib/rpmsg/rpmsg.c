@@ -127,6 +127,46 @@ int rpmsg_send_offchannel_raw(struct rpmsg_endpoint *ept, uint32_t src,
 	return RPMSG_ERR_PARAM;
 }
 
+/**
+ * This function sends rpmsg "message" gathered from fragments to remote
+ * device.
+ *
+ * @param ept     - pointer to end point
+ * @param src     - source address of channel
+ * @param dst     - destination address of channel
+ * @param iov     - fragments of the data to transmit
+ * @param iovcnt  - number of fragments
+ * @param wait    - boolean, wait or not for buffer to become
+ *                  available
+ *
+ * @return - size of data sent or negative value for failure.
+ *
+ */
+int rpmsg_send_offchannel_iov(struct rpmsg_endpoint *ept, uint32_t src,
+			      uint32_t dst, const struct rpmsg_iovec *iov,
+			      int iovcnt, int wait)
+{
+	struct rpmsg_device *rdev;
+	int i;
+
+	if (!ept || !ept->rdev || (!iov && iovcnt) || iovcnt < 0 ||
+	    dst == RPMSG_ADDR_ANY)
+		return RPMSG_ERR_PARAM;
+
+	for (i = 0; i < iovcnt; i++) {
+		if (iov[i].len < 0 || (!iov[i].base && iov[i].len))
+			return RPMSG_ERR_PARAM;
+	}
+
+	rdev = ept->rdev;
+
+	if (rdev->ops.send_offchannel_iov)
+		return rdev->ops.send_offchannel_iov(rdev, src, dst, iov,
+						     iovcnt, wait);
+
+	return RPMSG_ERR_PARAM;
+}
+
 int rpmsg_send_ns_message(struct rpmsg_endpoint *ept, unsigned long flags)
 {
 	struct rpmsg_ns_msg ns_msg;
@@ -203,6 +243,55 @@ int rpmsg_send_offchannel_nocopy(struct rpmsg_endpoint *ept, uint32_t src,
 	return RPMSG_ERR_PARAM;
 }
 
+int rpmsg_batch_begin(struct rpmsg_endpoint *ept, struct rpmsg_batch *batch)
+{
+	if (!ept || !ept->rdev || !batch)
+		return RPMSG_ERR_PARAM;
+
+	batch->ept = ept;
+	batch->num = 0;
+	return RPMSG_SUCCESS;
+}
+
+int rpmsg_batch_addto(struct rpmsg_batch *batch, const void *data, int len,
+		      uint32_t dst)
+{
+	if (!batch || !batch->ept || !data || len < 0 ||
+	    dst == RPMSG_ADDR_ANY)
+		return RPMSG_ERR_PARAM;
+
+	if (rpmsg_batch_is_full(batch))
+		return RPMSG_ERR_NO_MEM;
+
+	batch->dst[batch->num] = dst;
+	batch->data[batch->num] = data;
+	batch->len[batch->num] = len;
+	batch->num++;
+	return RPMSG_SUCCESS;
+}
+
+int rpmsg_batch_commit(struct rpmsg_batch *batch)
+{
+	struct rpmsg_device *rdev;
+	int ret;
+
+	if (!batch || !batch->ept || !batch->ept->rdev)
+		return RPMSG_ERR_PARAM;
+
+	if (!batch->num)
+		return 0;
+
+	rdev = batch->ept->rdev;
+
+	if (!rdev->ops.send_batch_nocopy)
+		return RPMSG_ERR_PARAM;
+
+	ret = rdev->ops.send_batch_nocopy(rdev, batch);
+	if (ret >= 0)
+		batch->num = 0;
+	return ret;
+}
+
 struct rpmsg_endpoint *rpmsg_get_endpoint(struct rpmsg_device *rdev,
 					  const char *name, uint32_t addr,
 					  uint32_t dest_addr)
@@ -239,11 +328,14 @@ struct rpmsg_endpoint *rpmsg_get_endpoint(struct rpmsg_device *rdev,
 static void rpmsg_unregister_endpoint(struct rpmsg_endpoint *ept)
 {
 	struct rpmsg_device *rdev = ept->rdev;
+	int idx = rpmsg_get_ept_table_index(ept->addr);
 
 	metal_mutex_acquire(&rdev->lock);
 	if (ept->addr != RPMSG_ADDR_ANY)
 		rpmsg_release_address(rdev->bitmap, RPMSG_ADDR_BMP_SIZE,
 				      ept->addr);
+	if (idx >= 0 && rdev->ept_table[idx] == ept)
+		rdev->ept_table[idx] = NULL;
 	metal_list_del(&ept->node);
 	ept->rdev = NULL;
 	metal_mutex_release(&rdev->lock);
@@ -252,8 +344,12 @@ static void rpmsg_unregister_endpoint(struct rpmsg_endpoint *ept)
 void rpmsg_register_endpoint(struct rpmsg_device *rdev,
 			     struct rpmsg_endpoint *ept)
 {
+	int idx = rpmsg_get_ept_table_index(ept->addr);
+
 	ept->rdev = rdev;
 	metal_list_add_tail(&rdev->endpoints, &ept->node);
+	if (idx >= 0)
+		rdev->ept_table[idx] = ept;
 }
 
 int rpmsg_create_ept(struct rpmsg_endpoint *ept, struct rpmsg_device *rdev,
@@ -120,9 +120,41 @@ struct rpmsg_endpoint *rpmsg_get_endpoint(struct rpmsg_device *rvdev,
 void rpmsg_register_endpoint(struct rpmsg_device *rdev,
 			     struct rpmsg_endpoint *ept);
 
+/**
+ * rpmsg_get_ept_table_index
+ *
+ * @param addr - local endpoint address
+ *
+ * @return - index of @addr in the endpoint table of the device, -1 for an
+ *           address outside of the table, such as a reserved address
+ */
+static inline int rpmsg_get_ept_table_index(uint32_t addr)
+{
+	if (addr < RPMSG_RESERVED_ADDRESSES ||
+	    addr - RPMSG_RESERVED_ADDRESSES >= RPMSG_ADDR_BMP_SIZE)
+		return -1;
+	return (int)(addr - RPMSG_RESERVED_ADDRESSES);
+}
+
+/**
+ * rpmsg_get_ept_from_addr
+ *
+ * Looks an endpoint up by its local address, in constant time for the
+ * addresses of the endpoint table. Must be called with the device lock held,
+ * a lockless device may read a table entry without it.
+ *
+ * @param rdev - pointer to rpmsg device
+ * @param addr - local endpoint address
+ *
+ * @return - endpoint, NULL if none is bound to @addr
+ */
 static inline struct rpmsg_endpoint *
 rpmsg_get_ept_from_addr(struct rpmsg_device *rdev, uint32_t addr)
 {
+	int idx = rpmsg_get_ept_table_index(addr);
+
+	if (idx >= 0)
+		return rdev->ept_table[idx];
 	return rpmsg_get_endpoint(rdev, NULL, addr, RPMSG_ADDR_ANY);
 }
 
@@ -23,6 +23,32 @@
 /* Time to wait - In multiple of 1 msecs. */
 #define RPMSG_TICKS_PER_INTERVAL                1000
 
+#ifdef RPMSG_VIRTIO_LOCKLESS
+#define rpmsg_virtio_is_lockless(rvdev)	((void)(rvdev), 1)
+#else
+#define rpmsg_virtio_is_lockless(rvdev)	((rvdev)->lockless)
+#endif
+
+/**
+ * rpmsg_virtio_vq_lock
+ *
+ * Locks the device around a virtqueue operation of the receive or the send
+ * path, unless each virtqueue has a single owner.
+ *
+ * @param rvdev - pointer to rpmsg virtio device
+ */
+static inline void rpmsg_virtio_vq_lock(struct rpmsg_virtio_device *rvdev)
+{
+	if (!rpmsg_virtio_is_lockless(rvdev))
+		metal_mutex_acquire(&rvdev->rdev.lock);
+}
+
+static inline void rpmsg_virtio_vq_unlock(struct rpmsg_virtio_device *rvdev)
+{
+	if (!rpmsg_virtio_is_lockless(rvdev))
+		metal_mutex_release(&rvdev->rdev.lock);
+}
+
 #ifndef VIRTIO_SLAVE_ONLY
 metal_weak void *
 rpmsg_virtio_shm_pool_get_buffer(struct rpmsg_virtio_shm_pool *shpool,
@@ -143,10 +169,16 @@ static void *rpmsg_virtio_get_tx_buffer(struct rpmsg_virtio_device *rvdev,
 #ifndef VIRTIO_SLAVE_ONLY
 	if (role == RPMSG_MASTER) {
 		data = virtqueue_get_buffer(rvdev->svq, len, idx);
-		if (!data && rvdev->svq->vq_free_cnt) {
+		/*
+		 * Buffers reserved by the application hold no descriptor, the
+		 * pool may only hand out as many as the vring takes.
+		 */
+		if (!data && rvdev->tx_bufs < rvdev->svq->vq_nentries) {
 			data = rpmsg_virtio_shm_pool_get_buffer(rvdev->shpool,
-							RPMSG_BUFFER_SIZE);
-			*len = RPMSG_BUFFER_SIZE;
+							rvdev->h2r_buf_size);
+			if (data)
+				rvdev->tx_bufs++;
+			*len = rvdev->h2r_buf_size;
 			*idx = 0;
 		}
 	}
@@ -237,9 +269,9 @@ static int _rpmsg_virtio_get_buffer_size(struct rpmsg_virtio_device *rvdev)
 	if (role == RPMSG_MASTER) {
 		/*
 		 * If device role is Master then buffers are provided by us,
-		 * so just provide the macro.
+		 * so just provide the negotiated size.
 		 */
-		length = RPMSG_BUFFER_SIZE - sizeof(struct rpmsg_hdr);
+		length = rvdev->h2r_buf_size - sizeof(struct rpmsg_hdr);
 	}
 #endif /*!VIRTIO_SLAVE_ONLY*/
 
@@ -286,11 +318,19 @@ static void rpmsg_virtio_release_rx_buffer(struct rpmsg_device *rdev,
 	/* The reserved field contains buffer index */
 	idx = (uint16_t)(rp_hdr->reserved & ~RPMSG_BUF_HELD);
 
-	metal_mutex_acquire(&rdev->lock);
+	rpmsg_virtio_vq_lock(rvdev);
 	/* Return buffer on virtqueue. */
 	len = virtqueue_get_buffer_length(rvdev->rvq, idx);
 	rpmsg_virtio_return_buffer(rvdev, rp_hdr, len, idx);
-	metal_mutex_release(&rdev->lock);
+	/*
+	 * The peer may wait for the buffer. A running rx callback notifies
+	 * all the buffers returned during its drain at once, otherwise
+	 * notify now: virtqueue_kick() only interrupts the peer if it asked
+	 * for it, with the event index or by clearing its no-notify flag.
+	 */
+	if (!rvdev->rx_draining)
+		virtqueue_kick(rvdev->rvq);
+	rpmsg_virtio_vq_unlock(rvdev);
 }
 
 static void *rpmsg_virtio_get_tx_payload_buffer(struct rpmsg_device *rdev,
@@ -317,13 +357,37 @@ static void *rpmsg_virtio_get_tx_payload_buffer(struct rpmsg_device *rdev,
 
 	while (1) {
 		/* Lock the device to enable exclusive access to virtqueues */
-		metal_mutex_acquire(&rdev->lock);
+		rpmsg_virtio_vq_lock(rvdev);
 		rp_hdr = rpmsg_virtio_get_tx_buffer(rvdev, len, &idx);
-		metal_mutex_release(&rdev->lock);
+		if (!rp_hdr && rvdev->tx_free) {
+			/*
+			 * Ask the peer to notify the next returned buffer,
+			 * a buffer returned before it saw the request is
+			 * picked up here. With the event index the request
+			 * only holds for one notification, renew it.
+			 */
+			rvdev->tx_free_armed = 1;
+			if (virtqueue_enable_cb(rvdev->svq))
+				rp_hdr = rpmsg_virtio_get_tx_buffer(rvdev, len,
+								    &idx);
+		}
+		if (rp_hdr && rvdev->tx_free_armed) {
+			/* Buffers are available, suppress the notification */
+			virtqueue_disable_cb(rvdev->svq);
+			rvdev->tx_free_armed = 0;
+		}
+		rpmsg_virtio_vq_unlock(rvdev);
 		if (rp_hdr || !tick_count)
 			break;
-		metal_sleep_usec(RPMSG_TICKS_PER_INTERVAL);
-		tick_count--;
+		if (rvdev->tx_free) {
+			/* Only a timeout counts, a post means buffer activity */
+			if (metal_sem_wait(rvdev->tx_free,
+					   RPMSG_TICKS_PER_INTERVAL))
+				tick_count--;
+		} else {
+			metal_sleep_usec(RPMSG_TICKS_PER_INTERVAL);
+			tick_count--;
+		}
 	}
 
 	if (!rp_hdr)
@@ -337,21 +401,30 @@ static void *rpmsg_virtio_get_tx_payload_buffer(struct rpmsg_device *rdev,
 	return RPMSG_LOCATE_DATA(rp_hdr);
 }
 
-static int rpmsg_virtio_send_offchannel_nocopy(struct rpmsg_device *rdev,
-					       uint32_t src, uint32_t dst,
-					       const void *data, int len)
+/**
+ * rpmsg_virtio_fill_tx_header
+ *
+ * Writes the RPMsg header of a tx buffer reserved by
+ * rpmsg_virtio_get_tx_payload_buffer().
+ *
+ * @param rvdev - pointer to rpmsg virtio device
+ * @param src   - source address of channel
+ * @param dst   - destination address of channel
+ * @param data  - tx payload buffer
+ * @param len   - size of data
+ *
+ * @return - buffer index stored when the buffer was reserved
+ */
+static uint16_t rpmsg_virtio_fill_tx_header(struct rpmsg_virtio_device *rvdev,
+					    uint32_t src, uint32_t dst,
+					    const void *data, int len)
 {
-	struct rpmsg_virtio_device *rvdev;
 	struct metal_io_region *io;
 	struct rpmsg_hdr rp_hdr;
 	struct rpmsg_hdr *hdr;
-	uint32_t buff_len;
 	uint16_t idx;
 	int status;
 
-	/* Get the associated remote device for channel. */
-	rvdev = metal_container_of(rdev, struct rpmsg_virtio_device, rdev);
-
 	hdr = RPMSG_LOCATE_HDR(data);
 	/* The reserved field contains buffer index */
 	idx = hdr->reserved;
@@ -369,11 +442,31 @@ static int rpmsg_virtio_send_offchannel_nocopy(struct rpmsg_device *rdev,
 				      &rp_hdr, sizeof(rp_hdr));
 	RPMSG_ASSERT(status == sizeof(rp_hdr), "failed to write header\r\n");
 
-	metal_mutex_acquire(&rdev->lock);
+	return idx;
+}
+
+/**
+ * rpmsg_virtio_enqueue_tx_buffer
+ *
+ * Places a tx buffer with filled header on the send virtqueue, without
+ * notifying the other side. Must be called with the device lock held.
+ *
+ * @param rvdev - pointer to rpmsg virtio device
+ * @param data  - tx payload buffer
+ * @param idx   - buffer index returned by rpmsg_virtio_fill_tx_header()
+ */
+static void rpmsg_virtio_enqueue_tx_buffer(struct rpmsg_virtio_device *rvdev,
+					   const void *data, uint16_t idx)
+{
+	struct rpmsg_hdr *hdr;
+	uint32_t buff_len;
+	int status;
+
+	hdr = RPMSG_LOCATE_HDR(data);
 
 #ifndef VIRTIO_SLAVE_ONLY
 	if (rpmsg_virtio_get_role(rvdev) == RPMSG_MASTER)
-		buff_len = RPMSG_BUFFER_SIZE;
+		buff_len = rvdev->h2r_buf_size;
 	else
 #endif /*!VIRTIO_SLAVE_ONLY*/
 		buff_len = virtqueue_get_buffer_length(rvdev->svq, idx);
@@ -381,38 +474,101 @@ static int rpmsg_virtio_send_offchannel_nocopy(struct rpmsg_device *rdev,
 	/* Enqueue buffer on virtqueue. */
 	status = rpmsg_virtio_enqueue_buffer(rvdev, hdr, buff_len, idx);
 	RPMSG_ASSERT(status == VQUEUE_SUCCESS, "failed to enqueue buffer\r\n");
+}
+
+static int rpmsg_virtio_send_offchannel_nocopy(struct rpmsg_device *rdev,
+					       uint32_t src, uint32_t dst,
+					       const void *data, int len)
+{
+	struct rpmsg_virtio_device *rvdev;
+	uint16_t idx;
+
+	/* Get the associated remote device for channel. */
+	rvdev = metal_container_of(rdev, struct rpmsg_virtio_device, rdev);
+
+	idx = rpmsg_virtio_fill_tx_header(rvdev, src, dst, data, len);
+
+	rpmsg_virtio_vq_lock(rvdev);
+	rpmsg_virtio_enqueue_tx_buffer(rvdev, data, idx);
 	/* Let the other side know that there is a job to process. */
 	virtqueue_kick(rvdev->svq);
-
-	metal_mutex_release(&rdev->lock);
+	rpmsg_virtio_vq_unlock(rvdev);
 
 	return len;
 }
 
 /**
- * This function sends rpmsg "message" to remote device.
+ * rpmsg_virtio_send_batch_nocopy
+ *
+ * Sends all tx buffers of a batch, the other side is notified once after
+ * the last buffer is placed on the virtqueue.
+ *
+ * @param rdev  - pointer to rpmsg device
+ * @param batch - batch filled by rpmsg_batch_add()
+ *
+ * @return - total size of data sent
+ */
+static int rpmsg_virtio_send_batch_nocopy(struct rpmsg_device *rdev,
+					  const struct rpmsg_batch *batch)
+{
+	struct rpmsg_virtio_device *rvdev;
+	uint16_t idx[RPMSG_BATCH_SIZE];
+	uint32_t src;
+	int total = 0;
+	int i;
+
+	/* Get the associated remote device for channel. */
+	rvdev = metal_container_of(rdev, struct rpmsg_virtio_device, rdev);
+	src = batch->ept->addr;
+
+	/* Headers are written outside of the lock, as for a single message */
+	for (i = 0; i < batch->num; i++) {
+		idx[i] = rpmsg_virtio_fill_tx_header(rvdev, src, batch->dst[i],
+						     batch->data[i],
+						     batch->len[i]);
+		total += batch->len[i];
+	}
+
+	rpmsg_virtio_vq_lock(rvdev);
+	for (i = 0; i < batch->num; i++)
+		rpmsg_virtio_enqueue_tx_buffer(rvdev, batch->data[i], idx[i]);
+	/* Let the other side know that there is a job to process. */
+	virtqueue_kick(rvdev->svq);
+	rpmsg_virtio_vq_unlock(rvdev);
+
+	return total;
+}
+
+/**
+ * This function sends rpmsg "message" gathered from fragments to remote
+ * device. The fragments are copied one after the other into a single tx
+ * buffer, the other side receives one message.
  *
  * @param rdev    - pointer to rpmsg device
  * @param src     - source address of channel
  * @param dst     - destination address of channel
- * @param data    - data to transmit
- * @param len     - size of data
+ * @param iov     - fragments of the data to transmit
+ * @param iovcnt  - number of fragments
  * @param wait    - boolean, wait or not for buffer to become
  *                  available
  *
  * @return - size of data sent or negative value for failure.
  *
  */
-static int rpmsg_virtio_send_offchannel_raw(struct rpmsg_device *rdev,
+static int rpmsg_virtio_send_offchannel_iov(struct rpmsg_device *rdev,
 					    uint32_t src, uint32_t dst,
-					    const void *data,
-					    int len, int wait)
+					    const struct rpmsg_iovec *iov,
+					    int iovcnt, int wait)
 {
 	struct rpmsg_virtio_device *rvdev;
 	struct metal_io_region *io;
+	unsigned long offset;
 	uint32_t buff_len;
 	void *buffer;
 	int status;
+	int len = 0;
+	int frag;
+	int i;
 
 	/* Get the associated remote device for channel. */
 	rvdev = metal_container_of(rdev, struct rpmsg_virtio_device, rdev);
@@ -422,17 +578,50 @@ static int rpmsg_virtio_send_offchannel_raw(struct rpmsg_device *rdev,
 	if (!buffer)
 		return RPMSG_ERR_NO_BUFF;
 
-	/* Copy data to rpmsg buffer. */
-	if (len > (int)buff_len)
-		len = buff_len;
+	/* Copy the fragments to rpmsg buffer, as much as fits. */
 	io = rvdev->shbuf_io;
-	status = metal_io_block_write(io, metal_io_virt_to_offset(io, buffer),
-				      data, len);
-	RPMSG_ASSERT(status == len, "failed to write buffer\r\n");
+	offset = metal_io_virt_to_offset(io, buffer);
+	for (i = 0; i < iovcnt && len < (int)buff_len; i++) {
+		frag = iov[i].len;
+		if (frag > (int)buff_len - len)
+			frag = buff_len - len;
+		if (!frag)
+			continue;
+		status = metal_io_block_write(io, offset + len, iov[i].base,
+					      frag);
+		RPMSG_ASSERT(status == frag, "failed to write buffer\r\n");
+		len += frag;
+	}
 
 	return rpmsg_virtio_send_offchannel_nocopy(rdev, src, dst, buffer, len);
 }
 
+/**
+ * This function sends rpmsg "message" to remote device.
+ *
+ * @param rdev    - pointer to rpmsg device
+ * @param src     - source address of channel
+ * @param dst     - destination address of channel
+ * @param data    - data to transmit
+ * @param len     - size of data
+ * @param wait    - boolean, wait or not for buffer to become
+ *                  available
+ *
+ * @return - size of data sent or negative value for failure.
+ *
+ */
+static int rpmsg_virtio_send_offchannel_raw(struct rpmsg_device *rdev,
+					    uint32_t src, uint32_t dst,
+					    const void *data,
+					    int len, int wait)
+{
+	struct rpmsg_iovec iov;
+
+	iov.base = data;
+	iov.len = len;
+	return rpmsg_virtio_send_offchannel_iov(rdev, src, dst, &iov, 1, wait);
+}
+
 /**
  * rpmsg_virtio_tx_callback
  *
@@ -466,20 +655,33 @@ static void rpmsg_virtio_rx_callback(struct virtqueue *vq)
 	uint16_t idx;
 	int status;
 
-	metal_mutex_acquire(&rdev->lock);
+	rpmsg_virtio_vq_lock(rvdev);
 
 	/* Process the received data from remote node */
 	rp_hdr = rpmsg_virtio_get_rx_buffer(rvdev, &len, &idx);
+	if (rp_hdr)
+		rvdev->rx_draining = 1;
 
-	metal_mutex_release(&rdev->lock);
+	rpmsg_virtio_vq_unlock(rvdev);
 
 	while (rp_hdr) {
 		rp_hdr->reserved = idx;
 
-		/* Get the channel node from the remote device channels list. */
-		metal_mutex_acquire(&rdev->lock);
-		ept = rpmsg_get_ept_from_addr(rdev, rp_hdr->dst);
-		metal_mutex_release(&rdev->lock);
+		/*
+		 * Get the channel node from the remote device channels list.
+		 * Lockless, the table entry is read in one access and the
+		 * endpoint outlives its messages. The addresses outside of
+		 * the table, the reserved ones such as the name service,
+		 * are in the list, which is only walked under the lock.
+		 */
+		if (rpmsg_virtio_is_lockless(rvdev) &&
+		    rpmsg_get_ept_table_index(rp_hdr->dst) >= 0) {
+			ept = rpmsg_get_ept_from_addr(rdev, rp_hdr->dst);
+		} else {
+			metal_mutex_acquire(&rdev->lock);
+			ept = rpmsg_get_ept_from_addr(rdev, rp_hdr->dst);
+			metal_mutex_release(&rdev->lock);
+		}
 
 		if (ept) {
 			if (ept->dest_addr == RPMSG_ADDR_ANY) {
@@ -496,7 +698,7 @@ static void rpmsg_virtio_rx_callback(struct virtqueue *vq)
 				     "unexpected callback status\r\n");
 		}
 
-		metal_mutex_acquire(&rdev->lock);
+		rpmsg_virtio_vq_lock(rvdev);
 
 		/* Check whether callback wants to hold buffer */
 		if (!(rp_hdr->reserved & RPMSG_BUF_HELD)) {
@@ -508,8 +710,19 @@ static void rpmsg_virtio_rx_callback(struct virtqueue *vq)
 		if (!rp_hdr) {
 			/* tell peer we return some rx buffer */
 			virtqueue_kick(rvdev->rvq);
+			/*
+			 * Publish the event index of the drained ring, the
+			 * peer notifies the next message only. Messages
+			 * added before the peer saw the index are not
+			 * notified, pick them up here.
+			 */
+			if (virtqueue_enable_cb(rvdev->rvq))
+				rp_hdr = rpmsg_virtio_get_rx_buffer(rvdev,
+								    &len, &idx);
+			if (!rp_hdr)
+				rvdev->rx_draining = 0;
 		}
-		metal_mutex_release(&rdev->lock);
+		rpmsg_virtio_vq_unlock(rvdev);
 	}
 }
 
@@ -594,11 +807,61 @@ int rpmsg_virtio_get_buffer_size(struct rpmsg_device *rdev)
 	return size;
 }
 
+#ifndef VIRTIO_SLAVE_ONLY
+/**
+ * rpmsg_virtio_set_buffer_sizes
+ *
+ * Sets the buffer sizes of the master, the sizes of the config or
+ * RPMSG_BUFFER_SIZE, limited to the sizes of the remote if it offers
+ * VIRTIO_RPMSG_F_BUFSZ.
+ *
+ * @param rvdev  - pointer to rpmsg virtio device
+ * @param config - buffer sizes of the master, NULL for RPMSG_BUFFER_SIZE
+ *
+ * @return - status of function execution
+ */
+static int rpmsg_virtio_set_buffer_sizes(struct rpmsg_virtio_device *rvdev,
+				const struct rpmsg_virtio_config *config)
+{
+	struct virtio_rpmsg_config rcfg;
+
+	rvdev->h2r_buf_size = RPMSG_BUFFER_SIZE;
+	rvdev->r2h_buf_size = RPMSG_BUFFER_SIZE;
+	if (!config || !(rvdev->vdev->features & (1 << VIRTIO_RPMSG_F_BUFSZ)))
+		return RPMSG_SUCCESS;
+
+	/* Left as is by a config space too short for it */
+	rcfg.h2r_buf_size = RPMSG_BUFFER_SIZE;
+	rcfg.r2h_buf_size = RPMSG_BUFFER_SIZE;
+	rpmsg_virtio_read_config(rvdev, 0, &rcfg, sizeof(rcfg));
+	rvdev->h2r_buf_size = metal_min(config->h2r_buf_size,
+					rcfg.h2r_buf_size);
+	rvdev->r2h_buf_size = metal_min(config->r2h_buf_size,
+					rcfg.r2h_buf_size);
+	if (rvdev->h2r_buf_size <= sizeof(struct rpmsg_hdr) ||
+	    rvdev->r2h_buf_size <= sizeof(struct rpmsg_hdr) ||
+	    rvdev->h2r_buf_size % 4 || rvdev->r2h_buf_size % 4)
+		return RPMSG_ERR_PARAM;
+	return RPMSG_SUCCESS;
+}
+#endif /*!VIRTIO_SLAVE_ONLY*/
+
 int rpmsg_init_vdev(struct rpmsg_virtio_device *rvdev,
 		    struct virtio_device *vdev,
 		    rpmsg_ns_bind_cb ns_bind_cb,
 		    struct metal_io_region *shm_io,
 		    struct rpmsg_virtio_shm_pool *shpool)
+{
+	return rpmsg_init_vdev_with_config(rvdev, vdev, ns_bind_cb, shm_io,
+					   shpool, NULL);
+}
+
+int rpmsg_init_vdev_with_config(struct rpmsg_virtio_device *rvdev,
+				struct virtio_device *vdev,
+				rpmsg_ns_bind_cb ns_bind_cb,
+				struct metal_io_region *shm_io,
+				struct rpmsg_virtio_shm_pool *shpool,
+				const struct rpmsg_virtio_config *config)
 {
 	struct rpmsg_device *rdev;
 	const char *vq_names[RPMSG_NUM_VRINGS];
@@ -610,13 +873,20 @@ int rpmsg_init_vdev(struct rpmsg_virtio_device *rvdev,
 	memset(rdev, 0, sizeof(*rdev));
 	metal_mutex_init(&rdev->lock);
 	rvdev->vdev = vdev;
+	rvdev->tx_free = NULL;
+	rvdev->tx_free_armed = 0;
+	rvdev->rx_draining = 0;
+	rvdev->tx_bufs = 0;
+	rvdev->lockless = 0;
 	rdev->ns_bind_cb = ns_bind_cb;
 	vdev->priv = rvdev;
 	rdev->ops.send_offchannel_raw = rpmsg_virtio_send_offchannel_raw;
+	rdev->ops.send_offchannel_iov = rpmsg_virtio_send_offchannel_iov;
 	rdev->ops.hold_rx_buffer = rpmsg_virtio_hold_rx_buffer;
 	rdev->ops.release_rx_buffer = rpmsg_virtio_release_rx_buffer;
 	rdev->ops.get_tx_payload_buffer = rpmsg_virtio_get_tx_payload_buffer;
 	rdev->ops.send_offchannel_nocopy = rpmsg_virtio_send_offchannel_nocopy;
+	rdev->ops.send_batch_nocopy = rpmsg_virtio_send_batch_nocopy;
 	role = rpmsg_virtio_get_role(rvdev);
 
 #ifndef VIRTIO_MASTER_ONLY
@@ -639,6 +909,9 @@ int rpmsg_init_vdev(struct rpmsg_virtio_device *rvdev,
 		if (!shpool->size)
 			return RPMSG_ERR_NO_BUFF;
 		rvdev->shpool = shpool;
+		status = rpmsg_virtio_set_buffer_sizes(rvdev, config);
+		if (status != RPMSG_SUCCESS)
+			return status;
 
 		vq_names[0] = "rx_vq";
 		vq_names[1] = "tx_vq";
@@ -651,6 +924,7 @@ int rpmsg_init_vdev(struct rpmsg_virtio_device *rvdev,
 
 #ifndef VIRTIO_MASTER_ONLY
 	(void)shpool;
+	(void)config;
 	if (role == RPMSG_REMOTE) {
 		vq_names[0] = "tx_vq";
 		vq_names[1] = "rx_vq";
@@ -688,11 +962,20 @@ int rpmsg_init_vdev(struct rpmsg_virtio_device *rvdev,
 		unsigned int idx;
 		void *buffer;
 
-		vqbuf.len = RPMSG_BUFFER_SIZE;
+		/*
+		 * The tx buffers are taken from the pool on the first send,
+		 * make sure now that they all fit with the rx buffers.
+		 */
+		if (shpool->avail <
+		    (size_t)rvdev->rvq->vq_nentries * rvdev->r2h_buf_size +
+		    (size_t)rvdev->svq->vq_nentries * rvdev->h2r_buf_size)
+			return RPMSG_ERR_NO_BUFF;
+
+		vqbuf.len = rvdev->r2h_buf_size;
 		for (idx = 0; idx < rvdev->rvq->vq_nentries; idx++) {
 			/* Initialize TX virtqueue buffers for remote device */
 			buffer = rpmsg_virtio_shm_pool_get_buffer(shpool,
-							RPMSG_BUFFER_SIZE);
+							rvdev->r2h_buf_size);
 
 			if (!buffer) {
 				return RPMSG_ERR_NO_BUFF;
@@ -703,7 +986,7 @@ int rpmsg_init_vdev(struct rpmsg_virtio_device *rvdev,
 			metal_io_block_set(shm_io,
 					   metal_io_virt_to_offset(shm_io,
 								   buffer),
-					   0x00, RPMSG_BUFFER_SIZE);
+					   0x00, rvdev->r2h_buf_size);
 			status =
 				virtqueue_add_buffer(rvdev->rvq, &vqbuf, 0, 1,
 						     buffer);
@@ -20,6 +20,11 @@
         remote processor (VIRT_UART_read_cb)
         OpenAMP MW deals with memory allocation/free and signal events
     (#) Transmit data on the created rpmsg channel by calling the VIRT_UART_Transmit()
+    (#) Or transmit a message kept in several parts, e.g. a header and a
+        payload, as one message with VIRT_UART_TransmitV()
+    (#) Or transmit without copy: take a shared memory buffer with
+        VIRT_UART_AcquireTxBuffer(), write the message into it and send the
+        used part with VIRT_UART_TransmitNoCopy()
     (#) Receive data in calling VIRT_UART_RegisterCallback to register user callback
 
 
@@ -48,6 +53,9 @@
 /* this string will be sent to remote processor */
 #define RPMSG_SERVICE_NAME              "rpmsg-tty-channel"
 
+/* largest message, the rpmsg header takes 16 bytes of the buffer */
+#define VIRT_UART_MAX_SIZE              (RPMSG_BUFFER_SIZE - 16)
+
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 
@@ -56,6 +64,7 @@ static int VIRT_UART_read_cb(struct rpmsg_endpoint *ept, void *data,
 {
   VIRT_UART_HandleTypeDef *huart = metal_container_of(ept, VIRT_UART_HandleTypeDef, ept);
   (void)src;
+  (void)priv;
 
   huart->pRxBuffPtr = data;
   huart->RxXferSize = len;
@@ -114,7 +123,7 @@ VIRT_UART_StatusTypeDef VIRT_UART_Transmit(VIRT_UART_HandleTypeDef *huart, const
 {
 	int res;
 
-	if (Size > (RPMSG_BUFFER_SIZE-16))
+	if (Size > VIRT_UART_MAX_SIZE)
 	  return VIRT_UART_ERROR;
 
 	res = OPENAMP_send(&huart->ept, pData, Size);
@@ -124,3 +133,78 @@ VIRT_UART_StatusTypeDef VIRT_UART_Transmit(VIRT_UART_HandleTypeDef *huart, const
 
 	return VIRT_UART_OK;
 }
+
+/**
+  * @brief  Send the parts of pIov as one message, they are copied one after
+  *         the other into the shared memory TX buffer.
+  * @param  huart: VIRTUAL UART handle
+  * @param  pIov: parts of the message, in order
+  * @param  IovCnt: number of parts
+  * @retval VIRT_UART_ERROR in case the message is too long or could not be sent
+  */
+VIRT_UART_StatusTypeDef VIRT_UART_TransmitV(VIRT_UART_HandleTypeDef *huart, const struct rpmsg_iovec *pIov,
+                                            uint8_t IovCnt)
+{
+  uint32_t size = 0;
+  uint8_t i;
+
+  for (i = 0; i < IovCnt; i++)
+    size += (uint32_t)pIov[i].len;
+  if (size > VIRT_UART_MAX_SIZE)
+    return VIRT_UART_ERROR;
+
+  if (rpmsg_sendv(&huart->ept, pIov, IovCnt) < 0)
+    return VIRT_UART_ERROR;
+
+  return VIRT_UART_OK;
+}
+
+/**
+  * @brief  Take a shared memory TX buffer to write a message into in place.
+  *         The buffer must be sent with VIRT_UART_TransmitNoCopy(), there is
+  *         no way to give it back unused.
+  * @param  huart: VIRTUAL UART handle
+  * @param  ppData: returns the buffer
+  * @param  pSize: returns the largest message the buffer takes
+  * @param  Wait: wait for a buffer returned by the remote processor,
+  *         for at most 15 s
+  * @retval VIRT_UART_BUSY: all buffers are in use and Wait is 0,
+  *         VIRT_UART_TIMEOUT: no buffer was returned in time,
+  *         VIRT_UART_ERROR: the remote processor did not bind the channel yet
+  */
+VIRT_UART_StatusTypeDef VIRT_UART_AcquireTxBuffer(VIRT_UART_HandleTypeDef *huart, uint8_t **ppData,
+                                                  uint16_t *pSize, uint8_t Wait)
+{
+  uint32_t size;
+
+  /* a buffer taken before the channel is bound could never be sent */
+  if (!is_rpmsg_ept_ready(&huart->ept))
+    return VIRT_UART_ERROR;
+
+  *ppData = rpmsg_get_tx_payload_buffer(&huart->ept, &size, Wait ? 1 : 0);
+  if (*ppData == NULL)
+    return Wait ? VIRT_UART_TIMEOUT : VIRT_UART_BUSY;
+
+  *pSize = (size < VIRT_UART_MAX_SIZE) ? (uint16_t)size : VIRT_UART_MAX_SIZE;
+  return VIRT_UART_OK;
+}
+
+/**
+  * @brief  Send a buffer taken with VIRT_UART_AcquireTxBuffer(), only the
+  *         first Size bytes are transferred. The buffer is owned by the
+  *         remote processor afterwards.
+  * @param  huart: VIRTUAL UART handle
+  * @param  pData: buffer returned by VIRT_UART_AcquireTxBuffer()
+  * @param  Size: message length, at most the size returned with the buffer
+  * @retval VIRT_UART_ERROR in case the message could not be sent
+  */
+VIRT_UART_StatusTypeDef VIRT_UART_TransmitNoCopy(VIRT_UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+  if (Size > VIRT_UART_MAX_SIZE)
+    return VIRT_UART_ERROR;
+
+  if (rpmsg_send_nocopy(&huart->ept, pData, Size) < 0)
+    return VIRT_UART_ERROR;
+
+  return VIRT_UART_OK;
+}
@@ -65,6 +65,11 @@ VIRT_UART_StatusTypeDef VIRT_UART_RegisterCallback(VIRT_UART_HandleTypeDef *huar
 
 /* IO operation functions *****************************************************/
 VIRT_UART_StatusTypeDef VIRT_UART_Transmit(VIRT_UART_HandleTypeDef *huart, const void *pData, uint16_t Size);
+VIRT_UART_StatusTypeDef VIRT_UART_TransmitV(VIRT_UART_HandleTypeDef *huart, const struct rpmsg_iovec *pIov,
+                                            uint8_t IovCnt);
+VIRT_UART_StatusTypeDef VIRT_UART_AcquireTxBuffer(VIRT_UART_HandleTypeDef *huart, uint8_t **ppData,
+                                                  uint16_t *pSize, uint8_t Wait);
+VIRT_UART_StatusTypeDef VIRT_UART_TransmitNoCopy(VIRT_UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
 
 
 #ifdef __cplusplus
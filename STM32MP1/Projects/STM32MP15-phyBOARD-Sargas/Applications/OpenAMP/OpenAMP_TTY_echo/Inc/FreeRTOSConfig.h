@@ -0,0 +1,98 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   FreeRTOS configuration of the CAN bridge tasks (can_bridge.c).
+ *          The task configuration is the Debug_FreeRTOS build configuration
+ *          of the STM32CubeIDE project, which defines CAN_BRIDGE_FREERTOS and
+ *          builds the kernel. Debug and Release exclude Middlewares/FreeRTOS
+ *          and run the bare metal main loop.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#if !defined(CAN_BRIDGE_FREERTOS)
+#error "the kernel is only built with CAN_BRIDGE_FREERTOS, see the Debug_FreeRTOS configuration"
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+#include "stdint.h"
+extern uint32_t SystemCoreClock;
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define configUSE_PREEMPTION                    1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 1
+#define configUSE_IDLE_HOOK                     0
+#define configUSE_TICK_HOOK                     0
+#define configMAX_PRIORITIES                    (5)
+#define configCPU_CLOCK_HZ                      (SystemCoreClock)
+/* same 1 ms as the HAL tick, both are counted by SysTick_Handler() */
+#define configTICK_RATE_HZ                      ((TickType_t)1000)
+#define configMINIMAL_STACK_SIZE                ((uint16_t)128)
+#define configMAX_TASK_NAME_LEN                 (16)
+#define configUSE_16_BIT_TICKS                  0
+#define configIDLE_SHOULD_YIELD                 1
+#define configUSE_TASK_NOTIFICATIONS            1
+#define configUSE_MUTEXES                       0
+#define configUSE_RECURSIVE_MUTEXES             0
+#define configUSE_COUNTING_SEMAPHORES           0
+#define configQUEUE_REGISTRY_SIZE               0
+#define configCHECK_FOR_STACK_OVERFLOW          0
+#define configUSE_MALLOC_FAILED_HOOK            0
+#define configUSE_TRACE_FACILITY                0
+#define configGENERATE_RUN_TIME_STATS           0
+#define configUSE_CO_ROUTINES                   0
+#define configUSE_TIMERS                        0
+/* all kernel objects are static, no heap_x.c is linked */
+#define configSUPPORT_STATIC_ALLOCATION         1
+#define configSUPPORT_DYNAMIC_ALLOCATION        0
+
+#define INCLUDE_vTaskDelay                      1
+#define INCLUDE_vTaskDelete                     0
+#define INCLUDE_vTaskSuspend                    1
+#define INCLUDE_xTaskGetSchedulerState          1
+#define INCLUDE_xTaskGetCurrentTaskHandle       1
+
+/* Cortex-M4 interrupt priorities */
+#ifdef __NVIC_PRIO_BITS
+#define configPRIO_BITS                         __NVIC_PRIO_BITS
+#else
+#define configPRIO_BITS                         4
+#endif
+#define configLIBRARY_LOWEST_INTERRUPT_PRIORITY 0xf
+/* FDCAN2, IPCC, DMA and USART3 run at DEFAULT_IRQ_PRIO (1) and call the
+ * FromISR functions, only priority 0 is above the kernel */
+#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY 1
+#define configKERNEL_INTERRUPT_PRIORITY         (configLIBRARY_LOWEST_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+#define configMAX_SYSCALL_INTERRUPT_PRIORITY    (configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY << (8 - configPRIO_BITS))
+
+/* Exported macro ------------------------------------------------------------*/
+#define configASSERT(x) do { \
+        if ((x) == 0) { \
+            taskDISABLE_INTERRUPTS(); \
+            for (;;) { \
+            } \
+        } \
+    } while (0)
+
+/* the port handles SVC and PendSV, SysTick_Handler() calls xPortSysTickHandler() */
+#if defined(CAN_BRIDGE_FREERTOS)
+#define vPortSVCHandler                         SVC_Handler
+#define xPortPendSVHandler                      PendSV_Handler
+#endif
+
+#endif /* FREERTOS_CONFIG_H */
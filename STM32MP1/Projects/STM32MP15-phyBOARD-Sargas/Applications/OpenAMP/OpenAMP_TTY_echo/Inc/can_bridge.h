@@ -0,0 +1,102 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Header for can_bridge.c, the FreeRTOS task configuration of the
+ *          CAN bridge (build with CAN_BRIDGE_FREERTOS).
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ *
+ * Three tasks replace the polling main loop, in falling priority:
+ *
+ *   ingest  woken by the FDCAN interrupt, moves the received frames and TX
+ *           events out of the interrupt rings into the item stream. It never
+ *           blocks, items which do not fit into the stream are counted and
+ *           dropped, so a slow host link cannot stall the interrupt rings.
+ *   format  formats the items into trace lines or record batches and passes
+ *           complete messages to the message buffer. It blocks while the
+ *           message buffer is full and sends a partly filled batch as soon as
+ *           the item stream runs empty.
+ *   rpmsg   woken by the IPCC interrupt, new messages and the format task,
+ *           runs the mailbox, the control channel and the CAN TX path and
+ *           sends the messages. While Linux holds all TX buffers it waits for
+ *           the next IPCC interrupt instead of polling.
+ *
+ * The application specific work is done by the callbacks of
+ * CanBridge_ConfigStruct_t, the module itself only depends on FreeRTOS, so
+ * it also runs in the host simulation Linux/can_bridge_sim.c.
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CAN_BRIDGE_H
+#define __CAN_BRIDGE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* largest item passed from the ingest to the format task */
+#define m_u32CANBRIDGE_ITEMLENGTH ((uint32_t)160)
+/* items buffered between ingest and format */
+#define m_u32CANBRIDGE_ITEMS ((uint32_t)32)
+/* largest message, the RPMsg payload */
+#define m_u32CANBRIDGE_MESSAGELENGTH ((uint32_t)496)
+/* bytes buffered between format and rpmsg, each message takes 12 to 16 more bytes */
+#define m_u32CANBRIDGE_MESSAGEBUFFER ((uint32_t)2048)
+
+/* events of vCanBridge_NotifyFromISR() */
+#define m_u32CANBRIDGE_EVENT_RX ((uint32_t)0x01)        /* frames or TX events in the interrupt rings */
+#define m_u32CANBRIDGE_EVENT_MAILBOX ((uint32_t)0x02)   /* IPCC, new message or TX buffers returned */
+#define m_u32CANBRIDGE_EVENT_TXSPACE ((uint32_t)0x04)   /* TX FIFO elements became free */
+
+/* task priorities, above the idle task */
+#define m_u32CANBRIDGE_PRIORITY_INGEST ((uint32_t)4)
+#define m_u32CANBRIDGE_PRIORITY_FORMAT ((uint32_t)3)
+#define m_u32CANBRIDGE_PRIORITY_RPMSG ((uint32_t)2)
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+    uint32_t u32ItemLength;     /* bytes of one item, at most m_u32CANBRIDGE_ITEMLENGTH */
+    /* ingest task, takes the next item out of the interrupt rings, false when they are empty */
+    bool (*pfnIngest)(void *pvItem);
+    /* format task, formats one item, complete messages are passed to bCanBridge_Send() */
+    void (*pfnFormat)(const void *pvItem);
+    /* format task, no item is pending, a partly filled message must be sent now */
+    void (*pfnFlush)(void);
+    /* rpmsg task, mailbox, control channel and CAN TX */
+    void (*pfnService)(void);
+    /* rpmsg task, sends one message, false while no TX buffer is free */
+    bool (*pfnTransmit)(const uint8_t au8Message[], uint32_t u32Length, const uint32_t *pu32OldestCycles);
+} CanBridge_ConfigStruct_t;
+
+typedef struct {
+    uint32_t u32ItemsDropped;   /* items dropped by the ingest task, the item stream was full */
+    uint32_t u32ItemsHighWater; /* most items waiting for the format task */
+    uint32_t u32SendBlocked;    /* messages the format task had to wait for */
+    uint32_t u32TxBusy;         /* transmissions delayed because Linux held all TX buffers */
+} CanBridge_StatsStruct_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+bool bCanBridge_Run(const CanBridge_ConfigStruct_t *pstConfig);
+void vCanBridge_NotifyFromISR(uint32_t u32Events);
+bool bCanBridge_Send(const uint8_t au8Message[], uint32_t u32Length, const uint32_t *pu32OldestCycles);
+void vCanBridge_GetStats(CanBridge_StatsStruct_t *pstStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_BRIDGE_H */
@@ -0,0 +1,154 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Binary command protocol of the control channel, shared by the
+ *          Cortex-M4 firmware and the Linux client library. This header must
+ *          stay free of HAL dependencies.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ *
+ * One request or response per RPMsg message on channel 0. All fields are
+ * little endian.
+ *
+ *   header (8 bytes)
+ *     [0]  u16 magic        m_u16CANCOMMAND_MAGIC
+ *     [2]  u8  version      m_u8CANCOMMAND_VERSION
+ *     [3]  u8  command      m_u8CANCOMMAND_xxx, | m_u8CANCOMMAND_RESPONSE in a response
+ *     [4]  u16 request id   chosen by Linux, copied into the response
+ *     [6]  u16 length       payload bytes following the header
+ *
+ *   response payload
+ *     [0]  u8  status       CanCommand_Status_t
+ *     [1]  command specific data, only for CANCOMMAND_OK
+ *
+ *   command          request payload                      response data
+ *   START            -                                    -
+ *   STOP             -                                    -
+ *   SETFORMAT        u8 m_u8CANCOMMAND_FORMAT_xxx         -
+ *   FILTERCLEAR      -                                    -   (receive all frames again)
+ *   FILTERADD        u8 0 std / 1 ext, u8 filter type,    -
+ *                    u8 filter config, u8 0,
+ *                    u32 id1, u32 id2 (see can_filter.h)
+ *   FILTERAPPLY      -                                    -
+ *   GETSTATS         -                                    u32 counter[], CanCommand_Stat_t order
+ *   SETRATELIMIT     u32 frames/s to Linux, 0 no limit    -
+ *   GETVERSION       -                                    u8 protocol version, u8 record version
+ *   GETLATENCY       [u8 1 clear after reading]           per stage latency, see can_latency.h
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CAN_COMMAND_H
+#define __CAN_COMMAND_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define m_u16CANCOMMAND_MAGIC ((uint16_t)0x4D43) /* "CM" */
+#define m_u8CANCOMMAND_VERSION ((uint8_t)1)
+
+#define m_u32CANCOMMAND_HEADERLENGTH ((uint32_t)8)
+/* largest message VIRT_UART_Transmit() accepts (VIRT_UART_MAX_SIZE) */
+#if defined(RPMSG_BUFFER_SIZE)
+#define m_u32CANCOMMAND_MAXLENGTH ((uint32_t)(RPMSG_BUFFER_SIZE - 16))
+#else
+#define m_u32CANCOMMAND_MAXLENGTH ((uint32_t)(512 - 16))
+#endif
+#define m_u32CANCOMMAND_MAXPAYLOAD (m_u32CANCOMMAND_MAXLENGTH - m_u32CANCOMMAND_HEADERLENGTH)
+
+#define m_u8CANCOMMAND_START ((uint8_t)0x01)
+#define m_u8CANCOMMAND_STOP ((uint8_t)0x02)
+#define m_u8CANCOMMAND_SETFORMAT ((uint8_t)0x03)
+#define m_u8CANCOMMAND_FILTERCLEAR ((uint8_t)0x04)
+#define m_u8CANCOMMAND_FILTERADD ((uint8_t)0x05)
+#define m_u8CANCOMMAND_FILTERAPPLY ((uint8_t)0x06)
+#define m_u8CANCOMMAND_GETSTATS ((uint8_t)0x07)
+#define m_u8CANCOMMAND_SETRATELIMIT ((uint8_t)0x08)
+#define m_u8CANCOMMAND_GETVERSION ((uint8_t)0x09)
+#define m_u8CANCOMMAND_GETLATENCY ((uint8_t)0x0A)
+#define m_u8CANCOMMAND_RESPONSE ((uint8_t)0x80)
+
+#define m_u8CANCOMMAND_FORMAT_ASCII ((uint8_t)0)
+#define m_u8CANCOMMAND_FORMAT_BINARY ((uint8_t)1)
+
+#define m_u32CANCOMMAND_FILTERADDLENGTH ((uint32_t)12)
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+    CANCOMMAND_OK = 0,
+    CANCOMMAND_ERROR_VERSION,   /* unsupported protocol version, data holds the supported one */
+    CANCOMMAND_ERROR_COMMAND,   /* unknown command */
+    CANCOMMAND_ERROR_LENGTH,    /* payload length does not fit the command */
+    CANCOMMAND_ERROR_VALUE,     /* invalid parameter value */
+    CANCOMMAND_ERROR_NOSPACE,   /* table full */
+    CANCOMMAND_ERROR_FAILED     /* the hardware could not be configured */
+} CanCommand_Status_t;
+
+/* counters of the GETSTATS response, new counters are appended */
+typedef enum {
+    CANCOMMAND_STAT_RXFRAMES = 0,       /* frames forwarded to Linux */
+    CANCOMMAND_STAT_RXRINGOVERFLOW,
+    CANCOMMAND_STAT_RXFIFOLOST,
+    CANCOMMAND_STAT_RXHIGHWATER,
+    CANCOMMAND_STAT_RXRATELIMITED,      /* frames dropped by the rate limit */
+    CANCOMMAND_STAT_TXFRAMES,
+    CANCOMMAND_STAT_TXINVALID,
+    CANCOMMAND_STAT_TXBATCHDROPPED,
+    CANCOMMAND_STAT_TXEVENTLOST,
+    CANCOMMAND_STAT_MIRRORSENT,
+    CANCOMMAND_STAT_MIRRORDROPPED,
+    CANCOMMAND_STAT_RPMSGFAILED,        /* messages to Linux which could not be sent */
+    CANCOMMAND_STAT_RXBYTES,            /* payload bytes forwarded to Linux */
+    CANCOMMAND_STAT_UPTIMEMS,           /* time base for rates computed from two queries */
+    CANCOMMAND_STAT_MIRRORFAILED,       /* mirror lines lost by a UART or DMA error */
+    CANCOMMAND_STAT_COUNT
+} CanCommand_Stat_t;
+
+/* writes the response data behind the status byte, at most m_u32CANCOMMAND_MAXPAYLOAD - 1 bytes */
+typedef CanCommand_Status_t (*CanCommand_Handler_t)(const uint8_t au8Payload[], uint16_t u16Length,
+        uint8_t au8Data[], uint16_t *pu16DataLength);
+
+typedef struct {
+    uint8_t u8Command;
+    uint16_t u16MinLength;      /* request payload length range */
+    uint16_t u16MaxLength;
+    CanCommand_Handler_t pfnHandler;
+} CanCommand_EntryStruct_t;
+
+typedef struct {
+    uint8_t u8Command;          /* without m_u8CANCOMMAND_RESPONSE */
+    uint16_t u16RequestId;
+    CanCommand_Status_t eStatus;
+    const uint8_t *pu8Data;
+    uint16_t u16DataLength;
+} CanCommand_ResponseStruct_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+bool bCanCommand_IsCommand(const uint8_t au8Message[], uint32_t u32Size);
+uint32_t u32CanCommand_Dispatch(const CanCommand_EntryStruct_t astTable[], uint32_t u32Entries,
+        const uint8_t au8Request[], uint32_t u32Size, uint8_t au8Response[]);
+uint32_t u32CanCommand_BuildRequest(uint8_t au8Buffer[], uint8_t u8Command, uint16_t u16RequestId,
+        const uint8_t au8Payload[], uint16_t u16Length);
+int32_t i32CanCommand_ParseResponse(const uint8_t au8Message[], uint32_t u32Size, CanCommand_ResponseStruct_t *pstResponse);
+void vCanCommand_PutUint32(uint8_t au8Dest[], uint32_t u32Value);
+uint32_t u32CanCommand_GetUint32(const uint8_t au8Src[]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_COMMAND_H */
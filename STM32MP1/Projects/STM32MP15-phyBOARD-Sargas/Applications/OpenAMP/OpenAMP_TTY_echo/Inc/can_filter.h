@@ -0,0 +1,103 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Acceptance filter table set up by control channel messages. Shared
+ *          by the Cortex-M4 firmware and the Linux host test, this header
+ *          must stay free of HAL dependencies.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ *
+ * Control messages, numbers are decimal or hexadecimal with 0x prefix:
+ *
+ *   filter std|ext mask  <id> <mask> [reject]   classic ID / mask filter
+ *   filter std|ext range <first> <last> [reject] identifier range
+ *   filter std|ext dual  <id1> <id2> [reject]   one of two identifiers
+ *   filter apply                                program the table into FDCAN2
+ *   filter clear                                empty the table, apply to receive all frames again
+ *
+ * Rules are evaluated in the order they were added, the first matching rule
+ * decides. After "filter apply" frames not matching any rule are rejected in
+ * hardware for every identifier type which has at least one accepting rule.
+ * An identifier type without accepting rules keeps receiving all frames which
+ * are not rejected explicitly.
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CAN_FILTER_H
+#define __CAN_FILTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* filter elements reserved in the FDCAN2 message RAM (StdFiltersNbr, ExtFiltersNbr) */
+#define m_u32CANFILTER_STDCOUNT ((uint32_t)16)
+#define m_u32CANFILTER_EXTCOUNT ((uint32_t)8)
+
+#define m_u32CANFILTER_STDIDMAX ((uint32_t)0x7FF)
+#define m_u32CANFILTER_EXTIDMAX ((uint32_t)0x1FFFFFFF)
+
+/* filter type (SFT / EFT), same values as FDCAN_FILTER_RANGE, _DUAL and _MASK */
+#define m_u8CANFILTER_TYPE_RANGE ((uint8_t)0)
+#define m_u8CANFILTER_TYPE_DUAL ((uint8_t)1)
+#define m_u8CANFILTER_TYPE_MASK ((uint8_t)2)
+
+/* filter element configuration (SFEC / EFEC), same values as FDCAN_FILTER_DISABLE,
+ * _TO_RXFIFO0 and _REJECT */
+#define m_u8CANFILTER_CONFIG_DISABLE ((uint8_t)0)
+#define m_u8CANFILTER_CONFIG_RXFIFO0 ((uint8_t)1)
+#define m_u8CANFILTER_CONFIG_REJECT ((uint8_t)3)
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+    CANFILTER_NOCOMMAND = 0,    /* message is no filter command */
+    CANFILTER_ADDED,            /* rule added to the table */
+    CANFILTER_APPLY,            /* table must be programmed */
+    CANFILTER_CLEARED,          /* table emptied, must be programmed */
+    CANFILTER_ERROR_SYNTAX,     /* malformed filter command */
+    CANFILTER_ERROR_RANGE,      /* invalid rule, identifier out of range or range first > last */
+    CANFILTER_ERROR_FULL        /* no free filter element left for the identifier type */
+} CanFilter_Result_t;
+
+typedef struct {
+    uint32_t u32Id1;
+    uint32_t u32Id2;
+    uint8_t u8Type;             /* m_u8CANFILTER_TYPE_xxx */
+    uint8_t u8Config;           /* m_u8CANFILTER_CONFIG_RXFIFO0 or _REJECT */
+} CanFilter_RuleStruct_t;
+
+typedef struct {
+    CanFilter_RuleStruct_t astStd[m_u32CANFILTER_STDCOUNT];
+    CanFilter_RuleStruct_t astExt[m_u32CANFILTER_EXTCOUNT];
+    uint32_t u32StdCount;
+    uint32_t u32ExtCount;
+} CanFilter_TableStruct_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void vCanFilter_Init(CanFilter_TableStruct_t *pstTable);
+CanFilter_Result_t eCanFilter_Parse(CanFilter_TableStruct_t *pstTable, const uint8_t au8Message[], uint16_t u16Size);
+CanFilter_Result_t eCanFilter_Add(CanFilter_TableStruct_t *pstTable, bool bExtended, const CanFilter_RuleStruct_t *pstRule);
+bool bCanFilter_HasAcceptRule(const CanFilter_RuleStruct_t astRules[], uint32_t u32Count);
+uint32_t u32CanFilter_EncodeStd(const CanFilter_RuleStruct_t *pstRule);
+void vCanFilter_EncodeExt(const CanFilter_RuleStruct_t *pstRule, uint32_t au32Element[2]);
+const char *pcCanFilter_ResultText(CanFilter_Result_t eResult);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_FILTER_H */
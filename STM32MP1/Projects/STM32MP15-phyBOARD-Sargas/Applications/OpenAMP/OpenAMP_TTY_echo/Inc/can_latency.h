@@ -0,0 +1,103 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Per stage latency statistics of the CAN to Linux path, measured
+ *          with the DWT cycle counter. Shared by the Cortex-M4 firmware and
+ *          the Linux client, this header must stay free of HAL dependencies.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ *
+ * A received frame is stamped when the interrupt takes it from the RX FIFO,
+ * when the main loop starts and ends formatting it, when the RPMsg TX buffer
+ * was acquired and when the message was handed to Linux with the kick. In
+ * binary mode one message carries many frames, the acquire and kick stages
+ * are counted once per message and the total latency is the one of the
+ * oldest frame in the message.
+ *
+ * Every stage keeps count, min, max, sum and a log2 histogram of the cycles:
+ * bucket 0 counts < 2^(m_u32CANLATENCY_FIRSTSHIFT + 1) cycles, bucket i
+ * [2^(i + FIRSTSHIFT), 2^(i + FIRSTSHIFT + 1)), the last bucket everything above.
+ *
+ * GETLATENCY response data (can_command.h), little endian:
+ *   [0]  u8  stages  [1] u8 buckets  [2] u8 first shift  [3] u8 0
+ *   [4]  u32 cycles per microsecond
+ *   per stage: u32 count, u32 min, u32 max, u32 average, u32 bucket[buckets]
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CAN_LATENCY_H
+#define __CAN_LATENCY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define m_u32CANLATENCY_BUCKETS ((uint32_t)16)
+/* 128 cycles, 0.6 us at 209 MHz, the last bucket starts at 2^21 cycles, 10 ms */
+#define m_u32CANLATENCY_FIRSTSHIFT ((uint32_t)6)
+#define m_u32CANLATENCY_HEADERLENGTH ((uint32_t)8)
+#define m_u32CANLATENCY_STAGELENGTH ((uint32_t)(4u * (4u + m_u32CANLATENCY_BUCKETS)))
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+    CANLATENCY_STAGE_QUEUE = 0,     /* RX FIFO dequeue until the main loop picks the frame up */
+    CANLATENCY_STAGE_FORMAT,        /* ASCII trace or binary record */
+    CANLATENCY_STAGE_ACQUIRE,       /* waiting for a free RPMsg TX buffer */
+    CANLATENCY_STAGE_KICK,          /* copy into the buffer, if any, and notify Linux */
+    CANLATENCY_STAGE_TOTAL,         /* RX FIFO dequeue until Linux is notified */
+    CANLATENCY_STAGE_COUNT
+} CanLatency_Stage_t;
+
+typedef struct {
+    uint32_t u32Count;
+    uint32_t u32Min;
+    uint32_t u32Max;
+    uint64_t u64Sum;
+    uint32_t au32Buckets[m_u32CANLATENCY_BUCKETS];
+} CanLatency_StageStruct_t;
+
+typedef struct {
+    CanLatency_StageStruct_t astStages[CANLATENCY_STAGE_COUNT];
+} CanLatency_Struct_t;
+
+/* decoded GETLATENCY response, values in cycles */
+typedef struct {
+    uint32_t u32CyclesPerUs;
+    uint32_t u32Stages;
+    struct {
+        uint32_t u32Count;
+        uint32_t u32Min;
+        uint32_t u32Max;
+        uint32_t u32Average;
+        uint32_t au32Buckets[m_u32CANLATENCY_BUCKETS];
+    } astStages[CANLATENCY_STAGE_COUNT];
+} CanLatency_ReportStruct_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void vCanLatency_Init(CanLatency_Struct_t *pstLatency);
+void vCanLatency_Add(CanLatency_Struct_t *pstLatency, CanLatency_Stage_t eStage, uint32_t u32Cycles);
+uint32_t u32CanLatency_GetBucket(uint32_t u32Cycles);
+uint32_t u32CanLatency_GetAverage(const CanLatency_StageStruct_t *pstStage);
+uint32_t u32CanLatency_Encode(const CanLatency_Struct_t *pstLatency, uint32_t u32CyclesPerUs, uint8_t au8Data[]);
+bool bCanLatency_Decode(const uint8_t au8Data[], uint32_t u32Length, CanLatency_ReportStruct_t *pstReport);
+const char *pcCanLatency_StageName(CanLatency_Stage_t eStage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_LATENCY_H */
@@ -0,0 +1,119 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Binary CAN record format shared by the Cortex-M4 firmware and the
+ *          Linux decoder. This header must stay free of HAL dependencies.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ *
+ * One batch is sent per RPMsg buffer. All fields are little endian.
+ *
+ *   batch header (8 bytes)
+ *     [0]  u16 magic        m_u16CANRECORD_MAGIC
+ *     [2]  u8  version      m_u8CANRECORD_VERSION
+ *     [3]  u8  record count
+ *     [4]  u16 length       bytes of records following the batch header
+ *     [6]  u16 sequence     incremented per batch, gaps show lost batches
+ *
+ *   record (14 bytes + payload), repeated record count times
+ *     [0]  u64 timestamp    capture time in microseconds
+ *     [8]  u32 identifier   11 or 29 bit CAN identifier
+ *     [12] u8  flags        m_u8CANRECORD_FLAG_xxx
+ *     [13] u8  length       payload bytes (0..64), not the DLC code
+ *     [14] payload
+ *
+ * Linux sends frames to transmit as batches in the same format on channel 1.
+ * The timestamp of such a record is ignored, the length must be a valid CAN
+ * (FD) payload length. Every transmitted frame is confirmed in binary mode by
+ * a record with m_u8CANRECORD_FLAG_TXEVENT, its timestamp is the start of
+ * frame time and its 1 byte payload the message marker. The marker counts
+ * the records received for transmission modulo 256, a missing marker shows a
+ * record which was no valid frame.
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CAN_RECORD_H
+#define __CAN_RECORD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define m_u16CANRECORD_MAGIC ((uint16_t)0x5243) /* "CR" */
+#define m_u8CANRECORD_VERSION ((uint8_t)1)
+
+#define m_u32CANRECORD_BATCHHEADERLENGTH ((uint32_t)8)
+#define m_u32CANRECORD_HEADERLENGTH ((uint32_t)14)
+#define m_u32CANRECORD_MAXDATALENGTH ((uint32_t)64)
+
+/* RPMsg buffer size, RPMSG_BUFFER_SIZE of the command line or rpmsg_virtio.h */
+#if defined(RPMSG_BUFFER_SIZE)
+#define m_u32CANRECORD_RPMSGBUFFERSIZE RPMSG_BUFFER_SIZE
+#else
+#define m_u32CANRECORD_RPMSGBUFFERSIZE 512
+#endif
+
+/* largest payload VIRT_UART_Transmit() accepts (VIRT_UART_MAX_SIZE) */
+#define m_u32CANRECORD_BATCHSIZE ((uint32_t)(m_u32CANRECORD_RPMSGBUFFERSIZE - 16))
+
+/* a batch holds at least one CAN FD record, its length fits the u16 length field */
+#if (m_u32CANRECORD_RPMSGBUFFERSIZE - 16) < (8 + 14 + 64)
+#error "RPMSG_BUFFER_SIZE is too small for a batch with one CAN FD record"
+#elif (m_u32CANRECORD_RPMSGBUFFERSIZE - 16) > (8 + 0xFFFF)
+#error "RPMSG_BUFFER_SIZE exceeds the batch length field"
+#endif
+
+#define m_u8CANRECORD_FLAG_EXTENDEDID ((uint8_t)0x01)
+#define m_u8CANRECORD_FLAG_FDFORMAT ((uint8_t)0x02)
+#define m_u8CANRECORD_FLAG_BITRATESWITCH ((uint8_t)0x04)
+#define m_u8CANRECORD_FLAG_ERRORPASSIVE ((uint8_t)0x08)
+#define m_u8CANRECORD_FLAG_REMOTEFRAME ((uint8_t)0x10)
+#define m_u8CANRECORD_FLAG_TXEVENT ((uint8_t)0x20)
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+    uint64_t u64Timestamp;
+    uint32_t u32Identifier;
+    uint8_t u8Flags;
+    uint8_t u8Length;
+    const uint8_t *pu8Data;
+} CanRecord_RecordStruct_t;
+
+typedef struct {
+    uint8_t au8Buffer[m_u32CANRECORD_BATCHSIZE];
+    uint8_t *pu8Buffer;         /* records are written here, au8Buffer or an attached RPMsg buffer */
+    uint32_t u32Size;           /* bytes of pu8Buffer, at most m_u32CANRECORD_BATCHSIZE */
+    uint32_t u32Length;
+    uint8_t u8RecordCount;
+    uint16_t u16Sequence;
+} CanRecord_BatchStruct_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void vCanRecord_BatchInit(CanRecord_BatchStruct_t *pstBatch);
+bool bCanRecord_BatchAdd(CanRecord_BatchStruct_t *pstBatch, const CanRecord_RecordStruct_t *pstRecord);
+bool bCanRecord_BatchIsEmpty(const CanRecord_BatchStruct_t *pstBatch);
+uint32_t u32CanRecord_BatchFinish(CanRecord_BatchStruct_t *pstBatch);
+void vCanRecord_BatchReset(CanRecord_BatchStruct_t *pstBatch);
+void vCanRecord_BatchAttach(CanRecord_BatchStruct_t *pstBatch, uint8_t *pu8Buffer, uint32_t u32Size);
+int32_t i32CanRecord_BatchCheck(const uint8_t au8Data[], uint32_t u32Length);
+uint32_t u32CanRecord_BatchGetRecord(const uint8_t au8Data[], uint32_t u32Offset, CanRecord_RecordStruct_t *pstRecord);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_RECORD_H */
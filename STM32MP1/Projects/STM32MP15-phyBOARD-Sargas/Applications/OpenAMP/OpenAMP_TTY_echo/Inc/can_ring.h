@@ -0,0 +1,76 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Header for can_ring.c module
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CAN_RING_H
+#define __CAN_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "stdint.h"
+#include "stdbool.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* number of frames in the ring, must be a power of two */
+#define m_u32CANRING_SIZE ((uint32_t)64)
+#define m_u32CANRING_DATALENGTH ((uint32_t)64)
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+    FDCAN_RxHeaderTypeDef stHeader;
+    uint64_t u64Timestamp;      /* capture time in microseconds */
+    uint32_t u32DequeueCycles;  /* DWT cycle counter when taken from the RX FIFO */
+    uint8_t au8Data[m_u32CANRING_DATALENGTH];
+} CanRing_FrameStruct_t;
+
+typedef struct {
+    uint32_t u32RingOverflow;   /* frames read from the FIFO but dropped because the ring was full */
+    uint32_t u32FifoLost;       /* message lost events signaled by the FDCAN RX FIFO */
+    uint32_t u32HighWater;      /* highest number of frames queued in the ring */
+} CanRing_StatsStruct_t;
+
+/*
+ * Single producer (FDCAN interrupt) / single consumer (main loop) ring.
+ * u32Head is only written by the producer, u32Tail only by the consumer.
+ */
+typedef struct {
+    volatile uint32_t u32Head;
+    volatile uint32_t u32Tail;
+    CanRing_StatsStruct_t stStats;
+    CanRing_FrameStruct_t astFrames[m_u32CANRING_SIZE];
+} CanRing_Struct_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void vCanRing_Init(CanRing_Struct_t *pstRing);
+CanRing_FrameStruct_t *pstCanRing_GetWriteSlot(CanRing_Struct_t *pstRing);
+void vCanRing_Commit(CanRing_Struct_t *pstRing);
+void vCanRing_CountFifoLost(CanRing_Struct_t *pstRing);
+CanRing_FrameStruct_t *pstCanRing_GetReadSlot(CanRing_Struct_t *pstRing);
+void vCanRing_Release(CanRing_Struct_t *pstRing);
+void vCanRing_Flush(CanRing_Struct_t *pstRing);
+uint32_t u32CanRing_GetFillLevel(const CanRing_Struct_t *pstRing);
+void vCanRing_GetStats(const CanRing_Struct_t *pstRing, CanRing_StatsStruct_t *pstStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_RING_H */
@@ -0,0 +1,49 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Header for can_timestamp.c module
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CAN_TIMESTAMP_H
+#define __CAN_TIMESTAMP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+
+/* Exported types ------------------------------------------------------------*/
+/*
+ * Extends a free-running hardware counter of up to 32 bits to 64 bits.
+ * vCanTimestamp_Update() must see the counter at least once per wrap period.
+ */
+typedef struct {
+    uint64_t u64Now;    /* extended counter value of the last update */
+    uint32_t u32Mask;   /* counter width mask, e.g. 0xFFFF for the FDCAN counter */
+} CanTimestamp_CounterStruct_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void vCanTimestamp_Init(CanTimestamp_CounterStruct_t *pstCounter, uint32_t u32Bits);
+uint64_t u64CanTimestamp_Update(CanTimestamp_CounterStruct_t *pstCounter, uint32_t u32Value);
+uint64_t u64CanTimestamp_Extend(const CanTimestamp_CounterStruct_t *pstCounter, uint32_t u32Sample);
+uint32_t u32CanTimestamp_Age(const CanTimestamp_CounterStruct_t *pstCounter, uint32_t u32Sample);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TIMESTAMP_H */
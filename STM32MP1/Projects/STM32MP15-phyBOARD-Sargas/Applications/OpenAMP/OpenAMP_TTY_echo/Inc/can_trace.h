@@ -0,0 +1,42 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Header for can_trace.c module
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CAN_TRACE_H
+#define __CAN_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define m_u32CANTRACE_LENGTH ((uint32_t)233)
+#define m_u32CANTRACE_DATALENGTH ((uint32_t)64)
+
+/* Exported functions prototypes ---------------------------------------------*/
+uint8_t u8CanTrace_GetDataLength(uint32_t u32DataLengthCode);
+void vCanTrace_Format(uint8_t au8TraceData[], uint32_t u32RxCount, uint32_t u32TimestampMs,
+        uint32_t u32Identifier, uint8_t u8Length, const uint8_t au8RxData[]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TRACE_H */
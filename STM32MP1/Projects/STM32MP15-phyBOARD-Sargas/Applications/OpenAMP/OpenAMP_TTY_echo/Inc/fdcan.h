@@ -29,11 +29,19 @@ extern "C" {
 #include "main.h"
 
 /* USER CODE BEGIN Includes */
-
+#include "can_ring.h"
+#include "can_filter.h"
+#include "can_record.h"
+#include "can_timestamp.h"
 /* USER CODE END Includes */
 
 extern FDCAN_HandleTypeDef hfdcan2;
 
+/* USER CODE BEGIN Private variables */
+extern CanRing_Struct_t stCanRxRing;
+extern CanRing_Struct_t stCanTxEventRing;
+/* USER CODE END Private variables */
+
 /* USER CODE BEGIN Private defines */
 
 /* USER CODE END Private defines */
@@ -41,6 +49,8 @@ extern FDCAN_HandleTypeDef hfdcan2;
 void MX_FDCAN2_Init(void);
 
 /* USER CODE BEGIN Prototypes */
+bool bFdcan2_ApplyFilters(const CanFilter_TableStruct_t *pstTable);
+bool bFdcan2_Transmit(const CanRecord_RecordStruct_t *pstRecord, uint8_t u8Marker);
 
 /* USER CODE END Prototypes */
 
@@ -23,17 +23,50 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include <stdint.h>
 
+struct virtio_device;
 /* USER CODE END Includes */
 
 /* Exported types ------------------------------------------------------------*/
 /* USER CODE BEGIN ET */
-
+/**
+  * @brief  Counters of an IPCC RX channel. Notifications which arrive before
+  *         the previous one was processed coalesce, Notified - Processed of
+  *         them were taken by an earlier run.
+  */
+typedef struct
+{
+  uint32_t Notified;   /* interrupts of the channel */
+  uint32_t Processed;  /* vring processing runs */
+} MAILBOX_StatsTypeDef;
 /* USER CODE END ET */
 
 /* Exported constants --------------------------------------------------------*/
 /* USER CODE BEGIN EC */
+/*
+ * Context which processes the vrings after an IPCC notification:
+ *   MBOX_PROCESS_POLL    MAILBOX_Poll(), from the main loop or the rpmsg task
+ *   MBOX_PROCESS_PENDSV  PendSV at the lowest priority, tail chained to the
+ *                        IPCC interrupt, preempts the main loop only
+ *   MBOX_PROCESS_IRQ     the IPCC interrupt itself
+ * With the last two the RX latency is the interrupt latency instead of the
+ * main loop period. The RPMsg callbacks then run in that context, the main
+ * loop masks it by MAILBOX_Lock() while it touches their data or RX buffers.
+ * CAN_BRIDGE_FREERTOS polls: the kernel owns PendSV and the IPCC interrupt
+ * already wakes the rpmsg task.
+ */
+#define MBOX_PROCESS_POLL    0
+#define MBOX_PROCESS_PENDSV  1
+#define MBOX_PROCESS_IRQ     2
 
+#ifndef MBOX_PROCESS_MODE
+#define MBOX_PROCESS_MODE    MBOX_PROCESS_POLL
+#endif
+
+#if (MBOX_PROCESS_MODE != MBOX_PROCESS_POLL) && defined(CAN_BRIDGE_FREERTOS)
+#error "MBOX_PROCESS_MODE: CAN_BRIDGE_FREERTOS only supports MBOX_PROCESS_POLL"
+#endif
 /* USER CODE END EC */
 
 /* Private defines -----------------------------------------------------------*/
@@ -48,7 +81,11 @@
 
 /* Exported functions prototypes ---------------------------------------------*/
 /* USER CODE BEGIN EFP */
-
+void MAILBOX_Attach(struct virtio_device *vdev);
+uint32_t MAILBOX_Lock(void);
+void MAILBOX_Unlock(uint32_t Mask);
+int MAILBOX_GetStats(uint32_t ChannelIndex, MAILBOX_StatsTypeDef *pStats);
+void MAILBOX_PendSV_Handler(void);
 /* USER CODE END EFP */
 
 int MAILBOX_Notify(void *priv, uint32_t id);
@@ -58,7 +58,8 @@
 
 /* Exported functions prototypes ---------------------------------------------*/
 /* USER CODE BEGIN EFP */
-
+/* Wake a sender waiting for a TX buffer, called from the 'buff free' IRQ */
+void OPENAMP_notify_tx_free(void);
 /* USER CODE END EFP */
 
 /* Initialize the openamp framework*/
@@ -166,14 +166,31 @@ extern int __OPENAMP_region_end__[];    /* defined by linker script */
 #define VRING_TX_ADDRESS     ((unsigned int)-1)  /* allocated by Master processor: CA7 */
 #define VRING_BUFF_ADDRESS   ((unsigned int)-1)  /* allocated by Master processor: CA7 */
 #define VRING_ALIGNMENT         16        /* fixed to match with linux constraint */
+#ifndef VRING_NUM_BUFFS
 #define VRING_NUM_BUFFS         16		  /* number of rpmsg buffer */
+#endif
 #else
 #define VRING_RX_ADDRESS        SHM_START_ADDRESS
 #define VRING_TX_ADDRESS        (SHM_START_ADDRESS + 0x400)
 #define VRING_BUFF_ADDRESS      (SHM_START_ADDRESS + 0x800)
 #define VRING_ALIGNMENT         4
+#ifndef VRING_NUM_BUFFS
 #define VRING_NUM_BUFFS         4   /* number of rpmsg buffers */
 #endif
+#endif
+
+/*
+ * VRING_NUM_BUFFS and RPMSG_BUFFER_SIZE can be given on the command line.
+ * The vrings and 2 * VRING_NUM_BUFFS buffers of RPMSG_BUFFER_SIZE have to fit
+ * the OpenAMP shared memory, MX_OPENAMP_Init() fails otherwise. With a Linux
+ * master they are allocated in the vdev0vring0, vdev0vring1 and vdev0buffer
+ * carveouts of the device tree, which have to grow with them. The Linux
+ * rpmsg bus keeps 512 bytes buffers, an OpenAMP master uses larger ones up
+ * to RPMSG_BUFFER_SIZE.
+ */
+#if (VRING_NUM_BUFFS & (VRING_NUM_BUFFS - 1)) != 0
+#error "VRING_NUM_BUFFS must be a power of 2"
+#endif
 
 /* Fixed parameter */
 #define NUM_RESOURCE_ENTRIES    2
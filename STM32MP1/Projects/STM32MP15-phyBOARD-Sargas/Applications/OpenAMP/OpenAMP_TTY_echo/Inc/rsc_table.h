@@ -43,6 +43,8 @@ struct shared_resource_table {
 	struct fw_rsc_vdev vdev;
 	struct fw_rsc_vdev_vring vring0;
 	struct fw_rsc_vdev_vring vring1;
+	/* rpmsg vdev config space, buffer sizes of VIRTIO_RPMSG_F_BUFSZ */
+	struct virtio_rpmsg_config config;
 	struct fw_rsc_trace cm_trace;
 };
 
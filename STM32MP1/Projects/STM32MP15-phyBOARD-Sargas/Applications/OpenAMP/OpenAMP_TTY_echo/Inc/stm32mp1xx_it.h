@@ -58,6 +58,9 @@ void DebugMon_Handler(void);
 void PendSV_Handler(void);
 void SysTick_Handler(void);
 void IPCC_RX1_IRQHandler(void);
+void FDCAN2_IT0_IRQHandler(void);
+void DMA2_Stream1_IRQHandler(void);
+void USART3_IRQHandler(void);
 /* USER CODE BEGIN EFP */
 
 /* USER CODE END EFP */
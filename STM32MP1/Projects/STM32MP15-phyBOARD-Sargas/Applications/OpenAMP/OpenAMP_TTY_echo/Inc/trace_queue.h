@@ -0,0 +1,77 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Header for trace_queue.c module
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TRACE_QUEUE_H
+#define __TRACE_QUEUE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* number of queued lines, must be a power of two */
+#define m_u32TRACEQUEUE_SLOTS ((uint32_t)16)
+#define m_u32TRACEQUEUE_SLOTLENGTH ((uint32_t)256)
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+    TRACEQUEUE_DROP_NEWEST = 0,     /* a full queue rejects the new line */
+    TRACEQUEUE_DROP_OLDEST          /* a full queue discards its oldest waiting line */
+} TraceQueue_Policy_t;
+
+typedef struct {
+    uint32_t u32Sent;
+    uint32_t u32Failed;         /* lines the transmitter could not start or aborted with an error */
+    uint32_t u32DroppedNewest;
+    uint32_t u32DroppedOldest;
+    uint32_t u32HighWater;
+} TraceQueue_StatsStruct_t;
+
+/*
+ * Queue of output lines. The line in transmission is copied to au8TxBuffer,
+ * so all slots stay available to the producer while the transmitter runs.
+ */
+typedef struct {
+    uint8_t au8Slots[m_u32TRACEQUEUE_SLOTS][m_u32TRACEQUEUE_SLOTLENGTH];
+    uint16_t au16Length[m_u32TRACEQUEUE_SLOTS];
+    uint8_t au8TxBuffer[m_u32TRACEQUEUE_SLOTLENGTH];
+    volatile uint32_t u32Head;
+    volatile uint32_t u32Tail;
+    volatile bool bBusy;
+    TraceQueue_Policy_t ePolicy;
+    TraceQueue_StatsStruct_t stStats;
+} TraceQueue_Struct_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void vTraceQueue_Init(TraceQueue_Struct_t *pstQueue, TraceQueue_Policy_t ePolicy);
+bool bTraceQueue_Put(TraceQueue_Struct_t *pstQueue, const uint8_t au8Line[], uint32_t u32Length);
+bool bTraceQueue_IsBusy(const TraceQueue_Struct_t *pstQueue);
+const uint8_t *pu8TraceQueue_StartNext(TraceQueue_Struct_t *pstQueue, uint16_t *pu16Length);
+void vTraceQueue_Done(TraceQueue_Struct_t *pstQueue);
+void vTraceQueue_Failed(TraceQueue_Struct_t *pstQueue);
+uint32_t u32TraceQueue_GetFillLevel(const TraceQueue_Struct_t *pstQueue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TRACE_QUEUE_H */
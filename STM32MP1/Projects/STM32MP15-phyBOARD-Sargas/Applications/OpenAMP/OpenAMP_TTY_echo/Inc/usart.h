@@ -29,19 +29,20 @@ extern "C" {
 #include "main.h"
 
 /* USER CODE BEGIN Includes */
-
+#include "trace_queue.h"
+#include "stdbool.h"
 /* USER CODE END Includes */
 
 extern UART_HandleTypeDef huart3;
 
 /* USER CODE BEGIN Private defines */
-
+extern TraceQueue_Struct_t stUsart3Queue;
 /* USER CODE END Private defines */
 
 void MX_USART3_UART_Init(void);
 
 /* USER CODE BEGIN Prototypes */
-
+bool bUsart3_MirrorWrite(const uint8_t *pu8Line, uint32_t u32Length);
 /* USER CODE END Prototypes */
 
 #ifdef __cplusplus
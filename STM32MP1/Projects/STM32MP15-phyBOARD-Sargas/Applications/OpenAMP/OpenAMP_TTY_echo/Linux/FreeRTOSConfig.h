@@ -0,0 +1,68 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   FreeRTOS configuration of the host simulation of the CAN bridge
+ *          tasks, see freertos_port.c. Kernel features follow the Cortex-M4
+ *          configuration in ../Inc/FreeRTOSConfig.h.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdlib.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define configUSE_PREEMPTION                    1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
+#define configUSE_IDLE_HOOK                     1
+#define configUSE_TICK_HOOK                     0
+/* one level above the bridge tasks for the simulated interrupts */
+#define configMAX_PRIORITIES                    (6)
+#define configTICK_RATE_HZ                      ((TickType_t)1000)
+/* host stacks, the C library needs more than a Cortex-M4 task */
+#define configMINIMAL_STACK_SIZE                ((uint16_t)16384)
+#define configMAX_TASK_NAME_LEN                 (16)
+#define configUSE_16_BIT_TICKS                  0
+#define configIDLE_SHOULD_YIELD                 1
+#define configUSE_TASK_NOTIFICATIONS            1
+#define configUSE_MUTEXES                       0
+#define configUSE_RECURSIVE_MUTEXES             0
+#define configUSE_COUNTING_SEMAPHORES           0
+#define configQUEUE_REGISTRY_SIZE               0
+#define configCHECK_FOR_STACK_OVERFLOW          0
+#define configUSE_MALLOC_FAILED_HOOK            0
+#define configUSE_TRACE_FACILITY                0
+#define configGENERATE_RUN_TIME_STATS           0
+#define configUSE_CO_ROUTINES                   0
+#define configUSE_TIMERS                        0
+#define configSUPPORT_STATIC_ALLOCATION         1
+#define configSUPPORT_DYNAMIC_ALLOCATION        0
+
+#define INCLUDE_vTaskDelay                      1
+#define INCLUDE_vTaskDelete                     0
+#define INCLUDE_vTaskSuspend                    1
+#define INCLUDE_xTaskGetSchedulerState          1
+#define INCLUDE_xTaskGetCurrentTaskHandle       1
+
+/* Exported macro ------------------------------------------------------------*/
+#define configASSERT(x) do { \
+        if ((x) == 0) { \
+            abort(); \
+        } \
+    } while (0)
+
+#endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,307 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Host simulation of the FreeRTOS task configuration of the CAN
+ *          bridge (can_bridge.c) on the vendored kernel with freertos_port.c.
+ *          A task of the highest priority plays the FDCAN and IPCC interrupts:
+ *          it receives frames into a ring like HAL_FDCAN_RxFifo0Callback() and
+ *          returns the TX buffers Linux has read. The simulation runs through
+ *          normal traffic, a stalled host link, the recovery and a quiet bus
+ *          and checks that
+ *            - every frame is delivered in order or counted as dropped,
+ *            - a stalled host link never overflows the interrupt ring, the
+ *              ingest task keeps draining it and drops in the item stream,
+ *            - no task runs while the bus and the host link are quiet.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_bridge.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+/* Private define ------------------------------------------------------------*/
+/* interrupt ring of the FDCAN2 callback, like m_u32CANRING_SIZE */
+#define m_u32RINGSIZE ((uint32_t)64)
+/* TX buffers of channel 1, VRING_NUM_BUFFS */
+#define m_u32TXBUFFERS ((uint32_t)16)
+/* frame numbers packed into one message */
+#define m_u32BATCHITEMS ((uint32_t)8)
+#define m_u32FRAMESPERTICK ((uint32_t)2)
+
+/* phases in ticks */
+#define m_u32NORMALTICKS ((uint32_t)200)
+#define m_u32STALLTICKS ((uint32_t)200)
+#define m_u32RECOVERYTICKS ((uint32_t)200)
+#define m_u32QUIETTICKS ((uint32_t)100)
+/* the tasks may still drain the backlog at the start of the recovery and
+ * finish the last frames at the start of the quiet phase */
+#define m_u32RECOVERYSETTLETICKS ((uint32_t)10)
+#define m_u32QUIETSETTLETICKS ((uint32_t)5)
+
+/* Private macro -------------------------------------------------------------*/
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            m_u32Failures++; \
+        } \
+    } while (0)
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+    uint32_t u32Frame;          /* frame number, starting at 1 */
+    uint32_t u32ReceiveTick;    /* tick of the simulated interrupt */
+} SimItem_Struct_t;
+
+typedef struct {
+    /* interrupt ring */
+    SimItem_Struct_t astRing[m_u32RINGSIZE];
+    volatile uint32_t u32Head;
+    volatile uint32_t u32Tail;
+    uint32_t u32RingOverflow;
+    uint32_t u32Generated;
+
+    /* host link */
+    bool bStalled;
+    uint32_t u32FreeBuffers;
+
+    /* format task */
+    uint8_t au8Batch[m_u32BATCHITEMS * sizeof(uint32_t)];
+    uint32_t u32BatchItems;
+    uint32_t u32BatchOldest;
+
+    /* received by Linux */
+    uint32_t u32Delivered;
+    uint32_t u32LastFrame;
+    uint32_t u32Messages;
+    uint32_t u32MaxLatency;
+
+    /* task activity */
+    uint32_t u32Callbacks;
+} Sim_Struct_t;
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t m_u32Failures = 0;
+static Sim_Struct_t m_stSim;
+static CanBridge_StatsStruct_t m_stStalledStats;
+static CanBridge_StatsStruct_t m_stRecoveredStats;
+static uint32_t m_u32StallRingOverflow = 0;
+static uint32_t m_u32QuietCallbacks = 0;
+static bool m_bEnded = false;
+
+static StaticTask_t m_stInterruptTask;
+static StackType_t m_axInterruptStack[configMINIMAL_STACK_SIZE];
+
+/* Private function prototypes -----------------------------------------------*/
+static bool bSimIngest(void *pvItem);
+static void vSimFormat(const void *pvItem);
+static void vSimFlush(void);
+static void vSimService(void);
+static bool bSimTransmit(const uint8_t au8Message[], uint32_t u32Length, const uint32_t *pu32OldestCycles);
+static void vInterruptTask(void *pvParameters);
+
+static const CanBridge_ConfigStruct_t m_stCONFIG = {
+    sizeof(SimItem_Struct_t), bSimIngest, vSimFormat, vSimFlush, vSimService, bSimTransmit
+};
+
+/**
+ * @brief  Ingest callback, takes the next frame of the interrupt ring.
+ * @retval false in case the ring is empty.
+ */
+static bool bSimIngest(void *pvItem) {
+
+    m_stSim.u32Callbacks++;
+    if (m_stSim.u32Tail == m_stSim.u32Head) {
+        return false;
+    }
+    memcpy(pvItem, &m_stSim.astRing[m_stSim.u32Tail % m_u32RINGSIZE], sizeof(SimItem_Struct_t));
+    m_stSim.u32Tail++;
+    return true;
+}
+
+/**
+ * @brief  Format callback, packs the frame numbers into batches.
+ * @retval void
+ */
+static void vSimFormat(const void *pvItem) {
+
+    SimItem_Struct_t stItem;
+
+    m_stSim.u32Callbacks++;
+    memcpy(&stItem, pvItem, sizeof(stItem));
+    if (m_stSim.u32BatchItems == m_u32BATCHITEMS) {
+        vSimFlush();
+    }
+    if (m_stSim.u32BatchItems == 0u) {
+        m_stSim.u32BatchOldest = stItem.u32ReceiveTick;
+    }
+    memcpy(&m_stSim.au8Batch[m_stSim.u32BatchItems * sizeof(uint32_t)], &stItem.u32Frame, sizeof(uint32_t));
+    m_stSim.u32BatchItems++;
+}
+
+/**
+ * @brief  Flush callback, sends the partly filled batch.
+ * @retval void
+ */
+static void vSimFlush(void) {
+
+    m_stSim.u32Callbacks++;
+    if (m_stSim.u32BatchItems == 0u) {
+        return;
+    }
+    CHECK(bCanBridge_Send(m_stSim.au8Batch, m_stSim.u32BatchItems * sizeof(uint32_t), &m_stSim.u32BatchOldest) == true);
+    m_stSim.u32BatchItems = 0u;
+}
+
+/**
+ * @brief  Service callback, the mailbox has nothing to do in the simulation.
+ * @retval void
+ */
+static void vSimService(void) {
+    m_stSim.u32Callbacks++;
+}
+
+/**
+ * @brief  Transmit callback, takes a TX buffer and checks the frame order as
+ *         Linux would see it.
+ * @retval false while all TX buffers are held by Linux.
+ */
+static bool bSimTransmit(const uint8_t au8Message[], uint32_t u32Length, const uint32_t *pu32OldestCycles) {
+
+    uint32_t u32Frame;
+    uint32_t u32Latency;
+
+    m_stSim.u32Callbacks++;
+    if (m_stSim.u32FreeBuffers == 0u) {
+        return false;
+    }
+    m_stSim.u32FreeBuffers--;
+    m_stSim.u32Messages++;
+
+    CHECK(pu32OldestCycles != NULL);
+    CHECK((u32Length != 0u) && ((u32Length % sizeof(uint32_t)) == 0u));
+    if (pu32OldestCycles != NULL) {
+        u32Latency = (uint32_t)xTaskGetTickCount() - *pu32OldestCycles;
+        if (u32Latency > m_stSim.u32MaxLatency) {
+            m_stSim.u32MaxLatency = u32Latency;
+        }
+    }
+    for (uint32_t i = 0; i < u32Length; i += sizeof(uint32_t)) {
+        memcpy(&u32Frame, &au8Message[i], sizeof(u32Frame));
+        CHECK(u32Frame > m_stSim.u32LastFrame);
+        m_stSim.u32LastFrame = u32Frame;
+        m_stSim.u32Delivered++;
+    }
+    return true;
+}
+
+/**
+ * @brief  Simulated interrupts, one pass per tick: Linux returns the buffers
+ *         it has read, then new frames are received.
+ * @retval void
+ */
+static void vInterruptTask(void *pvParameters) {
+
+    uint32_t u32Tick;
+    uint32_t u32Frames;
+
+    (void)pvParameters;
+    for (u32Tick = 0; u32Tick < (m_u32NORMALTICKS + m_u32STALLTICKS + m_u32RECOVERYTICKS + m_u32QUIETTICKS); u32Tick++) {
+        vTaskDelay(1);
+
+        m_stSim.bStalled = (u32Tick >= m_u32NORMALTICKS) && (u32Tick < (m_u32NORMALTICKS + m_u32STALLTICKS));
+        if ((m_stSim.bStalled == false) && (m_stSim.u32FreeBuffers != m_u32TXBUFFERS)) {
+            m_stSim.u32FreeBuffers = m_u32TXBUFFERS;
+            vCanBridge_NotifyFromISR(m_u32CANBRIDGE_EVENT_MAILBOX);
+        }
+        u32Frames = (u32Tick < (m_u32NORMALTICKS + m_u32STALLTICKS + m_u32RECOVERYTICKS)) ? m_u32FRAMESPERTICK : 0u;
+        for (uint32_t i = 0; i < u32Frames; i++) {
+            m_stSim.u32Generated++;
+            if ((m_stSim.u32Head - m_stSim.u32Tail) == m_u32RINGSIZE) {
+                m_stSim.u32RingOverflow++;
+                continue;
+            }
+            m_stSim.astRing[m_stSim.u32Head % m_u32RINGSIZE].u32Frame = m_stSim.u32Generated;
+            m_stSim.astRing[m_stSim.u32Head % m_u32RINGSIZE].u32ReceiveTick = (uint32_t)xTaskGetTickCount();
+            m_stSim.u32Head++;
+        }
+        if (u32Frames != 0u) {
+            vCanBridge_NotifyFromISR(m_u32CANBRIDGE_EVENT_RX);
+        }
+
+        if (u32Tick == (m_u32NORMALTICKS + m_u32STALLTICKS - 1u)) {
+            vCanBridge_GetStats(&m_stStalledStats);
+            m_u32StallRingOverflow = m_stSim.u32RingOverflow;
+        }
+        if (u32Tick == (m_u32NORMALTICKS + m_u32STALLTICKS + m_u32RECOVERYSETTLETICKS)) {
+            vCanBridge_GetStats(&m_stRecoveredStats);
+        }
+
+        if (u32Tick == (m_u32NORMALTICKS + m_u32STALLTICKS + m_u32RECOVERYTICKS + m_u32QUIETSETTLETICKS)) {
+            m_u32QuietCallbacks = m_stSim.u32Callbacks;
+        }
+    }
+    m_u32QuietCallbacks = m_stSim.u32Callbacks - m_u32QuietCallbacks;
+    m_bEnded = true;
+    vTaskEndScheduler();
+}
+
+int main(void) {
+
+    CanBridge_ConfigStruct_t stInvalid = m_stCONFIG;
+    CanBridge_StatsStruct_t stStats;
+
+    stInvalid.pfnTransmit = NULL;
+    CHECK(bCanBridge_Run(&stInvalid) == false);
+    stInvalid = m_stCONFIG;
+    stInvalid.u32ItemLength = m_u32CANBRIDGE_ITEMLENGTH + 1u;
+    CHECK(bCanBridge_Run(&stInvalid) == false);
+
+    memset(&m_stSim, 0, sizeof(m_stSim));
+    m_stSim.u32FreeBuffers = m_u32TXBUFFERS;
+    (void)xTaskCreateStatic(vInterruptTask, "irq", configMINIMAL_STACK_SIZE, NULL, configMAX_PRIORITIES - 1,
+            m_axInterruptStack, &m_stInterruptTask);
+    CHECK(bCanBridge_Run(&m_stCONFIG) == true);
+    CHECK(m_bEnded == true);
+
+    vCanBridge_GetStats(&stStats);
+    printf("can_bridge_sim: %u frames, %u delivered in %u messages, %u dropped, max latency %u ticks\n",
+            m_stSim.u32Generated, m_stSim.u32Delivered, m_stSim.u32Messages, stStats.u32ItemsDropped,
+            m_stSim.u32MaxLatency);
+
+    /* every frame is delivered or counted */
+    CHECK(m_stSim.u32Generated == ((m_u32NORMALTICKS + m_u32STALLTICKS + m_u32RECOVERYTICKS) * m_u32FRAMESPERTICK));
+    CHECK(m_stSim.u32Generated == (m_stSim.u32Delivered + stStats.u32ItemsDropped + m_stSim.u32RingOverflow));
+    CHECK(m_stSim.u32LastFrame == m_stSim.u32Generated);
+    /* the stalled host link made the format task wait and dropped in the item stream only */
+    CHECK(m_stStalledStats.u32ItemsDropped != 0u);
+    CHECK(m_stStalledStats.u32SendBlocked != 0u);
+    CHECK(m_stStalledStats.u32TxBusy != 0u);
+    CHECK(m_stStalledStats.u32ItemsHighWater == m_u32CANBRIDGE_ITEMS);
+    CHECK(m_u32StallRingOverflow == 0u);
+    CHECK(m_stSim.u32RingOverflow == 0u);
+    /* nothing was dropped after the backlog was sent */
+    CHECK(stStats.u32ItemsDropped == m_stRecoveredStats.u32ItemsDropped);
+    /* a quiet bus and host link wake no task */
+    CHECK(m_u32QuietCallbacks == 0u);
+
+    if (m_u32Failures != 0u) {
+        fprintf(stderr, "can_bridge_sim: %u failures\n", m_u32Failures);
+        return EXIT_FAILURE;
+    }
+    printf("can_bridge_sim: passed\n");
+    return EXIT_SUCCESS;
+}
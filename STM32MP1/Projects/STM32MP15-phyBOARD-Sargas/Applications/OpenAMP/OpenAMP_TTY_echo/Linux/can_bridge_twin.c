@@ -0,0 +1,124 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Host twin of the Cortex-M4 firmware: main.c, fdcan.c, usart.c,
+ *          openamp.c, mbox_ipcc.c, virt_uart.c and the shared modules run
+ *          unchanged on the host, against twin_hal.c, twin_ipcc.c and
+ *          twin_fdcan.c. Linux is replaced by the generic Linux machine of
+ *          open-amp, e.g. can_twin_master.c.
+ *
+ *          The twin takes the part of the remoteproc loader: it places the
+ *          resource table of the firmware at the start of the shared memory
+ *          file of the generic machine, openamp.shm, and the vrings behind
+ *          it. The shared memory is mapped at the address of the OpenAMP
+ *          region of the firmware, so the physical addresses in the vrings
+ *          are valid pointers on both sides.
+ *
+ *          usage: can_bridge_twin &
+ *                 can_twin_master
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "twin_hal.h"
+#include "rsc_table.h"
+#include "fcntl.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "unistd.h"
+#include "sys/mman.h"
+
+/* Private define ------------------------------------------------------------*/
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+/* shared memory file of the generic Linux machine of open-amp */
+#define m_pcSHMFILE "openamp.shm"
+/* vrings placed by the loader, the RPMsg buffers of the master follow at 0x10000 */
+#define m_u32VRING0OFFSET ((uint32_t)0x4000)
+#define m_u32VRING1OFFSET ((uint32_t)0x8000)
+
+/* Private variables ---------------------------------------------------------*/
+static struct shared_resource_table *m_pstResourceTable = NULL;
+
+/* Private function prototypes -----------------------------------------------*/
+/* main() and resource_table_init() of the firmware, renamed when compiled for the twin */
+int firmware_main(void);
+void resource_table_image(int RPMsgRole, void **table_ptr, int *length);
+static bool bLoadResourceTable(void);
+
+/**
+ * @brief  Maps the shared memory at SHM_START_ADDRESS and places the resource
+ *         table and the vrings, the work of the remoteproc driver of Linux.
+ * @retval false in case the shared memory could not be set up.
+ */
+static bool bLoadResourceTable(void) {
+
+    struct shared_resource_table *pstImage;
+    uint8_t *pu8Shm;
+    int iLength;
+    int iFile;
+
+    resource_table_image(RPMSG_REMOTE, (void **)&pstImage, &iLength);
+    if ((size_t)iLength > m_u32VRING0OFFSET) {
+        return false;
+    }
+
+    iFile = shm_open(m_pcSHMFILE, O_CREAT | O_RDWR | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (iFile < 0) {
+        perror("twin: shm_open");
+        return false;
+    }
+    if (ftruncate(iFile, (off_t)SHM_SIZE) != 0) {
+        perror("twin: ftruncate");
+        close(iFile);
+        return false;
+    }
+    pu8Shm = mmap((void *)(uintptr_t)SHM_START_ADDRESS, SHM_SIZE, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_FIXED_NOREPLACE, iFile, 0);
+    close(iFile);
+    if (pu8Shm != (uint8_t *)(uintptr_t)SHM_START_ADDRESS) {
+        fprintf(stderr, "twin: cannot map the shared memory at 0x%08lx\n", (unsigned long)SHM_START_ADDRESS);
+        return false;
+    }
+
+    memset(pu8Shm, 0, SHM_SIZE);
+    memcpy(pu8Shm, pstImage, (size_t)iLength);
+    m_pstResourceTable = (struct shared_resource_table *)pu8Shm;
+    m_pstResourceTable->vring0.da = (uint32_t)SHM_START_ADDRESS + m_u32VRING0OFFSET;
+    m_pstResourceTable->vring1.da = (uint32_t)SHM_START_ADDRESS + m_u32VRING1OFFSET;
+    return true;
+}
+
+/**
+ * @brief  Resource table of the firmware, the loaded copy in the shared memory.
+ * @retval void
+ */
+void resource_table_init(int RPMsgRole, void **table_ptr, int *length) {
+
+    (void)RPMsgRole;
+    *table_ptr = m_pstResourceTable;
+    *length = sizeof(*m_pstResourceTable);
+}
+
+int main(void) {
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    if ((bTwinHal_Init() == false) || (bLoadResourceTable() == false)) {
+        return EXIT_FAILURE;
+    }
+    /* returns only through Error_Handler() */
+    return firmware_main();
+}
@@ -0,0 +1,308 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Linux side client of the binary command protocol. The transport is
+ *          a pair of callbacks so the host test can replace the RPMsg tty by
+ *          a simulated endpoint.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_command_client.h"
+#include "can_filter.h"
+#include "fcntl.h"
+#include "poll.h"
+#include "stdio.h"
+#include "string.h"
+#include "termios.h"
+#include "unistd.h"
+
+/* Private function prototypes -----------------------------------------------*/
+static bool bTtyWrite(void *pvContext, const uint8_t *pu8Data, uint32_t u32Length);
+static int32_t i32TtyRead(void *pvContext, uint8_t *pu8Data, uint32_t u32Length, int iTimeoutMs);
+static void vConsume(CanClient_Struct_t *pstClient, uint32_t u32Length);
+
+/**
+ * @brief  Writes one message to the tty, RPMsg keeps the message boundary.
+ * @retval false in case the write failed.
+ */
+static bool bTtyWrite(void *pvContext, const uint8_t *pu8Data, uint32_t u32Length) {
+
+    CanClient_Struct_t *pstClient = (CanClient_Struct_t *)pvContext;
+
+    return write(pstClient->iFd, pu8Data, u32Length) == (ssize_t)u32Length;
+}
+
+/**
+ * @brief  Reads what the tty has, waits up to iTimeoutMs for data.
+ * @retval bytes read, 0 on timeout, -1 on error.
+ */
+static int32_t i32TtyRead(void *pvContext, uint8_t *pu8Data, uint32_t u32Length, int iTimeoutMs) {
+
+    CanClient_Struct_t *pstClient = (CanClient_Struct_t *)pvContext;
+    struct pollfd stPoll = { pstClient->iFd, POLLIN, 0 };
+    int iReady = poll(&stPoll, 1, iTimeoutMs);
+    ssize_t iRead;
+
+    if (iReady <= 0) {
+        return (iReady == 0) ? 0 : -1;
+    }
+    iRead = read(pstClient->iFd, pu8Data, u32Length);
+    return (iRead > 0) ? (int32_t)iRead : -1;
+}
+
+/**
+ * @brief  Drops bytes from the start of the receive stream.
+ * @retval void
+ */
+static void vConsume(CanClient_Struct_t *pstClient, uint32_t u32Length) {
+    memmove(pstClient->au8Stream, &pstClient->au8Stream[u32Length], pstClient->u32Fill - u32Length);
+    pstClient->u32Fill -= u32Length;
+}
+
+/**
+ * @brief  Sets up a client on a custom transport.
+ * @retval void
+ */
+void vCanClient_Init(CanClient_Struct_t *pstClient, CanClient_WriteFn_t pfnWrite, CanClient_ReadFn_t pfnRead,
+        void *pvContext) {
+
+    memset(pstClient, 0, sizeof(*pstClient));
+    pstClient->pfnWrite = pfnWrite;
+    pstClient->pfnRead = pfnRead;
+    pstClient->pvContext = pvContext;
+    pstClient->iFd = -1;
+    pstClient->iTimeoutMs = m_iCANCLIENT_TIMEOUTMS;
+    pstClient->u16NextRequestId = 1u;
+}
+
+/**
+ * @brief  Sets up a client on the control channel tty in raw mode.
+ * @retval false in case the device could not be opened.
+ */
+bool bCanClient_Open(CanClient_Struct_t *pstClient, const char *pcDevice) {
+
+    struct termios stTermios;
+    int iFd = open(pcDevice, O_RDWR | O_NOCTTY);
+
+    if (iFd < 0) {
+        perror(pcDevice);
+        return false;
+    }
+    /* binary data, no line discipline */
+    if (tcgetattr(iFd, &stTermios) == 0) {
+        cfmakeraw(&stTermios);
+        (void)tcsetattr(iFd, TCSANOW, &stTermios);
+    }
+
+    vCanClient_Init(pstClient, bTtyWrite, i32TtyRead, pstClient);
+    pstClient->iFd = iFd;
+    return true;
+}
+
+/**
+ * @brief  Closes the device opened by bCanClient_Open.
+ * @retval void
+ */
+void vCanClient_Close(CanClient_Struct_t *pstClient) {
+    if (pstClient->iFd >= 0) {
+        close(pstClient->iFd);
+        pstClient->iFd = -1;
+    }
+}
+
+/**
+ * @brief  Sends one request and waits for its response. The response data is
+ *         stored in au8Data / u16DataLength of the client.
+ * @retval status of the response, m_i32CANCLIENT_ERROR_TIMEOUT in case no data
+ *         arrived for iTimeoutMs.
+ */
+int32_t i32CanClient_Request(CanClient_Struct_t *pstClient, uint8_t u8Command, const uint8_t au8Payload[],
+        uint16_t u16Length) {
+
+    uint8_t au8Request[m_u32CANCOMMAND_MAXLENGTH];
+    CanCommand_ResponseStruct_t stResponse;
+    uint16_t u16RequestId = pstClient->u16NextRequestId++;
+    uint32_t u32Length = u32CanCommand_BuildRequest(au8Request, u8Command, u16RequestId, au8Payload, u16Length);
+    int32_t i32Result;
+
+    if (u32Length == 0u) {
+        return m_i32CANCLIENT_ERROR_PROTOCOL;
+    }
+    if (pstClient->pfnWrite(pstClient->pvContext, au8Request, u32Length) == false) {
+        return m_i32CANCLIENT_ERROR_IO;
+    }
+
+    pstClient->u16DataLength = 0u;
+    while (true) {
+        i32Result = i32CanCommand_ParseResponse(pstClient->au8Stream, pstClient->u32Fill, &stResponse);
+        if (i32Result < 0) {
+            /* no response, search the next magic */
+            vConsume(pstClient, 1u);
+            pstClient->u32SkippedBytes++;
+            continue;
+        }
+        if (i32Result > 0) {
+            if ((stResponse.u16RequestId == u16RequestId) && (stResponse.u8Command == u8Command)) {
+                memcpy(pstClient->au8Data, stResponse.pu8Data, stResponse.u16DataLength);
+                pstClient->u16DataLength = stResponse.u16DataLength;
+                vConsume(pstClient, (uint32_t)i32Result);
+                return (int32_t)stResponse.eStatus;
+            }
+            /* late response of an earlier request */
+            vConsume(pstClient, (uint32_t)i32Result);
+            continue;
+        }
+
+        i32Result = pstClient->pfnRead(pstClient->pvContext, &pstClient->au8Stream[pstClient->u32Fill],
+                (uint32_t)sizeof(pstClient->au8Stream) - pstClient->u32Fill, pstClient->iTimeoutMs);
+        if (i32Result == 0) {
+            return m_i32CANCLIENT_ERROR_TIMEOUT;
+        }
+        if (i32Result < 0) {
+            return m_i32CANCLIENT_ERROR_IO;
+        }
+        pstClient->u32Fill += (uint32_t)i32Result;
+    }
+}
+
+/**
+ * @brief  Starts forwarding the received frames.
+ * @retval status of the response or m_i32CANCLIENT_ERROR_xxx
+ */
+int32_t i32CanClient_Start(CanClient_Struct_t *pstClient) {
+    return i32CanClient_Request(pstClient, m_u8CANCOMMAND_START, NULL, 0u);
+}
+
+/**
+ * @brief  Stops forwarding the received frames.
+ * @retval status of the response or m_i32CANCLIENT_ERROR_xxx
+ */
+int32_t i32CanClient_Stop(CanClient_Struct_t *pstClient) {
+    return i32CanClient_Request(pstClient, m_u8CANCOMMAND_STOP, NULL, 0u);
+}
+
+/**
+ * @brief  Selects m_u8CANCOMMAND_FORMAT_ASCII or _BINARY on the data channel.
+ * @retval status of the response or m_i32CANCLIENT_ERROR_xxx
+ */
+int32_t i32CanClient_SetFormat(CanClient_Struct_t *pstClient, uint8_t u8Format) {
+    return i32CanClient_Request(pstClient, m_u8CANCOMMAND_SETFORMAT, &u8Format, 1u);
+}
+
+/**
+ * @brief  Removes all filter rules, all frames are received again.
+ * @retval status of the response or m_i32CANCLIENT_ERROR_xxx
+ */
+int32_t i32CanClient_FilterClear(CanClient_Struct_t *pstClient) {
+    return i32CanClient_Request(pstClient, m_u8CANCOMMAND_FILTERCLEAR, NULL, 0u);
+}
+
+/**
+ * @brief  Adds a filter rule, u8Type is m_u8CANFILTER_TYPE_xxx (can_filter.h).
+ * @retval status of the response or m_i32CANCLIENT_ERROR_xxx
+ */
+int32_t i32CanClient_FilterAdd(CanClient_Struct_t *pstClient, bool bExtended, uint8_t u8Type, bool bReject,
+        uint32_t u32Id1, uint32_t u32Id2) {
+
+    uint8_t au8Payload[m_u32CANCOMMAND_FILTERADDLENGTH];
+
+    au8Payload[0] = (bExtended == true) ? 1u : 0u;
+    au8Payload[1] = u8Type;
+    au8Payload[2] = (bReject == true) ? m_u8CANFILTER_CONFIG_REJECT : m_u8CANFILTER_CONFIG_RXFIFO0;
+    au8Payload[3] = 0u;
+    vCanCommand_PutUint32(&au8Payload[4], u32Id1);
+    vCanCommand_PutUint32(&au8Payload[8], u32Id2);
+    return i32CanClient_Request(pstClient, m_u8CANCOMMAND_FILTERADD, au8Payload, sizeof(au8Payload));
+}
+
+/**
+ * @brief  Programs the added filter rules.
+ * @retval status of the response or m_i32CANCLIENT_ERROR_xxx
+ */
+int32_t i32CanClient_FilterApply(CanClient_Struct_t *pstClient) {
+    return i32CanClient_Request(pstClient, m_u8CANCOMMAND_FILTERAPPLY, NULL, 0u);
+}
+
+/**
+ * @brief  Reads the counters in CanCommand_Stat_t order. au32Stats holds
+ *         *pu32Count entries, *pu32Count returns the number reported.
+ * @retval status of the response or m_i32CANCLIENT_ERROR_xxx
+ */
+int32_t i32CanClient_GetStats(CanClient_Struct_t *pstClient, uint32_t au32Stats[], uint32_t *pu32Count) {
+
+    int32_t i32Status = i32CanClient_Request(pstClient, m_u8CANCOMMAND_GETSTATS, NULL, 0u);
+    uint32_t u32Count = pstClient->u16DataLength / 4u;
+
+    if (i32Status != CANCOMMAND_OK) {
+        return i32Status;
+    }
+    /* newer firmware may report more counters */
+    if (u32Count > *pu32Count) {
+        u32Count = *pu32Count;
+    }
+    for (uint32_t i = 0; i < u32Count; i++) {
+        au32Stats[i] = u32CanCommand_GetUint32(&pstClient->au8Data[4u * i]);
+    }
+    *pu32Count = u32Count;
+    return i32Status;
+}
+
+/**
+ * @brief  Limits the frames forwarded to Linux, 0 removes the limit.
+ * @retval status of the response or m_i32CANCLIENT_ERROR_xxx
+ */
+int32_t i32CanClient_SetRateLimit(CanClient_Struct_t *pstClient, uint32_t u32FramesPerSecond) {
+
+    uint8_t au8Payload[4];
+
+    vCanCommand_PutUint32(au8Payload, u32FramesPerSecond);
+    return i32CanClient_Request(pstClient, m_u8CANCOMMAND_SETRATELIMIT, au8Payload, sizeof(au8Payload));
+}
+
+/**
+ * @brief  Reads the protocol and the binary record format versions.
+ * @retval status of the response or m_i32CANCLIENT_ERROR_xxx
+ */
+int32_t i32CanClient_GetVersion(CanClient_Struct_t *pstClient, uint8_t *pu8Protocol, uint8_t *pu8Record) {
+
+    int32_t i32Status = i32CanClient_Request(pstClient, m_u8CANCOMMAND_GETVERSION, NULL, 0u);
+
+    if (i32Status != CANCOMMAND_OK) {
+        return i32Status;
+    }
+    if (pstClient->u16DataLength < 2u) {
+        return m_i32CANCLIENT_ERROR_PROTOCOL;
+    }
+    *pu8Protocol = pstClient->au8Data[0];
+    *pu8Record = pstClient->au8Data[1];
+    return i32Status;
+}
+
+/**
+ * @brief  Reads the per stage latency statistics, bClear restarts them.
+ * @retval status of the response or m_i32CANCLIENT_ERROR_xxx
+ */
+int32_t i32CanClient_GetLatency(CanClient_Struct_t *pstClient, bool bClear, CanLatency_ReportStruct_t *pstReport) {
+
+    uint8_t u8Clear = (bClear == true) ? 1u : 0u;
+    int32_t i32Status = i32CanClient_Request(pstClient, m_u8CANCOMMAND_GETLATENCY, &u8Clear, 1u);
+
+    if (i32Status != CANCOMMAND_OK) {
+        return i32Status;
+    }
+    if (bCanLatency_Decode(pstClient->au8Data, pstClient->u16DataLength, pstReport) == false) {
+        return m_i32CANCLIENT_ERROR_PROTOCOL;
+    }
+    return i32Status;
+}
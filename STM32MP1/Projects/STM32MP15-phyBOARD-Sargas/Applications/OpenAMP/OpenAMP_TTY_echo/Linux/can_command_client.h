@@ -0,0 +1,88 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Header for the Linux side client of the binary command protocol
+ *          (can_command.h) on the control channel /dev/ttyRPMSG0.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ *
+ * Every call sends one request and waits for the response with the same
+ * request id. Responses of earlier, timed out requests and text replies of
+ * the legacy text commands are skipped. The calls return the status of the
+ * response (CanCommand_Status_t) or a negative m_i32CANCLIENT_ERROR_xxx.
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CAN_COMMAND_CLIENT_H
+#define __CAN_COMMAND_CLIENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "can_command.h"
+#include "can_latency.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define m_pcCANCLIENT_DEFAULTDEVICE "/dev/ttyRPMSG0"
+#define m_iCANCLIENT_TIMEOUTMS 1000
+
+#define m_i32CANCLIENT_ERROR_IO ((int32_t)-1)
+#define m_i32CANCLIENT_ERROR_TIMEOUT ((int32_t)-2)
+#define m_i32CANCLIENT_ERROR_PROTOCOL ((int32_t)-3)
+
+/* Exported types ------------------------------------------------------------*/
+/* transport, writes one message, returns false on error */
+typedef bool (*CanClient_WriteFn_t)(void *pvContext, const uint8_t *pu8Data, uint32_t u32Length);
+/* transport, returns the bytes read, 0 after iTimeoutMs without data, < 0 on error */
+typedef int32_t (*CanClient_ReadFn_t)(void *pvContext, uint8_t *pu8Data, uint32_t u32Length, int iTimeoutMs);
+
+typedef struct {
+    CanClient_WriteFn_t pfnWrite;
+    CanClient_ReadFn_t pfnRead;
+    void *pvContext;
+    int iFd;                    /* device opened by iCanClient_Open, -1 otherwise */
+    int iTimeoutMs;
+    uint16_t u16NextRequestId;
+    uint32_t u32Fill;
+    uint32_t u32SkippedBytes;   /* bytes which were no response */
+    uint8_t au8Stream[2u * m_u32CANCOMMAND_MAXLENGTH];
+    uint8_t au8Data[m_u32CANCOMMAND_MAXPAYLOAD];    /* data of the last response */
+    uint16_t u16DataLength;
+} CanClient_Struct_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void vCanClient_Init(CanClient_Struct_t *pstClient, CanClient_WriteFn_t pfnWrite, CanClient_ReadFn_t pfnRead,
+        void *pvContext);
+bool bCanClient_Open(CanClient_Struct_t *pstClient, const char *pcDevice);
+void vCanClient_Close(CanClient_Struct_t *pstClient);
+int32_t i32CanClient_Request(CanClient_Struct_t *pstClient, uint8_t u8Command, const uint8_t au8Payload[],
+        uint16_t u16Length);
+
+int32_t i32CanClient_Start(CanClient_Struct_t *pstClient);
+int32_t i32CanClient_Stop(CanClient_Struct_t *pstClient);
+int32_t i32CanClient_SetFormat(CanClient_Struct_t *pstClient, uint8_t u8Format);
+int32_t i32CanClient_FilterClear(CanClient_Struct_t *pstClient);
+int32_t i32CanClient_FilterAdd(CanClient_Struct_t *pstClient, bool bExtended, uint8_t u8Type, bool bReject,
+        uint32_t u32Id1, uint32_t u32Id2);
+int32_t i32CanClient_FilterApply(CanClient_Struct_t *pstClient);
+int32_t i32CanClient_GetStats(CanClient_Struct_t *pstClient, uint32_t au32Stats[], uint32_t *pu32Count);
+int32_t i32CanClient_SetRateLimit(CanClient_Struct_t *pstClient, uint32_t u32FramesPerSecond);
+int32_t i32CanClient_GetVersion(CanClient_Struct_t *pstClient, uint8_t *pu8Protocol, uint8_t *pu8Record);
+int32_t i32CanClient_GetLatency(CanClient_Struct_t *pstClient, bool bClear, CanLatency_ReportStruct_t *pstReport);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_COMMAND_CLIENT_H */
@@ -0,0 +1,495 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Host test of the binary command protocol. The client library talks
+ *          to a simulated RPMsg endpoint which dispatches the requests with
+ *          can_command.c to handlers modelled on those of main.c.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_command.h"
+#include "can_command_client.h"
+#include "can_filter.h"
+#include "can_latency.h"
+#include "can_record.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+/* Private macro -------------------------------------------------------------*/
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            m_u32Failures++; \
+        } \
+    } while (0)
+
+/* Private typedef -----------------------------------------------------------*/
+/* simulated endpoint, the responses are queued for the Linux side reads */
+typedef struct {
+    uint8_t au8Rx[8192];
+    uint32_t u32RxFill;
+    uint32_t u32RxRead;
+    uint32_t u32MaxRead;        /* bytes per read, models a tty splitting messages */
+    bool bDropResponse;         /* simulate a lost response */
+    const char *pcNoise;        /* text sent in front of the next response */
+    uint8_t au8LastRequest[m_u32CANCOMMAND_MAXLENGTH];
+    uint32_t u32LastRequestLength;
+} Endpoint_Struct_t;
+
+/* Private function prototypes -----------------------------------------------*/
+static CanCommand_Status_t eStart(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength);
+static CanCommand_Status_t eStop(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength);
+static CanCommand_Status_t eSetFormat(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength);
+static CanCommand_Status_t eFilterClear(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength);
+static CanCommand_Status_t eFilterAdd(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength);
+static CanCommand_Status_t eFilterApply(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength);
+static CanCommand_Status_t eGetStats(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength);
+static CanCommand_Status_t eSetRateLimit(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength);
+static CanCommand_Status_t eGetVersion(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength);
+static CanCommand_Status_t eGetLatency(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength);
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t m_u32Failures = 0;
+
+/* state of the simulated firmware */
+static bool m_bActive;
+static bool m_bBinary;
+static uint32_t m_u32RateLimit;
+static uint32_t m_u32Applied;
+static bool m_bApplyFails;
+static CanFilter_TableStruct_t m_stTable;
+static CanLatency_Struct_t m_stLatency;
+
+static const CanCommand_EntryStruct_t m_astCOMMANDS[] = {
+    { m_u8CANCOMMAND_START, 0u, 0u, eStart },
+    { m_u8CANCOMMAND_STOP, 0u, 0u, eStop },
+    { m_u8CANCOMMAND_SETFORMAT, 1u, 1u, eSetFormat },
+    { m_u8CANCOMMAND_FILTERCLEAR, 0u, 0u, eFilterClear },
+    { m_u8CANCOMMAND_FILTERADD, m_u32CANCOMMAND_FILTERADDLENGTH, m_u32CANCOMMAND_FILTERADDLENGTH, eFilterAdd },
+    { m_u8CANCOMMAND_FILTERAPPLY, 0u, 0u, eFilterApply },
+    { m_u8CANCOMMAND_GETSTATS, 0u, 0u, eGetStats },
+    { m_u8CANCOMMAND_SETRATELIMIT, 4u, 4u, eSetRateLimit },
+    { m_u8CANCOMMAND_GETVERSION, 0u, 0u, eGetVersion },
+    { m_u8CANCOMMAND_GETLATENCY, 0u, 1u, eGetLatency },
+};
+
+static CanCommand_Status_t eStart(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength) {
+    (void)au8Payload; (void)u16Length; (void)au8Data; (void)pu16DataLength;
+    m_bActive = true;
+    return CANCOMMAND_OK;
+}
+
+static CanCommand_Status_t eStop(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength) {
+    (void)au8Payload; (void)u16Length; (void)au8Data; (void)pu16DataLength;
+    m_bActive = false;
+    return CANCOMMAND_OK;
+}
+
+static CanCommand_Status_t eSetFormat(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength) {
+    (void)u16Length; (void)au8Data; (void)pu16DataLength;
+    if (au8Payload[0] > m_u8CANCOMMAND_FORMAT_BINARY) {
+        return CANCOMMAND_ERROR_VALUE;
+    }
+    m_bBinary = (au8Payload[0] == m_u8CANCOMMAND_FORMAT_BINARY);
+    return CANCOMMAND_OK;
+}
+
+static CanCommand_Status_t eFilterClear(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength) {
+    (void)au8Payload; (void)u16Length; (void)au8Data; (void)pu16DataLength;
+    vCanFilter_Init(&m_stTable);
+    m_u32Applied++;
+    return CANCOMMAND_OK;
+}
+
+static CanCommand_Status_t eFilterAdd(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength) {
+
+    CanFilter_RuleStruct_t stRule;
+
+    (void)u16Length; (void)au8Data; (void)pu16DataLength;
+    if (au8Payload[0] > 1u) {
+        return CANCOMMAND_ERROR_VALUE;
+    }
+    stRule.u8Type = au8Payload[1];
+    stRule.u8Config = au8Payload[2];
+    stRule.u32Id1 = u32CanCommand_GetUint32(&au8Payload[4]);
+    stRule.u32Id2 = u32CanCommand_GetUint32(&au8Payload[8]);
+
+    switch (eCanFilter_Add(&m_stTable, au8Payload[0] == 1u, &stRule)) {
+    case CANFILTER_ADDED:
+        return CANCOMMAND_OK;
+    case CANFILTER_ERROR_FULL:
+        return CANCOMMAND_ERROR_NOSPACE;
+    default:
+        return CANCOMMAND_ERROR_VALUE;
+    }
+}
+
+static CanCommand_Status_t eFilterApply(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength) {
+    (void)au8Payload; (void)u16Length; (void)au8Data; (void)pu16DataLength;
+    if (m_bApplyFails == true) {
+        return CANCOMMAND_ERROR_FAILED;
+    }
+    m_u32Applied++;
+    return CANCOMMAND_OK;
+}
+
+static CanCommand_Status_t eGetStats(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength) {
+    (void)au8Payload; (void)u16Length;
+    for (uint32_t i = 0; i < CANCOMMAND_STAT_COUNT; i++) {
+        vCanCommand_PutUint32(&au8Data[4u * i], 0x01000000u * i + i);
+    }
+    *pu16DataLength = (uint16_t)(4u * CANCOMMAND_STAT_COUNT);
+    return CANCOMMAND_OK;
+}
+
+static CanCommand_Status_t eSetRateLimit(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength) {
+    (void)u16Length; (void)au8Data; (void)pu16DataLength;
+    m_u32RateLimit = u32CanCommand_GetUint32(au8Payload);
+    return CANCOMMAND_OK;
+}
+
+static CanCommand_Status_t eGetVersion(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength) {
+    (void)au8Payload; (void)u16Length;
+    au8Data[0] = m_u8CANCOMMAND_VERSION;
+    au8Data[1] = m_u8CANRECORD_VERSION;
+    *pu16DataLength = 2u;
+    return CANCOMMAND_OK;
+}
+
+static CanCommand_Status_t eGetLatency(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength) {
+    *pu16DataLength = (uint16_t)u32CanLatency_Encode(&m_stLatency, 209u, au8Data);
+    if ((u16Length == 1u) && (au8Payload[0] == 1u)) {
+        vCanLatency_Init(&m_stLatency);
+    }
+    return CANCOMMAND_OK;
+}
+
+/**
+ * @brief  Resets the simulated firmware and endpoint.
+ * @retval void
+ */
+static void vReset(Endpoint_Struct_t *pstEndpoint) {
+    memset(pstEndpoint, 0, sizeof(*pstEndpoint));
+    pstEndpoint->u32MaxRead = sizeof(pstEndpoint->au8Rx);
+    m_bActive = false;
+    m_bBinary = false;
+    m_u32RateLimit = 0u;
+    m_u32Applied = 0u;
+    m_bApplyFails = false;
+    vCanFilter_Init(&m_stTable);
+    vCanLatency_Init(&m_stLatency);
+}
+
+/**
+ * @brief  Queues bytes for the Linux side.
+ * @retval void
+ */
+static void vQueue(Endpoint_Struct_t *pstEndpoint, const uint8_t *pu8Data, uint32_t u32Length) {
+    if (pstEndpoint->u32RxFill + u32Length <= sizeof(pstEndpoint->au8Rx)) {
+        memcpy(&pstEndpoint->au8Rx[pstEndpoint->u32RxFill], pu8Data, u32Length);
+        pstEndpoint->u32RxFill += u32Length;
+    }
+}
+
+/**
+ * @brief  Client write: the message arrives at the firmware, which answers at once.
+ * @retval true
+ */
+static bool bEndpointWrite(void *pvContext, const uint8_t *pu8Data, uint32_t u32Length) {
+
+    Endpoint_Struct_t *pstEndpoint = (Endpoint_Struct_t *)pvContext;
+    uint8_t au8Response[m_u32CANCOMMAND_MAXLENGTH];
+    uint32_t u32Response;
+
+    memcpy(pstEndpoint->au8LastRequest, pu8Data, u32Length);
+    pstEndpoint->u32LastRequestLength = u32Length;
+
+    u32Response = u32CanCommand_Dispatch(m_astCOMMANDS, sizeof(m_astCOMMANDS) / sizeof(m_astCOMMANDS[0]),
+            pu8Data, u32Length, au8Response);
+    if (pstEndpoint->pcNoise != NULL) {
+        vQueue(pstEndpoint, (const uint8_t *)pstEndpoint->pcNoise, (uint32_t)strlen(pstEndpoint->pcNoise));
+        pstEndpoint->pcNoise = NULL;
+    }
+    if (pstEndpoint->bDropResponse == true) {
+        pstEndpoint->bDropResponse = false;
+        return true;
+    }
+    vQueue(pstEndpoint, au8Response, u32Response);
+    return true;
+}
+
+/**
+ * @brief  Client read: returns at most u32MaxRead queued bytes, 0 when empty.
+ * @retval bytes read
+ */
+static int32_t i32EndpointRead(void *pvContext, uint8_t *pu8Data, uint32_t u32Length, int iTimeoutMs) {
+
+    Endpoint_Struct_t *pstEndpoint = (Endpoint_Struct_t *)pvContext;
+    uint32_t u32Available = pstEndpoint->u32RxFill - pstEndpoint->u32RxRead;
+
+    (void)iTimeoutMs;
+    if (u32Available > u32Length) {
+        u32Available = u32Length;
+    }
+    if (u32Available > pstEndpoint->u32MaxRead) {
+        u32Available = pstEndpoint->u32MaxRead;
+    }
+    memcpy(pu8Data, &pstEndpoint->au8Rx[pstEndpoint->u32RxRead], u32Available);
+    pstEndpoint->u32RxRead += u32Available;
+    return (int32_t)u32Available;
+}
+
+/**
+ * @brief  Dispatches a raw request and returns the parsed response.
+ * @retval length of the response
+ */
+static uint32_t u32RawRequest(const uint8_t au8Request[], uint32_t u32Length, uint8_t au8Response[],
+        CanCommand_ResponseStruct_t *pstResponse) {
+
+    uint32_t u32Response = u32CanCommand_Dispatch(m_astCOMMANDS, sizeof(m_astCOMMANDS) / sizeof(m_astCOMMANDS[0]),
+            au8Request, u32Length, au8Response);
+
+    if (u32Response != 0u) {
+        CHECK(i32CanCommand_ParseResponse(au8Response, u32Response, pstResponse) == (int32_t)u32Response);
+    }
+    return u32Response;
+}
+
+/**
+ * @brief  Request layout on the wire.
+ * @retval void
+ */
+static void vTestEncoding(void) {
+
+    static const uint8_t s_au8EXPECTED[] = { 0x43, 0x4D, 0x01, 0x08, 0x34, 0x12, 0x04, 0x00, 0x10, 0x27, 0x00, 0x00 };
+    uint8_t au8Payload[4];
+    uint8_t au8Request[m_u32CANCOMMAND_MAXLENGTH];
+
+    vCanCommand_PutUint32(au8Payload, 10000u);
+    CHECK(u32CanCommand_BuildRequest(au8Request, m_u8CANCOMMAND_SETRATELIMIT, 0x1234u, au8Payload, 4u) == 12u);
+    CHECK(memcmp(au8Request, s_au8EXPECTED, sizeof(s_au8EXPECTED)) == 0);
+    CHECK(u32CanCommand_BuildRequest(au8Request, m_u8CANCOMMAND_START, 1u, NULL, m_u32CANCOMMAND_MAXPAYLOAD + 1u) == 0u);
+
+    CHECK(bCanCommand_IsCommand(au8Request, 12u) == true);
+    CHECK(bCanCommand_IsCommand((const uint8_t *)"start", 5u) == false);
+    CHECK(bCanCommand_IsCommand(au8Request, 1u) == false);
+}
+
+/**
+ * @brief  Every command through the client library.
+ * @retval void
+ */
+static void vTestClient(void) {
+
+    Endpoint_Struct_t stEndpoint;
+    CanClient_Struct_t stClient;
+    uint32_t au32Stats[CANCOMMAND_STAT_COUNT + 4u];
+    uint32_t u32Count;
+    CanLatency_ReportStruct_t stReport;
+    uint8_t u8Protocol;
+    uint8_t u8Record;
+
+    vReset(&stEndpoint);
+    vCanClient_Init(&stClient, bEndpointWrite, i32EndpointRead, &stEndpoint);
+
+    CHECK(i32CanClient_Start(&stClient) == CANCOMMAND_OK);
+    CHECK(m_bActive == true);
+    CHECK(i32CanClient_SetFormat(&stClient, m_u8CANCOMMAND_FORMAT_BINARY) == CANCOMMAND_OK);
+    CHECK(m_bBinary == true);
+    CHECK(i32CanClient_SetFormat(&stClient, 7u) == CANCOMMAND_ERROR_VALUE);
+    CHECK(m_bBinary == true);
+    CHECK(i32CanClient_Stop(&stClient) == CANCOMMAND_OK);
+    CHECK(m_bActive == false);
+
+    CHECK(i32CanClient_FilterAdd(&stClient, false, m_u8CANFILTER_TYPE_MASK, false, 0x123u, 0x7FFu) == CANCOMMAND_OK);
+    CHECK(i32CanClient_FilterAdd(&stClient, true, m_u8CANFILTER_TYPE_RANGE, true, 0x1000u, 0x1FFFu) == CANCOMMAND_OK);
+    CHECK(i32CanClient_FilterAdd(&stClient, false, m_u8CANFILTER_TYPE_RANGE, false, 5u, 4u) == CANCOMMAND_ERROR_VALUE);
+    CHECK(i32CanClient_FilterAdd(&stClient, false, 3u, false, 1u, 2u) == CANCOMMAND_ERROR_VALUE);
+    CHECK(i32CanClient_FilterAdd(&stClient, false, m_u8CANFILTER_TYPE_DUAL, false, 0x800u, 1u) == CANCOMMAND_ERROR_VALUE);
+    CHECK(m_stTable.u32StdCount == 1u);
+    CHECK(m_stTable.u32ExtCount == 1u);
+    CHECK(u32CanFilter_EncodeStd(&m_stTable.astStd[0]) == 0x892307FFu);
+    CHECK(m_stTable.astExt[0].u8Config == m_u8CANFILTER_CONFIG_REJECT);
+    CHECK(i32CanClient_FilterApply(&stClient) == CANCOMMAND_OK);
+    CHECK(m_u32Applied == 1u);
+    m_bApplyFails = true;
+    CHECK(i32CanClient_FilterApply(&stClient) == CANCOMMAND_ERROR_FAILED);
+    CHECK(i32CanClient_FilterClear(&stClient) == CANCOMMAND_OK);
+    CHECK(m_stTable.u32StdCount == 0u);
+
+    for (uint32_t i = 0; i < m_u32CANFILTER_EXTCOUNT; i++) {
+        CHECK(i32CanClient_FilterAdd(&stClient, true, m_u8CANFILTER_TYPE_DUAL, false, i, i) == CANCOMMAND_OK);
+    }
+    CHECK(i32CanClient_FilterAdd(&stClient, true, m_u8CANFILTER_TYPE_DUAL, false, 1u, 1u) == CANCOMMAND_ERROR_NOSPACE);
+
+    CHECK(i32CanClient_SetRateLimit(&stClient, 2500u) == CANCOMMAND_OK);
+    CHECK(m_u32RateLimit == 2500u);
+
+    u32Count = sizeof(au32Stats) / sizeof(au32Stats[0]);
+    CHECK(i32CanClient_GetStats(&stClient, au32Stats, &u32Count) == CANCOMMAND_OK);
+    CHECK(u32Count == CANCOMMAND_STAT_COUNT);
+    CHECK(au32Stats[CANCOMMAND_STAT_RXFRAMES] == 0u);
+    CHECK(au32Stats[CANCOMMAND_STAT_MIRRORDROPPED] == 0x0A00000Au);
+    CHECK(au32Stats[CANCOMMAND_STAT_MIRRORFAILED] == 0x0E00000Eu);
+    /* older client with fewer counters */
+    u32Count = 2u;
+    CHECK(i32CanClient_GetStats(&stClient, au32Stats, &u32Count) == CANCOMMAND_OK);
+    CHECK(u32Count == 2u);
+    CHECK(au32Stats[1] == 0x01000001u);
+
+    CHECK(i32CanClient_GetVersion(&stClient, &u8Protocol, &u8Record) == CANCOMMAND_OK);
+    CHECK(u8Protocol == m_u8CANCOMMAND_VERSION);
+    CHECK(u8Record == m_u8CANRECORD_VERSION);
+    CHECK(i32CanClient_Request(&stClient, 0x55u, NULL, 0u) == CANCOMMAND_ERROR_COMMAND);
+
+    /* the latency report is the largest response */
+    vCanLatency_Add(&m_stLatency, CANLATENCY_STAGE_KICK, 1000u);
+    CHECK(i32CanClient_GetLatency(&stClient, true, &stReport) == CANCOMMAND_OK);
+    CHECK(stReport.astStages[CANLATENCY_STAGE_KICK].u32Max == 1000u);
+    CHECK(i32CanClient_GetLatency(&stClient, false, &stReport) == CANCOMMAND_OK);
+    CHECK(stReport.astStages[CANLATENCY_STAGE_KICK].u32Count == 0u);
+
+    CHECK(stClient.u32SkippedBytes == 0u);
+    CHECK(stEndpoint.u32RxRead == stEndpoint.u32RxFill);
+}
+
+/**
+ * @brief  Request ids, split reads, text replies and lost responses.
+ * @retval void
+ */
+static void vTestTransport(void) {
+
+    Endpoint_Struct_t stEndpoint;
+    CanClient_Struct_t stClient;
+    uint16_t u16RequestId;
+
+    vReset(&stEndpoint);
+    vCanClient_Init(&stClient, bEndpointWrite, i32EndpointRead, &stEndpoint);
+
+    /* request ids increase and are echoed */
+    u16RequestId = stClient.u16NextRequestId;
+    CHECK(i32CanClient_Start(&stClient) == CANCOMMAND_OK);
+    CHECK(stEndpoint.au8LastRequest[4] == (uint8_t)u16RequestId);
+    CHECK(i32CanClient_Start(&stClient) == CANCOMMAND_OK);
+    CHECK(stEndpoint.au8LastRequest[4] == (uint8_t)(u16RequestId + 1u));
+
+    /* tty delivers a few bytes per read */
+    stEndpoint.u32MaxRead = 3u;
+    CHECK(i32CanClient_SetRateLimit(&stClient, 1u) == CANCOMMAND_OK);
+    CHECK(m_u32RateLimit == 1u);
+    stEndpoint.u32MaxRead = sizeof(stEndpoint.au8Rx);
+
+    /* reply of a legacy text command in front of the response */
+    stEndpoint.pcNoise = "filter: added\n";
+    CHECK(i32CanClient_Stop(&stClient) == CANCOMMAND_OK);
+    CHECK(stClient.u32SkippedBytes == strlen("filter: added\n"));
+
+    /* the response is lost, the next call skips nothing but its own answer */
+    stEndpoint.bDropResponse = true;
+    CHECK(i32CanClient_Start(&stClient) == m_i32CANCLIENT_ERROR_TIMEOUT);
+    CHECK(i32CanClient_Stop(&stClient) == CANCOMMAND_OK);
+    CHECK(m_bActive == false);
+
+    /* a response arriving after its request timed out is discarded */
+    {
+        uint8_t au8Late[m_u32CANCOMMAND_MAXLENGTH];
+        uint8_t au8Request[m_u32CANCOMMAND_HEADERLENGTH];
+        uint32_t u32Length;
+
+        u32Length = u32CanCommand_BuildRequest(au8Request, m_u8CANCOMMAND_START, (uint16_t)(stClient.u16NextRequestId - 7u), NULL, 0u);
+        u32Length = u32CanCommand_Dispatch(m_astCOMMANDS, sizeof(m_astCOMMANDS) / sizeof(m_astCOMMANDS[0]),
+                au8Request, u32Length, au8Late);
+        vQueue(&stEndpoint, au8Late, u32Length);
+    }
+    CHECK(i32CanClient_Stop(&stClient) == CANCOMMAND_OK);
+    CHECK(stEndpoint.u32RxRead == stEndpoint.u32RxFill);
+}
+
+/**
+ * @brief  Malformed requests are answered with an error status.
+ * @retval void
+ */
+static void vTestDispatchErrors(void) {
+
+    Endpoint_Struct_t stEndpoint;
+    CanCommand_ResponseStruct_t stResponse;
+    uint8_t au8Request[m_u32CANCOMMAND_MAXLENGTH];
+    uint8_t au8Response[m_u32CANCOMMAND_MAXLENGTH];
+    uint8_t au8Payload[2] = { 1u, 1u };
+    uint32_t u32Length;
+
+    vReset(&stEndpoint);
+
+    /* no command, the text handling takes over */
+    CHECK(u32RawRequest((const uint8_t *)"start", 5u, au8Response, &stResponse) == 0u);
+    CHECK(u32RawRequest(au8Request, 0u, au8Response, &stResponse) == 0u);
+
+    /* header too short */
+    u32Length = u32CanCommand_BuildRequest(au8Request, m_u8CANCOMMAND_START, 9u, NULL, 0u);
+    CHECK(u32RawRequest(au8Request, u32Length - 1u, au8Response, &stResponse) == 0u);
+
+    /* unsupported version, the response reports the supported one */
+    au8Request[2] = 2u;
+    CHECK(u32RawRequest(au8Request, u32Length, au8Response, &stResponse) != 0u);
+    CHECK(stResponse.eStatus == CANCOMMAND_ERROR_VERSION);
+    CHECK((stResponse.u16DataLength == 1u) && (stResponse.pu8Data[0] == m_u8CANCOMMAND_VERSION));
+    CHECK(stResponse.u16RequestId == 9u);
+    CHECK(m_bActive == false);
+
+    /* length field does not match the message */
+    u32Length = u32CanCommand_BuildRequest(au8Request, m_u8CANCOMMAND_SETFORMAT, 10u, au8Payload, 1u);
+    CHECK(u32RawRequest(au8Request, u32Length + 1u, au8Response, &stResponse) != 0u);
+    CHECK(stResponse.eStatus == CANCOMMAND_ERROR_LENGTH);
+
+    /* payload length outside the range of the command */
+    u32Length = u32CanCommand_BuildRequest(au8Request, m_u8CANCOMMAND_SETFORMAT, 11u, au8Payload, 2u);
+    CHECK(u32RawRequest(au8Request, u32Length, au8Response, &stResponse) != 0u);
+    CHECK(stResponse.eStatus == CANCOMMAND_ERROR_LENGTH);
+    CHECK(stResponse.u8Command == m_u8CANCOMMAND_SETFORMAT);
+    u32Length = u32CanCommand_BuildRequest(au8Request, m_u8CANCOMMAND_FILTERADD, 12u, au8Payload, 2u);
+    CHECK(u32RawRequest(au8Request, u32Length, au8Response, &stResponse) != 0u);
+    CHECK(stResponse.eStatus == CANCOMMAND_ERROR_LENGTH);
+    CHECK(m_stTable.u32StdCount == 0u);
+    CHECK(m_bBinary == false);
+
+    /* a response sent back is no request */
+    u32Length = u32CanCommand_BuildRequest(au8Request, m_u8CANCOMMAND_START | m_u8CANCOMMAND_RESPONSE, 13u, NULL, 0u);
+    CHECK(u32RawRequest(au8Request, u32Length, au8Response, &stResponse) != 0u);
+    CHECK(stResponse.eStatus == CANCOMMAND_ERROR_LENGTH);
+    CHECK(m_bActive == false);
+
+    /* response parser */
+    u32Length = u32CanCommand_BuildRequest(au8Request, m_u8CANCOMMAND_GETVERSION, 14u, NULL, 0u);
+    u32Length = u32RawRequest(au8Request, u32Length, au8Response, &stResponse);
+    CHECK(u32Length == m_u32CANCOMMAND_HEADERLENGTH + 3u);
+    CHECK(i32CanCommand_ParseResponse(au8Response, u32Length - 1u, &stResponse) == 0);
+    CHECK(i32CanCommand_ParseResponse(au8Response, 1u, &stResponse) == 0);
+    CHECK(i32CanCommand_ParseResponse(au8Request, m_u32CANCOMMAND_HEADERLENGTH, &stResponse) == -1);
+    CHECK(i32CanCommand_ParseResponse((const uint8_t *)"filter", 6u, &stResponse) == -1);
+}
+
+int main(void) {
+    vTestEncoding();
+    vTestClient();
+    vTestTransport();
+    vTestDispatchErrors();
+
+    if (m_u32Failures != 0u) {
+        fprintf(stderr, "can_command_test: %u failures\n", m_u32Failures);
+        return EXIT_FAILURE;
+    }
+    printf("can_command_test: passed\n");
+    return EXIT_SUCCESS;
+}
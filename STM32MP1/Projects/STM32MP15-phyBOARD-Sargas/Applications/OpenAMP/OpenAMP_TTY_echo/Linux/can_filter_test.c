@@ -0,0 +1,203 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Host test of the filter control messages and the filter element
+ *          encoding of can_filter.c. The expected elements are built by hand
+ *          from the filter element layout of the FDCAN message RAM.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_filter.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+/* Private macro -------------------------------------------------------------*/
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            m_u32Failures++; \
+        } \
+    } while (0)
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t m_u32Failures = 0;
+
+/**
+ * @brief  Parses a zero terminated message like it arrives on the control channel.
+ * @retval parse result
+ */
+static CanFilter_Result_t eParse(CanFilter_TableStruct_t *pstTable, const char *pcMessage) {
+    return eCanFilter_Parse(pstTable, (const uint8_t *)pcMessage, (uint16_t)strlen(pcMessage));
+}
+
+/**
+ * @brief  Standard filter elements: SFT[31:30] SFEC[29:27] SFID1[26:16] SFID2[10:0].
+ * @retval void
+ */
+static void vTestStdElements(void) {
+    CanFilter_TableStruct_t stTable;
+
+    vCanFilter_Init(&stTable);
+    CHECK(eParse(&stTable, "filter std mask 0x123 0x7FF") == CANFILTER_ADDED);
+    CHECK(eParse(&stTable, "filter std range 0x100 0x1ff reject\n") == CANFILTER_ADDED);
+    CHECK(eParse(&stTable, "filter  std\tdual 1 2\r\n") == CANFILTER_ADDED);
+    CHECK(eParse(&stTable, "filter std range 0 2047") == CANFILTER_ADDED);
+    CHECK(stTable.u32StdCount == 4u);
+    CHECK(stTable.u32ExtCount == 0u);
+
+    /* classic filter, store in FIFO0 */
+    CHECK(u32CanFilter_EncodeStd(&stTable.astStd[0]) == 0x892307FFu);
+    /* range filter, reject */
+    CHECK(u32CanFilter_EncodeStd(&stTable.astStd[1]) == 0x190001FFu);
+    /* dual ID filter, store in FIFO0 */
+    CHECK(u32CanFilter_EncodeStd(&stTable.astStd[2]) == 0x48010002u);
+    CHECK(u32CanFilter_EncodeStd(&stTable.astStd[3]) == 0x080007FFu);
+    /* disabled element */
+    CHECK(u32CanFilter_EncodeStd(NULL) == 0u);
+}
+
+/**
+ * @brief  Extended filter elements: F0 EFEC[31:29] EFID1[28:0], F1 EFT[31:30] EFID2[28:0].
+ * @retval void
+ */
+static void vTestExtElements(void) {
+    CanFilter_TableStruct_t stTable;
+    uint32_t au32Element[2];
+
+    vCanFilter_Init(&stTable);
+    CHECK(eParse(&stTable, "filter ext mask 0x18DAF100 0x1FFFFF00") == CANFILTER_ADDED);
+    CHECK(eParse(&stTable, "filter ext range 4096 0x1FFF reject") == CANFILTER_ADDED);
+    CHECK(eParse(&stTable, "filter ext dual 0x1FFFFFFF 0") == CANFILTER_ADDED);
+    CHECK(stTable.u32ExtCount == 3u);
+    CHECK(stTable.u32StdCount == 0u);
+
+    vCanFilter_EncodeExt(&stTable.astExt[0], au32Element);
+    CHECK(au32Element[0] == 0x38DAF100u);
+    CHECK(au32Element[1] == 0x9FFFFF00u);
+
+    vCanFilter_EncodeExt(&stTable.astExt[1], au32Element);
+    CHECK(au32Element[0] == 0x60001000u);
+    CHECK(au32Element[1] == 0x00001FFFu);
+
+    vCanFilter_EncodeExt(&stTable.astExt[2], au32Element);
+    CHECK(au32Element[0] == 0x3FFFFFFFu);
+    CHECK(au32Element[1] == 0x40000000u);
+
+    vCanFilter_EncodeExt(NULL, au32Element);
+    CHECK((au32Element[0] == 0u) && (au32Element[1] == 0u));
+}
+
+/**
+ * @brief  Malformed messages must not change the table.
+ * @retval void
+ */
+static void vTestErrors(void) {
+    CanFilter_TableStruct_t stTable;
+
+    vCanFilter_Init(&stTable);
+    CHECK(eParse(&stTable, "start") == CANFILTER_NOCOMMAND);
+    CHECK(eParse(&stTable, "filters apply") == CANFILTER_NOCOMMAND);
+    CHECK(eParse(&stTable, "") == CANFILTER_NOCOMMAND);
+    CHECK(eParse(&stTable, "filter") == CANFILTER_ERROR_SYNTAX);
+    CHECK(eParse(&stTable, "filter reset") == CANFILTER_ERROR_SYNTAX);
+    CHECK(eParse(&stTable, "filter std mask 1") == CANFILTER_ERROR_SYNTAX);
+    CHECK(eParse(&stTable, "filter std mask 1 2 accept") == CANFILTER_ERROR_SYNTAX);
+    CHECK(eParse(&stTable, "filter std mask 1 2 reject 3") == CANFILTER_ERROR_SYNTAX);
+    CHECK(eParse(&stTable, "filter fd mask 1 2") == CANFILTER_ERROR_SYNTAX);
+    CHECK(eParse(&stTable, "filter std list 1 2") == CANFILTER_ERROR_SYNTAX);
+    CHECK(eParse(&stTable, "filter std mask 0xZZ 2") == CANFILTER_ERROR_SYNTAX);
+    CHECK(eParse(&stTable, "filter std mask 0x 2") == CANFILTER_ERROR_SYNTAX);
+    CHECK(eParse(&stTable, "filter std mask 12a 2") == CANFILTER_ERROR_SYNTAX);
+    CHECK(eParse(&stTable, "filter ext mask 99999999999 2") == CANFILTER_ERROR_SYNTAX);
+    CHECK(eParse(&stTable, "filter std mask 0x800 0x7FF") == CANFILTER_ERROR_RANGE);
+    CHECK(eParse(&stTable, "filter std range 5 4") == CANFILTER_ERROR_RANGE);
+    CHECK(eParse(&stTable, "filter ext dual 0x20000000 0") == CANFILTER_ERROR_RANGE);
+    CHECK(stTable.u32StdCount == 0u);
+    CHECK(stTable.u32ExtCount == 0u);
+}
+
+/**
+ * @brief  Table limits, clear and apply.
+ * @retval void
+ */
+static void vTestTable(void) {
+    CanFilter_TableStruct_t stTable;
+    char acMessage[48];
+
+    vCanFilter_Init(&stTable);
+    for (uint32_t i = 0; i < m_u32CANFILTER_STDCOUNT; i++) {
+        snprintf(acMessage, sizeof(acMessage), "filter std dual %u %u", i, i + 0x100u);
+        CHECK(eParse(&stTable, acMessage) == CANFILTER_ADDED);
+    }
+    CHECK(eParse(&stTable, "filter std dual 1 2") == CANFILTER_ERROR_FULL);
+    for (uint32_t i = 0; i < m_u32CANFILTER_EXTCOUNT; i++) {
+        CHECK(eParse(&stTable, "filter ext mask 0 0") == CANFILTER_ADDED);
+    }
+    CHECK(eParse(&stTable, "filter ext mask 0 0") == CANFILTER_ERROR_FULL);
+    CHECK(stTable.u32StdCount == m_u32CANFILTER_STDCOUNT);
+    CHECK(stTable.u32ExtCount == m_u32CANFILTER_EXTCOUNT);
+    CHECK(stTable.astStd[15].u32Id1 == 15u);
+    CHECK(stTable.astStd[15].u32Id2 == 0x10Fu);
+
+    /* message as sent by echo without newline stripping, terminated by zero */
+    CHECK(eCanFilter_Parse(&stTable, (const uint8_t *)"filter apply\n\0garbage", 21u) == CANFILTER_APPLY);
+    CHECK(stTable.u32StdCount == m_u32CANFILTER_STDCOUNT);
+
+    CHECK(eParse(&stTable, "filter clear") == CANFILTER_CLEARED);
+    CHECK(stTable.u32StdCount == 0u);
+    CHECK(stTable.u32ExtCount == 0u);
+}
+
+/**
+ * @brief  Frames matching no rule are only rejected when a rule accepts frames.
+ * @retval void
+ */
+static void vTestAcceptRule(void) {
+    CanFilter_TableStruct_t stTable;
+
+    vCanFilter_Init(&stTable);
+    CHECK(bCanFilter_HasAcceptRule(stTable.astStd, stTable.u32StdCount) == false);
+    CHECK(eParse(&stTable, "filter std range 0x700 0x7FF reject") == CANFILTER_ADDED);
+    CHECK(bCanFilter_HasAcceptRule(stTable.astStd, stTable.u32StdCount) == false);
+    CHECK(eParse(&stTable, "filter std mask 0x100 0x700") == CANFILTER_ADDED);
+    CHECK(bCanFilter_HasAcceptRule(stTable.astStd, stTable.u32StdCount) == true);
+    CHECK(bCanFilter_HasAcceptRule(stTable.astExt, stTable.u32ExtCount) == false);
+}
+
+/**
+ * @brief  Every result has a reply text.
+ * @retval void
+ */
+static void vTestResultText(void) {
+    CHECK(strcmp(pcCanFilter_ResultText(CANFILTER_ADDED), "added") == 0);
+    CHECK(strcmp(pcCanFilter_ResultText(CANFILTER_ERROR_FULL), "table full") == 0);
+    CHECK(strcmp(pcCanFilter_ResultText((CanFilter_Result_t)99), "") == 0);
+}
+
+int main(void) {
+    vTestStdElements();
+    vTestExtElements();
+    vTestErrors();
+    vTestTable();
+    vTestAcceptRule();
+    vTestResultText();
+
+    if (m_u32Failures != 0u) {
+        fprintf(stderr, "can_filter_test: %u failures\n", m_u32Failures);
+        return EXIT_FAILURE;
+    }
+    printf("can_filter_test: passed\n");
+    return EXIT_SUCCESS;
+}
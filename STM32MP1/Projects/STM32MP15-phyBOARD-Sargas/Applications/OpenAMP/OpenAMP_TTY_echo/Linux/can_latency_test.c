@@ -0,0 +1,137 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Host test of the latency statistics of can_latency.c: histogram
+ *          buckets, min / avg / max and the GETLATENCY encoding.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_command.h"
+#include "can_latency.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+/* Private macro -------------------------------------------------------------*/
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            m_u32Failures++; \
+        } \
+    } while (0)
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t m_u32Failures = 0;
+
+/**
+ * @brief  Bucket limits: < 128 cycles, then one bucket per power of two.
+ * @retval void
+ */
+static void vTestBuckets(void) {
+    CHECK(u32CanLatency_GetBucket(0u) == 0u);
+    CHECK(u32CanLatency_GetBucket(127u) == 0u);
+    CHECK(u32CanLatency_GetBucket(128u) == 1u);
+    CHECK(u32CanLatency_GetBucket(255u) == 1u);
+    CHECK(u32CanLatency_GetBucket(256u) == 2u);
+    CHECK(u32CanLatency_GetBucket((1u << 21) - 1u) == 14u);
+    CHECK(u32CanLatency_GetBucket(1u << 21) == 15u);
+    CHECK(u32CanLatency_GetBucket(UINT32_MAX) == m_u32CANLATENCY_BUCKETS - 1u);
+}
+
+/**
+ * @brief  Count, min, max, average and histogram of one stage.
+ * @retval void
+ */
+static void vTestStage(void) {
+    CanLatency_Struct_t stLatency;
+    const CanLatency_StageStruct_t *pstStage = &stLatency.astStages[CANLATENCY_STAGE_FORMAT];
+    uint32_t u32Sum = 0u;
+
+    vCanLatency_Init(&stLatency);
+    CHECK(u32CanLatency_GetAverage(pstStage) == 0u);
+
+    for (uint32_t i = 1; i <= 1000u; i++) {
+        vCanLatency_Add(&stLatency, CANLATENCY_STAGE_FORMAT, i * 10u);
+        u32Sum += i * 10u;
+    }
+    CHECK(pstStage->u32Count == 1000u);
+    CHECK(pstStage->u32Min == 10u);
+    CHECK(pstStage->u32Max == 10000u);
+    CHECK(u32CanLatency_GetAverage(pstStage) == u32Sum / 1000u);
+    /* 10..120 below 128, 130..250 in [128, 256) */
+    CHECK(pstStage->au32Buckets[0] == 12u);
+    CHECK(pstStage->au32Buckets[1] == 13u);
+    CHECK(stLatency.astStages[CANLATENCY_STAGE_KICK].u32Count == 0u);
+
+    /* durations beyond 2^32 / 1000 must not overflow the sum */
+    vCanLatency_Init(&stLatency);
+    vCanLatency_Add(&stLatency, CANLATENCY_STAGE_TOTAL, UINT32_MAX);
+    vCanLatency_Add(&stLatency, CANLATENCY_STAGE_TOTAL, UINT32_MAX - 2u);
+    CHECK(u32CanLatency_GetAverage(&stLatency.astStages[CANLATENCY_STAGE_TOTAL]) == UINT32_MAX - 1u);
+}
+
+/**
+ * @brief  Encode, decode and the size limit of a command response.
+ * @retval void
+ */
+static void vTestEncoding(void) {
+    CanLatency_Struct_t stLatency;
+    CanLatency_ReportStruct_t stReport;
+    uint8_t au8Data[m_u32CANCOMMAND_MAXPAYLOAD];
+    uint32_t u32Length;
+
+    vCanLatency_Init(&stLatency);
+    vCanLatency_Add(&stLatency, CANLATENCY_STAGE_QUEUE, 300u);
+    vCanLatency_Add(&stLatency, CANLATENCY_STAGE_QUEUE, 100u);
+    vCanLatency_Add(&stLatency, CANLATENCY_STAGE_KICK, 5000u);
+
+    u32Length = u32CanLatency_Encode(&stLatency, 209u, au8Data);
+    CHECK(u32Length == m_u32CANLATENCY_HEADERLENGTH + (CANLATENCY_STAGE_COUNT * m_u32CANLATENCY_STAGELENGTH));
+    /* response data behind the status byte */
+    CHECK(u32Length <= m_u32CANCOMMAND_MAXPAYLOAD - 1u);
+
+    CHECK(bCanLatency_Decode(au8Data, u32Length, &stReport) == true);
+    CHECK(stReport.u32CyclesPerUs == 209u);
+    CHECK(stReport.u32Stages == CANLATENCY_STAGE_COUNT);
+    CHECK(stReport.astStages[CANLATENCY_STAGE_QUEUE].u32Count == 2u);
+    CHECK(stReport.astStages[CANLATENCY_STAGE_QUEUE].u32Min == 100u);
+    CHECK(stReport.astStages[CANLATENCY_STAGE_QUEUE].u32Max == 300u);
+    CHECK(stReport.astStages[CANLATENCY_STAGE_QUEUE].u32Average == 200u);
+    CHECK(stReport.astStages[CANLATENCY_STAGE_QUEUE].au32Buckets[0] == 1u);
+    CHECK(stReport.astStages[CANLATENCY_STAGE_QUEUE].au32Buckets[2] == 1u);
+    CHECK(stReport.astStages[CANLATENCY_STAGE_KICK].au32Buckets[6] == 1u);
+    /* a stage without measurements reports min 0 instead of UINT32_MAX */
+    CHECK(stReport.astStages[CANLATENCY_STAGE_FORMAT].u32Min == 0u);
+
+    CHECK(bCanLatency_Decode(au8Data, u32Length - 1u, &stReport) == false);
+    CHECK(bCanLatency_Decode(au8Data, 4u, &stReport) == false);
+    au8Data[1] = 8u;
+    CHECK(bCanLatency_Decode(au8Data, u32Length, &stReport) == false);
+
+    CHECK(strcmp(pcCanLatency_StageName(CANLATENCY_STAGE_TOTAL), "total") == 0);
+    CHECK(strcmp(pcCanLatency_StageName(CANLATENCY_STAGE_COUNT), "") == 0);
+}
+
+int main(void) {
+    vTestBuckets();
+    vTestStage();
+    vTestEncoding();
+
+    if (m_u32Failures != 0u) {
+        fprintf(stderr, "can_latency_test: %u failures\n", m_u32Failures);
+        return EXIT_FAILURE;
+    }
+    printf("can_latency_test: passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,248 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Host benchmark comparing the 233 byte ASCII trace lines with the
+ *          binary batched CAN records: frames/s for encoding and decoding,
+ *          transported bytes per frame and RPMsg messages per frame.
+ *
+ *          usage: can_record_bench [frames]
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_record.h"
+#include "can_record_decoder.h"
+#include "can_trace.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "time.h"
+
+/* Private define ------------------------------------------------------------*/
+#define m_u32CANFDTRACELENGTH m_u32CANTRACE_LENGTH
+#define m_u32DEFAULTFRAMES ((uint32_t)200000)
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+    uint32_t u32Timestamp;  /* ms, like HAL_GetTick() */
+    uint32_t u32Identifier;
+    uint8_t u8Length;
+    uint8_t au8Data[m_u32CANRECORD_MAXDATALENGTH];
+} Bench_FrameStruct_t;
+
+typedef struct {
+    const char *pcName;
+    double dEncodeSeconds;
+    double dDecodeSeconds;
+    uint64_t u64Bytes;
+    uint64_t u64Messages;
+    uint64_t u64Checksum;
+} Bench_ResultStruct_t;
+
+/* Private variables ---------------------------------------------------------*/
+static const uint8_t m_au8FdLengths[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64};
+
+/* Private function prototypes -----------------------------------------------*/
+static double dNow(void);
+static void vCreateFrames(Bench_FrameStruct_t *pstFrames, uint32_t u32Frames, int iPayload);
+static void vBenchAscii(const Bench_FrameStruct_t *pstFrames, uint32_t u32Frames, Bench_ResultStruct_t *pstResult);
+static void vRecordCallback(const CanRecord_RecordStruct_t *pstRecord, void *pvContext);
+static void vBenchBinary(const Bench_FrameStruct_t *pstFrames, uint32_t u32Frames, Bench_ResultStruct_t *pstResult);
+static void vPrintResult(const Bench_ResultStruct_t *pstResult, uint32_t u32Frames);
+
+/**
+ * @brief  Monotonic time in seconds.
+ * @retval seconds
+ */
+static double dNow(void) {
+    struct timespec stTime;
+    clock_gettime(CLOCK_MONOTONIC, &stTime);
+    return (double)stTime.tv_sec + (double)stTime.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief  Creates random frames, iPayload < 0 mixes all FD payload lengths.
+ * @retval void
+ */
+static void vCreateFrames(Bench_FrameStruct_t *pstFrames, uint32_t u32Frames, int iPayload) {
+    srand(1);
+    for (uint32_t i = 0; i < u32Frames; i++) {
+        pstFrames[i].u32Timestamp = i / 4u;
+        pstFrames[i].u32Identifier = (uint32_t)rand() & 0x1FFFFFFFu;
+        pstFrames[i].u8Length = (iPayload < 0) ? m_au8FdLengths[(uint32_t)rand() % sizeof(m_au8FdLengths)]
+                : (uint8_t)iPayload;
+        memset(pstFrames[i].au8Data, 0, sizeof(pstFrames[i].au8Data));
+        for (uint32_t j = 0; j < pstFrames[i].u8Length; j++) {
+            pstFrames[i].au8Data[j] = (uint8_t)rand();
+        }
+    }
+}
+
+/**
+ * @brief  Formats every frame as one ASCII line (one RPMsg message each) and
+ *         parses the lines back like a Linux consumer would.
+ * @retval void
+ */
+static void vBenchAscii(const Bench_FrameStruct_t *pstFrames, uint32_t u32Frames, Bench_ResultStruct_t *pstResult) {
+
+    uint8_t *pu8Stream = malloc((size_t)u32Frames * m_u32CANFDTRACELENGTH);
+    double dStart;
+
+    pstResult->pcName = "ascii";
+
+    dStart = dNow();
+    for (uint32_t i = 0; i < u32Frames; i++) {
+        vCanTrace_Format(&pu8Stream[i * m_u32CANFDTRACELENGTH], i + 1u, pstFrames[i].u32Timestamp,
+                pstFrames[i].u32Identifier, pstFrames[i].u8Length, pstFrames[i].au8Data);
+    }
+    pstResult->dEncodeSeconds = dNow() - dStart;
+    pstResult->u64Bytes = (uint64_t)u32Frames * m_u32CANFDTRACELENGTH;
+    pstResult->u64Messages = u32Frames;
+
+    dStart = dNow();
+    for (uint32_t i = 0; i < u32Frames; i++) {
+        char acLine[m_u32CANFDTRACELENGTH + 1];
+        char *pcEnd;
+        uint32_t u32Length;
+
+        memcpy(acLine, &pu8Stream[i * m_u32CANFDTRACELENGTH], m_u32CANFDTRACELENGTH);
+        acLine[m_u32CANFDTRACELENGTH] = '\0';
+        pstResult->u64Checksum += strtoul(&acLine[8], &pcEnd, 10) * 1000u + strtoul(&acLine[18], &pcEnd, 10);
+        pstResult->u64Checksum += strtoul(&acLine[25], &pcEnd, 16);
+        u32Length = strtoul(&acLine[37], &pcEnd, 10);
+        for (uint32_t j = 0; j < u32Length; j++) {
+            pstResult->u64Checksum += strtoul(&acLine[40 + 3 * j], &pcEnd, 16);
+        }
+    }
+    pstResult->dDecodeSeconds = dNow() - dStart;
+
+    free(pu8Stream);
+}
+
+/**
+ * @brief  Decoder callback summing up the record content.
+ * @retval void
+ */
+static void vRecordCallback(const CanRecord_RecordStruct_t *pstRecord, void *pvContext) {
+    uint64_t *pu64Checksum = pvContext;
+
+    *pu64Checksum += pstRecord->u64Timestamp / 1000u + pstRecord->u32Identifier;
+    for (uint32_t j = 0; j < pstRecord->u8Length; j++) {
+        *pu64Checksum += pstRecord->pu8Data[j];
+    }
+}
+
+/**
+ * @brief  Packs the frames into binary batches with the firmware encoder and
+ *         decodes the resulting byte stream.
+ * @retval void
+ */
+static void vBenchBinary(const Bench_FrameStruct_t *pstFrames, uint32_t u32Frames, Bench_ResultStruct_t *pstResult) {
+
+    static CanRecord_BatchStruct_t s_stBatch;
+    CanRecord_DecoderStruct_t stDecoder;
+    CanRecord_RecordStruct_t stRecord;
+    /* worst case is one batch header per record */
+    uint8_t *pu8Stream = malloc((size_t)u32Frames * (m_u32CANRECORD_BATCHHEADERLENGTH + m_u32CANRECORD_HEADERLENGTH
+            + m_u32CANRECORD_MAXDATALENGTH));
+    uint64_t u64Length = 0;
+    uint32_t u32Batch;
+    double dStart;
+
+    pstResult->pcName = "binary";
+
+    dStart = dNow();
+    vCanRecord_BatchInit(&s_stBatch);
+    for (uint32_t i = 0; i < u32Frames; i++) {
+        stRecord.u64Timestamp = (uint64_t)pstFrames[i].u32Timestamp * 1000u;
+        stRecord.u32Identifier = pstFrames[i].u32Identifier;
+        stRecord.u8Flags = m_u8CANRECORD_FLAG_EXTENDEDID | m_u8CANRECORD_FLAG_FDFORMAT;
+        stRecord.u8Length = pstFrames[i].u8Length;
+        stRecord.pu8Data = pstFrames[i].au8Data;
+        if (bCanRecord_BatchAdd(&s_stBatch, &stRecord) == false) {
+            u32Batch = u32CanRecord_BatchFinish(&s_stBatch);
+            memcpy(&pu8Stream[u64Length], s_stBatch.au8Buffer, u32Batch);
+            u64Length += u32Batch;
+            pstResult->u64Messages++;
+            vCanRecord_BatchReset(&s_stBatch);
+            bCanRecord_BatchAdd(&s_stBatch, &stRecord);
+        }
+    }
+    if (bCanRecord_BatchIsEmpty(&s_stBatch) == false) {
+        u32Batch = u32CanRecord_BatchFinish(&s_stBatch);
+        memcpy(&pu8Stream[u64Length], s_stBatch.au8Buffer, u32Batch);
+        u64Length += u32Batch;
+        pstResult->u64Messages++;
+    }
+    pstResult->dEncodeSeconds = dNow() - dStart;
+    pstResult->u64Bytes = u64Length;
+
+    dStart = dNow();
+    vCanRecord_DecoderInit(&stDecoder);
+    u32CanRecord_DecodeStream(&stDecoder, pu8Stream, (uint32_t)u64Length, vRecordCallback, &pstResult->u64Checksum);
+    pstResult->dDecodeSeconds = dNow() - dStart;
+    if ((stDecoder.u32Records != u32Frames) || (stDecoder.u32LostBatches != 0u) || (stDecoder.u32SkippedBytes != 0u)) {
+        fprintf(stderr, "binary decode mismatch: %u records, %u lost batches, %u skipped bytes\n",
+                stDecoder.u32Records, stDecoder.u32LostBatches, stDecoder.u32SkippedBytes);
+        exit(EXIT_FAILURE);
+    }
+
+    free(pu8Stream);
+}
+
+/**
+ * @brief  Prints one result line.
+ * @retval void
+ */
+static void vPrintResult(const Bench_ResultStruct_t *pstResult, uint32_t u32Frames) {
+    printf("  %-7s %12.0f %12.0f %10.1f %12.1f\n", pstResult->pcName,
+            u32Frames / pstResult->dEncodeSeconds, u32Frames / pstResult->dDecodeSeconds,
+            (double)pstResult->u64Bytes / u32Frames, (double)u32Frames / pstResult->u64Messages);
+}
+
+int main(int argc, char *argv[]) {
+
+    uint32_t u32Frames = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : m_u32DEFAULTFRAMES;
+    Bench_FrameStruct_t *pstFrames = malloc((size_t)u32Frames * sizeof(*pstFrames));
+    static const int aiPayloads[] = {8, 64, -1};
+
+    if ((u32Frames == 0u) || (pstFrames == NULL)) {
+        fprintf(stderr, "usage: %s [frames]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (uint32_t i = 0; i < sizeof(aiPayloads) / sizeof(aiPayloads[0]); i++) {
+        Bench_ResultStruct_t stAscii = {0};
+        Bench_ResultStruct_t stBinary = {0};
+
+        vCreateFrames(pstFrames, u32Frames, aiPayloads[i]);
+        vBenchAscii(pstFrames, u32Frames, &stAscii);
+        vBenchBinary(pstFrames, u32Frames, &stBinary);
+        if (stAscii.u64Checksum != stBinary.u64Checksum) {
+            fprintf(stderr, "ascii and binary content differ\n");
+            return EXIT_FAILURE;
+        }
+
+        if (aiPayloads[i] < 0) {
+            printf("%u frames, mixed FD payload lengths\n", u32Frames);
+        } else {
+            printf("%u frames, %d byte payload\n", u32Frames, aiPayloads[i]);
+        }
+        printf("  %-7s %12s %12s %10s %12s\n", "format", "enc fr/s", "dec fr/s", "bytes/fr", "frames/msg");
+        vPrintResult(&stAscii, u32Frames);
+        vPrintResult(&stBinary, u32Frames);
+    }
+
+    free(pstFrames);
+    return EXIT_SUCCESS;
+}
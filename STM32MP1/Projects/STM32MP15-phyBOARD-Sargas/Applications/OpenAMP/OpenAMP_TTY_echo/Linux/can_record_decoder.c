@@ -0,0 +1,98 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Linux side decoder of the binary CAN records, see can_record.h
+ *          for the format.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_record_decoder.h"
+#include "string.h"
+
+/**
+ * @brief  Resets the decoder statistics and the sequence tracking.
+ * @retval void
+ */
+void vCanRecord_DecoderInit(CanRecord_DecoderStruct_t *pstDecoder) {
+    memset(pstDecoder, 0, sizeof(*pstDecoder));
+}
+
+/**
+ * @brief  Decodes the batch at the start of pu8Data and calls pfnCallback for
+ *         every record. No callback is made for a malformed batch.
+ * @retval number of bytes of the batch, 0 in case more data is needed,
+ *         -1 in case pu8Data does not start with a valid batch.
+ */
+int32_t i32CanRecord_DecodeBatch(CanRecord_DecoderStruct_t *pstDecoder, const uint8_t *pu8Data, uint32_t u32Length,
+        CanRecord_RecordCallback_t pfnCallback, void *pvContext) {
+
+    int32_t i32BatchLength = i32CanRecord_BatchCheck(pu8Data, u32Length);
+    uint32_t u32Offset = m_u32CANRECORD_BATCHHEADERLENGTH;
+    uint16_t u16Sequence;
+    uint8_t u8Records;
+    CanRecord_RecordStruct_t stRecord;
+
+    if (i32BatchLength <= 0) {
+        return i32BatchLength;
+    }
+    u8Records = pu8Data[3];
+    u16Sequence = (uint16_t)(pu8Data[6] | ((uint16_t)pu8Data[7] << 8u));
+
+    for (uint8_t i = 0u; i < u8Records; i++) {
+        u32Offset = u32CanRecord_BatchGetRecord(pu8Data, u32Offset, &stRecord);
+        if (pfnCallback != NULL) {
+            pfnCallback(&stRecord, pvContext);
+        }
+    }
+
+    if ((pstDecoder->bSequenceValid == true) && (u16Sequence != pstDecoder->u16NextSequence)) {
+        pstDecoder->u32LostBatches += (uint16_t)(u16Sequence - pstDecoder->u16NextSequence);
+    }
+    pstDecoder->bSequenceValid = true;
+    pstDecoder->u16NextSequence = (uint16_t)(u16Sequence + 1u);
+    pstDecoder->u32Batches++;
+    pstDecoder->u32Records += u8Records;
+
+    return i32BatchLength;
+}
+
+/**
+ * @brief  Decodes all complete batches of a byte stream, e.g. data read from
+ *         /dev/ttyRPMSG1 where one read() may hold several or partial batches.
+ *         Garbage in front of a batch header is skipped.
+ * @retval number of bytes consumed, the remaining bytes must be passed again
+ *         together with the next data.
+ */
+uint32_t u32CanRecord_DecodeStream(CanRecord_DecoderStruct_t *pstDecoder, const uint8_t *pu8Data, uint32_t u32Length,
+        CanRecord_RecordCallback_t pfnCallback, void *pvContext) {
+
+    uint32_t u32Offset = 0u;
+    int32_t i32Result;
+
+    while (u32Offset < u32Length) {
+        i32Result = i32CanRecord_DecodeBatch(pstDecoder, &pu8Data[u32Offset], u32Length - u32Offset,
+                pfnCallback, pvContext);
+        if (i32Result == 0) {
+            break;
+        }
+        if (i32Result < 0) {
+            pstDecoder->u32SkippedBytes++;
+            u32Offset++;
+        } else {
+            u32Offset += (uint32_t)i32Result;
+        }
+    }
+
+    return u32Offset;
+}
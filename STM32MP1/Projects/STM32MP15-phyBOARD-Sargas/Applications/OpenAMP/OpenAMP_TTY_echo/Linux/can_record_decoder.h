@@ -0,0 +1,54 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Header for the Linux side decoder of the binary CAN records sent
+ *          by the Cortex-M4 on /dev/ttyRPMSG1 after the "binary" command.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CAN_RECORD_DECODER_H
+#define __CAN_RECORD_DECODER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "can_record.h"
+
+/* Exported types ------------------------------------------------------------*/
+/* called once per decoded record, pstRecord->pu8Data points into the input buffer */
+typedef void (*CanRecord_RecordCallback_t)(const CanRecord_RecordStruct_t *pstRecord, void *pvContext);
+
+typedef struct {
+    uint32_t u32Batches;
+    uint32_t u32Records;
+    uint32_t u32LostBatches;    /* sequence number gaps */
+    uint32_t u32SkippedBytes;   /* bytes dropped while searching the next batch header */
+    bool bSequenceValid;
+    uint16_t u16NextSequence;
+} CanRecord_DecoderStruct_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+void vCanRecord_DecoderInit(CanRecord_DecoderStruct_t *pstDecoder);
+int32_t i32CanRecord_DecodeBatch(CanRecord_DecoderStruct_t *pstDecoder, const uint8_t *pu8Data, uint32_t u32Length,
+        CanRecord_RecordCallback_t pfnCallback, void *pvContext);
+uint32_t u32CanRecord_DecodeStream(CanRecord_DecoderStruct_t *pstDecoder, const uint8_t *pu8Data, uint32_t u32Length,
+        CanRecord_RecordCallback_t pfnCallback, void *pvContext);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_RECORD_DECODER_H */
@@ -0,0 +1,268 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Sends CAN / CAN FD frames through the Cortex-M4 by writing binary
+ *          TX batches (can_record.h) to the data channel. Frames use the
+ *          cansend syntax:
+ *
+ *            <id>#<data>             classic frame, 3 hex digits standard,
+ *                                    8 hex digits extended identifier
+ *            <id>#R                  remote frame
+ *            <id>##<flags><data>     CAN FD frame, flags bit 0 bit rate switch
+ *
+ *          usage: can_send [-d device] [-w] frame...
+ *            -d  data channel, default /dev/ttyRPMSG1
+ *            -w  wait for the TX confirmations, binary mode must be active
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_record.h"
+#include "can_record_decoder.h"
+#include "fcntl.h"
+#include "poll.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "termios.h"
+#include "unistd.h"
+
+/* Private define ------------------------------------------------------------*/
+#define m_pcDEFAULTDEVICE "/dev/ttyRPMSG1"
+#define m_iCONFIRMTIMEOUTMS 1000
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+    uint32_t u32Expected;
+    uint32_t u32Confirmed;
+} Confirm_Struct_t;
+
+/* Private function prototypes -----------------------------------------------*/
+static int iHexValue(char cHex);
+static bool bParseFrame(const char *pcFrame, CanRecord_RecordStruct_t *pstRecord, uint8_t au8Data[]);
+static bool bWriteBatch(int iFd, CanRecord_BatchStruct_t *pstBatch);
+static void vConfirmCallback(const CanRecord_RecordStruct_t *pstRecord, void *pvContext);
+static void vWaitConfirmations(int iFd, uint32_t u32Frames);
+
+/**
+ * @brief  Converts one hex digit.
+ * @retval value, -1 in case cHex is no hex digit.
+ */
+static int iHexValue(char cHex) {
+    if ((cHex >= '0') && (cHex <= '9')) {
+        return cHex - '0';
+    }
+    if ((cHex >= 'a') && (cHex <= 'f')) {
+        return cHex - 'a' + 10;
+    }
+    if ((cHex >= 'A') && (cHex <= 'F')) {
+        return cHex - 'A' + 10;
+    }
+    return -1;
+}
+
+/**
+ * @brief  Parses one frame in cansend syntax, the payload is written to au8Data.
+ * @retval false in case of a syntax error.
+ */
+static bool bParseFrame(const char *pcFrame, CanRecord_RecordStruct_t *pstRecord, uint8_t au8Data[]) {
+
+    const char *pcHash = strchr(pcFrame, '#');
+    const char *pcData;
+    uint32_t u32Digits;
+    int iHigh;
+    int iLow;
+
+    if (pcHash == NULL) {
+        return false;
+    }
+    u32Digits = (uint32_t)(pcHash - pcFrame);
+    if ((u32Digits != 3u) && (u32Digits != 8u)) {
+        return false;
+    }
+
+    memset(pstRecord, 0, sizeof(*pstRecord));
+    for (uint32_t i = 0; i < u32Digits; i++) {
+        if ((iHigh = iHexValue(pcFrame[i])) < 0) {
+            return false;
+        }
+        pstRecord->u32Identifier = (pstRecord->u32Identifier << 4u) | (uint32_t)iHigh;
+    }
+    if (u32Digits == 8u) {
+        pstRecord->u8Flags |= m_u8CANRECORD_FLAG_EXTENDEDID;
+    }
+
+    pcData = pcHash + 1;
+    if (*pcData == 'R') {
+        pstRecord->u8Flags |= m_u8CANRECORD_FLAG_REMOTEFRAME;
+        pstRecord->pu8Data = au8Data;
+        return (pcData[1] == '\0');
+    }
+    if (*pcData == '#') {
+        if ((iHigh = iHexValue(pcData[1])) < 0) {
+            return false;
+        }
+        pstRecord->u8Flags |= m_u8CANRECORD_FLAG_FDFORMAT;
+        if ((iHigh & 0x1) != 0) {
+            pstRecord->u8Flags |= m_u8CANRECORD_FLAG_BITRATESWITCH;
+        }
+        pcData += 2;
+    }
+
+    while (*pcData != '\0') {
+        if (*pcData == '.') {
+            pcData++;
+            continue;
+        }
+        iHigh = iHexValue(pcData[0]);
+        iLow = (iHigh < 0) ? -1 : iHexValue(pcData[1]);
+        if ((iLow < 0) || (pstRecord->u8Length >= m_u32CANRECORD_MAXDATALENGTH)) {
+            return false;
+        }
+        au8Data[pstRecord->u8Length++] = (uint8_t)((iHigh << 4) | iLow);
+        pcData += 2;
+    }
+    pstRecord->pu8Data = au8Data;
+
+    return true;
+}
+
+/**
+ * @brief  Writes one batch as one RPMsg message and empties it.
+ * @retval false in case the write failed.
+ */
+static bool bWriteBatch(int iFd, CanRecord_BatchStruct_t *pstBatch) {
+
+    uint32_t u32Length = u32CanRecord_BatchFinish(pstBatch);
+    ssize_t iWritten = write(iFd, pstBatch->au8Buffer, u32Length);
+
+    vCanRecord_BatchReset(pstBatch);
+    if (iWritten != (ssize_t)u32Length) {
+        perror("write");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief  Prints the TX confirmation records, received frames are ignored.
+ * @retval void
+ */
+static void vConfirmCallback(const CanRecord_RecordStruct_t *pstRecord, void *pvContext) {
+
+    Confirm_Struct_t *pstConfirm = (Confirm_Struct_t *)pvContext;
+
+    if ((pstRecord->u8Flags & m_u8CANRECORD_FLAG_TXEVENT) == 0u) {
+        return;
+    }
+    printf("sent %0*X marker %3u at %llu us\n", ((pstRecord->u8Flags & m_u8CANRECORD_FLAG_EXTENDEDID) != 0u) ? 8 : 3,
+            pstRecord->u32Identifier, (pstRecord->u8Length != 0u) ? pstRecord->pu8Data[0] : 0u,
+            (unsigned long long)pstRecord->u64Timestamp);
+    pstConfirm->u32Confirmed++;
+}
+
+/**
+ * @brief  Reads the data channel until all frames are confirmed or no data
+ *         arrives for m_iCONFIRMTIMEOUTMS.
+ * @retval void
+ */
+static void vWaitConfirmations(int iFd, uint32_t u32Frames) {
+
+    static uint8_t s_au8Stream[4u * m_u32CANRECORD_BATCHSIZE];
+    CanRecord_DecoderStruct_t stDecoder;
+    Confirm_Struct_t stConfirm = { u32Frames, 0u };
+    struct pollfd stPoll = { iFd, POLLIN, 0 };
+    uint32_t u32Fill = 0u;
+    uint32_t u32Used;
+    ssize_t iRead;
+
+    vCanRecord_DecoderInit(&stDecoder);
+    while ((stConfirm.u32Confirmed < stConfirm.u32Expected) && (poll(&stPoll, 1, m_iCONFIRMTIMEOUTMS) > 0)) {
+        iRead = read(iFd, &s_au8Stream[u32Fill], sizeof(s_au8Stream) - u32Fill);
+        if (iRead <= 0) {
+            break;
+        }
+        u32Fill += (uint32_t)iRead;
+        u32Used = u32CanRecord_DecodeStream(&stDecoder, s_au8Stream, u32Fill, vConfirmCallback, &stConfirm);
+        memmove(s_au8Stream, &s_au8Stream[u32Used], u32Fill - u32Used);
+        u32Fill -= u32Used;
+    }
+    if (stConfirm.u32Confirmed < stConfirm.u32Expected) {
+        fprintf(stderr, "%u of %u frames confirmed\n", stConfirm.u32Confirmed, stConfirm.u32Expected);
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    static CanRecord_BatchStruct_t s_stBatch;
+    const char *pcDevice = m_pcDEFAULTDEVICE;
+    bool bWait = false;
+    CanRecord_RecordStruct_t stRecord;
+    uint8_t au8Data[m_u32CANRECORD_MAXDATALENGTH];
+    struct termios stTermios;
+    int iOption;
+    int iFd;
+
+    while ((iOption = getopt(argc, argv, "d:w")) != -1) {
+        if (iOption == 'd') {
+            pcDevice = optarg;
+        } else if (iOption == 'w') {
+            bWait = true;
+        } else {
+            fprintf(stderr, "usage: %s [-d device] [-w] frame...\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "usage: %s [-d device] [-w] frame...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    iFd = open(pcDevice, O_RDWR | O_NOCTTY);
+    if (iFd < 0) {
+        perror(pcDevice);
+        return EXIT_FAILURE;
+    }
+    /* binary data, no line discipline */
+    if (tcgetattr(iFd, &stTermios) == 0) {
+        cfmakeraw(&stTermios);
+        (void)tcsetattr(iFd, TCSANOW, &stTermios);
+    }
+
+    vCanRecord_BatchInit(&s_stBatch);
+    for (int i = optind; i < argc; i++) {
+        if (bParseFrame(argv[i], &stRecord, au8Data) == false) {
+            fprintf(stderr, "invalid frame: %s\n", argv[i]);
+            close(iFd);
+            return EXIT_FAILURE;
+        }
+        if (bCanRecord_BatchAdd(&s_stBatch, &stRecord) == false) {
+            if (bWriteBatch(iFd, &s_stBatch) == false) {
+                close(iFd);
+                return EXIT_FAILURE;
+            }
+            (void)bCanRecord_BatchAdd(&s_stBatch, &stRecord);
+        }
+    }
+    if ((bCanRecord_BatchIsEmpty(&s_stBatch) == false) && (bWriteBatch(iFd, &s_stBatch) == false)) {
+        close(iFd);
+        return EXIT_FAILURE;
+    }
+
+    if (bWait == true) {
+        vWaitConfirmations(iFd, (uint32_t)(argc - optind));
+    }
+    close(iFd);
+
+    return EXIT_SUCCESS;
+}
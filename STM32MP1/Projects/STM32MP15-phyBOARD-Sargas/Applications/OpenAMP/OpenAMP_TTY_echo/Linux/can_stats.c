@@ -0,0 +1,135 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Prints the frame counters and the per stage latency statistics of
+ *          the Cortex-M4 CAN bridge, read with the GETSTATS and GETLATENCY
+ *          commands on the control channel.
+ *
+ *          usage: can_stats [-d device] [-c] [-i seconds]
+ *            -d  control channel, default /dev/ttyRPMSG0
+ *            -c  clear the latency statistics after reading
+ *            -i  repeat every interval and print the rates in between
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_command_client.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "unistd.h"
+
+/* Private const -------------------------------------------------------------*/
+static const char * const m_apcSTATNAME[CANCOMMAND_STAT_COUNT] = {
+    "rx frames", "rx ring overflow", "rx fifo lost", "rx ring high water", "rx rate limited",
+    "tx frames", "tx invalid", "tx batches dropped", "tx events lost", "mirror sent", "mirror dropped",
+    "rpmsg failed", "rx bytes", "uptime ms", "mirror failed"
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static void vPrintLatency(const CanLatency_ReportStruct_t *pstReport);
+
+/**
+ * @brief  Prints min / avg / max and the histogram of every stage in us.
+ * @retval void
+ */
+static void vPrintLatency(const CanLatency_ReportStruct_t *pstReport) {
+
+    double dCyclesPerUs = (pstReport->u32CyclesPerUs != 0u) ? (double)pstReport->u32CyclesPerUs : 1.0;
+
+    printf("%-8s %10s %10s %10s %10s   histogram from < %.1f us, x2 per bucket\n", "stage", "count", "min us",
+            "avg us", "max us", (double)(1u << (m_u32CANLATENCY_FIRSTSHIFT + 1u)) / dCyclesPerUs);
+    for (uint32_t i = 0; i < pstReport->u32Stages; i++) {
+        printf("%-8s %10u %10.1f %10.1f %10.1f  ", pcCanLatency_StageName((CanLatency_Stage_t)i),
+                pstReport->astStages[i].u32Count, pstReport->astStages[i].u32Min / dCyclesPerUs,
+                pstReport->astStages[i].u32Average / dCyclesPerUs, pstReport->astStages[i].u32Max / dCyclesPerUs);
+        for (uint32_t j = 0; j < m_u32CANLATENCY_BUCKETS; j++) {
+            printf(" %u", pstReport->astStages[i].au32Buckets[j]);
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    static CanClient_Struct_t s_stClient;
+    const char *pcDevice = m_pcCANCLIENT_DEFAULTDEVICE;
+    CanLatency_ReportStruct_t stReport;
+    uint32_t au32Stats[CANCOMMAND_STAT_COUNT];
+    uint32_t au32Previous[CANCOMMAND_STAT_COUNT];
+    uint32_t u32Count;
+    uint32_t u32Elapsed;
+    bool bPrevious = false;
+    bool bClear = false;
+    unsigned int uInterval = 0u;
+    int32_t i32Status;
+    int iOption;
+
+    while ((iOption = getopt(argc, argv, "d:ci:")) != -1) {
+        if (iOption == 'd') {
+            pcDevice = optarg;
+        } else if (iOption == 'c') {
+            bClear = true;
+        } else if (iOption == 'i') {
+            uInterval = (unsigned int)strtoul(optarg, NULL, 0);
+        } else {
+            fprintf(stderr, "usage: %s [-d device] [-c] [-i seconds]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (bCanClient_Open(&s_stClient, pcDevice) == false) {
+        return EXIT_FAILURE;
+    }
+
+    do {
+        u32Count = CANCOMMAND_STAT_COUNT;
+        i32Status = i32CanClient_GetStats(&s_stClient, au32Stats, &u32Count);
+        if (i32Status != CANCOMMAND_OK) {
+            fprintf(stderr, "stats query failed: %d\n", i32Status);
+            break;
+        }
+        for (uint32_t i = u32Count; i < CANCOMMAND_STAT_COUNT; i++) {
+            au32Stats[i] = 0u;
+        }
+        for (uint32_t i = 0; i < CANCOMMAND_STAT_COUNT; i++) {
+            printf("%-20s %10u\n", m_apcSTATNAME[i], au32Stats[i]);
+        }
+        if (bPrevious == true) {
+            u32Elapsed = au32Stats[CANCOMMAND_STAT_UPTIMEMS] - au32Previous[CANCOMMAND_STAT_UPTIMEMS];
+            if (u32Elapsed != 0u) {
+                printf("%-20s %10.1f frames/s, %.1f bytes/s\n", "rate",
+                        1000.0 * (au32Stats[CANCOMMAND_STAT_RXFRAMES] - au32Previous[CANCOMMAND_STAT_RXFRAMES]) / u32Elapsed,
+                        1000.0 * (au32Stats[CANCOMMAND_STAT_RXBYTES] - au32Previous[CANCOMMAND_STAT_RXBYTES]) / u32Elapsed);
+            }
+        }
+
+        i32Status = i32CanClient_GetLatency(&s_stClient, bClear, &stReport);
+        if (i32Status != CANCOMMAND_OK) {
+            fprintf(stderr, "latency query failed: %d\n", i32Status);
+            break;
+        }
+        vPrintLatency(&stReport);
+
+        for (uint32_t i = 0; i < CANCOMMAND_STAT_COUNT; i++) {
+            au32Previous[i] = au32Stats[i];
+        }
+        bPrevious = true;
+        if (uInterval != 0u) {
+            printf("\n");
+            sleep(uInterval);
+        }
+    } while (uInterval != 0u);
+
+    vCanClient_Close(&s_stClient);
+    return (i32Status == CANCOMMAND_OK) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,131 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Host unit test for the timestamp wrap extension in can_timestamp.c
+ *          with synthetic counter sequences.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_timestamp.h"
+#include "stdio.h"
+#include "stdlib.h"
+
+/* Private macro -------------------------------------------------------------*/
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            m_u32Failures++; \
+        } \
+    } while (0)
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t m_u32Failures = 0;
+
+/**
+ * @brief  Counts through several 16 bit wraps in random steps below one period
+ *         and compares against a 64 bit reference counter.
+ * @retval void
+ */
+static void vTestRandomSteps16(void) {
+    CanTimestamp_CounterStruct_t stCounter;
+    uint64_t u64Reference = 0xFFF0u;
+
+    vCanTimestamp_Init(&stCounter, 16u);
+    CHECK(u64CanTimestamp_Update(&stCounter, (uint32_t)u64Reference & 0xFFFFu) == u64Reference);
+
+    srand(3);
+    for (uint32_t i = 0; i < 100000u; i++) {
+        u64Reference += (uint32_t)rand() % 0xFFFFu;
+        CHECK(u64CanTimestamp_Update(&stCounter, (uint32_t)u64Reference & 0xFFFFu) == u64Reference);
+    }
+    CHECK(u64Reference > 0x80000000ull);   /* many wraps were crossed */
+}
+
+/**
+ * @brief  Samples taken shortly before the update, also across a wrap.
+ * @retval void
+ */
+static void vTestExtendSamples16(void) {
+    CanTimestamp_CounterStruct_t stCounter;
+
+    vCanTimestamp_Init(&stCounter, 16u);
+    (void)u64CanTimestamp_Update(&stCounter, 0xFFF0u);
+    (void)u64CanTimestamp_Update(&stCounter, 0x0010u);   /* wrapped, now 0x10010 */
+    CHECK(stCounter.u64Now == 0x10010u);
+
+    CHECK(u64CanTimestamp_Extend(&stCounter, 0x0010u) == 0x10010u);
+    CHECK(u64CanTimestamp_Extend(&stCounter, 0x0000u) == 0x10000u);
+    CHECK(u64CanTimestamp_Extend(&stCounter, 0xFFFFu) == 0x0FFFFu);   /* captured before the wrap */
+    CHECK(u64CanTimestamp_Extend(&stCounter, 0xFFF8u) == 0x0FFF8u);
+    CHECK(u64CanTimestamp_Extend(&stCounter, 0x0011u) == 0x00011u);   /* oldest possible sample */
+    CHECK(u32CanTimestamp_Age(&stCounter, 0xFFFFu) == 0x11u);
+}
+
+/**
+ * @brief  A sample older than the first update must not underflow.
+ * @retval void
+ */
+static void vTestExtendBeforeStart(void) {
+    CanTimestamp_CounterStruct_t stCounter;
+
+    vCanTimestamp_Init(&stCounter, 16u);
+    (void)u64CanTimestamp_Update(&stCounter, 0x0005u);
+    CHECK(u64CanTimestamp_Extend(&stCounter, 0xFFF0u) == 0u);
+    CHECK(u64CanTimestamp_Extend(&stCounter, 0x0002u) == 2u);
+}
+
+/**
+ * @brief  Full 32 bit counter, e.g. the DWT cycle counter.
+ * @retval void
+ */
+static void vTestCounter32(void) {
+    CanTimestamp_CounterStruct_t stCounter;
+
+    vCanTimestamp_Init(&stCounter, 32u);
+    CHECK(stCounter.u32Mask == 0xFFFFFFFFu);
+    (void)u64CanTimestamp_Update(&stCounter, 0xF0000000u);
+    (void)u64CanTimestamp_Update(&stCounter, 0x10000000u);
+    (void)u64CanTimestamp_Update(&stCounter, 0x90000000u);
+    (void)u64CanTimestamp_Update(&stCounter, 0x00000001u);
+    CHECK(stCounter.u64Now == 0x200000001ull);
+    CHECK(u64CanTimestamp_Extend(&stCounter, 0xFFFFFFFFu) == 0x1FFFFFFFFull);
+}
+
+/**
+ * @brief  Repeated updates with the same value must not advance the counter.
+ * @retval void
+ */
+static void vTestNoProgress(void) {
+    CanTimestamp_CounterStruct_t stCounter;
+
+    vCanTimestamp_Init(&stCounter, 16u);
+    (void)u64CanTimestamp_Update(&stCounter, 0x1234u);
+    (void)u64CanTimestamp_Update(&stCounter, 0x1234u);
+    CHECK(stCounter.u64Now == 0x1234u);
+}
+
+int main(void) {
+    vTestRandomSteps16();
+    vTestExtendSamples16();
+    vTestExtendBeforeStart();
+    vTestCounter32();
+    vTestNoProgress();
+
+    if (m_u32Failures != 0u) {
+        fprintf(stderr, "can_timestamp_test: %u failures\n", m_u32Failures);
+        return EXIT_FAILURE;
+    }
+    printf("can_timestamp_test: passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,123 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Host benchmark of the trace formatter: former snprintf based
+ *          formatter against the table driven can_trace.c, in cycles/frame
+ *          (x86 TSC, if available) and frames/s at DLC 8 and 64.
+ *
+ *          usage: can_trace_bench [frames]
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_trace.h"
+#include "can_trace_legacy.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "time.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include "x86intrin.h"
+#define m_bHAVE_TSC 1
+#else
+#define m_bHAVE_TSC 0
+#endif
+
+/* Private define ------------------------------------------------------------*/
+#define m_u32DEFAULTFRAMES ((uint32_t)1000000)
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t m_au8Trace[m_u32CANTRACE_LENGTH];
+static volatile uint32_t m_u32Sink;
+
+/**
+ * @brief  Monotonic time in seconds.
+ * @retval seconds
+ */
+static double dNow(void) {
+    struct timespec stTime;
+    clock_gettime(CLOCK_MONOTONIC, &stTime);
+    return (double)stTime.tv_sec + (double)stTime.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief  Cycle counter, 0 if not available.
+ * @retval cycles
+ */
+static uint64_t u64Cycles(void) {
+#if m_bHAVE_TSC
+    return __rdtsc();
+#else
+    return 0u;
+#endif
+}
+
+/**
+ * @brief  Runs one formatter u32Frames times and prints the result line.
+ * @retval void
+ */
+static void vRun(const char *pcName, bool bLegacy, uint32_t u32DataLengthCode, uint32_t u32Frames) {
+
+    uint8_t au8Data[m_u32CANTRACE_DATALENGTH];
+    uint8_t u8Length = u8CanTrace_GetDataLength(u32DataLengthCode);
+    double dStart;
+    double dSeconds;
+    uint64_t u64Start;
+    uint64_t u64Cycles_;
+
+    memset(au8Data, 0, sizeof(au8Data));
+    for (uint32_t i = 0; i < u8Length; i++) {
+        au8Data[i] = (uint8_t)(i * 37u + 11u);
+    }
+
+    dStart = dNow();
+    u64Start = u64Cycles();
+    for (uint32_t i = 0; i < u32Frames; i++) {
+        if (bLegacy == true) {
+            /* the firmware cleared the line before every frame */
+            memset(m_au8Trace, 0, sizeof(m_au8Trace));
+            bLegacyCreateCanFdTrace(i, i + 0x1234u, u32DataLengthCode, i, au8Data, m_au8Trace);
+        } else {
+            vCanTrace_Format(m_au8Trace, i, i, i + 0x1234u, u8Length, au8Data);
+        }
+        m_u32Sink += m_au8Trace[i % m_u32CANTRACE_LENGTH];
+    }
+    u64Cycles_ = u64Cycles() - u64Start;
+    dSeconds = dNow() - dStart;
+
+    printf("  %-7s DLC %2u %12.0f frames/s %9.1f ns/frame", pcName, u8Length, u32Frames / dSeconds,
+            dSeconds * 1e9 / u32Frames);
+    if (m_bHAVE_TSC) {
+        printf(" %9.1f cycles/frame", (double)u64Cycles_ / u32Frames);
+    }
+    printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+
+    uint32_t u32Frames = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : m_u32DEFAULTFRAMES;
+    static const uint32_t au32Dlc[] = {0x00080000u, 0x000F0000u};   /* 8 and 64 bytes */
+
+    if (u32Frames == 0u) {
+        fprintf(stderr, "usage: %s [frames]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    printf("%u frames\n", u32Frames);
+    for (uint32_t i = 0; i < sizeof(au32Dlc) / sizeof(au32Dlc[0]); i++) {
+        vRun("legacy", true, au32Dlc[i], u32Frames);
+        vRun("table", false, au32Dlc[i], u32Frames);
+    }
+
+    return EXIT_SUCCESS;
+}
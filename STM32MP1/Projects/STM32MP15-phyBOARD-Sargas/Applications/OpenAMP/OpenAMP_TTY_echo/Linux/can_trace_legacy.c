@@ -0,0 +1,186 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   snprintf based trace formatter as used by the firmware up to
+ *          release 1.0.0. Kept as reference for the golden output test and
+ *          the benchmark of the table driven formatter in can_trace.c.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_trace_legacy.h"
+#include "stdio.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+    uint8_t u8Digits[2u];
+} LxUtilities_Hex8Struct_t;
+
+/* Private define ------------------------------------------------------------*/
+#define m_u32RXDATALENGTH ((uint32_t)64)
+#define m_u32CANFDTRACELENGTH ((uint32_t)233)
+
+/* DLC codes as defined by the STM32MP1 HAL */
+#define FDCAN_DLC_BYTES_0  ((uint32_t)0x00000000U)
+#define FDCAN_DLC_BYTES_1  ((uint32_t)0x00010000U)
+#define FDCAN_DLC_BYTES_2  ((uint32_t)0x00020000U)
+#define FDCAN_DLC_BYTES_3  ((uint32_t)0x00030000U)
+#define FDCAN_DLC_BYTES_4  ((uint32_t)0x00040000U)
+#define FDCAN_DLC_BYTES_5  ((uint32_t)0x00050000U)
+#define FDCAN_DLC_BYTES_6  ((uint32_t)0x00060000U)
+#define FDCAN_DLC_BYTES_7  ((uint32_t)0x00070000U)
+#define FDCAN_DLC_BYTES_8  ((uint32_t)0x00080000U)
+#define FDCAN_DLC_BYTES_12 ((uint32_t)0x00090000U)
+#define FDCAN_DLC_BYTES_16 ((uint32_t)0x000A0000U)
+#define FDCAN_DLC_BYTES_20 ((uint32_t)0x000B0000U)
+#define FDCAN_DLC_BYTES_32 ((uint32_t)0x000D0000U)
+#define FDCAN_DLC_BYTES_48 ((uint32_t)0x000E0000U)
+#define FDCAN_DLC_BYTES_64 ((uint32_t)0x000F0000U)
+
+/**
+ * @brief  Converts a uint8_t value into a hex8 value.
+ * @retval void
+ */
+static void vUint8ToHex(uint8_t u8Input, LxUtilities_Hex8Struct_t *const pstHex8Result) {
+
+    uint8_t u8LowNibble = u8Input & 0x0Fu;
+    uint8_t u8HighNibble = (u8Input >> 4u) & 0x0Fu;
+
+    ((uint8_t *)pstHex8Result->u8Digits)[0u] = (u8HighNibble < 10u) ? (48u + u8HighNibble) : (55u + u8HighNibble);
+    ((uint8_t *)pstHex8Result->u8Digits)[1u] = (u8LowNibble < 10u) ? (48u + u8LowNibble) : (55u + u8LowNibble);
+}
+
+/**
+ * @brief  converts the coded header data length in a uint8_t value.
+ *         The switch has no case for FDCAN_DLC_BYTES_24, which is kept here.
+ * @retval data length of the CAN frame as uint8_t.
+ */
+uint8_t u8LegacyGetCanHeaderDataLength(uint32_t u32DataLengthCode) {
+    uint8_t u8DataLength = 0;
+    switch (u32DataLengthCode) {
+    case FDCAN_DLC_BYTES_0:
+        u8DataLength = 0;
+        break;
+
+    case FDCAN_DLC_BYTES_1:
+        u8DataLength = 1;
+        break;
+
+    case FDCAN_DLC_BYTES_2:
+        u8DataLength = 2;
+        break;
+
+    case FDCAN_DLC_BYTES_3:
+        u8DataLength = 3;
+        break;
+
+    case FDCAN_DLC_BYTES_4:
+        u8DataLength = 4;
+        break;
+
+    case FDCAN_DLC_BYTES_5:
+        u8DataLength = 5;
+        break;
+
+    case FDCAN_DLC_BYTES_6:
+        u8DataLength = 6;
+        break;
+
+    case FDCAN_DLC_BYTES_7:
+        u8DataLength = 7;
+        break;
+
+    case FDCAN_DLC_BYTES_8:
+        u8DataLength = 8;
+        break;
+
+    case FDCAN_DLC_BYTES_12:
+        u8DataLength = 12;
+        break;
+
+    case FDCAN_DLC_BYTES_16:
+        u8DataLength = 16;
+        break;
+
+    case FDCAN_DLC_BYTES_20:
+        u8DataLength = 20;
+        break;
+
+    case FDCAN_DLC_BYTES_32:
+        u8DataLength = 32;
+        break;
+
+    case FDCAN_DLC_BYTES_48:
+        u8DataLength = 48;
+        break;
+
+    case FDCAN_DLC_BYTES_64:
+        u8DataLength = 64;
+        break;
+
+    default:
+        u8DataLength = 0;
+        break;
+    }
+
+    return u8DataLength;
+}
+
+/**
+ * @brief  Create readable a ascii string from the raw can data in the same format like a can trace output.
+ *         au8TraceData must be cleared and au8RxData must hold 64 bytes.
+ * @retval false in case of a converting error.
+ */
+bool bLegacyCreateCanFdTrace(uint32_t u32TimestampMs, uint32_t u32Identifier, uint32_t u32DataLengthCode,
+        uint32_t u32RxCount, uint8_t au8RxData[], uint8_t au8TraceData[]) {
+
+    /*Field 0 - Message number: start at position 0, right align, max. 7 places*/
+    snprintf((void*) &(au8TraceData[0]), 8, "%07u", u32RxCount);
+
+    /*Field 1 - TimeOffset[ms]: start at position 8, right align, max. 9 places for [s] max 3 places for [ms]*/
+    uint32_t u32Timestamp1s = u32TimestampMs / 1000u;
+    uint32_t u32Timestamp1ms = u32TimestampMs % 1000u;
+    snprintf((void*) &(au8TraceData[8]), 10, "%09u", u32Timestamp1s);
+    au8TraceData[17] = '.';
+    snprintf((void*) &(au8TraceData[18]), 4, "%03u", u32Timestamp1ms);
+
+    /*Field 2 - Type:  start at position 22, 2 places */
+    snprintf((void*) &(au8TraceData[22]), 3, "%s", "FB");
+
+    /*Field 3 - CanId:  start at position 25, right align, max 8 places */
+    snprintf((void*) &(au8TraceData[25]), 9, "%08X", u32Identifier);
+
+    /*Field 4 - Rx/Tx:  start at position 34, 2 places */
+    snprintf((void*) &(au8TraceData[34]), 3, "%s", "Rx");
+
+    /*Field 5 - Data length: start at position 37, 2 places */
+    snprintf((void*) &(au8TraceData[37]), 3, "%02u", u8LegacyGetCanHeaderDataLength(u32DataLengthCode));
+
+    /*Field 6 - Data: start at position 41, 192 places */
+    for (uint32_t i = 0; i < m_u32RXDATALENGTH; i++) {
+        vUint8ToHex(au8RxData[i],
+        (void*) &(au8TraceData[40 + 3 * i]));
+    }
+
+    /* replace null termination from snprintf with space*/
+    for (uint32_t i = 0; i < m_u32CANFDTRACELENGTH; i++) {
+        if (au8TraceData[i] == 0x00) {
+            au8TraceData[i] = 32;
+        }
+    }
+
+    /*Line End 1 places*/
+    au8TraceData[m_u32CANFDTRACELENGTH - 1] = '\n';
+
+    return true;
+}
@@ -0,0 +1,31 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Header for can_trace_legacy.c
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CAN_TRACE_LEGACY_H
+#define __CAN_TRACE_LEGACY_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+
+/* Exported functions prototypes ---------------------------------------------*/
+uint8_t u8LegacyGetCanHeaderDataLength(uint32_t u32DataLengthCode);
+bool bLegacyCreateCanFdTrace(uint32_t u32TimestampMs, uint32_t u32Identifier, uint32_t u32DataLengthCode,
+        uint32_t u32RxCount, uint8_t au8RxData[], uint8_t au8TraceData[]);
+
+#endif /* __CAN_TRACE_LEGACY_H */
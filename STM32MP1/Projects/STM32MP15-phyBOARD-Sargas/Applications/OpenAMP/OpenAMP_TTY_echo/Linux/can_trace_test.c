@@ -0,0 +1,103 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Golden output test: the table driven formatter in can_trace.c must
+ *          produce the same lines as the former snprintf based formatter.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_trace.h"
+#include "can_trace_legacy.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+/* Private define ------------------------------------------------------------*/
+#define m_u32DLC24 ((uint32_t)0x000C0000)
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t m_u32Failures = 0;
+
+/**
+ * @brief  Formats one frame with both formatters and compares the lines.
+ *         Data bytes behind the data length are zero, like they were when
+ *         the firmware cleared the receive buffer before each frame.
+ * @retval void
+ */
+static void vCompare(uint32_t u32RxCount, uint32_t u32TimestampMs, uint32_t u32Identifier,
+        uint32_t u32DataLengthCode, const uint8_t au8Data[]) {
+
+    uint8_t au8Expected[m_u32CANTRACE_LENGTH];
+    uint8_t au8Actual[m_u32CANTRACE_LENGTH];
+    uint8_t au8Padded[m_u32CANTRACE_DATALENGTH] = {0};
+    uint8_t u8Length = u8CanTrace_GetDataLength(u32DataLengthCode);
+
+    memcpy(au8Padded, au8Data, u8Length);
+    memset(au8Expected, 0, sizeof(au8Expected));
+    bLegacyCreateCanFdTrace(u32TimestampMs, u32Identifier, u32DataLengthCode, u32RxCount, au8Padded, au8Expected);
+    if (u32DataLengthCode == m_u32DLC24) {
+        /* the old switch had no case for 24 bytes and printed 00 */
+        au8Expected[37] = '2';
+        au8Expected[38] = '4';
+    }
+
+    memset(au8Actual, 0xA5, sizeof(au8Actual));
+    vCanTrace_Format(au8Actual, u32RxCount, u32TimestampMs, u32Identifier, u8Length, au8Data);
+
+    if (memcmp(au8Expected, au8Actual, sizeof(au8Actual)) != 0) {
+        m_u32Failures++;
+        fprintf(stderr, "mismatch count=%u ts=%u id=%08X dlc=%05X\n  expected: %.*s  actual:   %.*s",
+                u32RxCount, u32TimestampMs, u32Identifier, u32DataLengthCode,
+                (int)sizeof(au8Expected), au8Expected, (int)sizeof(au8Actual), au8Actual);
+    }
+}
+
+int main(void) {
+
+    static const uint32_t au32Counts[] = {0u, 1u, 9u, 10u, 99u, 1234567u, 9999999u, 10000000u, 12345678u, 0xFFFFFFFFu};
+    static const uint32_t au32Timestamps[] = {0u, 1u, 999u, 1000u, 1001u, 59999u, 86400000u, 0xFFFFFFFFu};
+    static const uint32_t au32Ids[] = {0u, 0x7FFu, 0x123u, 0x1FFFFFFFu, 0xFFFFFFFFu, 0x0ABCDEF0u};
+    uint8_t au8Data[m_u32CANTRACE_DATALENGTH];
+
+    for (uint32_t i = 0; i < sizeof(au8Data); i++) {
+        au8Data[i] = (uint8_t)(i * 37u + 11u);
+    }
+
+    /* all field boundaries with every DLC code */
+    for (uint32_t c = 0; c < sizeof(au32Counts) / sizeof(au32Counts[0]); c++) {
+        for (uint32_t t = 0; t < sizeof(au32Timestamps) / sizeof(au32Timestamps[0]); t++) {
+            for (uint32_t n = 0; n < sizeof(au32Ids) / sizeof(au32Ids[0]); n++) {
+                for (uint32_t d = 0; d < 16u; d++) {
+                    vCompare(au32Counts[c], au32Timestamps[t], au32Ids[n], d << 16u, au8Data);
+                }
+            }
+        }
+    }
+
+    /* every byte value in every data position */
+    srand(7);
+    for (uint32_t i = 0; i < 20000u; i++) {
+        for (uint32_t j = 0; j < sizeof(au8Data); j++) {
+            au8Data[j] = (uint8_t)rand();
+        }
+        vCompare((uint32_t)rand(), (uint32_t)rand(), (uint32_t)rand(), ((uint32_t)rand() & 0x0Fu) << 16u, au8Data);
+    }
+
+    if (m_u32Failures != 0u) {
+        fprintf(stderr, "can_trace_test: %u failures\n", m_u32Failures);
+        return EXIT_FAILURE;
+    }
+    printf("can_trace_test: passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,434 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   RPMsg master of the host twin of the firmware, in place of Linux on
+ *          the Cortex-A7. It runs the generic Linux machine of open-amp as
+ *          processor 1, binds the two "rpmsg-tty-channel" endpoints the
+ *          firmware announces, drives the control channel with the binary
+ *          commands of can_command_client.c and sends CAN frames as TX
+ *          batches on channel 1. The FDCAN stand-in of the twin echoes every
+ *          frame, so each frame comes back as TX event and as received frame.
+ *
+ *          Checked: every frame is confirmed by a TX event with the next
+ *          message marker and received once, in order and with its payload.
+ *          Measured: frames per second and the round trip from the send of
+ *          the batch to the received frame. The main loop of the firmware
+ *          spins, the figures need a core for it besides the interrupt
+ *          threads of the twin and the master, on fewer cores the round trip
+ *          is a multiple of the scheduler time slice.
+ *
+ *          usage: can_bridge_twin &
+ *                 can_twin_master [-n frames] [-w frames in flight]
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "openamp/open_amp.h"
+#include "platform_info.h"
+#include "can_command_client.h"
+#include "can_record_decoder.h"
+#include "errno.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "time.h"
+#include "unistd.h"
+
+/* Private define ------------------------------------------------------------*/
+/* address of the OpenAMP region of the firmware, see the Makefile */
+#define m_ulSHMSTART ((metal_phys_addr_t)TWIN_SHM_START)
+/* the twin loads the resource table in front of vring 0 */
+#define m_iRSCTABLESIZE 0x4000
+
+#define m_pcCHANNELNAME "rpmsg-tty-channel"
+#define m_u32CHANNELS ((uint32_t)2)
+#define m_u32CONTROLBUFFERSIZE ((uint32_t)2048)
+
+#define m_u32DEFAULTFRAMES ((uint32_t)10000)
+#define m_u32DEFAULTWINDOW ((uint32_t)48)
+#define m_u32FRAMESPERBATCH ((uint32_t)8)
+#define m_u32FRAMELENGTH ((uint32_t)8)
+
+/* Private variables ---------------------------------------------------------*/
+static void *m_pvPlatform = NULL;
+static struct rpmsg_endpoint m_astEndpoint[m_u32CHANNELS];
+static uint32_t m_u32Endpoints = 0u;
+
+/* responses of channel 0, read by the command client */
+static uint8_t m_au8Control[m_u32CONTROLBUFFERSIZE];
+static uint32_t m_u32ControlFill = 0u;
+static uint32_t m_u32ControlDropped = 0u;
+
+static CanRecord_BatchStruct_t m_stBatch;
+static CanRecord_DecoderStruct_t m_stDecoder;
+static uint64_t *m_pu64SendNs = NULL;
+static uint32_t m_u32Frames = m_u32DEFAULTFRAMES;
+static uint32_t m_u32RxFrames = 0u;
+static uint32_t m_u32TxEvents = 0u;
+static uint8_t m_u8NextMarker = 0u;
+static uint32_t m_u32Errors = 0u;
+static uint64_t m_u64RoundTripSumNs = 0u;
+static uint64_t m_u64RoundTripMaxNs = 0u;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint64_t u64GetTimeNs(void);
+static int iControlCallback(struct rpmsg_endpoint *pstEndpoint, void *pvData, size_t uLength, uint32_t u32Source,
+        void *pvPrivate);
+static int iDataCallback(struct rpmsg_endpoint *pstEndpoint, void *pvData, size_t uLength, uint32_t u32Source,
+        void *pvPrivate);
+static void vBindChannel(struct rpmsg_device *pstDevice, const char *pcName, uint32_t u32Destination);
+static void vRecordCallback(const CanRecord_RecordStruct_t *pstRecord, void *pvContext);
+static bool bControlWrite(void *pvContext, const uint8_t *pu8Data, uint32_t u32Length);
+static int32_t i32ControlRead(void *pvContext, uint8_t *pu8Data, uint32_t u32Length, int iTimeoutMs);
+static bool bSendFrames(uint32_t u32First, uint32_t u32Count);
+static bool bRunTraffic(uint32_t u32Window);
+
+/* Resource table of the generic machine, loaded by the twin -----------------*/
+void *get_resource_table(int rsc_id, int *len) {
+
+    (void)rsc_id;
+    /* only mapped and parsed, the table in the shared memory is used */
+    *len = m_iRSCTABLESIZE;
+    return NULL;
+}
+
+int set_resource_table_buffers(void *rsc_table, unsigned int vring_num, unsigned int buf_size) {
+
+    (void)rsc_table;
+    (void)vring_num;
+    (void)buf_size;
+    /* the vrings are placed by the twin */
+    return -EINVAL;
+}
+
+/**
+ * @brief  Monotonic time.
+ * @retval ns
+ */
+static uint64_t u64GetTimeNs(void) {
+
+    struct timespec stNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &stNow);
+    return (uint64_t)stNow.tv_sec * 1000000000u + (uint64_t)stNow.tv_nsec;
+}
+
+/**
+ * @brief  Channel 0, appends the response to the buffer of i32ControlRead().
+ * @retval RPMSG_SUCCESS
+ */
+static int iControlCallback(struct rpmsg_endpoint *pstEndpoint, void *pvData, size_t uLength, uint32_t u32Source,
+        void *pvPrivate) {
+
+    (void)pstEndpoint;
+    (void)u32Source;
+    (void)pvPrivate;
+    if (uLength > (m_u32CONTROLBUFFERSIZE - m_u32ControlFill)) {
+        m_u32ControlDropped++;
+        return RPMSG_SUCCESS;
+    }
+    memcpy(&m_au8Control[m_u32ControlFill], pvData, uLength);
+    m_u32ControlFill += (uint32_t)uLength;
+    return RPMSG_SUCCESS;
+}
+
+/**
+ * @brief  Channel 1, one record batch per message.
+ * @retval RPMSG_SUCCESS
+ */
+static int iDataCallback(struct rpmsg_endpoint *pstEndpoint, void *pvData, size_t uLength, uint32_t u32Source,
+        void *pvPrivate) {
+
+    (void)pstEndpoint;
+    (void)u32Source;
+    (void)pvPrivate;
+    if (i32CanRecord_DecodeBatch(&m_stDecoder, pvData, (uint32_t)uLength, vRecordCallback, NULL) <= 0) {
+        fprintf(stderr, "master: no record batch, %zu bytes\n", uLength);
+        m_u32Errors++;
+    }
+    return RPMSG_SUCCESS;
+}
+
+/**
+ * @brief  Name service, the firmware announces channel 0 before channel 1.
+ * @retval void
+ */
+static void vBindChannel(struct rpmsg_device *pstDevice, const char *pcName, uint32_t u32Destination) {
+
+    if ((strcmp(pcName, m_pcCHANNELNAME) != 0) || (m_u32Endpoints == m_u32CHANNELS)) {
+        return;
+    }
+    if (rpmsg_create_ept(&m_astEndpoint[m_u32Endpoints], pstDevice, pcName, RPMSG_ADDR_ANY, u32Destination,
+            (m_u32Endpoints == 0u) ? iControlCallback : iDataCallback, NULL) == RPMSG_SUCCESS) {
+        printf("master: channel %u bound to 0x%x\n", m_u32Endpoints, u32Destination);
+        m_u32Endpoints++;
+    }
+}
+
+/**
+ * @brief  Checks a record of channel 1. TX events must carry consecutive
+ *         markers, received frames must arrive in order with the payload
+ *         written by bSendFrames().
+ * @retval void
+ */
+static void vRecordCallback(const CanRecord_RecordStruct_t *pstRecord, void *pvContext) {
+
+    uint32_t u32Index;
+    uint64_t u64RoundTripNs;
+
+    (void)pvContext;
+    if ((pstRecord->u8Flags & m_u8CANRECORD_FLAG_TXEVENT) != 0u) {
+        if ((pstRecord->u8Length != 1u) || (pstRecord->pu8Data[0] != m_u8NextMarker)) {
+            fprintf(stderr, "master: TX event %u has no marker 0x%02x\n", m_u32TxEvents, m_u8NextMarker);
+            m_u32Errors++;
+        }
+        m_u8NextMarker = (uint8_t)(pstRecord->pu8Data[0] + 1u);
+        m_u32TxEvents++;
+        return;
+    }
+
+    u32Index = (pstRecord->u8Length >= 4u) ? ((uint32_t)pstRecord->pu8Data[0] | ((uint32_t)pstRecord->pu8Data[1] << 8u)
+            | ((uint32_t)pstRecord->pu8Data[2] << 16u) | ((uint32_t)pstRecord->pu8Data[3] << 24u)) : UINT32_MAX;
+    if ((u32Index != m_u32RxFrames) || (pstRecord->u32Identifier != (u32Index & 0x7FFu))
+            || (pstRecord->u8Length != m_u32FRAMELENGTH) || (pstRecord->pu8Data[7] != (uint8_t)~u32Index)) {
+        fprintf(stderr, "master: frame %u received as id 0x%x length %u index %u\n", m_u32RxFrames,
+                pstRecord->u32Identifier, pstRecord->u8Length, u32Index);
+        m_u32Errors++;
+    } else {
+        u64RoundTripNs = u64GetTimeNs() - m_pu64SendNs[u32Index];
+        m_u64RoundTripSumNs += u64RoundTripNs;
+        if (u64RoundTripNs > m_u64RoundTripMaxNs) {
+            m_u64RoundTripMaxNs = u64RoundTripNs;
+        }
+    }
+    m_u32RxFrames++;
+}
+
+/**
+ * @brief  Transport of the command client, channel 0.
+ * @retval false in case the message could not be sent.
+ */
+static bool bControlWrite(void *pvContext, const uint8_t *pu8Data, uint32_t u32Length) {
+
+    (void)pvContext;
+    return rpmsg_send(&m_astEndpoint[0], pu8Data, (int)u32Length) >= 0;
+}
+
+/**
+ * @brief  Transport of the command client, processes the vrings until
+ *         channel 0 brought data or the timeout expired.
+ * @retval bytes read, 0 after the timeout.
+ */
+static int32_t i32ControlRead(void *pvContext, uint8_t *pu8Data, uint32_t u32Length, int iTimeoutMs) {
+
+    uint64_t u64Deadline = u64GetTimeNs() + (uint64_t)iTimeoutMs * 1000000u;
+    uint64_t u64Now;
+    int iResult;
+
+    (void)pvContext;
+    while (m_u32ControlFill == 0u) {
+        u64Now = u64GetTimeNs();
+        if (u64Now >= u64Deadline) {
+            return 0;
+        }
+        iResult = platform_poll_timeout(m_pvPlatform, (unsigned int)((u64Deadline - u64Now + 999u) / 1000u));
+        if ((iResult < 0) && (iResult != -ETIMEDOUT)) {
+            return -1;
+        }
+    }
+    if (u32Length > m_u32ControlFill) {
+        u32Length = m_u32ControlFill;
+    }
+    memcpy(pu8Data, m_au8Control, u32Length);
+    m_u32ControlFill -= u32Length;
+    memmove(m_au8Control, &m_au8Control[u32Length], m_u32ControlFill);
+    return (int32_t)u32Length;
+}
+
+/**
+ * @brief  Sends frames u32First .. u32First + u32Count - 1 as one TX batch.
+ *         Frame n has the identifier n & 0x7FF and carries n in its payload.
+ * @retval false in case the batch could not be sent.
+ */
+static bool bSendFrames(uint32_t u32First, uint32_t u32Count) {
+
+    CanRecord_RecordStruct_t stRecord;
+    uint8_t au8Data[m_u32FRAMELENGTH];
+    uint64_t u64Now = u64GetTimeNs();
+    uint32_t u32Length;
+    bool bSent;
+
+    for (uint32_t u32Index = u32First; u32Index < (u32First + u32Count); u32Index++) {
+        au8Data[0] = (uint8_t)u32Index;
+        au8Data[1] = (uint8_t)(u32Index >> 8u);
+        au8Data[2] = (uint8_t)(u32Index >> 16u);
+        au8Data[3] = (uint8_t)(u32Index >> 24u);
+        au8Data[4] = 0x55u;
+        au8Data[5] = 0xAAu;
+        au8Data[6] = 0x5Au;
+        au8Data[7] = (uint8_t)~u32Index;
+        stRecord.u64Timestamp = 0u;
+        stRecord.u32Identifier = u32Index & 0x7FFu;
+        stRecord.u8Flags = 0u;
+        stRecord.u8Length = (uint8_t)m_u32FRAMELENGTH;
+        stRecord.pu8Data = au8Data;
+        (void)bCanRecord_BatchAdd(&m_stBatch, &stRecord);
+        m_pu64SendNs[u32Index] = u64Now;
+    }
+    u32Length = u32CanRecord_BatchFinish(&m_stBatch);
+    bSent = rpmsg_send(&m_astEndpoint[1], m_stBatch.pu8Buffer, (int)u32Length) >= 0;
+    vCanRecord_BatchReset(&m_stBatch);
+    return bSent;
+}
+
+/**
+ * @brief  Sends m_u32Frames frames with at most u32Window unconfirmed ones
+ *         and waits for all TX events and received frames.
+ * @retval false in case a batch could not be sent.
+ */
+static bool bRunTraffic(uint32_t u32Window) {
+
+    uint32_t u32Sent = 0u;
+    uint32_t u32Confirmed;
+    uint32_t u32Count;
+
+    while ((m_u32RxFrames < m_u32Frames) || (m_u32TxEvents < m_u32Frames)) {
+        u32Confirmed = (m_u32RxFrames < m_u32TxEvents) ? m_u32RxFrames : m_u32TxEvents;
+        if ((u32Sent < m_u32Frames) && ((u32Sent - u32Confirmed) < u32Window)) {
+            u32Count = u32Window - (u32Sent - u32Confirmed);
+            if (u32Count > m_u32FRAMESPERBATCH) {
+                u32Count = m_u32FRAMESPERBATCH;
+            }
+            if (u32Count > (m_u32Frames - u32Sent)) {
+                u32Count = m_u32Frames - u32Sent;
+            }
+            if (bSendFrames(u32Sent, u32Count) == false) {
+                return false;
+            }
+            u32Sent += u32Count;
+            continue;
+        }
+        if (platform_poll(m_pvPlatform) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+
+    static CanClient_Struct_t s_stClient;
+    static char s_acProcessor[] = "1";
+    char *apcPlatformArgs[] = { argv[0], s_acProcessor };
+    struct rpmsg_device *pstDevice;
+    CanLatency_ReportStruct_t stReport;
+    uint32_t au32Stats[CANCOMMAND_STAT_COUNT];
+    uint32_t u32Count = CANCOMMAND_STAT_COUNT;
+    uint32_t u32Window = m_u32DEFAULTWINDOW;
+    uint64_t u64Start;
+    uint64_t u64Elapsed;
+    uint8_t u8Protocol;
+    uint8_t u8Record;
+    int32_t i32Status;
+    int iOption;
+
+    while ((iOption = getopt(argc, argv, "n:w:")) != -1) {
+        if (iOption == 'n') {
+            m_u32Frames = (uint32_t)strtoul(optarg, NULL, 0);
+        } else if (iOption == 'w') {
+            u32Window = (uint32_t)strtoul(optarg, NULL, 0);
+        } else {
+            fprintf(stderr, "usage: %s [-n frames] [-w frames in flight]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    m_pu64SendNs = calloc((m_u32Frames != 0u) ? m_u32Frames : 1u, sizeof(*m_pu64SendNs));
+    if ((m_pu64SendNs == NULL) || (u32Window == 0u)) {
+        return EXIT_FAILURE;
+    }
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    platform_set_shm_pa(m_ulSHMSTART);
+    if (platform_init(2, apcPlatformArgs, &m_pvPlatform) != 0) {
+        return EXIT_FAILURE;
+    }
+    pstDevice = platform_create_rpmsg_vdev(m_pvPlatform, 0, VIRTIO_DEV_MASTER, NULL, vBindChannel);
+    if (pstDevice == NULL) {
+        platform_cleanup(m_pvPlatform);
+        return EXIT_FAILURE;
+    }
+    while (m_u32Endpoints < m_u32CHANNELS) {
+        platform_poll(m_pvPlatform);
+    }
+    vCanRecord_BatchInit(&m_stBatch);
+    vCanRecord_DecoderInit(&m_stDecoder);
+
+    /* the first message of each channel tells the firmware the address of Linux */
+    vCanClient_Init(&s_stClient, bControlWrite, i32ControlRead, NULL);
+    i32Status = i32CanClient_GetVersion(&s_stClient, &u8Protocol, &u8Record);
+    if (i32Status == CANCOMMAND_OK) {
+        printf("master: protocol %u, record format %u\n", u8Protocol, u8Record);
+        i32Status = i32CanClient_SetFormat(&s_stClient, m_u8CANCOMMAND_FORMAT_BINARY);
+    }
+    if ((i32Status == CANCOMMAND_OK) && (bSendFrames(0u, 0u) == false)) {
+        i32Status = m_i32CANCLIENT_ERROR_IO;
+    }
+    if (i32Status == CANCOMMAND_OK) {
+        i32Status = i32CanClient_Start(&s_stClient);
+    }
+
+    u64Start = u64GetTimeNs();
+    if ((i32Status == CANCOMMAND_OK) && (bRunTraffic(u32Window) == false)) {
+        i32Status = m_i32CANCLIENT_ERROR_IO;
+    }
+    u64Elapsed = u64GetTimeNs() - u64Start;
+
+    if (i32Status == CANCOMMAND_OK) {
+        i32Status = i32CanClient_GetStats(&s_stClient, au32Stats, &u32Count);
+    }
+    if ((i32Status == CANCOMMAND_OK) && (u32Count > CANCOMMAND_STAT_TXEVENTLOST)) {
+        printf("master: firmware rx %u tx %u tx invalid %u tx batches dropped %u tx events lost %u\n",
+                au32Stats[CANCOMMAND_STAT_RXFRAMES], au32Stats[CANCOMMAND_STAT_TXFRAMES],
+                au32Stats[CANCOMMAND_STAT_TXINVALID], au32Stats[CANCOMMAND_STAT_TXBATCHDROPPED],
+                au32Stats[CANCOMMAND_STAT_TXEVENTLOST]);
+        i32Status = i32CanClient_GetLatency(&s_stClient, false, &stReport);
+    }
+    if (i32Status == CANCOMMAND_OK) {
+        for (uint32_t i = 0; i < stReport.u32Stages; i++) {
+            printf("master: firmware %-8s n %u avg %.1f us max %.1f us\n", pcCanLatency_StageName((CanLatency_Stage_t)i),
+                    stReport.astStages[i].u32Count,
+                    stReport.astStages[i].u32Average / (double)stReport.u32CyclesPerUs,
+                    stReport.astStages[i].u32Max / (double)stReport.u32CyclesPerUs);
+        }
+    }
+
+    if (i32Status != CANCOMMAND_OK) {
+        fprintf(stderr, "master: command failed: %d\n", i32Status);
+    } else if ((m_u32RxFrames != 0u) && (u64Elapsed != 0u)) {
+        printf("master: %u frames, window %u, %.0f frames/s, round trip avg %.1f us max %.1f us\n", m_u32Frames,
+                u32Window, (double)m_u32Frames * 1e9 / (double)u64Elapsed,
+                (double)m_u64RoundTripSumNs / m_u32RxFrames / 1000.0, (double)m_u64RoundTripMaxNs / 1000.0);
+    }
+    if ((m_stDecoder.u32LostBatches != 0u) || (m_u32ControlDropped != 0u)) {
+        fprintf(stderr, "master: %u batches lost, %u control messages dropped\n", m_stDecoder.u32LostBatches,
+                m_u32ControlDropped);
+        m_u32Errors++;
+    }
+
+    platform_release_rpmsg_vdev(pstDevice, m_pvPlatform);
+    platform_cleanup(m_pvPlatform);
+    free(m_pu64SendNs);
+    printf("master: %s, %u errors\n", ((i32Status == CANCOMMAND_OK) && (m_u32Errors == 0u)) ? "passed" : "FAILED",
+            m_u32Errors);
+    return ((i32Status == CANCOMMAND_OK) && (m_u32Errors == 0u)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
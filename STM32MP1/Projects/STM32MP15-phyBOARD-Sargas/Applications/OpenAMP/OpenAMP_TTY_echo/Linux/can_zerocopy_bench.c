@@ -0,0 +1,257 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Host benchmark of the channel 1 send path of the main loop: the
+ *          ASCII trace line and the binary batch built in a static array and
+ *          copied into the RPMsg TX buffer like bTransmitData(), against
+ *          formatting them in place in the TX buffer. Reports frames/s,
+ *          copies and copied bytes per frame.
+ *
+ *          usage: can_zerocopy_bench [frames]
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_record.h"
+#include "can_trace.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "time.h"
+
+/* Private define ------------------------------------------------------------*/
+#define m_u32DEFAULTFRAMES ((uint32_t)1000000)
+/* RPMsg TX buffers used round robin, payload size like VIRT_UART_AcquireTxBuffer() */
+#define m_u32TXBUFFERS ((uint32_t)16)
+#define m_u32TXBUFFERSIZE m_u32CANRECORD_BATCHSIZE
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+    uint32_t u32Timestamp;
+    uint32_t u32Identifier;
+    uint8_t u8Length;
+    uint8_t au8Data[m_u32CANRECORD_MAXDATALENGTH];
+} Bench_FrameStruct_t;
+
+typedef struct {
+    const char *pcName;
+    double dSeconds;
+    uint64_t u64Copies;
+    uint64_t u64CopiedBytes;
+    uint64_t u64Messages;
+    uint64_t u64Checksum;
+} Bench_ResultStruct_t;
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t m_au8TxBuffers[m_u32TXBUFFERS][m_u32TXBUFFERSIZE];
+static uint32_t m_u32TxNext = 0;
+static uint8_t m_au8CanFdTrace[m_u32CANTRACE_LENGTH];
+static CanRecord_BatchStruct_t m_stBatch;
+
+/* Private function prototypes -----------------------------------------------*/
+static double dNow(void);
+static void vCreateFrames(Bench_FrameStruct_t *pstFrames, uint32_t u32Frames);
+static uint8_t *pu8Acquire(void);
+static void vSend(Bench_ResultStruct_t *pstResult, const uint8_t *pu8Buffer, uint32_t u32Length);
+static void vCopy(Bench_ResultStruct_t *pstResult, uint8_t *pu8Dest, const uint8_t *pu8Src, uint32_t u32Length);
+static void vBenchAscii(const Bench_FrameStruct_t *pstFrames, uint32_t u32Frames, bool bInPlace,
+        Bench_ResultStruct_t *pstResult);
+static void vSendBatch(Bench_ResultStruct_t *pstResult, uint8_t **ppu8Attached);
+static void vBenchBinary(const Bench_FrameStruct_t *pstFrames, uint32_t u32Frames, bool bInPlace,
+        Bench_ResultStruct_t *pstResult);
+static void vPrintResult(const Bench_ResultStruct_t *pstResult, uint32_t u32Frames);
+
+/**
+ * @brief  Monotonic time in seconds.
+ * @retval seconds
+ */
+static double dNow(void) {
+    struct timespec stTime;
+    clock_gettime(CLOCK_MONOTONIC, &stTime);
+    return (double)stTime.tv_sec + (double)stTime.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief  Creates random frames with 8 byte payload.
+ * @retval void
+ */
+static void vCreateFrames(Bench_FrameStruct_t *pstFrames, uint32_t u32Frames) {
+    srand(1);
+    for (uint32_t i = 0; i < u32Frames; i++) {
+        pstFrames[i].u32Timestamp = i / 4u;
+        pstFrames[i].u32Identifier = (uint32_t)rand() & 0x7FFu;
+        pstFrames[i].u8Length = 8u;
+        memset(pstFrames[i].au8Data, 0, sizeof(pstFrames[i].au8Data));
+        for (uint32_t j = 0; j < pstFrames[i].u8Length; j++) {
+            pstFrames[i].au8Data[j] = (uint8_t)rand();
+        }
+    }
+}
+
+/**
+ * @brief  Takes the next TX buffer like VIRT_UART_AcquireTxBuffer().
+ * @retval buffer
+ */
+static uint8_t *pu8Acquire(void) {
+    uint8_t *pu8Buffer = m_au8TxBuffers[m_u32TxNext];
+
+    m_u32TxNext = (m_u32TxNext + 1u) % m_u32TXBUFFERS;
+    return pu8Buffer;
+}
+
+/**
+ * @brief  Stands in for VIRT_UART_TransmitNoCopy(), Linux reads the message.
+ * @retval void
+ */
+static void vSend(Bench_ResultStruct_t *pstResult, const uint8_t *pu8Buffer, uint32_t u32Length) {
+    pstResult->u64Messages++;
+    pstResult->u64Checksum = pstResult->u64Checksum * 31u + pu8Buffer[0] + pu8Buffer[u32Length / 2u]
+            + pu8Buffer[u32Length - 1u] + u32Length;
+}
+
+/**
+ * @brief  Counted copy into a TX buffer like the memcpy() of bTransmitData().
+ * @retval void
+ */
+static void vCopy(Bench_ResultStruct_t *pstResult, uint8_t *pu8Dest, const uint8_t *pu8Src, uint32_t u32Length) {
+    memcpy(pu8Dest, pu8Src, u32Length);
+    pstResult->u64Copies++;
+    pstResult->u64CopiedBytes += u32Length;
+}
+
+/**
+ * @brief  One ASCII trace line per message, formatted into m_au8CanFdTrace
+ *         and copied or formatted in place.
+ * @retval void
+ */
+static void vBenchAscii(const Bench_FrameStruct_t *pstFrames, uint32_t u32Frames, bool bInPlace,
+        Bench_ResultStruct_t *pstResult) {
+
+    uint8_t *pu8Buffer;
+    double dStart = dNow();
+
+    pstResult->pcName = bInPlace ? "ascii in place" : "ascii copied";
+    for (uint32_t i = 0; i < u32Frames; i++) {
+        pu8Buffer = pu8Acquire();
+        vCanTrace_Format(bInPlace ? pu8Buffer : m_au8CanFdTrace, i + 1u, pstFrames[i].u32Timestamp,
+                pstFrames[i].u32Identifier, pstFrames[i].u8Length, pstFrames[i].au8Data);
+        if (bInPlace == false) {
+            vCopy(pstResult, pu8Buffer, m_au8CanFdTrace, m_u32CANTRACE_LENGTH);
+        }
+        vSend(pstResult, pu8Buffer, m_u32CANTRACE_LENGTH);
+    }
+    pstResult->dSeconds = dNow() - dStart;
+}
+
+/**
+ * @brief  Sends the batch like vSendCanRecordBatch(), from the attached
+ *         TX buffer or with a copy of au8Buffer.
+ * @retval void
+ */
+static void vSendBatch(Bench_ResultStruct_t *pstResult, uint8_t **ppu8Attached) {
+
+    uint32_t u32Length = u32CanRecord_BatchFinish(&m_stBatch);
+    uint8_t *pu8Buffer;
+
+    if (*ppu8Attached != NULL) {
+        pu8Buffer = *ppu8Attached;
+        *ppu8Attached = NULL;
+        vCanRecord_BatchAttach(&m_stBatch, NULL, 0u);
+    } else {
+        pu8Buffer = pu8Acquire();
+        vCopy(pstResult, pu8Buffer, m_stBatch.au8Buffer, u32Length);
+    }
+    vSend(pstResult, pu8Buffer, u32Length);
+    vCanRecord_BatchReset(&m_stBatch);
+}
+
+/**
+ * @brief  Binary batches collected in au8Buffer and copied, or collected in
+ *         an attached TX buffer like vAttachCanRecordBuffer().
+ * @retval void
+ */
+static void vBenchBinary(const Bench_FrameStruct_t *pstFrames, uint32_t u32Frames, bool bInPlace,
+        Bench_ResultStruct_t *pstResult) {
+
+    CanRecord_RecordStruct_t stRecord;
+    uint8_t *pu8Attached = NULL;
+    double dStart = dNow();
+
+    pstResult->pcName = bInPlace ? "binary in place" : "binary copied";
+    vCanRecord_BatchInit(&m_stBatch);
+    for (uint32_t i = 0; i < u32Frames; i++) {
+        stRecord.u64Timestamp = (uint64_t)pstFrames[i].u32Timestamp * 1000u;
+        stRecord.u32Identifier = pstFrames[i].u32Identifier;
+        stRecord.u8Flags = 0u;
+        stRecord.u8Length = pstFrames[i].u8Length;
+        stRecord.pu8Data = pstFrames[i].au8Data;
+        if ((bInPlace == true) && (bCanRecord_BatchIsEmpty(&m_stBatch) == true)) {
+            pu8Attached = pu8Acquire();
+            vCanRecord_BatchAttach(&m_stBatch, pu8Attached, m_u32TXBUFFERSIZE);
+        }
+        if (bCanRecord_BatchAdd(&m_stBatch, &stRecord) == false) {
+            vSendBatch(pstResult, &pu8Attached);
+            if (bInPlace == true) {
+                pu8Attached = pu8Acquire();
+                vCanRecord_BatchAttach(&m_stBatch, pu8Attached, m_u32TXBUFFERSIZE);
+            }
+            bCanRecord_BatchAdd(&m_stBatch, &stRecord);
+        }
+    }
+    if (bCanRecord_BatchIsEmpty(&m_stBatch) == false) {
+        vSendBatch(pstResult, &pu8Attached);
+    }
+    pstResult->dSeconds = dNow() - dStart;
+}
+
+/**
+ * @brief  Prints one result line.
+ * @retval void
+ */
+static void vPrintResult(const Bench_ResultStruct_t *pstResult, uint32_t u32Frames) {
+    printf("  %-16s %12.0f %10.2f %12.1f %12.1f\n", pstResult->pcName, u32Frames / pstResult->dSeconds,
+            (double)pstResult->u64Copies / u32Frames, (double)pstResult->u64CopiedBytes / u32Frames,
+            (double)u32Frames / pstResult->u64Messages);
+}
+
+int main(int argc, char *argv[]) {
+
+    uint32_t u32Frames = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : m_u32DEFAULTFRAMES;
+    Bench_FrameStruct_t *pstFrames = malloc((size_t)u32Frames * sizeof(*pstFrames));
+    Bench_ResultStruct_t astResults[4] = {0};
+
+    if ((u32Frames == 0u) || (pstFrames == NULL)) {
+        fprintf(stderr, "usage: %s [frames]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    vCreateFrames(pstFrames, u32Frames);
+    vBenchAscii(pstFrames, u32Frames, false, &astResults[0]);
+    vBenchAscii(pstFrames, u32Frames, true, &astResults[1]);
+    vBenchBinary(pstFrames, u32Frames, false, &astResults[2]);
+    vBenchBinary(pstFrames, u32Frames, true, &astResults[3]);
+    if ((astResults[0].u64Checksum != astResults[1].u64Checksum)
+            || (astResults[2].u64Checksum != astResults[3].u64Checksum)) {
+        fprintf(stderr, "copied and in place messages differ\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%u frames, 8 byte payload\n", u32Frames);
+    printf("  %-16s %12s %10s %12s %12s\n", "path", "fr/s", "copies/fr", "copied B/fr", "frames/msg");
+    for (uint32_t i = 0; i < sizeof(astResults) / sizeof(astResults[0]); i++) {
+        vPrintResult(&astResults[i], u32Frames);
+    }
+
+    free(pstFrames);
+    return EXIT_SUCCESS;
+}
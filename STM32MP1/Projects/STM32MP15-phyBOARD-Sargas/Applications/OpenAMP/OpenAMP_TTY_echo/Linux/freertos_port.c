@@ -0,0 +1,177 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Deterministic host port of the vendored FreeRTOS kernel for the
+ *          simulation of the task configuration of the CAN bridge, see
+ *          portmacro.h. It replaces the FreeRTOS POSIX port, which is not part
+ *          of FreeRTOS V10.2.0, and unlike it does not depend on the timing of
+ *          the host threads.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stdbool.h"
+#include "stdint.h"
+#include "ucontext.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* kept at the top of the task stack, pxTopOfStack of the TCB points to it */
+typedef struct {
+    ucontext_t stContext;
+    TaskFunction_t pfnCode;
+    void *pvParameters;
+} Port_TaskStruct_t;
+
+/* Private define ------------------------------------------------------------*/
+/* every task stack has at least configMINIMAL_STACK_SIZE words, the top may be
+ * aligned down by a few words */
+#define m_u32STACKRESERVE ((uint32_t)4)
+
+/* Private variables ---------------------------------------------------------*/
+extern void * volatile pxCurrentTCB;
+
+static ucontext_t m_stSchedulerContext;
+static UBaseType_t m_uxCriticalNesting = 0;
+static bool m_bYieldPending = false;
+
+/* Private function prototypes -----------------------------------------------*/
+static Port_TaskStruct_t *pstGetCurrentTask(void);
+static void vStartTask(void);
+
+/**
+ * @brief  Task structure of the running task.
+ * @retval pointer to the structure on the task stack
+ */
+static Port_TaskStruct_t *pstGetCurrentTask(void) {
+    return *(Port_TaskStruct_t * volatile *)pxCurrentTCB;
+}
+
+/**
+ * @brief  Entry of every task context, the first switch to a task lands here.
+ * @retval void
+ */
+static void vStartTask(void) {
+
+    Port_TaskStruct_t *pstTask = pstGetCurrentTask();
+
+    pstTask->pfnCode(pstTask->pvParameters);
+    /* FreeRTOS tasks must not return */
+    configASSERT(0);
+}
+
+/**
+ * @brief  Prepares the context of a new task below pxTopOfStack.
+ * @retval new top of stack, the task structure
+ */
+StackType_t *pxPortInitialiseStack(StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters) {
+
+    uint8_t *pu8Bottom = (uint8_t *)(pxTopOfStack + 1) - ((configMINIMAL_STACK_SIZE - m_u32STACKRESERVE)
+            * sizeof(StackType_t));
+    uintptr_t uTask = ((uintptr_t)(pxTopOfStack + 1) - sizeof(Port_TaskStruct_t)) & ~(uintptr_t)(portBYTE_ALIGNMENT - 1);
+    Port_TaskStruct_t *pstTask = (Port_TaskStruct_t *)uTask;
+    int iResult = getcontext(&pstTask->stContext);
+
+    configASSERT(iResult == 0);
+    pstTask->stContext.uc_stack.ss_sp = pu8Bottom;
+    pstTask->stContext.uc_stack.ss_size = (size_t)((uint8_t *)pstTask - pu8Bottom);
+    pstTask->stContext.uc_link = NULL;
+    pstTask->pfnCode = pxCode;
+    pstTask->pvParameters = pvParameters;
+    makecontext(&pstTask->stContext, vStartTask, 0);
+
+    return (StackType_t *)pstTask;
+}
+
+/**
+ * @brief  Switches to the first task, returns after vTaskEndScheduler().
+ * @retval pdFALSE
+ */
+BaseType_t xPortStartScheduler(void) {
+
+    int iResult;
+
+    m_uxCriticalNesting = 0;
+    m_bYieldPending = false;
+    iResult = swapcontext(&m_stSchedulerContext, &pstGetCurrentTask()->stContext);
+    configASSERT(iResult == 0);
+    return pdFALSE;
+}
+
+/**
+ * @brief  Returns to the caller of vTaskStartScheduler(), the tasks are not
+ *         resumed anymore.
+ * @retval void
+ */
+void vPortEndScheduler(void) {
+    setcontext(&m_stSchedulerContext);
+}
+
+/**
+ * @brief  Switches to the highest priority ready task. Inside a critical
+ *         section the switch is delayed until its end, like the PendSV
+ *         exception of the Cortex-M port.
+ * @retval void
+ */
+void vPortYield(void) {
+
+    Port_TaskStruct_t *pstFrom;
+    Port_TaskStruct_t *pstTo;
+    int iResult;
+
+    if (m_uxCriticalNesting != 0u) {
+        m_bYieldPending = true;
+        return;
+    }
+    pstFrom = pstGetCurrentTask();
+    vTaskSwitchContext();
+    pstTo = pstGetCurrentTask();
+    if (pstTo != pstFrom) {
+        iResult = swapcontext(&pstFrom->stContext, &pstTo->stContext);
+        configASSERT(iResult == 0);
+    }
+}
+
+/**
+ * @brief  Enters a critical section, there is nothing to mask on one thread.
+ * @retval void
+ */
+void vPortEnterCritical(void) {
+    m_uxCriticalNesting++;
+}
+
+/**
+ * @brief  Leaves a critical section and switches a delayed yield.
+ * @retval void
+ */
+void vPortExitCritical(void) {
+
+    configASSERT(m_uxCriticalNesting != 0u);
+    m_uxCriticalNesting--;
+    if ((m_uxCriticalNesting == 0u) && (m_bYieldPending == true)) {
+        m_bYieldPending = false;
+        vPortYield();
+    }
+}
+
+/**
+ * @brief  Simulated time: every pass of the idle task is one tick.
+ * @retval void
+ */
+void vApplicationIdleHook(void) {
+
+    if (xTaskIncrementTick() != pdFALSE) {
+        vPortYield();
+    }
+}
@@ -0,0 +1,86 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   FreeRTOS port macros of the host simulation port freertos_port.c.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ *
+ * All tasks run on one host thread and switch with swapcontext(), so a task
+ * only loses the CPU inside a FreeRTOS call. There are no real interrupts, an
+ * "interrupt" of the simulation is a task of the highest priority calling the
+ * FromISR functions. The tick advances while the idle task runs, so the
+ * simulated time only passes when every task waits.
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+
+/* Exported types ------------------------------------------------------------*/
+#define portCHAR char
+#define portFLOAT float
+#define portDOUBLE double
+#define portLONG long
+#define portSHORT short
+#define portSTACK_TYPE uintptr_t
+#define portBASE_TYPE long
+#define portPOINTER_SIZE_TYPE uintptr_t
+
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+/* Exported constants --------------------------------------------------------*/
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_TYPE_IS_ATOMIC 1
+#define portSTACK_GROWTH (-1)
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portBYTE_ALIGNMENT 16
+
+/* Exported macro ------------------------------------------------------------*/
+#define portYIELD() vPortYield()
+#define portEND_SWITCHING_ISR(xSwitchRequired) do { \
+        if ((xSwitchRequired) != pdFALSE) { \
+            vPortYield(); \
+        } \
+    } while (0)
+#define portYIELD_FROM_ISR(x) portEND_SWITCHING_ISR(x)
+
+#define portDISABLE_INTERRUPTS()
+#define portENABLE_INTERRUPTS()
+#define portENTER_CRITICAL() vPortEnterCritical()
+#define portEXIT_CRITICAL() vPortExitCritical()
+#define portSET_INTERRUPT_MASK_FROM_ISR() 0
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x) ((void)(x))
+
+#define portTASK_FUNCTION_PROTO(vFunction, pvParameters) void vFunction(void *pvParameters)
+#define portTASK_FUNCTION(vFunction, pvParameters) void vFunction(void *pvParameters)
+#define portNOP()
+
+/* Exported functions prototypes ---------------------------------------------*/
+void vPortYield(void);
+void vPortEnterCritical(void);
+void vPortExitCritical(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORTMACRO_H */
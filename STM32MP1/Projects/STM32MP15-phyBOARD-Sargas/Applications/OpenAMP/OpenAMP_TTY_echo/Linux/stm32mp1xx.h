@@ -0,0 +1,51 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   CMSIS device header of the host twin of the firmware, wraps the
+ *          real stm32mp1xx.h, see twin_hal.h.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ *
+ * The Cortex-M4 intrinsics the firmware uses are inline assembly in
+ * cmsis_gcc.h. They are renamed while the real header is included, the unused
+ * inline functions are never emitted, and replaced by the twin core. The DWT
+ * is the only core peripheral which must change without being written.
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TWIN_STM32MP1XX_H
+#define TWIN_STM32MP1XX_H
+
+/* Includes ------------------------------------------------------------------*/
+#define __DMB vTwinCmsis_Dmb
+#define __disable_irq vTwinCmsis_DisableIrq
+#define __get_PRIMASK u32TwinCmsis_GetPrimask
+#define __set_PRIMASK vTwinCmsis_SetPrimask
+#include_next "stm32mp1xx.h"
+#undef __DMB
+#undef __disable_irq
+#undef __get_PRIMASK
+#undef __set_PRIMASK
+#undef __WFI
+#undef DWT
+
+#include "twin_hal.h"
+
+/* Exported macro ------------------------------------------------------------*/
+#define __DMB() vTwinHal_Fence()
+#define __disable_irq() vTwinHal_DisableIrq()
+#define __get_PRIMASK() u32TwinHal_GetPrimask()
+#define __set_PRIMASK(u32Primask) vTwinHal_SetPrimask(u32Primask)
+#define __WFI() vTwinHal_Wfi()
+#define DWT (pstTwinHal_GetDwt())
+
+#endif /* TWIN_STM32MP1XX_H */
@@ -0,0 +1,180 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Host simulation of the USART3 trace mirror queue (trace_queue.c).
+ *          A simulated main loop queues one trace line per received frame
+ *          while a simulated 921600 baud DMA UART drains the queue. The
+ *          simulation checks that queuing never waits for the UART, that the
+ *          drop counters account for every line and that the order of the
+ *          sent lines is kept, for both drop policies.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "trace_queue.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+/* Private define ------------------------------------------------------------*/
+#define m_u32LINELENGTH ((uint32_t)233)
+#define m_u32BAUDRATE ((uint32_t)921600)
+/* 10 bit times per byte */
+#define m_u32LINETIMEUS ((uint32_t)((uint64_t)m_u32LINELENGTH * 10u * 1000000u / m_u32BAUDRATE))
+
+/* Private macro -------------------------------------------------------------*/
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            m_u32Failures++; \
+        } \
+    } while (0)
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+    TraceQueue_Struct_t stQueue;
+    uint64_t u64UartDoneUs;     /* end of the running transfer */
+    uint32_t u32LastSent;
+    uint32_t u32FirstSent;
+    uint32_t u32Sent;           /* transfers started */
+    uint32_t u32FailEvery;      /* every n-th transfer ends with a UART error, 0 for none */
+    uint32_t u32Failed;
+} Sim_Struct_t;
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t m_u32Failures = 0;
+
+/**
+ * @brief  Simulated transmit complete interrupt and DMA start, like
+ *         HAL_UART_TxCpltCallback() and vUsart3_MirrorKick() in usart.c.
+ * @retval void
+ */
+static void vUartKick(Sim_Struct_t *pstSim, uint64_t u64NowUs) {
+    const uint8_t *pu8Line;
+    uint16_t u16Length;
+    uint32_t u32Sequence;
+
+    pu8Line = pu8TraceQueue_StartNext(&pstSim->stQueue, &u16Length);
+    if (pu8Line == NULL) {
+        return;
+    }
+    CHECK(u16Length == m_u32LINELENGTH);
+    memcpy(&u32Sequence, pu8Line, sizeof(u32Sequence));
+    CHECK(pu8Line[m_u32LINELENGTH - 1u] == '\n');
+    if (pstSim->u32Sent == 0u) {
+        pstSim->u32FirstSent = u32Sequence;
+    } else {
+        CHECK(u32Sequence > pstSim->u32LastSent);
+    }
+    pstSim->u32LastSent = u32Sequence;
+    pstSim->u32Sent++;
+    pstSim->u64UartDoneUs = u64NowUs + m_u32LINETIMEUS;
+}
+
+/**
+ * @brief  Advances the simulated UART up to u64NowUs.
+ * @retval void
+ */
+static void vUartRun(Sim_Struct_t *pstSim, uint64_t u64NowUs) {
+    while ((bTraceQueue_IsBusy(&pstSim->stQueue) == true) && (pstSim->u64UartDoneUs <= u64NowUs)) {
+        uint64_t u64DoneUs = pstSim->u64UartDoneUs;
+        if ((pstSim->u32FailEvery != 0u) && ((pstSim->u32Sent % pstSim->u32FailEvery) == 0u)) {
+            /* HAL_UART_ErrorCallback() */
+            vTraceQueue_Failed(&pstSim->stQueue);
+            pstSim->u32Failed++;
+        } else {
+            vTraceQueue_Done(&pstSim->stQueue);
+        }
+        vUartKick(pstSim, u64DoneUs);
+    }
+}
+
+/**
+ * @brief  Runs u32Frames frames with u32FrameGapUs between them, every
+ *         u32FailEvery-th transfer fails.
+ * @retval void
+ */
+static void vSimulate(TraceQueue_Policy_t ePolicy, uint32_t u32Frames, uint32_t u32FrameGapUs,
+        uint32_t u32FailEvery) {
+
+    static Sim_Struct_t s_stSim;
+    uint8_t au8Line[m_u32LINELENGTH];
+    uint64_t u64NowUs = 0u;
+    uint32_t u32Accepted = 0u;
+    TraceQueue_StatsStruct_t *pstStats = &s_stSim.stQueue.stStats;
+
+    memset(&s_stSim, 0, sizeof(s_stSim));
+    vTraceQueue_Init(&s_stSim.stQueue, ePolicy);
+    s_stSim.u32FailEvery = u32FailEvery;
+    memset(au8Line, ' ', sizeof(au8Line));
+    au8Line[m_u32LINELENGTH - 1u] = '\n';
+
+    for (uint32_t i = 1; i <= u32Frames; i++) {
+        u64NowUs += u32FrameGapUs;
+        vUartRun(&s_stSim, u64NowUs);
+
+        /* main loop: queue and kick, the simulated time does not advance here */
+        memcpy(au8Line, &i, sizeof(i));
+        if (bTraceQueue_Put(&s_stSim.stQueue, au8Line, sizeof(au8Line)) == true) {
+            u32Accepted++;
+        }
+        vUartKick(&s_stSim, u64NowUs);
+    }
+    CHECK((u32Accepted + pstStats->u32DroppedNewest) == u32Frames);
+
+    /* drain */
+    while (bTraceQueue_IsBusy(&s_stSim.stQueue) == true) {
+        u64NowUs = s_stSim.u64UartDoneUs;
+        vUartRun(&s_stSim, u64NowUs);
+    }
+    CHECK(u32TraceQueue_GetFillLevel(&s_stSim.stQueue) == 0u);
+    CHECK((pstStats->u32Sent + pstStats->u32Failed) == s_stSim.u32Sent);
+    CHECK(pstStats->u32Failed == s_stSim.u32Failed);
+    CHECK((pstStats->u32Sent + pstStats->u32Failed + pstStats->u32DroppedNewest + pstStats->u32DroppedOldest)
+            == u32Frames);
+    CHECK(pstStats->u32HighWater <= m_u32TRACEQUEUE_SLOTS);
+    CHECK(s_stSim.u32FirstSent == 1u);
+    if (ePolicy == TRACEQUEUE_DROP_OLDEST) {
+        CHECK(pstStats->u32DroppedNewest == 0u);
+        CHECK(s_stSim.u32LastSent == u32Frames);
+    } else {
+        CHECK(pstStats->u32DroppedOldest == 0u);
+    }
+
+    printf("  %-11s gap %5u us: %7u frames, %7u sent, %5u failed, %7u dropped newest, %7u dropped oldest, "
+            "high water %2u\n", (ePolicy == TRACEQUEUE_DROP_OLDEST) ? "drop-oldest" : "drop-newest", u32FrameGapUs,
+            u32Frames, pstStats->u32Sent, pstStats->u32Failed, pstStats->u32DroppedNewest, pstStats->u32DroppedOldest,
+            pstStats->u32HighWater);
+}
+
+int main(void) {
+
+    static const uint32_t au32GapUs[] = {50u, 500u, 2000u, 2600u, 10000u};
+
+    printf("line %u bytes at %u baud: %u us per line, a blocking transmit limits the loop to %u frames/s\n",
+            m_u32LINELENGTH, m_u32BAUDRATE, m_u32LINETIMEUS, 1000000u / m_u32LINETIMEUS);
+    for (uint32_t i = 0; i < sizeof(au32GapUs) / sizeof(au32GapUs[0]); i++) {
+        vSimulate(TRACEQUEUE_DROP_OLDEST, 20000u, au32GapUs[i], 0u);
+        vSimulate(TRACEQUEUE_DROP_NEWEST, 20000u, au32GapUs[i], 0u);
+    }
+    /* a UART error every 7th line */
+    vSimulate(TRACEQUEUE_DROP_OLDEST, 20000u, 500u, 7u);
+    vSimulate(TRACEQUEUE_DROP_NEWEST, 20000u, 2600u, 7u);
+
+    if (m_u32Failures != 0u) {
+        fprintf(stderr, "trace_queue_sim: %u failures\n", m_u32Failures);
+        return EXIT_FAILURE;
+    }
+    printf("trace_queue_sim: passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,554 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   FDCAN stand-in of the host twin of the firmware. The bus has one
+ *          other node, which sends every frame it receives back at once:
+ *          a frame of the TX FIFO gets its TX event and returns as received
+ *          frame, if the filter elements in the message RAM and the global
+ *          filter accept it. Frames take no bus time. The FDCAN2 interrupt is
+ *          the bus thread, the timestamp counter counts bit times of the
+ *          nominal bit rate since bTwinHal_Init().
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "twin_hal.h"
+#include "stm32mp1xx_hal.h"
+#include "pthread.h"
+#include "string.h"
+#include "time.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+    FDCAN_TxHeaderTypeDef stHeader;
+    uint8_t au8Data[64];
+} TwinFdcan_TxStruct_t;
+
+typedef struct {
+    FDCAN_RxHeaderTypeDef stHeader;
+    uint8_t au8Data[64];
+} TwinFdcan_RxStruct_t;
+
+/* Private define ------------------------------------------------------------*/
+/* element limits of the message RAM sections */
+#define m_u32TXFIFOMAX ((uint32_t)32)
+#define m_u32RXFIFOMAX ((uint32_t)64)
+#define m_u32TXEVENTMAX ((uint32_t)32)
+/* longest wait of the bus thread, well below one counter wrap */
+#define m_u32IDLENS ((uint32_t)10000000)
+
+/* Private variables ---------------------------------------------------------*/
+static const uint8_t m_au8DLCTOBYTES[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64};
+
+static pthread_mutex_t m_stLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t m_stWakeup;
+static pthread_t m_stBusThread;
+static bool m_bBusRunning = false;
+
+static TwinFdcan_TxStruct_t m_astTxFifo[m_u32TXFIFOMAX];
+static uint32_t m_u32TxHead = 0;
+static uint32_t m_u32TxCount = 0;
+static TwinFdcan_RxStruct_t m_astRxFifo0[m_u32RXFIFOMAX];
+static uint32_t m_u32RxHead = 0;
+static uint32_t m_u32RxCount = 0;
+static FDCAN_TxEventFifoTypeDef m_astTxEvents[m_u32TXEVENTMAX];
+static uint32_t m_u32EventHead = 0;
+static uint32_t m_u32EventCount = 0;
+
+static uint32_t m_u32ActiveITs = 0;
+static uint32_t m_u32RxWatermark = 0;
+static uint32_t m_u32NonMatchingStd = FDCAN_ACCEPT_IN_RX_FIFO0;
+static uint32_t m_u32NonMatchingExt = FDCAN_ACCEPT_IN_RX_FIFO0;
+static uint32_t m_u32RejectRemoteStd = FDCAN_FILTER_REMOTE;
+static uint32_t m_u32RejectRemoteExt = FDCAN_FILTER_REMOTE;
+static uint32_t m_u32TickNs = 1000;
+static bool m_bCounterEnabled = false;
+static uint64_t m_u64CounterWraps = 0;
+
+/* interrupt flags not yet passed to the callbacks */
+static uint32_t m_u32PendingRxFifo0 = 0;
+static uint32_t m_u32PendingTxEvent = 0;
+static bool m_bPendingWraparound = false;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t u32GetCounter(void);
+static bool bMatchId(uint32_t u32Type, uint32_t u32Id, uint32_t u32Id1, uint32_t u32Id2);
+static bool bAcceptFrame(FDCAN_HandleTypeDef *hfdcan, FDCAN_RxHeaderTypeDef *pstHeader);
+static void vTransmitFrame(FDCAN_HandleTypeDef *hfdcan);
+static void vUpdateEventFillLevel(FDCAN_HandleTypeDef *hfdcan);
+static void *pvBusThread(void *pvArgument);
+
+/**
+ * @brief  Timestamp counter, bit times since start.
+ * @retval counter value, 16 bit
+ */
+static uint32_t u32GetCounter(void) {
+    return (uint32_t)(u64TwinHal_GetTimeNs() / m_u32TickNs) & 0xFFFFu;
+}
+
+/**
+ * @brief  Compares an identifier with the two identifiers of a filter element.
+ * @retval true in case the element matches.
+ */
+static bool bMatchId(uint32_t u32Type, uint32_t u32Id, uint32_t u32Id1, uint32_t u32Id2) {
+
+    switch (u32Type) {
+    case FDCAN_FILTER_DUAL:
+        return (u32Id == u32Id1) || (u32Id == u32Id2);
+    case FDCAN_FILTER_MASK:
+        return (u32Id & u32Id2) == (u32Id1 & u32Id2);
+    default:
+        return (u32Id >= u32Id1) && (u32Id <= u32Id2);
+    }
+}
+
+/**
+ * @brief  Acceptance filtering of a received frame with the filter elements in
+ *         the message RAM, the first enabled matching element decides.
+ * @retval true in case the frame is stored in RX FIFO0.
+ */
+static bool bAcceptFrame(FDCAN_HandleTypeDef *hfdcan, FDCAN_RxHeaderTypeDef *pstHeader) {
+
+    bool bExtended = (pstHeader->IdType == FDCAN_EXTENDED_ID);
+    uint32_t u32Count = (bExtended == true) ? hfdcan->Init.ExtFiltersNbr : hfdcan->Init.StdFiltersNbr;
+    const volatile uint32_t *pu32Element;
+    uint32_t u32Type;
+    uint32_t u32Config;
+    uint32_t u32Id1;
+    uint32_t u32Id2;
+
+    if ((pstHeader->RxFrameType == FDCAN_REMOTE_FRAME)
+            && (((bExtended == true) ? m_u32RejectRemoteExt : m_u32RejectRemoteStd) == FDCAN_REJECT_REMOTE)) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < u32Count; i++) {
+        if (bExtended == true) {
+            pu32Element = (const volatile uint32_t *)(uintptr_t)(hfdcan->msgRam.ExtendedFilterSA + (i * 8u));
+            u32Config = pu32Element[0] >> 29u;
+            u32Id1 = pu32Element[0] & 0x1FFFFFFFu;
+            u32Type = pu32Element[1] >> 30u;
+            u32Id2 = pu32Element[1] & 0x1FFFFFFFu;
+        } else {
+            pu32Element = (const volatile uint32_t *)(uintptr_t)(hfdcan->msgRam.StandardFilterSA + (i * 4u));
+            u32Type = pu32Element[0] >> 30u;
+            u32Config = (pu32Element[0] >> 27u) & 0x7u;
+            u32Id1 = (pu32Element[0] >> 16u) & 0x7FFu;
+            u32Id2 = pu32Element[0] & 0x7FFu;
+            if (u32Type == FDCAN_FILTER_RANGE_NO_EIDM) {
+                /* standard element disabled */
+                continue;
+            }
+        }
+        if ((u32Config == FDCAN_FILTER_DISABLE) || (bMatchId(u32Type, pstHeader->Identifier, u32Id1, u32Id2) == false)) {
+            continue;
+        }
+        pstHeader->FilterIndex = i;
+        pstHeader->IsFilterMatchingFrame = 0u;
+        return (u32Config == FDCAN_FILTER_TO_RXFIFO0) || (u32Config == FDCAN_FILTER_TO_RXFIFO0_HP);
+    }
+
+    pstHeader->FilterIndex = 0u;
+    pstHeader->IsFilterMatchingFrame = 1u;
+    return ((bExtended == true) ? m_u32NonMatchingExt : m_u32NonMatchingStd) == FDCAN_ACCEPT_IN_RX_FIFO0;
+}
+
+/**
+ * @brief  TX event fill level in TXEFS, read by the firmware without the HAL.
+ * @retval void
+ */
+static void vUpdateEventFillLevel(FDCAN_HandleTypeDef *hfdcan) {
+    __atomic_store_n(&hfdcan->Instance->TXEFS, m_u32EventCount & FDCAN_TXEFS_EFFL, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief  Sends the oldest frame of the TX FIFO, the other node returns it.
+ *         Called with m_stLock held.
+ * @retval void
+ */
+static void vTransmitFrame(FDCAN_HandleTypeDef *hfdcan) {
+
+    TwinFdcan_TxStruct_t *pstTx = &m_astTxFifo[m_u32TxHead];
+    TwinFdcan_RxStruct_t *pstRx;
+    FDCAN_TxEventFifoTypeDef *pstEvent;
+    uint32_t u32Counter = u32GetCounter();
+
+    m_u32TxHead = (m_u32TxHead + 1u) % hfdcan->Init.TxFifoQueueElmtsNbr;
+    m_u32TxCount--;
+
+    if (pstTx->stHeader.TxEventFifoControl == FDCAN_STORE_TX_EVENTS) {
+        if (m_u32EventCount == hfdcan->Init.TxEventsNbr) {
+            m_u32PendingTxEvent |= FDCAN_IT_TX_EVT_FIFO_ELT_LOST;
+        } else {
+            pstEvent = &m_astTxEvents[(m_u32EventHead + m_u32EventCount) % hfdcan->Init.TxEventsNbr];
+            pstEvent->Identifier = pstTx->stHeader.Identifier;
+            pstEvent->IdType = pstTx->stHeader.IdType;
+            pstEvent->TxFrameType = pstTx->stHeader.TxFrameType;
+            pstEvent->DataLength = pstTx->stHeader.DataLength;
+            pstEvent->ErrorStateIndicator = pstTx->stHeader.ErrorStateIndicator;
+            pstEvent->BitRateSwitch = pstTx->stHeader.BitRateSwitch;
+            pstEvent->FDFormat = pstTx->stHeader.FDFormat;
+            pstEvent->TxTimestamp = u32Counter;
+            pstEvent->MessageMarker = pstTx->stHeader.MessageMarker;
+            pstEvent->EventType = FDCAN_TX_EVENT;
+            m_u32EventCount++;
+            vUpdateEventFillLevel(hfdcan);
+            m_u32PendingTxEvent |= FDCAN_IT_TX_EVT_FIFO_NEW_DATA;
+        }
+    }
+
+    pstRx = &m_astRxFifo0[(m_u32RxHead + m_u32RxCount) % hfdcan->Init.RxFifo0ElmtsNbr];
+    pstRx->stHeader.Identifier = pstTx->stHeader.Identifier;
+    pstRx->stHeader.IdType = pstTx->stHeader.IdType;
+    pstRx->stHeader.RxFrameType = pstTx->stHeader.TxFrameType;
+    pstRx->stHeader.DataLength = pstTx->stHeader.DataLength;
+    pstRx->stHeader.ErrorStateIndicator = pstTx->stHeader.ErrorStateIndicator;
+    pstRx->stHeader.BitRateSwitch = pstTx->stHeader.BitRateSwitch;
+    pstRx->stHeader.FDFormat = pstTx->stHeader.FDFormat;
+    pstRx->stHeader.RxTimestamp = u32Counter;
+    if (bAcceptFrame(hfdcan, &pstRx->stHeader) == false) {
+        return;
+    }
+    /* blocking mode, a full FIFO loses the new frame */
+    if (m_u32RxCount == hfdcan->Init.RxFifo0ElmtsNbr) {
+        m_u32PendingRxFifo0 |= FDCAN_IT_RX_FIFO0_MESSAGE_LOST;
+        return;
+    }
+    memcpy(pstRx->au8Data, pstTx->au8Data, m_au8DLCTOBYTES[pstTx->stHeader.DataLength >> 16u]);
+    m_u32RxCount++;
+    m_u32PendingRxFifo0 |= FDCAN_IT_RX_FIFO0_NEW_MESSAGE;
+    if (m_u32RxCount == m_u32RxWatermark) {
+        m_u32PendingRxFifo0 |= FDCAN_IT_RX_FIFO0_WATERMARK;
+    }
+    if (m_u32RxCount == hfdcan->Init.RxFifo0ElmtsNbr) {
+        m_u32PendingRxFifo0 |= FDCAN_IT_RX_FIFO0_FULL;
+    }
+}
+
+/**
+ * @brief  The bus and the FDCAN2 interrupt. Sends the queued frames while
+ *         started and raises the enabled interrupts, the callbacks run
+ *         without m_stLock.
+ * @retval NULL
+ */
+static void *pvBusThread(void *pvArgument) {
+
+    FDCAN_HandleTypeDef *hfdcan = (FDCAN_HandleTypeDef *)pvArgument;
+    struct timespec stTimeout;
+    uint64_t u64Wraps;
+    uint32_t u32RxFifo0ITs;
+    uint32_t u32TxEventITs;
+    bool bWraparound;
+
+    pthread_mutex_lock(&m_stLock);
+    while (true) {
+        while ((hfdcan->State == HAL_FDCAN_STATE_BUSY) && (m_u32TxCount != 0u)) {
+            vTransmitFrame(hfdcan);
+        }
+        u64Wraps = (u64TwinHal_GetTimeNs() / m_u32TickNs) >> 16u;
+        if (u64Wraps != m_u64CounterWraps) {
+            m_u64CounterWraps = u64Wraps;
+            m_bPendingWraparound = m_bCounterEnabled;
+        }
+
+        u32RxFifo0ITs = m_u32PendingRxFifo0 & m_u32ActiveITs;
+        u32TxEventITs = m_u32PendingTxEvent & m_u32ActiveITs;
+        bWraparound = m_bPendingWraparound && ((m_u32ActiveITs & FDCAN_IT_TIMESTAMP_WRAPAROUND) != 0u);
+        m_u32PendingRxFifo0 = 0u;
+        m_u32PendingTxEvent = 0u;
+        m_bPendingWraparound = false;
+        if ((u32RxFifo0ITs != 0u) || (u32TxEventITs != 0u) || (bWraparound == true)) {
+            pthread_mutex_unlock(&m_stLock);
+            vTwinHal_EnterIrq(FDCAN2_IT0_IRQn);
+            if (bWraparound == true) {
+                HAL_FDCAN_TimestampWraparoundCallback(hfdcan);
+            }
+            if (u32TxEventITs != 0u) {
+                HAL_FDCAN_TxEventFifoCallback(hfdcan, u32TxEventITs);
+            }
+            if (u32RxFifo0ITs != 0u) {
+                HAL_FDCAN_RxFifo0Callback(hfdcan, u32RxFifo0ITs);
+            }
+            vTwinHal_ExitIrq(FDCAN2_IT0_IRQn);
+            pthread_mutex_lock(&m_stLock);
+            continue;
+        }
+
+        if ((hfdcan->State != HAL_FDCAN_STATE_BUSY) || (m_u32TxCount == 0u)) {
+            clock_gettime(CLOCK_MONOTONIC, &stTimeout);
+            stTimeout.tv_nsec += m_u32IDLENS;
+            if (stTimeout.tv_nsec >= 1000000000L) {
+                stTimeout.tv_sec++;
+                stTimeout.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&m_stWakeup, &m_stLock, &stTimeout);
+        }
+    }
+    return NULL;
+}
+
+/* HAL ------------------------------------------------------------------------*/
+HAL_StatusTypeDef HAL_FDCAN_Init(FDCAN_HandleTypeDef *hfdcan) {
+
+    pthread_condattr_t stAttr;
+
+    if ((hfdcan->Init.TxFifoQueueElmtsNbr == 0u) || (hfdcan->Init.TxFifoQueueElmtsNbr > m_u32TXFIFOMAX)
+            || (hfdcan->Init.RxFifo0ElmtsNbr == 0u) || (hfdcan->Init.RxFifo0ElmtsNbr > m_u32RXFIFOMAX)
+            || (hfdcan->Init.TxEventsNbr == 0u) || (hfdcan->Init.TxEventsNbr > m_u32TXEVENTMAX)) {
+        hfdcan->ErrorCode |= HAL_FDCAN_ERROR_PARAM;
+        return HAL_ERROR;
+    }
+    if (hfdcan->State == HAL_FDCAN_STATE_RESET) {
+        HAL_FDCAN_MspInit(hfdcan);
+    }
+
+    /* filter sections as placed by the HAL, the rest of the message RAM is not used */
+    hfdcan->msgRam.StandardFilterSA = SRAMCAN_BASE + (hfdcan->Init.MessageRAMOffset * 4u);
+    hfdcan->msgRam.ExtendedFilterSA = hfdcan->msgRam.StandardFilterSA + (hfdcan->Init.StdFiltersNbr * 4u);
+    m_u32TickNs = (uint32_t)(((uint64_t)1000000000u * hfdcan->Init.NominalPrescaler
+            * (1u + hfdcan->Init.NominalTimeSeg1 + hfdcan->Init.NominalTimeSeg2)) / m_u32TWINHAL_FDCANCLOCK);
+
+    if (m_bBusRunning == false) {
+        pthread_condattr_init(&stAttr);
+        pthread_condattr_setclock(&stAttr, CLOCK_MONOTONIC);
+        pthread_cond_init(&m_stWakeup, &stAttr);
+        pthread_condattr_destroy(&stAttr);
+        if (pthread_create(&m_stBusThread, NULL, pvBusThread, hfdcan) != 0) {
+            return HAL_ERROR;
+        }
+        m_bBusRunning = true;
+    }
+    hfdcan->ErrorCode = HAL_FDCAN_ERROR_NONE;
+    hfdcan->State = HAL_FDCAN_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FDCAN_ConfigTimestampCounter(FDCAN_HandleTypeDef *hfdcan, uint32_t TimestampPrescaler) {
+
+    if (hfdcan->State != HAL_FDCAN_STATE_READY) {
+        hfdcan->ErrorCode |= HAL_FDCAN_ERROR_NOT_READY;
+        return HAL_ERROR;
+    }
+    pthread_mutex_lock(&m_stLock);
+    m_u32TickNs *= (TimestampPrescaler >> 16u) + 1u;
+    pthread_mutex_unlock(&m_stLock);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FDCAN_EnableTimestampCounter(FDCAN_HandleTypeDef *hfdcan, uint32_t TimestampOperation) {
+
+    if (hfdcan->State != HAL_FDCAN_STATE_READY) {
+        hfdcan->ErrorCode |= HAL_FDCAN_ERROR_NOT_READY;
+        return HAL_ERROR;
+    }
+    pthread_mutex_lock(&m_stLock);
+    m_bCounterEnabled = (TimestampOperation == FDCAN_TIMESTAMP_INTERNAL);
+    pthread_mutex_unlock(&m_stLock);
+    return HAL_OK;
+}
+
+uint16_t HAL_FDCAN_GetTimestampCounter(FDCAN_HandleTypeDef *hfdcan) {
+    (void)hfdcan;
+    return (uint16_t)u32GetCounter();
+}
+
+HAL_StatusTypeDef HAL_FDCAN_ConfigFifoWatermark(FDCAN_HandleTypeDef *hfdcan, uint32_t FIFO, uint32_t Watermark) {
+
+    if (hfdcan->State != HAL_FDCAN_STATE_READY) {
+        hfdcan->ErrorCode |= HAL_FDCAN_ERROR_NOT_READY;
+        return HAL_ERROR;
+    }
+    if (FIFO == FDCAN_CFG_RX_FIFO0) {
+        pthread_mutex_lock(&m_stLock);
+        m_u32RxWatermark = Watermark;
+        pthread_mutex_unlock(&m_stLock);
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FDCAN_ActivateNotification(FDCAN_HandleTypeDef *hfdcan, uint32_t ActiveITs,
+        uint32_t BufferIndexes) {
+
+    (void)BufferIndexes;
+    if ((hfdcan->State != HAL_FDCAN_STATE_READY) && (hfdcan->State != HAL_FDCAN_STATE_BUSY)) {
+        hfdcan->ErrorCode |= HAL_FDCAN_ERROR_NOT_INITIALIZED;
+        return HAL_ERROR;
+    }
+    pthread_mutex_lock(&m_stLock);
+    m_u32ActiveITs |= ActiveITs;
+    pthread_mutex_unlock(&m_stLock);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FDCAN_ConfigFilter(FDCAN_HandleTypeDef *hfdcan, FDCAN_FilterTypeDef *sFilterConfig) {
+
+    volatile uint32_t *pu32Element;
+
+    if ((hfdcan->State != HAL_FDCAN_STATE_READY) && (hfdcan->State != HAL_FDCAN_STATE_BUSY)) {
+        hfdcan->ErrorCode |= HAL_FDCAN_ERROR_NOT_INITIALIZED;
+        return HAL_ERROR;
+    }
+    pthread_mutex_lock(&m_stLock);
+    if (sFilterConfig->IdType == FDCAN_STANDARD_ID) {
+        pu32Element = (volatile uint32_t *)(uintptr_t)(hfdcan->msgRam.StandardFilterSA + (sFilterConfig->FilterIndex * 4u));
+        pu32Element[0] = (sFilterConfig->FilterType << 30u) | (sFilterConfig->FilterConfig << 27u)
+                | (sFilterConfig->FilterID1 << 16u) | sFilterConfig->FilterID2;
+    } else {
+        pu32Element = (volatile uint32_t *)(uintptr_t)(hfdcan->msgRam.ExtendedFilterSA + (sFilterConfig->FilterIndex * 8u));
+        pu32Element[0] = (sFilterConfig->FilterConfig << 29u) | sFilterConfig->FilterID1;
+        pu32Element[1] = (sFilterConfig->FilterType << 30u) | sFilterConfig->FilterID2;
+    }
+    pthread_mutex_unlock(&m_stLock);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FDCAN_ConfigGlobalFilter(FDCAN_HandleTypeDef *hfdcan, uint32_t NonMatchingStd,
+        uint32_t NonMatchingExt, uint32_t RejectRemoteStd, uint32_t RejectRemoteExt) {
+
+    if (hfdcan->State != HAL_FDCAN_STATE_READY) {
+        hfdcan->ErrorCode |= HAL_FDCAN_ERROR_NOT_READY;
+        return HAL_ERROR;
+    }
+    pthread_mutex_lock(&m_stLock);
+    m_u32NonMatchingStd = NonMatchingStd;
+    m_u32NonMatchingExt = NonMatchingExt;
+    m_u32RejectRemoteStd = RejectRemoteStd;
+    m_u32RejectRemoteExt = RejectRemoteExt;
+    pthread_mutex_unlock(&m_stLock);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FDCAN_Start(FDCAN_HandleTypeDef *hfdcan) {
+
+    if (hfdcan->State != HAL_FDCAN_STATE_READY) {
+        hfdcan->ErrorCode |= HAL_FDCAN_ERROR_NOT_READY;
+        return HAL_ERROR;
+    }
+    pthread_mutex_lock(&m_stLock);
+    hfdcan->State = HAL_FDCAN_STATE_BUSY;
+    hfdcan->ErrorCode = HAL_FDCAN_ERROR_NONE;
+    pthread_cond_signal(&m_stWakeup);
+    pthread_mutex_unlock(&m_stLock);
+    return HAL_OK;
+}
+
+/* pending transmissions are cancelled */
+HAL_StatusTypeDef HAL_FDCAN_Stop(FDCAN_HandleTypeDef *hfdcan) {
+
+    if (hfdcan->State != HAL_FDCAN_STATE_BUSY) {
+        hfdcan->ErrorCode |= HAL_FDCAN_ERROR_NOT_STARTED;
+        return HAL_ERROR;
+    }
+    pthread_mutex_lock(&m_stLock);
+    m_u32TxHead = 0u;
+    m_u32TxCount = 0u;
+    hfdcan->State = HAL_FDCAN_STATE_READY;
+    pthread_mutex_unlock(&m_stLock);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FDCAN_AddMessageToTxFifoQ(FDCAN_HandleTypeDef *hfdcan, FDCAN_TxHeaderTypeDef *pTxHeader,
+        uint8_t *pTxData) {
+
+    TwinFdcan_TxStruct_t *pstTx;
+
+    if (hfdcan->State != HAL_FDCAN_STATE_BUSY) {
+        hfdcan->ErrorCode |= HAL_FDCAN_ERROR_NOT_STARTED;
+        return HAL_ERROR;
+    }
+    pthread_mutex_lock(&m_stLock);
+    if (m_u32TxCount == hfdcan->Init.TxFifoQueueElmtsNbr) {
+        pthread_mutex_unlock(&m_stLock);
+        hfdcan->ErrorCode |= HAL_FDCAN_ERROR_FIFO_FULL;
+        return HAL_ERROR;
+    }
+    pstTx = &m_astTxFifo[(m_u32TxHead + m_u32TxCount) % hfdcan->Init.TxFifoQueueElmtsNbr];
+    pstTx->stHeader = *pTxHeader;
+    memcpy(pstTx->au8Data, pTxData, m_au8DLCTOBYTES[pTxHeader->DataLength >> 16u]);
+    m_u32TxCount++;
+    pthread_cond_signal(&m_stWakeup);
+    pthread_mutex_unlock(&m_stLock);
+    return HAL_OK;
+}
+
+uint32_t HAL_FDCAN_GetTxFifoFreeLevel(FDCAN_HandleTypeDef *hfdcan) {
+
+    uint32_t u32Free;
+
+    pthread_mutex_lock(&m_stLock);
+    u32Free = hfdcan->Init.TxFifoQueueElmtsNbr - m_u32TxCount;
+    pthread_mutex_unlock(&m_stLock);
+    return u32Free;
+}
+
+uint32_t HAL_FDCAN_GetRxFifoFillLevel(FDCAN_HandleTypeDef *hfdcan, uint32_t RxFifo) {
+
+    uint32_t u32Fill;
+
+    (void)hfdcan;
+    if (RxFifo != FDCAN_RX_FIFO0) {
+        return 0u;
+    }
+    pthread_mutex_lock(&m_stLock);
+    u32Fill = m_u32RxCount;
+    pthread_mutex_unlock(&m_stLock);
+    return u32Fill;
+}
+
+HAL_StatusTypeDef HAL_FDCAN_GetRxMessage(FDCAN_HandleTypeDef *hfdcan, uint32_t RxLocation,
+        FDCAN_RxHeaderTypeDef *pRxHeader, uint8_t *pRxData) {
+
+    TwinFdcan_RxStruct_t *pstRx;
+
+    if (hfdcan->State != HAL_FDCAN_STATE_BUSY) {
+        hfdcan->ErrorCode |= HAL_FDCAN_ERROR_NOT_STARTED;
+        return HAL_ERROR;
+    }
+    if (RxLocation != FDCAN_RX_FIFO0) {
+        hfdcan->ErrorCode |= HAL_FDCAN_ERROR_NOT_SUPPORTED;
+        return HAL_ERROR;
+    }
+    pthread_mutex_lock(&m_stLock);
+    if (m_u32RxCount == 0u) {
+        pthread_mutex_unlock(&m_stLock);
+        hfdcan->ErrorCode |= HAL_FDCAN_ERROR_FIFO_EMPTY;
+        return HAL_ERROR;
+    }
+    pstRx = &m_astRxFifo0[m_u32RxHead];
+    *pRxHeader = pstRx->stHeader;
+    memcpy(pRxData, pstRx->au8Data, m_au8DLCTOBYTES[pstRx->stHeader.DataLength >> 16u]);
+    m_u32RxHead = (m_u32RxHead + 1u) % hfdcan->Init.RxFifo0ElmtsNbr;
+    m_u32RxCount--;
+    pthread_mutex_unlock(&m_stLock);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FDCAN_GetTxEvent(FDCAN_HandleTypeDef *hfdcan, FDCAN_TxEventFifoTypeDef *pTxEvent) {
+
+    if (hfdcan->State != HAL_FDCAN_STATE_BUSY) {
+        hfdcan->ErrorCode |= HAL_FDCAN_ERROR_NOT_STARTED;
+        return HAL_ERROR;
+    }
+    pthread_mutex_lock(&m_stLock);
+    if (m_u32EventCount == 0u) {
+        pthread_mutex_unlock(&m_stLock);
+        hfdcan->ErrorCode |= HAL_FDCAN_ERROR_FIFO_EMPTY;
+        return HAL_ERROR;
+    }
+    *pTxEvent = m_astTxEvents[m_u32EventHead];
+    m_u32EventHead = (m_u32EventHead + 1u) % hfdcan->Init.TxEventsNbr;
+    m_u32EventCount--;
+    vUpdateEventFillLevel(hfdcan);
+    pthread_mutex_unlock(&m_stLock);
+    return HAL_OK;
+}
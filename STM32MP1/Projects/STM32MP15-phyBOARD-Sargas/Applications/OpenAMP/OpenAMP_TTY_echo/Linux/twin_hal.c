@@ -0,0 +1,419 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Cortex-M4 core and the HAL stand-ins without own module of the host
+ *          twin of the firmware: memory map, clocks, PRIMASK, NVIC, GPIO, DMA,
+ *          the USART3 mirror and the LEDs. See twin_hal.h.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "twin_hal.h"
+#include "stm32mp1xx_hal.h"
+#include "stm32mp15xx_phyboard-sargas.h"
+#include "metal/sys.h"
+#include "metal/device.h"
+#include "pthread.h"
+#include "sched.h"
+#include "stdio.h"
+#include "string.h"
+#include "sys/mman.h"
+#include "time.h"
+
+/* Private define ------------------------------------------------------------*/
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+/* HAL version of Drivers/STM32MP1xx_HAL_Driver */
+#define m_u32HALVERSION ((uint32_t)0x01050000)
+/* peripherals and the private peripheral bus of the Cortex-M4 */
+#define m_u32PERIPHSTART ((uintptr_t)0x40000000)
+#define m_u32PERIPHSIZE ((size_t)0x20000000)
+#define m_u32COREPERIPHSTART ((uintptr_t)0xE0000000)
+#define m_u32COREPERIPHSIZE ((size_t)0x00100000)
+/* external interrupts of the NVIC */
+#define m_u32IRQLINES ((uint32_t)256)
+
+/* Private variables ---------------------------------------------------------*/
+uint32_t SystemCoreClock = m_u32TWINHAL_CORECLOCK;
+
+static struct timespec m_stStart;
+
+/* held by a handler or while PRIMASK is set */
+static pthread_mutex_t m_stCpuLock;
+static __thread uint32_t m_u32Primask = 0u;
+static __thread DWT_Type m_stDwt;
+
+static pthread_mutex_t m_stNvicLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t m_stNvicChanged = PTHREAD_COND_INITIALIZER;
+/* the last entry is shared by the core exceptions */
+static bool m_abIrqEnabled[m_u32IRQLINES + 1u];
+static bool m_abIrqActive[m_u32IRQLINES + 1u];
+
+/* USART3 mirror, the lines are discarded */
+static bool m_bUartTransmitting = false;
+static bool m_bUartCompleted = false;
+
+/* Private function prototypes -----------------------------------------------*/
+static bool bMapRegion(uintptr_t uAddress, size_t uSize);
+static uint32_t u32GetIrqLine(int32_t i32Irq);
+int __real_metal_init(const struct metal_init_params *params);
+int __wrap_metal_init(const struct metal_init_params *params);
+
+/**
+ * @brief  Maps zeroed memory at a fixed address of the Cortex-M4 memory map.
+ * @retval false in case the address range is in use.
+ */
+static bool bMapRegion(uintptr_t uAddress, size_t uSize) {
+
+    void *pvMap = mmap((void *)uAddress, uSize, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE, -1, 0);
+
+    if (pvMap == (void *)uAddress) {
+        return true;
+    }
+    if (pvMap != MAP_FAILED) {
+        munmap(pvMap, uSize);
+    }
+    fprintf(stderr, "twin: cannot map 0x%08lx\n", (unsigned long)uAddress);
+    return false;
+}
+
+/**
+ * @brief  NVIC line of an external interrupt, the core exceptions have none.
+ * @retval m_u32IRQLINES for the core exceptions.
+ */
+static uint32_t u32GetIrqLine(int32_t i32Irq) {
+    return ((i32Irq >= 0) && ((uint32_t)i32Irq < m_u32IRQLINES)) ? (uint32_t)i32Irq : m_u32IRQLINES;
+}
+
+/**
+ * @brief  Maps the peripheral registers at their addresses and starts the
+ *         clock. Call it before any firmware code.
+ * @retval false in case the memory map could not be set up.
+ */
+bool bTwinHal_Init(void) {
+
+    pthread_mutexattr_t stAttr;
+
+    pthread_mutexattr_init(&stAttr);
+    pthread_mutexattr_settype(&stAttr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&m_stCpuLock, &stAttr);
+    pthread_mutexattr_destroy(&stAttr);
+    clock_gettime(CLOCK_MONOTONIC, &m_stStart);
+
+    return (bMapRegion(m_u32PERIPHSTART, m_u32PERIPHSIZE) == true)
+            && (bMapRegion(m_u32COREPERIPHSTART, m_u32COREPERIPHSIZE) == true);
+}
+
+/**
+ * @brief  Time since bTwinHal_Init(), the clock of all twin peripherals.
+ * @retval time in ns
+ */
+uint64_t u64TwinHal_GetTimeNs(void) {
+
+    struct timespec stNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &stNow);
+    return (uint64_t)(stNow.tv_sec - m_stStart.tv_sec) * 1000000000u + (uint64_t)stNow.tv_nsec
+            - (uint64_t)m_stStart.tv_nsec;
+}
+
+/**
+ * @brief  Enters the handler of an interrupt, waits while its line is disabled
+ *         or PRIMASK is set. Every interrupt has its own thread.
+ * @retval void
+ */
+void vTwinHal_EnterIrq(int32_t i32Irq) {
+
+    uint32_t u32Line = u32GetIrqLine(i32Irq);
+
+    pthread_mutex_lock(&m_stNvicLock);
+    while (true) {
+        while (m_abIrqEnabled[u32Line] == false) {
+            pthread_cond_wait(&m_stNvicChanged, &m_stNvicLock);
+        }
+        pthread_mutex_unlock(&m_stNvicLock);
+        pthread_mutex_lock(&m_stCpuLock);
+        pthread_mutex_lock(&m_stNvicLock);
+        if (m_abIrqEnabled[u32Line] == true) {
+            break;
+        }
+        /* disabled while waiting for PRIMASK */
+        pthread_mutex_unlock(&m_stCpuLock);
+    }
+    m_abIrqActive[u32Line] = true;
+    pthread_mutex_unlock(&m_stNvicLock);
+}
+
+/**
+ * @brief  Leaves the handler entered with vTwinHal_EnterIrq().
+ * @retval void
+ */
+void vTwinHal_ExitIrq(int32_t i32Irq) {
+
+    uint32_t u32Line = u32GetIrqLine(i32Irq);
+
+    pthread_mutex_lock(&m_stNvicLock);
+    m_abIrqActive[u32Line] = false;
+    pthread_cond_broadcast(&m_stNvicChanged);
+    pthread_mutex_unlock(&m_stNvicLock);
+    pthread_mutex_unlock(&m_stCpuLock);
+}
+
+/**
+ * @brief  __DMB(), orders the memory accesses of the interrupt threads.
+ * @retval void
+ */
+void vTwinHal_Fence(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief  __disable_irq(), waits for a running handler.
+ * @retval void
+ */
+void vTwinHal_DisableIrq(void) {
+
+    if (m_u32Primask == 0u) {
+        pthread_mutex_lock(&m_stCpuLock);
+        m_u32Primask = 1u;
+    }
+}
+
+/**
+ * @brief  __get_PRIMASK() of the calling thread.
+ * @retval 1 while the interrupts are disabled.
+ */
+uint32_t u32TwinHal_GetPrimask(void) {
+    return m_u32Primask;
+}
+
+/**
+ * @brief  __set_PRIMASK(), restores a value of u32TwinHal_GetPrimask().
+ * @retval void
+ */
+void vTwinHal_SetPrimask(uint32_t u32Primask) {
+
+    if ((u32Primask & 1u) != 0u) {
+        vTwinHal_DisableIrq();
+    } else if (m_u32Primask != 0u) {
+        m_u32Primask = 0u;
+        pthread_mutex_unlock(&m_stCpuLock);
+    }
+}
+
+/**
+ * @brief  __WFI(), lets the handler threads run instead of waiting for one.
+ * @retval void
+ */
+void vTwinHal_Wfi(void) {
+    sched_yield();
+}
+
+/**
+ * @brief  DWT of the calling thread, CYCCNT counts SystemCoreClock cycles.
+ * @retval pointer to the DWT registers.
+ */
+DWT_Type *pstTwinHal_GetDwt(void) {
+
+    m_stDwt.CYCCNT = (uint32_t)(u64TwinHal_GetTimeNs() * (m_u32TWINHAL_CORECLOCK / 1000000u) / 1000u);
+    return &m_stDwt;
+}
+
+/**
+ * @brief  Linux libmetal does not register the generic bus of the firmware
+ *         shared memory device, linked with -Wl,--wrap=metal_init.
+ * @retval 0 on success.
+ */
+int __wrap_metal_init(const struct metal_init_params *params) {
+
+    int iResult = __real_metal_init(params);
+
+    return (iResult == 0) ? metal_bus_register(&metal_generic_bus) : iResult;
+}
+
+/* HAL ------------------------------------------------------------------------*/
+HAL_StatusTypeDef HAL_Init(void) {
+    HAL_MspInit();
+    return HAL_OK;
+}
+
+uint32_t HAL_GetTick(void) {
+    return (uint32_t)(u64TwinHal_GetTimeNs() / 1000000u);
+}
+
+void HAL_Delay(uint32_t Delay) {
+
+    struct timespec stDelay = { (time_t)(Delay / 1000u), (long)(Delay % 1000u) * 1000000L };
+
+    nanosleep(&stDelay, NULL);
+}
+
+uint32_t HAL_GetHalVersion(void) {
+    return m_u32HALVERSION;
+}
+
+/* the clock tree is set by Linux, only the engineering boot mode configures it */
+HAL_StatusTypeDef HAL_RCC_DeInit(void) {
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct) {
+    (void)RCC_OscInitStruct;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct) {
+    (void)RCC_ClkInitStruct;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit) {
+    (void)PeriphClkInit;
+    return HAL_OK;
+}
+
+uint32_t HAL_RCCEx_GetPeriphCLKFreq(uint64_t PeriphClk) {
+    return (PeriphClk == RCC_PERIPHCLK_FDCAN) ? m_u32TWINHAL_FDCANCLOCK : 0u;
+}
+
+void HAL_PWR_EnableBkUpAccess(void) {
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority) {
+    (void)IRQn;
+    (void)PreemptPriority;
+    (void)SubPriority;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn) {
+
+    uint32_t u32Line = u32GetIrqLine(IRQn);
+
+    pthread_mutex_lock(&m_stNvicLock);
+    m_abIrqEnabled[u32Line] = true;
+    pthread_cond_broadcast(&m_stNvicChanged);
+    pthread_mutex_unlock(&m_stNvicLock);
+}
+
+/* returns after a running handler of the line */
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn) {
+
+    uint32_t u32Line = u32GetIrqLine(IRQn);
+
+    pthread_mutex_lock(&m_stNvicLock);
+    m_abIrqEnabled[u32Line] = false;
+    while ((m_abIrqActive[u32Line] == true) && (m_u32Primask == 0u)) {
+        pthread_cond_wait(&m_stNvicChanged, &m_stNvicLock);
+    }
+    pthread_mutex_unlock(&m_stNvicLock);
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init) {
+    (void)GPIOx;
+    (void)GPIO_Init;
+}
+
+void HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin) {
+    (void)GPIOx;
+    (void)GPIO_Pin;
+}
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma) {
+    hdma->State = HAL_DMA_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma) {
+    hdma->State = HAL_DMA_STATE_RESET;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart) {
+
+    if (huart->gState == HAL_UART_STATE_RESET) {
+        HAL_UART_MspInit(huart);
+    }
+    huart->gState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_SetTxFifoThreshold(UART_HandleTypeDef *huart, uint32_t Threshold) {
+    (void)huart;
+    (void)Threshold;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_SetRxFifoThreshold(UART_HandleTypeDef *huart, uint32_t Threshold) {
+    (void)huart;
+    (void)Threshold;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_DisableFifoMode(UART_HandleTypeDef *huart) {
+    (void)huart;
+    return HAL_OK;
+}
+
+/* the transfer completes at once, a transfer started by the complete callback
+ * is completed after it returns instead of recursively */
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size) {
+
+    (void)pData;
+    (void)Size;
+    if (m_bUartTransmitting == true) {
+        m_bUartCompleted = true;
+        return HAL_OK;
+    }
+    m_bUartTransmitting = true;
+    do {
+        m_bUartCompleted = false;
+        HAL_UART_TxCpltCallback(huart);
+    } while (m_bUartCompleted == true);
+    m_bUartTransmitting = false;
+    return HAL_OK;
+}
+
+/* the Cortex-A7 never holds a semaphore of the twin */
+HAL_StatusTypeDef HAL_HSEM_FastTake(uint32_t SemID) {
+    (void)SemID;
+    return HAL_OK;
+}
+
+void HAL_HSEM_Release(uint32_t SemID, uint32_t ProcessID) {
+    (void)SemID;
+    (void)ProcessID;
+}
+
+/* BSP ------------------------------------------------------------------------*/
+int32_t BSP_LED_Init(Led_TypeDef Led) {
+    (void)Led;
+    return BSP_ERROR_NONE;
+}
+
+int32_t BSP_LED_On(Led_TypeDef Led) {
+    (void)Led;
+    return BSP_ERROR_NONE;
+}
+
+int32_t BSP_LED_Off(Led_TypeDef Led) {
+    (void)Led;
+    return BSP_ERROR_NONE;
+}
+
+int32_t BSP_LED_Toggle(Led_TypeDef Led) {
+    (void)Led;
+    return BSP_ERROR_NONE;
+}
@@ -0,0 +1,64 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Cortex-M4 core of the host twin of the firmware, see twin_hal.c.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ *
+ * The firmware sources are compiled unchanged against the real HAL headers.
+ * The peripheral registers are plain memory at their addresses, the HAL
+ * functions the firmware calls are stand-ins. The interrupts of the twin are
+ * host threads calling the HAL callbacks: a handler runs while its NVIC line
+ * is enabled and PRIMASK is clear, disabling the line or setting PRIMASK waits
+ * for a running handler. Unlike on the Cortex-M4 the main loop keeps running
+ * while a handler runs.
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TWIN_HAL_H
+#define TWIN_HAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+/* not the current directory, #include_next of stm32mp1xx.h finds the real header behind -I. */
+#include <stm32mp1xx.h>
+#include "stdint.h"
+#include "stdbool.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* M4 clock of the production boot, set by the Linux clock tree */
+#define m_u32TWINHAL_CORECLOCK ((uint32_t)209000000)
+/* kernel clock of FDCAN2 returned by HAL_RCCEx_GetPeriphCLKFreq() */
+#define m_u32TWINHAL_FDCANCLOCK ((uint32_t)24000000)
+
+/* Exported functions prototypes ---------------------------------------------*/
+bool bTwinHal_Init(void);
+uint64_t u64TwinHal_GetTimeNs(void);
+
+void vTwinHal_EnterIrq(int32_t i32Irq);
+void vTwinHal_ExitIrq(int32_t i32Irq);
+
+void vTwinHal_Fence(void);
+void vTwinHal_DisableIrq(void);
+uint32_t u32TwinHal_GetPrimask(void);
+void vTwinHal_SetPrimask(uint32_t u32Primask);
+void vTwinHal_Wfi(void);
+DWT_Type *pstTwinHal_GetDwt(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TWIN_HAL_H */
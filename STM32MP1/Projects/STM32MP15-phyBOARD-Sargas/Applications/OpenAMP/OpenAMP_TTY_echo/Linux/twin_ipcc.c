@@ -0,0 +1,164 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   IPCC stand-in of the host twin of the firmware. The Cortex-A7 side
+ *          is the UNIX socket IPI of the generic Linux machine of open-amp
+ *          (apps/system/linux/machine/generic/platform_info.c), the twin is
+ *          its server. A notification is one byte carrying the vring id:
+ *            master -> twin  id 0 raises channel 1 (buffer free), id 1
+ *                            channel 2 (new message)
+ *            twin -> master  channel 1 sends id 0, channel 2 id 1
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "twin_hal.h"
+#include "stm32mp1xx_hal.h"
+#include "openamp_conf.h"
+#include "pthread.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "unistd.h"
+#include "sys/socket.h"
+#include "sys/un.h"
+
+/* Private define ------------------------------------------------------------*/
+#define m_pcIPCC_SOCKET "/tmp/openamp.event.0"
+
+/* Private variables ---------------------------------------------------------*/
+static int m_iSocket = -1;
+static pthread_t m_stRxThread;
+
+/* Private function prototypes -----------------------------------------------*/
+static int iWaitForMaster(const char *pcPath);
+static void vRaiseChannel(IPCC_HandleTypeDef *hipcc, uint32_t u32Channel);
+static void *pvRxThread(void *pvArgument);
+
+/**
+ * @brief  Listens on the IPI socket and accepts the master.
+ * @retval connected socket, -1 on error.
+ */
+static int iWaitForMaster(const char *pcPath) {
+
+    struct sockaddr_un stAddress;
+    int iListen;
+    int iSocket;
+
+    iListen = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (iListen < 0) {
+        return -1;
+    }
+    memset(&stAddress, 0, sizeof(stAddress));
+    stAddress.sun_family = AF_UNIX;
+    strncpy(stAddress.sun_path, pcPath, sizeof(stAddress.sun_path) - 1u);
+    unlink(pcPath);
+    if ((bind(iListen, (struct sockaddr *)&stAddress, sizeof(stAddress)) < 0) || (listen(iListen, 1) < 0)) {
+        close(iListen);
+        return -1;
+    }
+    printf("twin: waiting for the master on %s\n", pcPath);
+    iSocket = accept(iListen, NULL, NULL);
+    close(iListen);
+    return iSocket;
+}
+
+/**
+ * @brief  Calls the RX callback of a channel from the IPCC RX1 interrupt.
+ * @retval void
+ */
+static void vRaiseChannel(IPCC_HandleTypeDef *hipcc, uint32_t u32Channel) {
+
+    if (hipcc->ChannelCallbackRx[u32Channel] != NULL) {
+        hipcc->ChannelCallbackRx[u32Channel](hipcc, u32Channel, IPCC_CHANNEL_DIR_RX);
+    }
+}
+
+/**
+ * @brief  IPCC RX1 interrupt, raises the channels of the received
+ *         notifications. The twin ends with the master.
+ * @retval NULL
+ */
+static void *pvRxThread(void *pvArgument) {
+
+    IPCC_HandleTypeDef *hipcc = (IPCC_HandleTypeDef *)pvArgument;
+    uint8_t au8Ids[32];
+    ssize_t iLength;
+
+    while ((iLength = read(m_iSocket, au8Ids, sizeof(au8Ids))) > 0) {
+        vTwinHal_EnterIrq(IPCC_RX1_IRQn);
+        for (ssize_t i = 0; i < iLength; i++) {
+            if (au8Ids[i] != VRING1_ID) {
+                vRaiseChannel(hipcc, IPCC_CHANNEL_1);
+            }
+            if (au8Ids[i] != VRING0_ID) {
+                vRaiseChannel(hipcc, IPCC_CHANNEL_2);
+            }
+        }
+        vTwinHal_ExitIrq(IPCC_RX1_IRQn);
+    }
+    printf("twin: master disconnected\n");
+    exit(EXIT_SUCCESS);
+    return NULL;
+}
+
+/* HAL ------------------------------------------------------------------------*/
+/* returns once the master is connected */
+HAL_StatusTypeDef HAL_IPCC_Init(IPCC_HandleTypeDef *hipcc) {
+
+    if (hipcc->State == HAL_IPCC_STATE_RESET) {
+        HAL_IPCC_MspInit(hipcc);
+    }
+    m_iSocket = iWaitForMaster(m_pcIPCC_SOCKET);
+    if ((m_iSocket < 0) || (pthread_create(&m_stRxThread, NULL, pvRxThread, hipcc) != 0)) {
+        return HAL_ERROR;
+    }
+    hipcc->State = HAL_IPCC_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_IPCC_ActivateNotification(IPCC_HandleTypeDef *hipcc, uint32_t ChannelIndex,
+        IPCC_CHANNELDirTypeDef ChannelDir, ChannelCb cb) {
+
+    if ((hipcc->State != HAL_IPCC_STATE_READY) || (ChannelIndex >= IPCC_CHANNEL_NUMBER)) {
+        return HAL_ERROR;
+    }
+    if (ChannelDir == IPCC_CHANNEL_DIR_RX) {
+        hipcc->ChannelCallbackRx[ChannelIndex] = cb;
+    } else {
+        hipcc->ChannelCallbackTx[ChannelIndex] = cb;
+    }
+    return HAL_OK;
+}
+
+/* a notification is received completely before the next one */
+IPCC_CHANNELStatusTypeDef HAL_IPCC_GetChannelStatus(IPCC_HandleTypeDef const *const hipcc, uint32_t ChannelIndex,
+        IPCC_CHANNELDirTypeDef ChannelDir) {
+    (void)hipcc;
+    (void)ChannelIndex;
+    (void)ChannelDir;
+    return IPCC_CHANNEL_STATUS_FREE;
+}
+
+/* TX notifies the master, RX acknowledges a received notification */
+HAL_StatusTypeDef HAL_IPCC_NotifyCPU(IPCC_HandleTypeDef const *const hipcc, uint32_t ChannelIndex,
+        IPCC_CHANNELDirTypeDef ChannelDir) {
+
+    uint8_t u8Id = (ChannelIndex == IPCC_CHANNEL_1) ? VRING0_ID : VRING1_ID;
+
+    (void)hipcc;
+    if (ChannelDir == IPCC_CHANNEL_DIR_RX) {
+        return HAL_OK;
+    }
+    return (send(m_iSocket, &u8Id, 1u, MSG_NOSIGNAL) == 1) ? HAL_OK : HAL_ERROR;
+}
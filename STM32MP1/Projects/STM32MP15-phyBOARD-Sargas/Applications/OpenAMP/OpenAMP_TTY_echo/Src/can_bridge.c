@@ -0,0 +1,262 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   FreeRTOS tasks of the CAN bridge: ingest, format and rpmsg,
+ *          connected by a stream buffer of items and a message buffer of
+ *          complete messages. The task structure is described in can_bridge.h.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_bridge.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stream_buffer.h"
+#include "message_buffer.h"
+#include "string.h"
+
+/* Private define ------------------------------------------------------------*/
+/* format task to rpmsg task, a message was passed to the message buffer */
+#define m_u32EVENT_DATA ((uint32_t)0x100)
+/* header of a message in the message buffer: oldest cycles valid, oldest cycles */
+#define m_u32MESSAGEHEADERLENGTH ((uint32_t)8)
+
+#define m_u32INGESTSTACK ((uint32_t)(configMINIMAL_STACK_SIZE * 2))
+#define m_u32FORMATSTACK ((uint32_t)(configMINIMAL_STACK_SIZE * 4))
+#define m_u32RPMSGSTACK ((uint32_t)(configMINIMAL_STACK_SIZE * 8))
+
+/* Private variables ---------------------------------------------------------*/
+static const CanBridge_ConfigStruct_t *m_pstConfig = NULL;
+static CanBridge_StatsStruct_t m_stStats;
+
+static StreamBufferHandle_t m_hItems = NULL;
+static StaticStreamBuffer_t m_stItems;
+static uint8_t m_au8ItemStorage[(m_u32CANBRIDGE_ITEMLENGTH * m_u32CANBRIDGE_ITEMS) + 1u];
+
+static MessageBufferHandle_t m_hMessages = NULL;
+static StaticMessageBuffer_t m_stMessages;
+static uint8_t m_au8MessageStorage[m_u32CANBRIDGE_MESSAGEBUFFER + 1u];
+
+static TaskHandle_t m_hIngestTask = NULL;
+static TaskHandle_t m_hRpmsgTask = NULL;
+static StaticTask_t m_stIngestTask;
+static StaticTask_t m_stFormatTask;
+static StaticTask_t m_stRpmsgTask;
+static StackType_t m_axIngestStack[m_u32INGESTSTACK];
+static StackType_t m_axFormatStack[m_u32FORMATSTACK];
+static StackType_t m_axRpmsgStack[m_u32RPMSGSTACK];
+static StaticTask_t m_stIdleTask;
+static StackType_t m_axIdleStack[configMINIMAL_STACK_SIZE];
+
+/* items and messages are copied, keep the buffers of the tasks aligned for the callbacks */
+static uint64_t m_au64IngestItem[m_u32CANBRIDGE_ITEMLENGTH / sizeof(uint64_t)];
+static uint64_t m_au64FormatItem[m_u32CANBRIDGE_ITEMLENGTH / sizeof(uint64_t)];
+static uint8_t m_au8SendMessage[m_u32MESSAGEHEADERLENGTH + m_u32CANBRIDGE_MESSAGELENGTH];
+static uint8_t m_au8TxMessage[m_u32MESSAGEHEADERLENGTH + m_u32CANBRIDGE_MESSAGELENGTH];
+
+/* Private function prototypes -----------------------------------------------*/
+static void vIngestTask(void *pvParameters);
+static void vFormatTask(void *pvParameters);
+static void vRpmsgTask(void *pvParameters);
+
+/**
+ * @brief  Ingest task, drains the interrupt rings into the item stream after
+ *         every FDCAN interrupt. The first pass takes the frames received
+ *         before the scheduler started.
+ * @retval void
+ */
+static void vIngestTask(void *pvParameters) {
+
+    uint32_t u32Length = m_pstConfig->u32ItemLength;
+    uint32_t u32Items;
+
+    (void)pvParameters;
+    for (;;) {
+        while (m_pstConfig->pfnIngest(m_au64IngestItem) == true) {
+            if (xStreamBufferSpacesAvailable(m_hItems) < u32Length) {
+                m_stStats.u32ItemsDropped++;
+                continue;
+            }
+            (void)xStreamBufferSend(m_hItems, m_au64IngestItem, u32Length, 0);
+            u32Items = (uint32_t)xStreamBufferBytesAvailable(m_hItems) / u32Length;
+            if (u32Items > m_stStats.u32ItemsHighWater) {
+                m_stStats.u32ItemsHighWater = u32Items;
+            }
+        }
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+/**
+ * @brief  Format task, formats the items and flushes the partly filled
+ *         message once no further item is waiting.
+ * @retval void
+ */
+static void vFormatTask(void *pvParameters) {
+
+    uint32_t u32Length = m_pstConfig->u32ItemLength;
+    bool bPending = false;
+
+    (void)pvParameters;
+    for (;;) {
+        if (xStreamBufferReceive(m_hItems, m_au64FormatItem, u32Length,
+                (bPending == true) ? 0 : portMAX_DELAY) != u32Length) {
+            if (bPending == true) {
+                m_pstConfig->pfnFlush();
+                bPending = false;
+            }
+            continue;
+        }
+        m_pstConfig->pfnFormat(m_au64FormatItem);
+        bPending = true;
+    }
+}
+
+/**
+ * @brief  RPMsg task, services the mailbox and sends the messages of the
+ *         format task. A message which finds no free TX buffer is kept and
+ *         sent after the next event, in most cases the IPCC interrupt of
+ *         Linux returning buffers.
+ * @retval void
+ */
+static void vRpmsgTask(void *pvParameters) {
+
+    size_t xLength = 0;
+    uint32_t u32HasOldest;
+    uint32_t u32OldestCycles;
+
+    (void)pvParameters;
+    for (;;) {
+        m_pstConfig->pfnService();
+
+        for (;;) {
+            if (xLength == 0u) {
+                xLength = xMessageBufferReceive(m_hMessages, m_au8TxMessage, sizeof(m_au8TxMessage), 0);
+                if (xLength == 0u) {
+                    break;
+                }
+            }
+            memcpy(&u32HasOldest, &m_au8TxMessage[0], sizeof(u32HasOldest));
+            memcpy(&u32OldestCycles, &m_au8TxMessage[4], sizeof(u32OldestCycles));
+            if (m_pstConfig->pfnTransmit(&m_au8TxMessage[m_u32MESSAGEHEADERLENGTH],
+                    (uint32_t)xLength - m_u32MESSAGEHEADERLENGTH, (u32HasOldest != 0u) ? &u32OldestCycles : NULL) == false) {
+                m_stStats.u32TxBusy++;
+                break;
+            }
+            xLength = 0u;
+        }
+
+        (void)xTaskNotifyWait(0u, UINT32_MAX, NULL, portMAX_DELAY);
+    }
+}
+
+/**
+ * @brief  Creates the buffers and tasks and starts the scheduler.
+ * @retval false for an invalid configuration, otherwise only returns when
+ *         the scheduler is ended, which the host simulation does.
+ */
+bool bCanBridge_Run(const CanBridge_ConfigStruct_t *pstConfig) {
+
+    if ((pstConfig->u32ItemLength == 0u) || (pstConfig->u32ItemLength > m_u32CANBRIDGE_ITEMLENGTH)
+            || (pstConfig->pfnIngest == NULL) || (pstConfig->pfnFormat == NULL) || (pstConfig->pfnFlush == NULL)
+            || (pstConfig->pfnService == NULL) || (pstConfig->pfnTransmit == NULL)) {
+        return false;
+    }
+    m_pstConfig = pstConfig;
+    memset(&m_stStats, 0, sizeof(m_stStats));
+
+    /* a buffer keeps one byte of the storage free, the format task wakes up for a complete item */
+    m_hItems = xStreamBufferCreateStatic((pstConfig->u32ItemLength * m_u32CANBRIDGE_ITEMS) + 1u,
+            pstConfig->u32ItemLength, m_au8ItemStorage, &m_stItems);
+    m_hMessages = xMessageBufferCreateStatic(m_u32CANBRIDGE_MESSAGEBUFFER + 1u, m_au8MessageStorage, &m_stMessages);
+
+    m_hRpmsgTask = xTaskCreateStatic(vRpmsgTask, "rpmsg", m_u32RPMSGSTACK, NULL, m_u32CANBRIDGE_PRIORITY_RPMSG,
+            m_axRpmsgStack, &m_stRpmsgTask);
+    (void)xTaskCreateStatic(vFormatTask, "format", m_u32FORMATSTACK, NULL, m_u32CANBRIDGE_PRIORITY_FORMAT,
+            m_axFormatStack, &m_stFormatTask);
+    m_hIngestTask = xTaskCreateStatic(vIngestTask, "ingest", m_u32INGESTSTACK, NULL, m_u32CANBRIDGE_PRIORITY_INGEST,
+            m_axIngestStack, &m_stIngestTask);
+
+    vTaskStartScheduler();
+    return true;
+}
+
+/**
+ * @brief  Wakes the tasks handling u32Events, called by the FDCAN and IPCC
+ *         interrupts. Events before the scheduler started are picked up by
+ *         the first pass of the tasks.
+ * @retval void
+ */
+void vCanBridge_NotifyFromISR(uint32_t u32Events) {
+
+    BaseType_t xWoken = pdFALSE;
+
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
+        return;
+    }
+    if ((u32Events & m_u32CANBRIDGE_EVENT_RX) != 0u) {
+        vTaskNotifyGiveFromISR(m_hIngestTask, &xWoken);
+    }
+    if ((u32Events & (m_u32CANBRIDGE_EVENT_MAILBOX | m_u32CANBRIDGE_EVENT_TXSPACE)) != 0u) {
+        (void)xTaskNotifyFromISR(m_hRpmsgTask, u32Events, eSetBits, &xWoken);
+    }
+    portYIELD_FROM_ISR(xWoken);
+}
+
+/**
+ * @brief  Passes a complete message to the rpmsg task, called by the format
+ *         callbacks. Blocks while the message buffer is full.
+ * @param  pu32OldestCycles  dequeue stamp of the oldest frame in the message,
+ *                           NULL in case it carries no received frame.
+ * @retval false in case the message is too long.
+ */
+bool bCanBridge_Send(const uint8_t au8Message[], uint32_t u32Length, const uint32_t *pu32OldestCycles) {
+
+    uint32_t u32HasOldest = (pu32OldestCycles != NULL) ? 1u : 0u;
+    uint32_t u32OldestCycles = (pu32OldestCycles != NULL) ? *pu32OldestCycles : 0u;
+    size_t xLength = m_u32MESSAGEHEADERLENGTH + u32Length;
+
+    if (u32Length > m_u32CANBRIDGE_MESSAGELENGTH) {
+        return false;
+    }
+    memcpy(&m_au8SendMessage[0], &u32HasOldest, sizeof(u32HasOldest));
+    memcpy(&m_au8SendMessage[4], &u32OldestCycles, sizeof(u32OldestCycles));
+    memcpy(&m_au8SendMessage[m_u32MESSAGEHEADERLENGTH], au8Message, u32Length);
+
+    if (xMessageBufferSpacesAvailable(m_hMessages) < (xLength + sizeof(configMESSAGE_BUFFER_LENGTH_TYPE))) {
+        m_stStats.u32SendBlocked++;
+    }
+    (void)xMessageBufferSend(m_hMessages, m_au8SendMessage, xLength, portMAX_DELAY);
+    (void)xTaskNotify(m_hRpmsgTask, m_u32EVENT_DATA, eSetBits);
+    return true;
+}
+
+/**
+ * @brief  Copies the counters of the tasks.
+ * @retval void
+ */
+void vCanBridge_GetStats(CanBridge_StatsStruct_t *pstStats) {
+    *pstStats = m_stStats;
+}
+
+/**
+ * @brief  Memory of the idle task, all kernel objects are allocated statically.
+ * @retval void
+ */
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer,
+        uint32_t *pulIdleTaskStackSize) {
+
+    *ppxIdleTaskTCBBuffer = &m_stIdleTask;
+    *ppxIdleTaskStackBuffer = m_axIdleStack;
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
@@ -0,0 +1,205 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Encodes and dispatches the binary control channel commands. The
+ *          message layout is described in can_command.h.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_command.h"
+#include "string.h"
+
+/* Private function prototypes -----------------------------------------------*/
+static void vPutUint16(uint8_t au8Dest[], uint16_t u16Value);
+static uint16_t u16GetUint16(const uint8_t au8Src[]);
+static void vPutHeader(uint8_t au8Buffer[], uint8_t u8Command, uint16_t u16RequestId, uint16_t u16Length);
+static uint32_t u32Respond(uint8_t au8Response[], uint8_t u8Command, uint16_t u16RequestId,
+        CanCommand_Status_t eStatus, uint16_t u16DataLength);
+
+/**
+ * @brief  Writes a little endian 16 bit value.
+ * @retval void
+ */
+static void vPutUint16(uint8_t au8Dest[], uint16_t u16Value) {
+    au8Dest[0] = (uint8_t)u16Value;
+    au8Dest[1] = (uint8_t)(u16Value >> 8u);
+}
+
+/**
+ * @brief  Reads a little endian 16 bit value.
+ * @retval value
+ */
+static uint16_t u16GetUint16(const uint8_t au8Src[]) {
+    return (uint16_t)((uint16_t)au8Src[0] | ((uint16_t)au8Src[1] << 8u));
+}
+
+/**
+ * @brief  Writes a little endian 32 bit value.
+ * @retval void
+ */
+void vCanCommand_PutUint32(uint8_t au8Dest[], uint32_t u32Value) {
+    au8Dest[0] = (uint8_t)u32Value;
+    au8Dest[1] = (uint8_t)(u32Value >> 8u);
+    au8Dest[2] = (uint8_t)(u32Value >> 16u);
+    au8Dest[3] = (uint8_t)(u32Value >> 24u);
+}
+
+/**
+ * @brief  Reads a little endian 32 bit value.
+ * @retval value
+ */
+uint32_t u32CanCommand_GetUint32(const uint8_t au8Src[]) {
+    return (uint32_t)au8Src[0] | ((uint32_t)au8Src[1] << 8u) | ((uint32_t)au8Src[2] << 16u)
+            | ((uint32_t)au8Src[3] << 24u);
+}
+
+/**
+ * @brief  Writes a message header.
+ * @retval void
+ */
+static void vPutHeader(uint8_t au8Buffer[], uint8_t u8Command, uint16_t u16RequestId, uint16_t u16Length) {
+    vPutUint16(&au8Buffer[0], m_u16CANCOMMAND_MAGIC);
+    au8Buffer[2] = m_u8CANCOMMAND_VERSION;
+    au8Buffer[3] = u8Command;
+    vPutUint16(&au8Buffer[4], u16RequestId);
+    vPutUint16(&au8Buffer[6], u16Length);
+}
+
+/**
+ * @brief  Completes a response whose data was already written behind the status byte.
+ * @retval length of the response message
+ */
+static uint32_t u32Respond(uint8_t au8Response[], uint8_t u8Command, uint16_t u16RequestId,
+        CanCommand_Status_t eStatus, uint16_t u16DataLength) {
+
+    vPutHeader(au8Response, u8Command | m_u8CANCOMMAND_RESPONSE, u16RequestId, (uint16_t)(u16DataLength + 1u));
+    au8Response[m_u32CANCOMMAND_HEADERLENGTH] = (uint8_t)eStatus;
+    return m_u32CANCOMMAND_HEADERLENGTH + 1u + u16DataLength;
+}
+
+/**
+ * @brief  Checks if a control channel message is a binary command rather than
+ *         a text command. Text commands never start with the magic bytes.
+ * @retval true in case the message starts with m_u16CANCOMMAND_MAGIC.
+ */
+bool bCanCommand_IsCommand(const uint8_t au8Message[], uint32_t u32Size) {
+    return (u32Size >= 2u) && (u16GetUint16(au8Message) == m_u16CANCOMMAND_MAGIC);
+}
+
+/**
+ * @brief  Validates a request and calls the handler of its command. Every
+ *         request starting with the magic gets a response, errors are
+ *         reported in the status byte.
+ * @param  au8Response  buffer of m_u32CANCOMMAND_MAXLENGTH bytes
+ * @retval length of the response, 0 in case the message is no command.
+ */
+uint32_t u32CanCommand_Dispatch(const CanCommand_EntryStruct_t astTable[], uint32_t u32Entries,
+        const uint8_t au8Request[], uint32_t u32Size, uint8_t au8Response[]) {
+
+    const CanCommand_EntryStruct_t *pstEntry = NULL;
+    uint8_t *pu8Data = &au8Response[m_u32CANCOMMAND_HEADERLENGTH + 1u];
+    uint16_t u16DataLength = 0u;
+    CanCommand_Status_t eStatus;
+    uint16_t u16RequestId;
+    uint16_t u16Length;
+    uint8_t u8Command;
+
+    if ((bCanCommand_IsCommand(au8Request, u32Size) == false) || (u32Size < m_u32CANCOMMAND_HEADERLENGTH)) {
+        return 0u;
+    }
+    u8Command = au8Request[3];
+    u16RequestId = u16GetUint16(&au8Request[4]);
+    u16Length = u16GetUint16(&au8Request[6]);
+
+    if (au8Request[2] != m_u8CANCOMMAND_VERSION) {
+        pu8Data[0] = m_u8CANCOMMAND_VERSION;
+        return u32Respond(au8Response, u8Command, u16RequestId, CANCOMMAND_ERROR_VERSION, 1u);
+    }
+    if (((u8Command & m_u8CANCOMMAND_RESPONSE) != 0u) || (u32Size != (m_u32CANCOMMAND_HEADERLENGTH + u16Length))) {
+        return u32Respond(au8Response, u8Command, u16RequestId, CANCOMMAND_ERROR_LENGTH, 0u);
+    }
+
+    for (uint32_t i = 0; i < u32Entries; i++) {
+        if (astTable[i].u8Command == u8Command) {
+            pstEntry = &astTable[i];
+            break;
+        }
+    }
+    if (pstEntry == NULL) {
+        return u32Respond(au8Response, u8Command, u16RequestId, CANCOMMAND_ERROR_COMMAND, 0u);
+    }
+    if ((u16Length < pstEntry->u16MinLength) || (u16Length > pstEntry->u16MaxLength)) {
+        return u32Respond(au8Response, u8Command, u16RequestId, CANCOMMAND_ERROR_LENGTH, 0u);
+    }
+
+    eStatus = pstEntry->pfnHandler(&au8Request[m_u32CANCOMMAND_HEADERLENGTH], u16Length, pu8Data, &u16DataLength);
+    if ((eStatus != CANCOMMAND_OK) || (u16DataLength >= m_u32CANCOMMAND_MAXPAYLOAD)) {
+        u16DataLength = 0u;
+    }
+    return u32Respond(au8Response, u8Command, u16RequestId, eStatus, u16DataLength);
+}
+
+/**
+ * @brief  Builds a request message, used by the Linux client.
+ * @param  au8Buffer  buffer of m_u32CANCOMMAND_HEADERLENGTH + u16Length bytes
+ * @retval length of the request, 0 in case the payload is too long.
+ */
+uint32_t u32CanCommand_BuildRequest(uint8_t au8Buffer[], uint8_t u8Command, uint16_t u16RequestId,
+        const uint8_t au8Payload[], uint16_t u16Length) {
+
+    if (u16Length > m_u32CANCOMMAND_MAXPAYLOAD) {
+        return 0u;
+    }
+    vPutHeader(au8Buffer, u8Command, u16RequestId, u16Length);
+    if (u16Length != 0u) {
+        memcpy(&au8Buffer[m_u32CANCOMMAND_HEADERLENGTH], au8Payload, u16Length);
+    }
+    return m_u32CANCOMMAND_HEADERLENGTH + u16Length;
+}
+
+/**
+ * @brief  Parses the response at the start of a byte stream, used by the
+ *         Linux client. The data pointer refers into au8Message.
+ * @retval length of the response, 0 in case more data is needed,
+ *         -1 in case the stream does not start with a valid response.
+ */
+int32_t i32CanCommand_ParseResponse(const uint8_t au8Message[], uint32_t u32Size, CanCommand_ResponseStruct_t *pstResponse) {
+
+    uint16_t u16Length;
+
+    if (u32Size < 2u) {
+        return 0;
+    }
+    if (bCanCommand_IsCommand(au8Message, u32Size) == false) {
+        return -1;
+    }
+    if (u32Size < m_u32CANCOMMAND_HEADERLENGTH) {
+        return 0;
+    }
+    u16Length = u16GetUint16(&au8Message[6]);
+    if ((au8Message[2] != m_u8CANCOMMAND_VERSION) || ((au8Message[3] & m_u8CANCOMMAND_RESPONSE) == 0u)
+            || (u16Length == 0u) || (u16Length > m_u32CANCOMMAND_MAXPAYLOAD)) {
+        return -1;
+    }
+    if (u32Size < (m_u32CANCOMMAND_HEADERLENGTH + u16Length)) {
+        return 0;
+    }
+
+    pstResponse->u8Command = au8Message[3] & (uint8_t)~m_u8CANCOMMAND_RESPONSE;
+    pstResponse->u16RequestId = u16GetUint16(&au8Message[4]);
+    pstResponse->eStatus = (CanCommand_Status_t)au8Message[m_u32CANCOMMAND_HEADERLENGTH];
+    pstResponse->pu8Data = &au8Message[m_u32CANCOMMAND_HEADERLENGTH + 1u];
+    pstResponse->u16DataLength = (uint16_t)(u16Length - 1u);
+    return (int32_t)(m_u32CANCOMMAND_HEADERLENGTH + u16Length);
+}
@@ -0,0 +1,282 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Parses the "filter" control messages into an acceptance filter
+ *          table and encodes the FDCAN filter elements. The message syntax is
+ *          described in can_filter.h.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_filter.h"
+#include "string.h"
+
+/* Private define ------------------------------------------------------------*/
+#define m_u32MAXTOKENS ((uint32_t)6)
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+    const uint8_t *pu8Start;
+    uint32_t u32Length;
+} Token_Struct_t;
+
+/* Private const -------------------------------------------------------------*/
+static const char * const m_apcRESULTTEXT[] = {
+    "no command", "added", "applied", "cleared", "syntax error", "identifier out of range", "table full"
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t u32Tokenize(const uint8_t au8Message[], uint16_t u16Size, Token_Struct_t astTokens[]);
+static bool bTokenIs(const Token_Struct_t *pstToken, const char *pcWord);
+static bool bParseNumber(const Token_Struct_t *pstToken, uint32_t *pu32Value);
+
+/**
+ * @brief  Splits the message at blanks, tabs and line ends. A trailing zero
+ *         terminates the message.
+ * @retval number of tokens, m_u32MAXTOKENS + 1 in case there are more.
+ */
+static uint32_t u32Tokenize(const uint8_t au8Message[], uint16_t u16Size, Token_Struct_t astTokens[]) {
+
+    uint32_t u32Count = 0u;
+    uint32_t i = 0u;
+
+    while ((i < u16Size) && (au8Message[i] != 0u)) {
+        if ((au8Message[i] == ' ') || (au8Message[i] == '\t') || (au8Message[i] == '\r') || (au8Message[i] == '\n')) {
+            i++;
+            continue;
+        }
+        if (u32Count == m_u32MAXTOKENS) {
+            return m_u32MAXTOKENS + 1u;
+        }
+        astTokens[u32Count].pu8Start = &au8Message[i];
+        while ((i < u16Size) && (au8Message[i] != 0u) && (au8Message[i] != ' ') && (au8Message[i] != '\t')
+                && (au8Message[i] != '\r') && (au8Message[i] != '\n')) {
+            i++;
+        }
+        astTokens[u32Count].u32Length = (uint32_t)(&au8Message[i] - astTokens[u32Count].pu8Start);
+        u32Count++;
+    }
+    return u32Count;
+}
+
+/**
+ * @brief  Compares a token with a keyword.
+ * @retval true in case they are equal.
+ */
+static bool bTokenIs(const Token_Struct_t *pstToken, const char *pcWord) {
+    return (strlen(pcWord) == pstToken->u32Length) && (memcmp(pstToken->pu8Start, pcWord, pstToken->u32Length) == 0);
+}
+
+/**
+ * @brief  Converts a decimal or 0x prefixed hexadecimal token.
+ * @retval false in case the token is no number or exceeds 32 bit.
+ */
+static bool bParseNumber(const Token_Struct_t *pstToken, uint32_t *pu32Value) {
+
+    const uint8_t *pu8Char = pstToken->pu8Start;
+    uint32_t u32Length = pstToken->u32Length;
+    uint32_t u32Base = 10u;
+    uint64_t u64Value = 0u;
+    uint32_t u32Digit;
+
+    if ((u32Length > 2u) && (pu8Char[0] == '0') && ((pu8Char[1] == 'x') || (pu8Char[1] == 'X'))) {
+        u32Base = 16u;
+        pu8Char += 2;
+        u32Length -= 2u;
+    }
+    if ((u32Length == 0u) || (u32Length > 10u)) {
+        return false;
+    }
+
+    while (u32Length-- != 0u) {
+        if ((*pu8Char >= '0') && (*pu8Char <= '9')) {
+            u32Digit = (uint32_t)(*pu8Char - '0');
+        } else if ((u32Base == 16u) && (*pu8Char >= 'a') && (*pu8Char <= 'f')) {
+            u32Digit = (uint32_t)(*pu8Char - 'a') + 10u;
+        } else if ((u32Base == 16u) && (*pu8Char >= 'A') && (*pu8Char <= 'F')) {
+            u32Digit = (uint32_t)(*pu8Char - 'A') + 10u;
+        } else {
+            return false;
+        }
+        u64Value = (u64Value * u32Base) + u32Digit;
+        pu8Char++;
+    }
+    if (u64Value > UINT32_MAX) {
+        return false;
+    }
+
+    *pu32Value = (uint32_t)u64Value;
+    return true;
+}
+
+/**
+ * @brief  Empties the filter table.
+ * @retval void
+ */
+void vCanFilter_Init(CanFilter_TableStruct_t *pstTable) {
+    memset(pstTable, 0, sizeof(*pstTable));
+}
+
+/**
+ * @brief  Handles one control message. Rules are only collected in the table,
+ *         the caller programs the hardware on CANFILTER_APPLY and CANFILTER_CLEARED.
+ * @retval CANFILTER_NOCOMMAND in case the message does not start with "filter".
+ */
+CanFilter_Result_t eCanFilter_Parse(CanFilter_TableStruct_t *pstTable, const uint8_t au8Message[], uint16_t u16Size) {
+
+    Token_Struct_t astTokens[m_u32MAXTOKENS];
+    CanFilter_RuleStruct_t stRule;
+    uint32_t u32Tokens = u32Tokenize(au8Message, u16Size, astTokens);
+    bool bExtended;
+
+    if ((u32Tokens == 0u) || (bTokenIs(&astTokens[0], "filter") == false)) {
+        return CANFILTER_NOCOMMAND;
+    }
+
+    if (u32Tokens == 2u) {
+        if (bTokenIs(&astTokens[1], "apply") == true) {
+            return CANFILTER_APPLY;
+        }
+        if (bTokenIs(&astTokens[1], "clear") == true) {
+            vCanFilter_Init(pstTable);
+            return CANFILTER_CLEARED;
+        }
+        return CANFILTER_ERROR_SYNTAX;
+    }
+
+    /* filter std|ext <type> <id1> <id2> [reject] */
+    if ((u32Tokens < 5u) || (u32Tokens > 6u)) {
+        return CANFILTER_ERROR_SYNTAX;
+    }
+
+    if (bTokenIs(&astTokens[1], "std") == true) {
+        bExtended = false;
+    } else if (bTokenIs(&astTokens[1], "ext") == true) {
+        bExtended = true;
+    } else {
+        return CANFILTER_ERROR_SYNTAX;
+    }
+
+    if (bTokenIs(&astTokens[2], "mask") == true) {
+        stRule.u8Type = m_u8CANFILTER_TYPE_MASK;
+    } else if (bTokenIs(&astTokens[2], "range") == true) {
+        stRule.u8Type = m_u8CANFILTER_TYPE_RANGE;
+    } else if (bTokenIs(&astTokens[2], "dual") == true) {
+        stRule.u8Type = m_u8CANFILTER_TYPE_DUAL;
+    } else {
+        return CANFILTER_ERROR_SYNTAX;
+    }
+
+    if ((bParseNumber(&astTokens[3], &stRule.u32Id1) == false)
+            || (bParseNumber(&astTokens[4], &stRule.u32Id2) == false)) {
+        return CANFILTER_ERROR_SYNTAX;
+    }
+
+    stRule.u8Config = m_u8CANFILTER_CONFIG_RXFIFO0;
+    if (u32Tokens == 6u) {
+        if (bTokenIs(&astTokens[5], "reject") == false) {
+            return CANFILTER_ERROR_SYNTAX;
+        }
+        stRule.u8Config = m_u8CANFILTER_CONFIG_REJECT;
+    }
+
+    return eCanFilter_Add(pstTable, bExtended, &stRule);
+}
+
+/**
+ * @brief  Appends a rule behind the rules of its identifier type.
+ * @retval CANFILTER_ADDED, CANFILTER_ERROR_RANGE for an invalid rule,
+ *         CANFILTER_ERROR_FULL in case no filter element is left.
+ */
+CanFilter_Result_t eCanFilter_Add(CanFilter_TableStruct_t *pstTable, bool bExtended, const CanFilter_RuleStruct_t *pstRule) {
+
+    uint32_t u32IdMax = (bExtended == true) ? m_u32CANFILTER_EXTIDMAX : m_u32CANFILTER_STDIDMAX;
+
+    if ((pstRule->u32Id1 > u32IdMax) || (pstRule->u32Id2 > u32IdMax)
+            || (pstRule->u8Type > m_u8CANFILTER_TYPE_MASK)
+            || ((pstRule->u8Config != m_u8CANFILTER_CONFIG_RXFIFO0) && (pstRule->u8Config != m_u8CANFILTER_CONFIG_REJECT))
+            || ((pstRule->u8Type == m_u8CANFILTER_TYPE_RANGE) && (pstRule->u32Id1 > pstRule->u32Id2))) {
+        return CANFILTER_ERROR_RANGE;
+    }
+
+    if (bExtended == false) {
+        if (pstTable->u32StdCount >= m_u32CANFILTER_STDCOUNT) {
+            return CANFILTER_ERROR_FULL;
+        }
+        pstTable->astStd[pstTable->u32StdCount++] = *pstRule;
+    } else {
+        if (pstTable->u32ExtCount >= m_u32CANFILTER_EXTCOUNT) {
+            return CANFILTER_ERROR_FULL;
+        }
+        pstTable->astExt[pstTable->u32ExtCount++] = *pstRule;
+    }
+    return CANFILTER_ADDED;
+}
+
+/**
+ * @brief  Checks if any rule stores matching frames. Decides whether frames
+ *         matching no rule are rejected by the global filter.
+ * @retval true in case at least one rule accepts frames.
+ */
+bool bCanFilter_HasAcceptRule(const CanFilter_RuleStruct_t astRules[], uint32_t u32Count) {
+
+    for (uint32_t i = 0; i < u32Count; i++) {
+        if (astRules[i].u8Config == m_u8CANFILTER_CONFIG_RXFIFO0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief  Encodes a standard filter element (SFT[31:30] SFEC[29:27]
+ *         SFID1[26:16] SFID2[10:0]) as HAL_FDCAN_ConfigFilter() writes it.
+ * @retval message RAM word of the element, NULL encodes a disabled element.
+ */
+uint32_t u32CanFilter_EncodeStd(const CanFilter_RuleStruct_t *pstRule) {
+
+    if (pstRule == NULL) {
+        return 0u;
+    }
+    return ((uint32_t)pstRule->u8Type << 30u) | ((uint32_t)pstRule->u8Config << 27u)
+            | ((pstRule->u32Id1 & m_u32CANFILTER_STDIDMAX) << 16u) | (pstRule->u32Id2 & m_u32CANFILTER_STDIDMAX);
+}
+
+/**
+ * @brief  Encodes an extended filter element (F0: EFEC[31:29] EFID1[28:0],
+ *         F1: EFT[31:30] EFID2[28:0]) as HAL_FDCAN_ConfigFilter() writes it.
+ *         NULL encodes a disabled element.
+ * @retval void
+ */
+void vCanFilter_EncodeExt(const CanFilter_RuleStruct_t *pstRule, uint32_t au32Element[2]) {
+
+    if (pstRule == NULL) {
+        au32Element[0] = 0u;
+        au32Element[1] = 0u;
+        return;
+    }
+    au32Element[0] = ((uint32_t)pstRule->u8Config << 29u) | (pstRule->u32Id1 & m_u32CANFILTER_EXTIDMAX);
+    au32Element[1] = ((uint32_t)pstRule->u8Type << 30u) | (pstRule->u32Id2 & m_u32CANFILTER_EXTIDMAX);
+}
+
+/**
+ * @brief  Short description of a parse result for the control channel reply.
+ * @retval zero terminated text.
+ */
+const char *pcCanFilter_ResultText(CanFilter_Result_t eResult) {
+
+    if ((uint32_t)eResult >= (sizeof(m_apcRESULTTEXT) / sizeof(m_apcRESULTTEXT[0]))) {
+        return "";
+    }
+    return m_apcRESULTTEXT[eResult];
+}
@@ -0,0 +1,168 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Collects the per stage latency statistics and encodes them for the
+ *          GETLATENCY command. The stages are described in can_latency.h.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_latency.h"
+#include "can_command.h"
+#include "string.h"
+
+/* Private const -------------------------------------------------------------*/
+static const char * const m_apcSTAGENAME[CANLATENCY_STAGE_COUNT] = {
+    "queue", "format", "acquire", "kick", "total"
+};
+
+/**
+ * @brief  Clears all stages.
+ * @retval void
+ */
+void vCanLatency_Init(CanLatency_Struct_t *pstLatency) {
+
+    memset(pstLatency, 0, sizeof(*pstLatency));
+    for (uint32_t i = 0; i < CANLATENCY_STAGE_COUNT; i++) {
+        pstLatency->astStages[i].u32Min = UINT32_MAX;
+    }
+}
+
+/**
+ * @brief  Histogram bucket of a duration, see can_latency.h.
+ * @retval bucket index
+ */
+uint32_t u32CanLatency_GetBucket(uint32_t u32Cycles) {
+
+    uint32_t u32Log2;
+
+    if ((u32Cycles >> (m_u32CANLATENCY_FIRSTSHIFT + 1u)) == 0u) {
+        return 0u;
+    }
+    u32Log2 = 31u - (uint32_t)__builtin_clz(u32Cycles);
+    if ((u32Log2 - m_u32CANLATENCY_FIRSTSHIFT) >= m_u32CANLATENCY_BUCKETS) {
+        return m_u32CANLATENCY_BUCKETS - 1u;
+    }
+    return u32Log2 - m_u32CANLATENCY_FIRSTSHIFT;
+}
+
+/**
+ * @brief  Adds one measurement, called from the main loop only.
+ * @retval void
+ */
+void vCanLatency_Add(CanLatency_Struct_t *pstLatency, CanLatency_Stage_t eStage, uint32_t u32Cycles) {
+
+    CanLatency_StageStruct_t *pstStage = &pstLatency->astStages[eStage];
+
+    pstStage->u32Count++;
+    pstStage->u64Sum += u32Cycles;
+    if (u32Cycles < pstStage->u32Min) {
+        pstStage->u32Min = u32Cycles;
+    }
+    if (u32Cycles > pstStage->u32Max) {
+        pstStage->u32Max = u32Cycles;
+    }
+    pstStage->au32Buckets[u32CanLatency_GetBucket(u32Cycles)]++;
+}
+
+/**
+ * @brief  Average duration of a stage.
+ * @retval cycles, 0 without measurements.
+ */
+uint32_t u32CanLatency_GetAverage(const CanLatency_StageStruct_t *pstStage) {
+
+    if (pstStage->u32Count == 0u) {
+        return 0u;
+    }
+    return (uint32_t)(pstStage->u64Sum / pstStage->u32Count);
+}
+
+/**
+ * @brief  Encodes the GETLATENCY response data. A stage without measurements
+ *         reports min 0.
+ * @param  au8Data  buffer of m_u32CANLATENCY_HEADERLENGTH
+ *                  + CANLATENCY_STAGE_COUNT * m_u32CANLATENCY_STAGELENGTH bytes
+ * @retval length of the data
+ */
+uint32_t u32CanLatency_Encode(const CanLatency_Struct_t *pstLatency, uint32_t u32CyclesPerUs, uint8_t au8Data[]) {
+
+    const CanLatency_StageStruct_t *pstStage;
+    uint32_t u32Offset = m_u32CANLATENCY_HEADERLENGTH;
+
+    au8Data[0] = (uint8_t)CANLATENCY_STAGE_COUNT;
+    au8Data[1] = (uint8_t)m_u32CANLATENCY_BUCKETS;
+    au8Data[2] = (uint8_t)m_u32CANLATENCY_FIRSTSHIFT;
+    au8Data[3] = 0u;
+    vCanCommand_PutUint32(&au8Data[4], u32CyclesPerUs);
+
+    for (uint32_t i = 0; i < CANLATENCY_STAGE_COUNT; i++) {
+        pstStage = &pstLatency->astStages[i];
+        vCanCommand_PutUint32(&au8Data[u32Offset], pstStage->u32Count);
+        vCanCommand_PutUint32(&au8Data[u32Offset + 4u], (pstStage->u32Count != 0u) ? pstStage->u32Min : 0u);
+        vCanCommand_PutUint32(&au8Data[u32Offset + 8u], pstStage->u32Max);
+        vCanCommand_PutUint32(&au8Data[u32Offset + 12u], u32CanLatency_GetAverage(pstStage));
+        u32Offset += 16u;
+        for (uint32_t j = 0; j < m_u32CANLATENCY_BUCKETS; j++) {
+            vCanCommand_PutUint32(&au8Data[u32Offset], pstStage->au32Buckets[j]);
+            u32Offset += 4u;
+        }
+    }
+    return u32Offset;
+}
+
+/**
+ * @brief  Decodes the GETLATENCY response data. Stages added by a newer
+ *         firmware are ignored.
+ * @retval false in case the data is truncated or the histogram layout differs.
+ */
+bool bCanLatency_Decode(const uint8_t au8Data[], uint32_t u32Length, CanLatency_ReportStruct_t *pstReport) {
+
+    uint32_t u32Stages;
+    uint32_t u32Offset = m_u32CANLATENCY_HEADERLENGTH;
+
+    if ((u32Length < m_u32CANLATENCY_HEADERLENGTH) || (au8Data[1] != m_u32CANLATENCY_BUCKETS)
+            || (au8Data[2] != m_u32CANLATENCY_FIRSTSHIFT)) {
+        return false;
+    }
+    u32Stages = au8Data[0];
+    if (u32Length < (m_u32CANLATENCY_HEADERLENGTH + (u32Stages * m_u32CANLATENCY_STAGELENGTH))) {
+        return false;
+    }
+
+    memset(pstReport, 0, sizeof(*pstReport));
+    pstReport->u32CyclesPerUs = u32CanCommand_GetUint32(&au8Data[4]);
+    pstReport->u32Stages = (u32Stages < CANLATENCY_STAGE_COUNT) ? u32Stages : CANLATENCY_STAGE_COUNT;
+    for (uint32_t i = 0; i < pstReport->u32Stages; i++) {
+        pstReport->astStages[i].u32Count = u32CanCommand_GetUint32(&au8Data[u32Offset]);
+        pstReport->astStages[i].u32Min = u32CanCommand_GetUint32(&au8Data[u32Offset + 4u]);
+        pstReport->astStages[i].u32Max = u32CanCommand_GetUint32(&au8Data[u32Offset + 8u]);
+        pstReport->astStages[i].u32Average = u32CanCommand_GetUint32(&au8Data[u32Offset + 12u]);
+        for (uint32_t j = 0; j < m_u32CANLATENCY_BUCKETS; j++) {
+            pstReport->astStages[i].au32Buckets[j] = u32CanCommand_GetUint32(&au8Data[u32Offset + 16u + (4u * j)]);
+        }
+        u32Offset += m_u32CANLATENCY_STAGELENGTH;
+    }
+    return true;
+}
+
+/**
+ * @brief  Short name of a stage for the trace log and the Linux tools.
+ * @retval zero terminated text.
+ */
+const char *pcCanLatency_StageName(CanLatency_Stage_t eStage) {
+
+    if ((uint32_t)eStage >= CANLATENCY_STAGE_COUNT) {
+        return "";
+    }
+    return m_apcSTAGENAME[eStage];
+}
@@ -0,0 +1,213 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Packs CAN frames as binary records into one RPMsg sized batch.
+ *          The format is described in can_record.h.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_record.h"
+#include "string.h"
+
+/* Private function prototypes -----------------------------------------------*/
+static void vPutUint16(uint8_t *pu8Dest, uint16_t u16Value);
+static void vPutUint32(uint8_t *pu8Dest, uint32_t u32Value);
+static uint16_t u16GetUint16(const uint8_t *pu8Src);
+static uint32_t u32GetUint32(const uint8_t *pu8Src);
+
+/**
+ * @brief  Writes a uint16_t value in little endian byte order.
+ * @retval void
+ */
+static void vPutUint16(uint8_t *pu8Dest, uint16_t u16Value) {
+    pu8Dest[0] = (uint8_t)u16Value;
+    pu8Dest[1] = (uint8_t)(u16Value >> 8u);
+}
+
+/**
+ * @brief  Writes a uint32_t value in little endian byte order.
+ * @retval void
+ */
+static void vPutUint32(uint8_t *pu8Dest, uint32_t u32Value) {
+    pu8Dest[0] = (uint8_t)u32Value;
+    pu8Dest[1] = (uint8_t)(u32Value >> 8u);
+    pu8Dest[2] = (uint8_t)(u32Value >> 16u);
+    pu8Dest[3] = (uint8_t)(u32Value >> 24u);
+}
+
+/**
+ * @brief  Reads a little endian uint16_t value.
+ * @retval value
+ */
+static uint16_t u16GetUint16(const uint8_t *pu8Src) {
+    return (uint16_t)(pu8Src[0] | ((uint16_t)pu8Src[1] << 8u));
+}
+
+/**
+ * @brief  Reads a little endian uint32_t value.
+ * @retval value
+ */
+static uint32_t u32GetUint32(const uint8_t *pu8Src) {
+    return (uint32_t)pu8Src[0] | ((uint32_t)pu8Src[1] << 8u) | ((uint32_t)pu8Src[2] << 16u)
+            | ((uint32_t)pu8Src[3] << 24u);
+}
+
+/**
+ * @brief  Initializes an empty batch, the sequence number starts at 0.
+ * @retval void
+ */
+void vCanRecord_BatchInit(CanRecord_BatchStruct_t *pstBatch) {
+    pstBatch->pu8Buffer = pstBatch->au8Buffer;
+    pstBatch->u32Size = m_u32CANRECORD_BATCHSIZE;
+    pstBatch->u16Sequence = 0u;
+    pstBatch->u32Length = m_u32CANRECORD_BATCHHEADERLENGTH;
+    pstBatch->u8RecordCount = 0u;
+}
+
+/**
+ * @brief  Appends one record behind the records already in the batch.
+ * @retval false in case the record does not fit anymore, the batch must be sent first.
+ */
+bool bCanRecord_BatchAdd(CanRecord_BatchStruct_t *pstBatch, const CanRecord_RecordStruct_t *pstRecord) {
+
+    uint32_t u32Length = (pstRecord->u8Length < m_u32CANRECORD_MAXDATALENGTH) ?
+            pstRecord->u8Length : m_u32CANRECORD_MAXDATALENGTH;
+    uint8_t *pu8Dest = &pstBatch->pu8Buffer[pstBatch->u32Length];
+
+    if (((pstBatch->u32Length + m_u32CANRECORD_HEADERLENGTH + u32Length) > pstBatch->u32Size)
+            || (pstBatch->u8RecordCount == UINT8_MAX)) {
+        return false;
+    }
+
+    vPutUint32(&pu8Dest[0], (uint32_t)pstRecord->u64Timestamp);
+    vPutUint32(&pu8Dest[4], (uint32_t)(pstRecord->u64Timestamp >> 32u));
+    vPutUint32(&pu8Dest[8], pstRecord->u32Identifier);
+    pu8Dest[12] = pstRecord->u8Flags;
+    pu8Dest[13] = (uint8_t)u32Length;
+    memcpy(&pu8Dest[14], pstRecord->pu8Data, u32Length);
+
+    pstBatch->u32Length += m_u32CANRECORD_HEADERLENGTH + u32Length;
+    pstBatch->u8RecordCount++;
+
+    return true;
+}
+
+/**
+ * @brief  Checks if the batch holds any record.
+ * @retval true in case no record was added since the last reset.
+ */
+bool bCanRecord_BatchIsEmpty(const CanRecord_BatchStruct_t *pstBatch) {
+    return (pstBatch->u8RecordCount == 0u);
+}
+
+/**
+ * @brief  Writes the batch header. pu8Buffer is ready to be sent afterwards.
+ * @retval number of bytes to send from pu8Buffer.
+ */
+uint32_t u32CanRecord_BatchFinish(CanRecord_BatchStruct_t *pstBatch) {
+    vPutUint16(&pstBatch->pu8Buffer[0], m_u16CANRECORD_MAGIC);
+    pstBatch->pu8Buffer[2] = m_u8CANRECORD_VERSION;
+    pstBatch->pu8Buffer[3] = pstBatch->u8RecordCount;
+    vPutUint16(&pstBatch->pu8Buffer[4], (uint16_t)(pstBatch->u32Length - m_u32CANRECORD_BATCHHEADERLENGTH));
+    vPutUint16(&pstBatch->pu8Buffer[6], pstBatch->u16Sequence);
+
+    return pstBatch->u32Length;
+}
+
+/**
+ * @brief  Empties the batch after it was sent and advances the sequence number.
+ * @retval void
+ */
+void vCanRecord_BatchReset(CanRecord_BatchStruct_t *pstBatch) {
+    pstBatch->u16Sequence++;
+    pstBatch->u32Length = m_u32CANRECORD_BATCHHEADERLENGTH;
+    pstBatch->u8RecordCount = 0u;
+}
+
+/**
+ * @brief  Lets an empty batch write its records into pu8Buffer, e.g. a
+ *         RPMsg TX buffer, so the batch is sent without a copy. The batch
+ *         stays within the u32Size bytes of pu8Buffer, at least
+ *         m_u32CANRECORD_BATCHHEADERLENGTH. NULL selects au8Buffer again.
+ * @retval void
+ */
+void vCanRecord_BatchAttach(CanRecord_BatchStruct_t *pstBatch, uint8_t *pu8Buffer, uint32_t u32Size) {
+    if (pu8Buffer != NULL) {
+        pstBatch->pu8Buffer = pu8Buffer;
+        pstBatch->u32Size = (u32Size < m_u32CANRECORD_BATCHSIZE) ? u32Size : m_u32CANRECORD_BATCHSIZE;
+    } else {
+        pstBatch->pu8Buffer = pstBatch->au8Buffer;
+        pstBatch->u32Size = m_u32CANRECORD_BATCHSIZE;
+    }
+}
+
+/**
+ * @brief  Checks the batch header at the start of au8Data and that the
+ *         record lengths add up to the batch length.
+ * @retval number of bytes of the batch, 0 in case more data is needed,
+ *         -1 in case au8Data does not start with a valid batch.
+ */
+int32_t i32CanRecord_BatchCheck(const uint8_t au8Data[], uint32_t u32Length) {
+
+    uint32_t u32BatchLength;
+    uint32_t u32Offset;
+    uint8_t u8Records;
+
+    if (u32Length < m_u32CANRECORD_BATCHHEADERLENGTH) {
+        return 0;
+    }
+    if ((u16GetUint16(&au8Data[0]) != m_u16CANRECORD_MAGIC) || (au8Data[2] != m_u8CANRECORD_VERSION)) {
+        return -1;
+    }
+    u8Records = au8Data[3];
+    u32BatchLength = m_u32CANRECORD_BATCHHEADERLENGTH + u16GetUint16(&au8Data[4]);
+    if (u32BatchLength > m_u32CANRECORD_BATCHSIZE) {
+        return -1;
+    }
+    if (u32Length < u32BatchLength) {
+        return 0;
+    }
+
+    u32Offset = m_u32CANRECORD_BATCHHEADERLENGTH;
+    for (uint8_t i = 0u; i < u8Records; i++) {
+        if ((u32Offset + m_u32CANRECORD_HEADERLENGTH) > u32BatchLength) {
+            return -1;
+        }
+        u32Offset += m_u32CANRECORD_HEADERLENGTH + au8Data[u32Offset + 13u];
+    }
+    if (u32Offset != u32BatchLength) {
+        return -1;
+    }
+
+    return (int32_t)u32BatchLength;
+}
+
+/**
+ * @brief  Decodes the record at u32Offset of a batch checked with
+ *         i32CanRecord_BatchCheck(). The first record starts at
+ *         m_u32CANRECORD_BATCHHEADERLENGTH. pstRecord->pu8Data points into au8Data.
+ * @retval offset of the next record.
+ */
+uint32_t u32CanRecord_BatchGetRecord(const uint8_t au8Data[], uint32_t u32Offset, CanRecord_RecordStruct_t *pstRecord) {
+
+    const uint8_t *pu8Record = &au8Data[u32Offset];
+
+    pstRecord->u64Timestamp = (uint64_t)u32GetUint32(&pu8Record[0]) | ((uint64_t)u32GetUint32(&pu8Record[4]) << 32u);
+    pstRecord->u32Identifier = u32GetUint32(&pu8Record[8]);
+    pstRecord->u8Flags = pu8Record[12];
+    pstRecord->u8Length = pu8Record[13];
+    pstRecord->pu8Data = &pu8Record[14];
+
+    return u32Offset + m_u32CANRECORD_HEADERLENGTH + pstRecord->u8Length;
+}
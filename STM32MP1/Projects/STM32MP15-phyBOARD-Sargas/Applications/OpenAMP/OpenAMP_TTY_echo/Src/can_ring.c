@@ -0,0 +1,126 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Lock-free single producer / single consumer ring for CAN frames.
+ *          The FDCAN interrupt fills the ring, the main loop empties it.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_ring.h"
+#include "string.h"
+
+/* Private define ------------------------------------------------------------*/
+#define m_u32CANRING_MASK (m_u32CANRING_SIZE - 1u)
+
+/**
+ * @brief  Resets the ring indexes and the statistic counters.
+ * @retval void
+ */
+void vCanRing_Init(CanRing_Struct_t *pstRing) {
+    pstRing->u32Head = 0u;
+    pstRing->u32Tail = 0u;
+    memset(&pstRing->stStats, 0u, sizeof(pstRing->stStats));
+}
+
+/**
+ * @brief  Producer side: returns the next free frame slot. The slot becomes
+ *         visible to the consumer with vCanRing_Commit().
+ * @retval pointer to the free slot, NULL in case the ring is full.
+ */
+CanRing_FrameStruct_t *pstCanRing_GetWriteSlot(CanRing_Struct_t *pstRing) {
+    uint32_t u32Head = pstRing->u32Head;
+
+    if ((u32Head - pstRing->u32Tail) >= m_u32CANRING_SIZE) {
+        pstRing->stStats.u32RingOverflow++;
+        return NULL;
+    }
+    return &pstRing->astFrames[u32Head & m_u32CANRING_MASK];
+}
+
+/**
+ * @brief  Producer side: publishes the slot returned by pstCanRing_GetWriteSlot().
+ * @retval void
+ */
+void vCanRing_Commit(CanRing_Struct_t *pstRing) {
+    uint32_t u32Head = pstRing->u32Head + 1u;
+    uint32_t u32Level = u32Head - pstRing->u32Tail;
+
+    /* frame content must be written before the consumer can see the new head */
+    __DMB();
+    pstRing->u32Head = u32Head;
+
+    if (u32Level > pstRing->stStats.u32HighWater) {
+        pstRing->stStats.u32HighWater = u32Level;
+    }
+}
+
+/**
+ * @brief  Producer side: counts a message lost event of the hardware FIFO
+ *         feeding the ring.
+ * @retval void
+ */
+void vCanRing_CountFifoLost(CanRing_Struct_t *pstRing) {
+    pstRing->stStats.u32FifoLost++;
+}
+
+/**
+ * @brief  Consumer side: returns the oldest queued frame. The slot is given
+ *         back to the producer with vCanRing_Release().
+ * @retval pointer to the frame, NULL in case the ring is empty.
+ */
+CanRing_FrameStruct_t *pstCanRing_GetReadSlot(CanRing_Struct_t *pstRing) {
+    uint32_t u32Tail = pstRing->u32Tail;
+
+    if (pstRing->u32Head == u32Tail) {
+        return NULL;
+    }
+    /* head must be read before the frame content */
+    __DMB();
+    return &pstRing->astFrames[u32Tail & m_u32CANRING_MASK];
+}
+
+/**
+ * @brief  Consumer side: frees the slot returned by pstCanRing_GetReadSlot().
+ * @retval void
+ */
+void vCanRing_Release(CanRing_Struct_t *pstRing) {
+    /* frame content must be read before the producer can reuse the slot */
+    __DMB();
+    pstRing->u32Tail = pstRing->u32Tail + 1u;
+}
+
+/**
+ * @brief  Consumer side: drops all queued frames.
+ * @retval void
+ */
+void vCanRing_Flush(CanRing_Struct_t *pstRing) {
+    __DMB();
+    pstRing->u32Tail = pstRing->u32Head;
+}
+
+/**
+ * @brief  Returns the number of queued frames.
+ * @retval fill level of the ring
+ */
+uint32_t u32CanRing_GetFillLevel(const CanRing_Struct_t *pstRing) {
+    return pstRing->u32Head - pstRing->u32Tail;
+}
+
+/**
+ * @brief  Copies the statistic counters.
+ * @retval void
+ */
+void vCanRing_GetStats(const CanRing_Struct_t *pstRing, CanRing_StatsStruct_t *pstStats) {
+    *pstStats = pstRing->stStats;
+}
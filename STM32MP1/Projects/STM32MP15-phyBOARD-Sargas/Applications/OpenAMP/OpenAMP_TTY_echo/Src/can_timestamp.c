@@ -0,0 +1,61 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Wrap tracking for hardware timestamp counters, e.g. the 16 bit
+ *          FDCAN timestamp counter or the 32 bit DWT cycle counter.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_timestamp.h"
+
+/**
+ * @brief  Initializes the extension for a counter of u32Bits (1..32) bits.
+ * @retval void
+ */
+void vCanTimestamp_Init(CanTimestamp_CounterStruct_t *pstCounter, uint32_t u32Bits) {
+    pstCounter->u64Now = 0u;
+    pstCounter->u32Mask = (u32Bits >= 32u) ? 0xFFFFFFFFu : ((1u << u32Bits) - 1u);
+}
+
+/**
+ * @brief  Advances the extended counter to the current hardware counter value.
+ *         The counter must not have advanced by a full wrap period since the
+ *         previous update.
+ * @retval extended counter value
+ */
+uint64_t u64CanTimestamp_Update(CanTimestamp_CounterStruct_t *pstCounter, uint32_t u32Value) {
+    pstCounter->u64Now += (u32Value - (uint32_t)pstCounter->u64Now) & pstCounter->u32Mask;
+    return pstCounter->u64Now;
+}
+
+/**
+ * @brief  Returns how many counter ticks u32Sample was taken before the last update.
+ * @retval age in counter ticks
+ */
+uint32_t u32CanTimestamp_Age(const CanTimestamp_CounterStruct_t *pstCounter, uint32_t u32Sample) {
+    return ((uint32_t)pstCounter->u64Now - u32Sample) & pstCounter->u32Mask;
+}
+
+/**
+ * @brief  Extends a counter value captured before the last update, e.g. the
+ *         RxTimestamp of a frame, to 64 bits. The sample must not be older
+ *         than one wrap period.
+ * @retval extended sample value
+ */
+uint64_t u64CanTimestamp_Extend(const CanTimestamp_CounterStruct_t *pstCounter, uint32_t u32Sample) {
+    uint32_t u32Age = u32CanTimestamp_Age(pstCounter, u32Sample);
+
+    /* a sample taken before the first update would underflow */
+    return (u32Age > pstCounter->u64Now) ? 0u : (pstCounter->u64Now - u32Age);
+}
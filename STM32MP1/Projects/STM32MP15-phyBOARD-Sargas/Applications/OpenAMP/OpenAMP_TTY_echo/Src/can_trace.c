@@ -0,0 +1,148 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Formats a CAN frame as one line of the ASCII CAN trace.
+ *
+ *          Line layout (233 bytes):
+ *            [0]   message number, 7 digits
+ *            [8]   time offset, 9 digits [s] '.' 3 digits [ms]
+ *            [22]  type "FB"
+ *            [25]  CAN id, 8 hex digits
+ *            [34]  direction "Rx"
+ *            [37]  data length, 2 digits
+ *            [40]  64 data bytes, 2 hex digits and a space each
+ *            [232] '\n'
+ *          Data bytes behind the data length are printed as "00".
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "can_trace.h"
+#include "string.h"
+
+/* Private define ------------------------------------------------------------*/
+#define m_u32COUNT_POS ((uint32_t)0)
+#define m_u32COUNT_DIGITS ((uint32_t)7)
+#define m_u32SECONDS_POS ((uint32_t)8)
+#define m_u32SECONDS_DIGITS ((uint32_t)9)
+#define m_u32MILLISECONDS_POS ((uint32_t)18)
+#define m_u32MILLISECONDS_DIGITS ((uint32_t)3)
+#define m_u32ID_POS ((uint32_t)25)
+#define m_u32LENGTH_POS ((uint32_t)37)
+#define m_u32LENGTH_DIGITS ((uint32_t)2)
+#define m_u32DATA_POS ((uint32_t)40)
+
+/* Private macro -------------------------------------------------------------*/
+#define m_DEC10(d) d "0" d "1" d "2" d "3" d "4" d "5" d "6" d "7" d "8" d "9"
+#define m_HEX16(h) h "0" h "1" h "2" h "3" h "4" h "5" h "6" h "7" \
+                   h "8" h "9" h "A" h "B" h "C" h "D" h "E" h "F"
+#define m_DATA8 "00 00 00 00 00 00 00 00 "
+
+/* Private const -------------------------------------------------------------*/
+/* "00" .. "99" */
+static const char m_acDecimal2[200 + 1] =
+        m_DEC10("0") m_DEC10("1") m_DEC10("2") m_DEC10("3") m_DEC10("4")
+        m_DEC10("5") m_DEC10("6") m_DEC10("7") m_DEC10("8") m_DEC10("9");
+
+/* "00" .. "FF" */
+static const char m_acHex2[512 + 1] =
+        m_HEX16("0") m_HEX16("1") m_HEX16("2") m_HEX16("3") m_HEX16("4") m_HEX16("5") m_HEX16("6") m_HEX16("7")
+        m_HEX16("8") m_HEX16("9") m_HEX16("A") m_HEX16("B") m_HEX16("C") m_HEX16("D") m_HEX16("E") m_HEX16("F");
+
+/* fixed part of a trace line, copied before the variable fields are written */
+static const char m_acTemplate[m_u32CANTRACE_LENGTH + 1] =
+        "0000000 000000000.000 FB 00000000 Rx 00 "
+        m_DATA8 m_DATA8 m_DATA8 m_DATA8 m_DATA8 m_DATA8 m_DATA8 m_DATA8
+        "\n";
+
+/* data length in bytes for the 4 bit DLC code */
+static const uint8_t m_au8DataLength[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64};
+
+/* Private function prototypes -----------------------------------------------*/
+static void vPutDecimal(uint8_t *pu8Dest, uint32_t u32Value, uint32_t u32Digits);
+static void vPutHex8(uint8_t *pu8Dest, uint8_t u8Value);
+
+/**
+ * @brief  Writes u32Value right aligned with leading zeros into u32Digits places.
+ * @retval void
+ */
+static void vPutDecimal(uint8_t *pu8Dest, uint32_t u32Value, uint32_t u32Digits) {
+    uint8_t *pu8Digit = pu8Dest + u32Digits;
+
+    while (u32Digits >= 2u) {
+        uint32_t u32Quotient = u32Value / 100u;
+        uint32_t u32Pair = (u32Value - u32Quotient * 100u) * 2u;
+
+        pu8Digit -= 2;
+        pu8Digit[0] = (uint8_t)m_acDecimal2[u32Pair];
+        pu8Digit[1] = (uint8_t)m_acDecimal2[u32Pair + 1u];
+        u32Value = u32Quotient;
+        u32Digits -= 2u;
+    }
+    if (u32Digits != 0u) {
+        pu8Digit[-1] = (uint8_t)('0' + (u32Value % 10u));
+    }
+}
+
+/**
+ * @brief  Writes the two hex digits of u8Value.
+ * @retval void
+ */
+static void vPutHex8(uint8_t *pu8Dest, uint8_t u8Value) {
+    pu8Dest[0] = (uint8_t)m_acHex2[u8Value * 2u];
+    pu8Dest[1] = (uint8_t)m_acHex2[u8Value * 2u + 1u];
+}
+
+/**
+ * @brief  converts the coded header data length (FDCAN_DLC_BYTES_x) in a uint8_t value.
+ * @retval data length of the CAN frame as uint8_t.
+ */
+uint8_t u8CanTrace_GetDataLength(uint32_t u32DataLengthCode) {
+    return m_au8DataLength[(u32DataLengthCode >> 16u) & 0x0Fu];
+}
+
+/**
+ * @brief  Creates one trace line, see the layout above. au8TraceData must hold
+ *         m_u32CANTRACE_LENGTH bytes, only u8Length bytes of au8RxData are read.
+ * @retval void
+ */
+void vCanTrace_Format(uint8_t au8TraceData[], uint32_t u32RxCount, uint32_t u32TimestampMs,
+        uint32_t u32Identifier, uint8_t u8Length, const uint8_t au8RxData[]) {
+
+    uint8_t *pu8Data = &au8TraceData[m_u32DATA_POS];
+
+    memcpy(au8TraceData, m_acTemplate, m_u32CANTRACE_LENGTH);
+
+    /* like the former snprintf("%07u"), larger numbers keep their leading 7 digits */
+    while (u32RxCount > 9999999u) {
+        u32RxCount /= 10u;
+    }
+    vPutDecimal(&au8TraceData[m_u32COUNT_POS], u32RxCount, m_u32COUNT_DIGITS);
+    vPutDecimal(&au8TraceData[m_u32SECONDS_POS], u32TimestampMs / 1000u, m_u32SECONDS_DIGITS);
+    vPutDecimal(&au8TraceData[m_u32MILLISECONDS_POS], u32TimestampMs % 1000u, m_u32MILLISECONDS_DIGITS);
+
+    vPutHex8(&au8TraceData[m_u32ID_POS + 0u], (uint8_t)(u32Identifier >> 24u));
+    vPutHex8(&au8TraceData[m_u32ID_POS + 2u], (uint8_t)(u32Identifier >> 16u));
+    vPutHex8(&au8TraceData[m_u32ID_POS + 4u], (uint8_t)(u32Identifier >> 8u));
+    vPutHex8(&au8TraceData[m_u32ID_POS + 6u], (uint8_t)u32Identifier);
+
+    if (u8Length > m_u32CANTRACE_DATALENGTH) {
+        u8Length = m_u32CANTRACE_DATALENGTH;
+    }
+    vPutDecimal(&au8TraceData[m_u32LENGTH_POS], u8Length, m_u32LENGTH_DIGITS);
+
+    /* bytes behind the data length stay "00" from the template */
+    for (uint32_t i = 0; i < u8Length; i++) {
+        vPutHex8(&pu8Data[3u * i], au8RxData[i]);
+    }
+}
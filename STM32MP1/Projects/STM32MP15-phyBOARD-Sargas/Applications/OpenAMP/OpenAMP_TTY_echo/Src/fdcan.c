@@ -21,7 +21,32 @@
 #include "fdcan.h"
 
 /* USER CODE BEGIN 0 */
+#include "can_bridge.h"
 
+/* FIFO0 fill level which raises the watermark interrupt */
+#define m_u32RXFIFO0WATERMARK ((uint32_t)4)
+
+/* derive the frame timestamps from the DWT cycle counter instead of the FDCAN
+ * timestamp counter alone, see vUpdateRxTimebase() */
+#define CAN_TIMESTAMP_CYCCNT
+
+/* frames drained from RX FIFO0 by the FDCAN2 interrupt */
+CanRing_Struct_t stCanRxRing;
+/* transmitted frames drained from the TX event FIFO, au8Data[0] holds the message marker */
+CanRing_Struct_t stCanTxEventRing;
+
+/* FDCAN timestamp counter tick in ns (one nominal bit time) */
+static uint32_t m_u32TimestampTickNs = 1000u;
+static CanTimestamp_CounterStruct_t m_stFdcanCounter;
+#if defined(CAN_TIMESTAMP_CYCCNT)
+static uint32_t m_u32CyclesPerUs = 1u;
+static CanTimestamp_CounterStruct_t m_stCycleCounter;
+#endif
+
+static void vUpdateRxTimebase(FDCAN_HandleTypeDef *hfdcan);
+static uint64_t u64GetRxTimestampUs(uint32_t u32RxTimestamp);
+static bool bConfigFilter(uint32_t u32IdType, uint32_t u32Index, const CanFilter_RuleStruct_t *pstRule);
+static uint32_t u32GetDataLengthCode(uint8_t u8Length);
 /* USER CODE END 0 */
 
 FDCAN_HandleTypeDef hfdcan2;
@@ -52,15 +77,15 @@ void MX_FDCAN2_Init(void)
   hfdcan2.Init.DataTimeSeg1 = 4;
   hfdcan2.Init.DataTimeSeg2 = 1;
   hfdcan2.Init.MessageRAMOffset = 0;
-  hfdcan2.Init.StdFiltersNbr = 0;
-  hfdcan2.Init.ExtFiltersNbr = 0;
+  hfdcan2.Init.StdFiltersNbr = 16;
+  hfdcan2.Init.ExtFiltersNbr = 8;
   hfdcan2.Init.RxFifo0ElmtsNbr = 8;
   hfdcan2.Init.RxFifo0ElmtSize = FDCAN_DATA_BYTES_64;
   hfdcan2.Init.RxFifo1ElmtsNbr = 0;
   hfdcan2.Init.RxFifo1ElmtSize = FDCAN_DATA_BYTES_64;
   hfdcan2.Init.RxBuffersNbr = 8;
   hfdcan2.Init.RxBufferSize = FDCAN_DATA_BYTES_64;
-  hfdcan2.Init.TxEventsNbr = 2;
+  hfdcan2.Init.TxEventsNbr = 8;
   hfdcan2.Init.TxBuffersNbr = 8;
   hfdcan2.Init.TxFifoQueueElmtsNbr = 8;
   hfdcan2.Init.TxFifoQueueMode = FDCAN_TX_FIFO_OPERATION;
@@ -70,7 +95,40 @@ void MX_FDCAN2_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN FDCAN2_Init 2 */
+  vCanRing_Init(&stCanRxRing);
+  vCanRing_Init(&stCanTxEventRing);
+
+  /* timestamp counter counts nominal bit times, captured at start of frame */
+  m_u32TimestampTickNs = (uint32_t)(((uint64_t)1000000000u * hfdcan2.Init.NominalPrescaler
+      * (1u + hfdcan2.Init.NominalTimeSeg1 + hfdcan2.Init.NominalTimeSeg2))
+      / HAL_RCCEx_GetPeriphCLKFreq(RCC_PERIPHCLK_FDCAN));
+  vCanTimestamp_Init(&m_stFdcanCounter, 16u);
+  if (HAL_FDCAN_ConfigTimestampCounter(&hfdcan2, FDCAN_TIMESTAMP_PRESC_1) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  if (HAL_FDCAN_EnableTimestampCounter(&hfdcan2, FDCAN_TIMESTAMP_INTERNAL) != HAL_OK)
+  {
+    Error_Handler();
+  }
+#if defined(CAN_TIMESTAMP_CYCCNT)
+  m_u32CyclesPerUs = SystemCoreClock / 1000000u;
+  vCanTimestamp_Init(&m_stCycleCounter, 32u);
+#endif
+  /* the cycle counter also stamps the frames for the latency statistics (can_latency.h) */
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 
+  if (HAL_FDCAN_ConfigFifoWatermark(&hfdcan2, FDCAN_CFG_RX_FIFO0, m_u32RXFIFO0WATERMARK) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  if (HAL_FDCAN_ActivateNotification(&hfdcan2, FDCAN_IT_RX_FIFO0_NEW_MESSAGE | FDCAN_IT_RX_FIFO0_WATERMARK
+                                     | FDCAN_IT_RX_FIFO0_MESSAGE_LOST | FDCAN_IT_TIMESTAMP_WRAPAROUND
+                                     | FDCAN_IT_TX_EVT_FIFO_NEW_DATA | FDCAN_IT_TX_EVT_FIFO_ELT_LOST, 0) != HAL_OK)
+  {
+    Error_Handler();
+  }
   /* USER CODE END FDCAN2_Init 2 */
 
 }
@@ -120,7 +178,9 @@ void HAL_FDCAN_MspInit(FDCAN_HandleTypeDef* fdcanHandle)
     HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
 
   /* USER CODE BEGIN FDCAN2_MspInit 1 */
-
+    /* FDCAN2 interrupt Init */
+    HAL_NVIC_SetPriority(FDCAN2_IT0_IRQn, DEFAULT_IRQ_PRIO, 0);
+    HAL_NVIC_EnableIRQ(FDCAN2_IT0_IRQn);
   /* USER CODE END FDCAN2_MspInit 1 */
   }
 }
@@ -143,11 +203,311 @@ void HAL_FDCAN_MspDeInit(FDCAN_HandleTypeDef* fdcanHandle)
     HAL_GPIO_DeInit(GPIOB, GPIO_PIN_5|GPIO_PIN_13);
 
   /* USER CODE BEGIN FDCAN2_MspDeInit 1 */
+    HAL_NVIC_DisableIRQ(FDCAN2_IT0_IRQn);
 
   /* USER CODE END FDCAN2_MspDeInit 1 */
   }
 }
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief  Samples the FDCAN timestamp counter (and the DWT cycle counter) and
+  *         advances their 64 bit extensions. Called at least once per 16 bit
+  *         wrap of the FDCAN counter by the wraparound interrupt.
+  * @param  hfdcan pointer to the FDCAN handle.
+  * @retval None
+  */
+static void vUpdateRxTimebase(FDCAN_HandleTypeDef *hfdcan)
+{
+  (void)u64CanTimestamp_Update(&m_stFdcanCounter, HAL_FDCAN_GetTimestampCounter(hfdcan));
+#if defined(CAN_TIMESTAMP_CYCCNT)
+  (void)u64CanTimestamp_Update(&m_stCycleCounter, DWT->CYCCNT);
+#endif
+}
+
+/**
+  * @brief  Converts the 16 bit RxTimestamp of a frame to microseconds. Must be
+  *         called after vUpdateRxTimebase() for a frame still younger than one
+  *         counter wrap.
+  *         In CAN FD the counter also counts the faster data phase bits, so it
+  *         is no stable long term time base. With CAN_TIMESTAMP_CYCCNT only the
+  *         short age of the frame is taken from the FDCAN counter, the absolute
+  *         time comes from the DWT cycle counter.
+  * @param  u32RxTimestamp timestamp counter value captured at start of frame.
+  * @retval capture time in microseconds.
+  */
+static uint64_t u64GetRxTimestampUs(uint32_t u32RxTimestamp)
+{
+#if defined(CAN_TIMESTAMP_CYCCNT)
+  uint64_t u64AgeNs = (uint64_t)u32CanTimestamp_Age(&m_stFdcanCounter, u32RxTimestamp) * m_u32TimestampTickNs;
+  uint64_t u64NowUs = m_stCycleCounter.u64Now / m_u32CyclesPerUs;
+
+  return (u64NowUs > (u64AgeNs / 1000u)) ? (u64NowUs - (u64AgeNs / 1000u)) : 0u;
+#else
+  return (u64CanTimestamp_Extend(&m_stFdcanCounter, u32RxTimestamp) * m_u32TimestampTickNs) / 1000u;
+#endif
+}
 
+/**
+  * @brief  Timestamp wraparound callback, keeps the counter extensions running
+  *         while no frames are received.
+  * @param  hfdcan pointer to the FDCAN handle.
+  * @retval None
+  */
+void HAL_FDCAN_TimestampWraparoundCallback(FDCAN_HandleTypeDef *hfdcan)
+{
+  vUpdateRxTimebase(hfdcan);
+}
+
+/**
+  * @brief  Rx FIFO 0 callback, drains the complete FIFO into stCanRxRing.
+  *         Frames which do not fit into the ring are read out and dropped,
+  *         so the FIFO never blocks new frames from the bus.
+  * @param  hfdcan pointer to the FDCAN handle.
+  * @param  RxFifo0ITs indicates which Rx FIFO 0 interrupts are signaled.
+  * @retval None
+  */
+void HAL_FDCAN_RxFifo0Callback(FDCAN_HandleTypeDef *hfdcan, uint32_t RxFifo0ITs)
+{
+  static CanRing_FrameStruct_t s_stDropFrame;
+  CanRing_FrameStruct_t *pstFrame;
+
+  if ((RxFifo0ITs & FDCAN_IT_RX_FIFO0_MESSAGE_LOST) != 0u)
+  {
+    vCanRing_CountFifoLost(&stCanRxRing);
+  }
+
+  vUpdateRxTimebase(hfdcan);
+
+  while (HAL_FDCAN_GetRxFifoFillLevel(hfdcan, FDCAN_RX_FIFO0) != 0u)
+  {
+    pstFrame = pstCanRing_GetWriteSlot(&stCanRxRing);
+    if (pstFrame == NULL)
+    {
+      if (HAL_FDCAN_GetRxMessage(hfdcan, FDCAN_RX_FIFO0, &s_stDropFrame.stHeader, s_stDropFrame.au8Data) != HAL_OK)
+      {
+        break;
+      }
+      continue;
+    }
+
+    if (HAL_FDCAN_GetRxMessage(hfdcan, FDCAN_RX_FIFO0, &pstFrame->stHeader, pstFrame->au8Data) != HAL_OK)
+    {
+      break;
+    }
+    pstFrame->u32DequeueCycles = DWT->CYCCNT;
+    pstFrame->u64Timestamp = u64GetRxTimestampUs(pstFrame->stHeader.RxTimestamp);
+    /* the ASCII trace prints milliseconds */
+    pstFrame->stHeader.RxTimestamp = (uint32_t)(pstFrame->u64Timestamp / 1000u);
+    vCanRing_Commit(&stCanRxRing);
+  }
+#if defined(CAN_BRIDGE_FREERTOS)
+  vCanBridge_NotifyFromISR(m_u32CANBRIDGE_EVENT_RX);
+#endif
+}
+
+/**
+  * @brief  Tx event FIFO callback, drains the complete event FIFO into
+  *         stCanTxEventRing. Events which do not fit into the ring are dropped.
+  * @param  hfdcan pointer to the FDCAN handle.
+  * @param  TxEventFifoITs indicates which Tx event FIFO interrupts are signaled.
+  * @retval None
+  */
+void HAL_FDCAN_TxEventFifoCallback(FDCAN_HandleTypeDef *hfdcan, uint32_t TxEventFifoITs)
+{
+  FDCAN_TxEventFifoTypeDef stEvent;
+  CanRing_FrameStruct_t *pstFrame;
+
+  if ((TxEventFifoITs & FDCAN_IT_TX_EVT_FIFO_ELT_LOST) != 0u)
+  {
+    vCanRing_CountFifoLost(&stCanTxEventRing);
+  }
+
+  vUpdateRxTimebase(hfdcan);
+
+  while ((hfdcan->Instance->TXEFS & FDCAN_TXEFS_EFFL) != 0u)
+  {
+    if (HAL_FDCAN_GetTxEvent(hfdcan, &stEvent) != HAL_OK)
+    {
+      break;
+    }
+    pstFrame = pstCanRing_GetWriteSlot(&stCanTxEventRing);
+    if (pstFrame == NULL)
+    {
+      continue;
+    }
+
+    pstFrame->stHeader.Identifier = stEvent.Identifier;
+    pstFrame->stHeader.IdType = stEvent.IdType;
+    pstFrame->stHeader.RxFrameType = stEvent.TxFrameType;
+    pstFrame->stHeader.DataLength = stEvent.DataLength;
+    pstFrame->stHeader.ErrorStateIndicator = stEvent.ErrorStateIndicator;
+    pstFrame->stHeader.BitRateSwitch = stEvent.BitRateSwitch;
+    pstFrame->stHeader.FDFormat = stEvent.FDFormat;
+    pstFrame->u64Timestamp = u64GetRxTimestampUs(stEvent.TxTimestamp);
+    pstFrame->stHeader.RxTimestamp = (uint32_t)(pstFrame->u64Timestamp / 1000u);
+    pstFrame->au8Data[0] = (uint8_t)stEvent.MessageMarker;
+    vCanRing_Commit(&stCanTxEventRing);
+  }
+#if defined(CAN_BRIDGE_FREERTOS)
+  /* every TX event also frees a TX FIFO element for the held TX batches */
+  vCanBridge_NotifyFromISR(m_u32CANBRIDGE_EVENT_RX | m_u32CANBRIDGE_EVENT_TXSPACE);
+#endif
+}
+
+/**
+  * @brief  Converts a payload length to the FDCAN DLC code.
+  * @param  u8Length payload bytes.
+  * @retval FDCAN_DLC_BYTES_xxx, UINT32_MAX in case u8Length is no valid CAN FD length.
+  */
+static uint32_t u32GetDataLengthCode(uint8_t u8Length)
+{
+  static const uint8_t s_au8FDLENGTH[] = {12u, 16u, 20u, 24u, 32u, 48u, 64u};
+
+  if (u8Length <= 8u)
+  {
+    return (uint32_t)u8Length << 16u;
+  }
+  for (uint32_t i = 0; i < sizeof(s_au8FDLENGTH); i++)
+  {
+    if (s_au8FDLENGTH[i] == u8Length)
+    {
+      return (9u + i) << 16u;
+    }
+  }
+  return UINT32_MAX;
+}
+
+/**
+  * @brief  Queues one frame in the TX FIFO. The frame is confirmed by an entry
+  *         in stCanTxEventRing carrying u8Marker once it is on the bus.
+  * @param  pstRecord frame to send, the timestamp is ignored.
+  * @param  u8Marker message marker of the frame.
+  * @retval false in case the record is no valid frame or the TX FIFO is full,
+  *         check HAL_FDCAN_GetTxFifoFreeLevel() before.
+  */
+bool bFdcan2_Transmit(const CanRecord_RecordStruct_t *pstRecord, uint8_t u8Marker)
+{
+  FDCAN_TxHeaderTypeDef stHeader;
+  bool bExtended = ((pstRecord->u8Flags & m_u8CANRECORD_FLAG_EXTENDEDID) != 0u);
+  bool bFdFormat = ((pstRecord->u8Flags & m_u8CANRECORD_FLAG_FDFORMAT) != 0u);
+  bool bRemote = ((pstRecord->u8Flags & m_u8CANRECORD_FLAG_REMOTEFRAME) != 0u);
+
+  stHeader.DataLength = u32GetDataLengthCode(pstRecord->u8Length);
+  if ((stHeader.DataLength == UINT32_MAX) || ((bFdFormat == false) && (pstRecord->u8Length > 8u))
+      || ((bFdFormat == true) && (bRemote == true))
+      || (pstRecord->u32Identifier > ((bExtended == true) ? 0x1FFFFFFFu : 0x7FFu)))
+  {
+    return false;
+  }
+
+  stHeader.Identifier = pstRecord->u32Identifier;
+  stHeader.IdType = (bExtended == true) ? FDCAN_EXTENDED_ID : FDCAN_STANDARD_ID;
+  stHeader.TxFrameType = (bRemote == true) ? FDCAN_REMOTE_FRAME : FDCAN_DATA_FRAME;
+  stHeader.ErrorStateIndicator = FDCAN_ESI_ACTIVE;
+  stHeader.BitRateSwitch = ((bFdFormat == true) && ((pstRecord->u8Flags & m_u8CANRECORD_FLAG_BITRATESWITCH) != 0u)) ?
+      FDCAN_BRS_ON : FDCAN_BRS_OFF;
+  stHeader.FDFormat = (bFdFormat == true) ? FDCAN_FD_CAN : FDCAN_CLASSIC_CAN;
+  stHeader.TxEventFifoControl = FDCAN_STORE_TX_EVENTS;
+  stHeader.MessageMarker = u8Marker;
+
+  /* the HAL reads the payload in words, up to 3 bytes behind the record, which
+   * are still inside the RPMsg buffer of the batch */
+  return (HAL_FDCAN_AddMessageToTxFifoQ(&hfdcan2, &stHeader, (uint8_t *)pstRecord->pu8Data) == HAL_OK);
+}
+
+/**
+  * @brief  Programs one filter element and verifies the element written to
+  *         the message RAM against the can_filter.c encoding.
+  * @param  u32IdType FDCAN_STANDARD_ID or FDCAN_EXTENDED_ID.
+  * @param  u32Index filter element index.
+  * @param  pstRule rule to program, NULL disables the element.
+  * @retval false in case the element could not be programmed.
+  */
+static bool bConfigFilter(uint32_t u32IdType, uint32_t u32Index, const CanFilter_RuleStruct_t *pstRule)
+{
+  FDCAN_FilterTypeDef stFilter = {0};
+  uint32_t au32Element[2];
+  volatile uint32_t *pu32Element;
+
+  stFilter.IdType = u32IdType;
+  stFilter.FilterIndex = u32Index;
+  stFilter.FilterType = FDCAN_FILTER_RANGE;
+  stFilter.FilterConfig = FDCAN_FILTER_DISABLE;
+  if (pstRule != NULL)
+  {
+    /* the rule values are the HAL register encodings */
+    stFilter.FilterType = pstRule->u8Type;
+    stFilter.FilterConfig = pstRule->u8Config;
+    stFilter.FilterID1 = pstRule->u32Id1;
+    stFilter.FilterID2 = pstRule->u32Id2;
+  }
+  if (HAL_FDCAN_ConfigFilter(&hfdcan2, &stFilter) != HAL_OK)
+  {
+    return false;
+  }
+
+  if (u32IdType == FDCAN_STANDARD_ID)
+  {
+    pu32Element = (volatile uint32_t *)(uintptr_t)(hfdcan2.msgRam.StandardFilterSA + (u32Index * 4u));
+    return (pu32Element[0] == u32CanFilter_EncodeStd(pstRule));
+  }
+  pu32Element = (volatile uint32_t *)(uintptr_t)(hfdcan2.msgRam.ExtendedFilterSA + (u32Index * 8u));
+  vCanFilter_EncodeExt(pstRule, au32Element);
+  return (pu32Element[0] == au32Element[0]) && (pu32Element[1] == au32Element[1]);
+}
+
+/**
+  * @brief  Programs the filter table into the FDCAN2 filter elements. Unused
+  *         elements are disabled. Frames not matching any element are rejected
+  *         for each identifier type with an accepting rule. The global filter
+  *         can only be changed in init mode, so a running FDCAN2 is stopped
+  *         for the update, no frames are received meanwhile.
+  * @param  pstTable filter table filled by eCanFilter_Parse().
+  * @retval false in case the hardware could not be programmed.
+  */
+bool bFdcan2_ApplyFilters(const CanFilter_TableStruct_t *pstTable)
+{
+  bool bStarted = (hfdcan2.State == HAL_FDCAN_STATE_BUSY);
+  bool bResult = true;
+
+  /* the RX FIFO cannot be read while stopped, keep the interrupt away */
+  HAL_NVIC_DisableIRQ(FDCAN2_IT0_IRQn);
+  if ((bStarted == true) && (HAL_FDCAN_Stop(&hfdcan2) != HAL_OK))
+  {
+    HAL_NVIC_EnableIRQ(FDCAN2_IT0_IRQn);
+    return false;
+  }
+
+  for (uint32_t i = 0; i < hfdcan2.Init.StdFiltersNbr; i++)
+  {
+    if (bConfigFilter(FDCAN_STANDARD_ID, i, (i < pstTable->u32StdCount) ? &pstTable->astStd[i] : NULL) == false)
+    {
+      bResult = false;
+    }
+  }
+  for (uint32_t i = 0; i < hfdcan2.Init.ExtFiltersNbr; i++)
+  {
+    if (bConfigFilter(FDCAN_EXTENDED_ID, i, (i < pstTable->u32ExtCount) ? &pstTable->astExt[i] : NULL) == false)
+    {
+      bResult = false;
+    }
+  }
+
+  if (HAL_FDCAN_ConfigGlobalFilter(&hfdcan2,
+      bCanFilter_HasAcceptRule(pstTable->astStd, pstTable->u32StdCount) ? FDCAN_REJECT : FDCAN_ACCEPT_IN_RX_FIFO0,
+      bCanFilter_HasAcceptRule(pstTable->astExt, pstTable->u32ExtCount) ? FDCAN_REJECT : FDCAN_ACCEPT_IN_RX_FIFO0,
+      FDCAN_FILTER_REMOTE, FDCAN_FILTER_REMOTE) != HAL_OK)
+  {
+    bResult = false;
+  }
+
+  if ((bStarted == true) && (HAL_FDCAN_Start(&hfdcan2) != HAL_OK))
+  {
+    bResult = false;
+  }
+  HAL_NVIC_EnableIRQ(FDCAN2_IT0_IRQn);
+
+  return bResult;
+}
 /* USER CODE END 1 */
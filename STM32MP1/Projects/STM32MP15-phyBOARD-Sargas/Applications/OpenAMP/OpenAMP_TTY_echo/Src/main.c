@@ -20,32 +20,89 @@
 #include "fdcan.h"
 #include "ipcc.h"
 #include "usart.h"
+#include "dma.h"
 #include "gpio.h"
+#include "can_bridge.h"
+#include "can_command.h"
+#include "can_filter.h"
+#include "can_latency.h"
+#include "can_record.h"
+#include "can_trace.h"
+#include "string.h"
 #include "stdint.h"
 #include "stdbool.h"
 
 /* Private typedef -----------------------------------------------------------*/
 typedef struct {
-    uint8_t u8Digits[2u];
-} LxUtilities_Hex8Struct_t;
+    uint8_t *pu8Batch;          /* held RPMsg buffer */
+    uint32_t u32Offset;         /* next record to submit */
+    uint32_t u32Remaining;      /* records not yet submitted */
+} TxBatch_Struct_t;
+
+#if defined(CAN_BRIDGE_FREERTOS)
+/* passed from the ingest to the format task */
+typedef struct {
+    CanRing_FrameStruct_t stFrame;
+    uint32_t u32RxCount;        /* frame number of the trace line */
+    bool bTxEvent;              /* stFrame is a TX event of stCanTxEventRing */
+} BridgeItem_Struct_t;
+#endif
 
 /* Private define ------------------------------------------------------------*/
 #define MAX_BUFFER_SIZE RPMSG_BUFFER_SIZE
-#define m_u32RXDATALENGTH ((uint32_t)64)
-#define m_u32CANFDTRACELENGTH ((uint32_t)233)
+#if m_u32CANRECORD_RPMSGBUFFERSIZE != RPMSG_BUFFER_SIZE
+#error "can_record.h sized the batches for another RPMSG_BUFFER_SIZE"
+#endif
+#define m_u32CANFDTRACELENGTH m_u32CANTRACE_LENGTH
+/* TX batches held while the TX FIFO is full, up to every RPMsg buffer of Linux. With all buffers held Linux
+ * blocks in its next send, also of a control message, until vTransmitCanBatches() releases a batch */
+#define m_u32TXBATCHES ((uint32_t)VRING_NUM_BUFFS)
+/* rate limit in frames/s, the bucket holds the frames of m_u32RATEBURSTMS, tokens count 1/1000 frame */
+#define m_u32RATELIMITMAX ((uint32_t)1000000)
+#define m_u32RATEBURSTMS ((uint32_t)100)
+#define m_u32RATETOKENSPERFRAME ((uint32_t)1000)
+/* interval of the latency summary in the remoteproc trace buffer */
+#define m_u32LATENCYLOGMS ((uint32_t)10000)
 
 /* Private macro -------------------------------------------------------------*/
 
 /* Private const -------------------------------------------------------------*/
 const uint8_t m_au8CMD_START[] = {'s','t','a','r','t'};
 const uint8_t m_au8CMD_STOP[] = {'s','t','o','p'};
+const uint8_t m_au8CMD_BINARY[] = {'b','i','n','a','r','y'};
+const uint8_t m_au8CMD_ASCII[] = {'a','s','c','i','i'};
 
 /* Private variables ---------------------------------------------------------*/
 bool m_bTxActive = false;
-FDCAN_RxHeaderTypeDef m_stRxHeader;
-
-uint8_t m_au8RxData[m_u32RXDATALENGTH];
+bool m_bBinaryMode = false;
+CanRecord_BatchStruct_t m_stCanRecordBatch;
+CanFilter_TableStruct_t m_stCanFilterTable;
 uint8_t m_au8CanFdTrace[m_u32CANFDTRACELENGTH];
+uint8_t *m_pu8RecordTxBuffer = NULL;
+uint8_t m_au8CommandResponse[m_u32CANCOMMAND_MAXLENGTH];
+
+uint32_t m_u32RxFrames = 0;
+uint32_t m_u32RxRateLimited = 0;
+uint32_t m_u32RateLimit = 0;
+uint32_t m_u32RateTokens = 0;
+uint32_t m_u32RateTick = 0;
+
+CanLatency_Struct_t m_stCanLatency;
+uint32_t m_u32RxBytes = 0;
+uint32_t m_u32RpmsgFailed = 0;
+uint32_t m_u32BatchOldestCycles = 0;
+bool m_bBatchHasRxFrame = false;
+bool m_bTxBufferBusy = false;
+uint32_t m_u32LatencyLogTick = 0;
+uint32_t m_u32LatencyLogCount = 0;
+
+TxBatch_Struct_t m_astTxBatch[m_u32TXBATCHES];
+uint32_t m_u32TxBatchTail = 0;
+uint32_t m_u32TxBatchCount = 0;
+uint32_t m_u32TxBatchDropped = 0;
+uint32_t m_u32TxFrames = 0;
+uint32_t m_u32TxInvalid = 0;
+uint8_t m_u8TxMarker = 0;
 
 VIRT_UART_HandleTypeDef huart0;
 VIRT_UART_HandleTypeDef huart1;
@@ -59,215 +116,933 @@ uint8_t VirtUart1ChannelBuffRx[MAX_BUFFER_SIZE];
 uint16_t VirtUart1ChannelRxSize = 0;
 
 /* Private function prototypes -----------------------------------------------*/
-void vUint8ToHex(uint8_t u8Input, LxUtilities_Hex8Struct_t *const pstHex8Result);
-uint8_t u8GetCanHeaderDataLength(uint32_t u32DataLengthCode);
-bool bCreateCanFdTrace(FDCAN_RxHeaderTypeDef *pstRxHeader, uint32_t u32RxCount, uint8_t au8RxData[], uint8_t au8TraceData[]);
+bool bCreateCanFdTrace(const CanRing_FrameStruct_t *pstFrame, uint32_t u32RxCount, uint8_t au8TraceData[]);
+bool bAddCanRecord(const CanRing_FrameStruct_t *pstFrame, bool bTxEvent);
+void vAttachCanRecordBuffer(void);
+uint8_t *pu8AcquireTxBuffer(uint32_t u32Length, bool bWait);
+bool bSendTxBuffer(uint8_t *pu8Buffer, uint32_t u32Length, const uint32_t *pu32OldestCycles, uint32_t u32KickStart);
+bool bTransmitData(const uint8_t au8Data[], uint32_t u32Length, const uint32_t *pu32OldestCycles, bool bWait);
+void vSendCanRecordBatch(void);
+void vLogCanLatency(void);
+bool bHoldCanTxBatch(VIRT_UART_HandleTypeDef *huart);
+void vReleaseRpmsgBuffer(VIRT_UART_HandleTypeDef *huart, void *pvBuffer);
+void vTransmitCanBatches(void);
+void vConfirmCanTransmits(void);
+bool bPassRateLimit(void);
+void vApplyCanFilter(const uint8_t au8Message[], uint16_t u16Size);
+CanCommand_Status_t eCommandStart(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength);
+CanCommand_Status_t eCommandStop(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength);
+CanCommand_Status_t eCommandSetFormat(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength);
+CanCommand_Status_t eCommandFilterClear(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength);
+CanCommand_Status_t eCommandFilterAdd(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength);
+CanCommand_Status_t eCommandFilterApply(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength);
+CanCommand_Status_t eCommandGetStats(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength);
+CanCommand_Status_t eCommandSetRateLimit(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength);
+CanCommand_Status_t eCommandGetVersion(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength);
+CanCommand_Status_t eCommandGetLatency(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength);
+void vApplicationControl(const uint8_t au8Message[], uint16_t u16Size);
+void vApplicationService(void);
 void vApplicationDo(void);
+#if defined(CAN_BRIDGE_FREERTOS)
+bool bBridgeIngest(void *pvItem);
+void vBridgeFormat(const void *pvItem);
+void vBridgeFlush(void);
+void vBridgeService(void);
+bool bBridgeTransmit(const uint8_t au8Message[], uint32_t u32Length, const uint32_t *pu32OldestCycles);
+#endif
 void SystemClock_Config(void);
 void VIRT_UART0_RxCpltCallback(VIRT_UART_HandleTypeDef *huart);
 void VIRT_UART1_RxCpltCallback(VIRT_UART_HandleTypeDef *huart);
 void Error_Handler(void);
 
+/* binary commands of channel 0, see can_command.h */
+static const CanCommand_EntryStruct_t m_astCOMMANDS[] = {
+    { m_u8CANCOMMAND_START, 0u, 0u, eCommandStart },
+    { m_u8CANCOMMAND_STOP, 0u, 0u, eCommandStop },
+    { m_u8CANCOMMAND_SETFORMAT, 1u, 1u, eCommandSetFormat },
+    { m_u8CANCOMMAND_FILTERCLEAR, 0u, 0u, eCommandFilterClear },
+    { m_u8CANCOMMAND_FILTERADD, m_u32CANCOMMAND_FILTERADDLENGTH, m_u32CANCOMMAND_FILTERADDLENGTH, eCommandFilterAdd },
+    { m_u8CANCOMMAND_FILTERAPPLY, 0u, 0u, eCommandFilterApply },
+    { m_u8CANCOMMAND_GETSTATS, 0u, 0u, eCommandGetStats },
+    { m_u8CANCOMMAND_SETRATELIMIT, 4u, 4u, eCommandSetRateLimit },
+    { m_u8CANCOMMAND_GETVERSION, 0u, 0u, eCommandGetVersion },
+    { m_u8CANCOMMAND_GETLATENCY, 0u, 1u, eCommandGetLatency },
+};
+
+#if defined(CAN_BRIDGE_FREERTOS)
+/* task configuration replacing vApplicationDo(), see can_bridge.h */
+static const CanBridge_ConfigStruct_t m_stBRIDGE = {
+    sizeof(BridgeItem_Struct_t), bBridgeIngest, vBridgeFormat, vBridgeFlush, vBridgeService, bBridgeTransmit
+};
+#endif
+
+/**
+ * @brief  Create readable a ascii string from the raw can data in the same format like a can trace output.
+ * @retval false in case of a converting error.
+ */
+bool bCreateCanFdTrace(const CanRing_FrameStruct_t *pstFrame, uint32_t u32RxCount, uint8_t au8TraceData[]) {
+
+    vCanTrace_Format(au8TraceData, u32RxCount, pstFrame->stHeader.RxTimestamp, pstFrame->stHeader.Identifier,
+            u8CanTrace_GetDataLength(pstFrame->stHeader.DataLength), pstFrame->au8Data);
+
+    return true;
+}
+
+/**
+ * @brief  Appends a received frame as binary record to m_stCanRecordBatch. A
+ *         TX event is added as confirmation record carrying the message marker.
+ * @retval false in case the batch is full and must be sent first.
+ */
+bool bAddCanRecord(const CanRing_FrameStruct_t *pstFrame, bool bTxEvent) {
+
+    CanRecord_RecordStruct_t stRecord;
+
+    stRecord.u64Timestamp = pstFrame->u64Timestamp;
+    stRecord.u32Identifier = pstFrame->stHeader.Identifier;
+    stRecord.u8Flags = 0u;
+    if (pstFrame->stHeader.IdType == FDCAN_EXTENDED_ID) {
+        stRecord.u8Flags |= m_u8CANRECORD_FLAG_EXTENDEDID;
+    }
+    if (pstFrame->stHeader.FDFormat == FDCAN_FD_CAN) {
+        stRecord.u8Flags |= m_u8CANRECORD_FLAG_FDFORMAT;
+    }
+    if (pstFrame->stHeader.BitRateSwitch == FDCAN_BRS_ON) {
+        stRecord.u8Flags |= m_u8CANRECORD_FLAG_BITRATESWITCH;
+    }
+    if (pstFrame->stHeader.ErrorStateIndicator == FDCAN_ESI_PASSIVE) {
+        stRecord.u8Flags |= m_u8CANRECORD_FLAG_ERRORPASSIVE;
+    }
+    if (pstFrame->stHeader.RxFrameType == FDCAN_REMOTE_FRAME) {
+        stRecord.u8Flags |= m_u8CANRECORD_FLAG_REMOTEFRAME;
+    }
+    stRecord.u8Length = u8CanTrace_GetDataLength(pstFrame->stHeader.DataLength);
+    stRecord.pu8Data = pstFrame->au8Data;
+    if (bTxEvent == true) {
+        stRecord.u8Flags |= m_u8CANRECORD_FLAG_TXEVENT;
+        stRecord.u8Length = 1u;
+    }
+
+    vAttachCanRecordBuffer();
+    return bCanRecord_BatchAdd(&m_stCanRecordBatch, &stRecord);
+}
+
 /**
- * @brief  Converts a uint8_t value into a hex8 value.
+ * @brief  Lets an empty batch collect its records directly in a TX buffer of
+ *         channel 1, the batch is sent without a copy. Does not wait, without
+ *         a free buffer the records go to au8Buffer and are copied when sent.
+ *         With CAN_BRIDGE_FREERTOS only the rpmsg task takes TX buffers.
  * @retval void
  */
-void vUint8ToHex(uint8_t u8Input, LxUtilities_Hex8Struct_t *const pstHex8Result) {
+void vAttachCanRecordBuffer(void) {
 
-    uint8_t u8LowNibble = u8Input & 0x0Fu;
-    uint8_t u8HighNibble = (u8Input >> 4u) & 0x0Fu;
+#if !defined(CAN_BRIDGE_FREERTOS)
+    uint32_t u32Start;
+    uint16_t u16Size;
 
-    ((uint8_t *)pstHex8Result->u8Digits)[0u] = (u8HighNibble < 10u) ? (48u + u8HighNibble) : (55u + u8HighNibble);
-    ((uint8_t *)pstHex8Result->u8Digits)[1u] = (u8LowNibble < 10u) ? (48u + u8LowNibble) : (55u + u8LowNibble);
+    if ((m_pu8RecordTxBuffer != NULL) || (bCanRecord_BatchIsEmpty(&m_stCanRecordBatch) == false)) {
+        return;
+    }
+    u32Start = DWT->CYCCNT;
+    if (VIRT_UART_AcquireTxBuffer(&huart1, &m_pu8RecordTxBuffer, &u16Size, 0u) != VIRT_UART_OK) {
+        m_pu8RecordTxBuffer = NULL;
+        return;
+    }
+    vCanLatency_Add(&m_stCanLatency, CANLATENCY_STAGE_ACQUIRE, DWT->CYCCNT - u32Start);
+    if (u16Size < (m_u32CANRECORD_BATCHHEADERLENGTH + m_u32CANRECORD_HEADERLENGTH + m_u32CANRECORD_MAXDATALENGTH)) {
+        /* holds no full record, give it back empty, the batch stays in au8Buffer */
+        m_u32RpmsgFailed++;
+        (void)VIRT_UART_TransmitNoCopy(&huart1, m_pu8RecordTxBuffer, 0u);
+        m_pu8RecordTxBuffer = NULL;
+        return;
+    }
+    vCanRecord_BatchAttach(&m_stCanRecordBatch, m_pu8RecordTxBuffer, u16Size);
+#endif
 }
 
 /**
- * @brief  converts the coded header data length in a uint8_t value.
- * @retval data length of the CAN frame as uint8_t.
+ * @brief  Takes a TX buffer of channel 1 to write a message into in place and
+ *         measures the wait for it. The buffer must be sent with bSendTxBuffer().
+ * @param  bWait  wait for a free TX buffer, otherwise m_bTxBufferBusy is set
+ *                while Linux holds all buffers.
+ * @retval NULL in case no buffer of u32Length bytes is available.
  */
-uint8_t u8GetCanHeaderDataLength(uint32_t u32DataLengthCode) {
-    uint8_t u8DataLength = 0;
-    switch (u32DataLengthCode) {
-    case FDCAN_DLC_BYTES_0:
-        u8DataLength = 0;
-        break;
+uint8_t *pu8AcquireTxBuffer(uint32_t u32Length, bool bWait) {
 
-    case FDCAN_DLC_BYTES_1:
-        u8DataLength = 1;
-        break;
+    uint32_t u32Start = DWT->CYCCNT;
+    uint8_t *pu8Buffer;
+    uint16_t u16Size;
 
-    case FDCAN_DLC_BYTES_2:
-        u8DataLength = 2;
+    switch (VIRT_UART_AcquireTxBuffer(&huart1, &pu8Buffer, &u16Size, (bWait == true) ? 1u : 0u)) {
+    case VIRT_UART_OK:
         break;
+    case VIRT_UART_BUSY:
+        m_bTxBufferBusy = true;
+        return NULL;
+    default:
+        m_u32RpmsgFailed++;
+        return NULL;
+    }
+    if (u16Size < u32Length) {
+        m_u32RpmsgFailed++;
+        return NULL;
+    }
+    vCanLatency_Add(&m_stCanLatency, CANLATENCY_STAGE_ACQUIRE, DWT->CYCCNT - u32Start);
+    return pu8Buffer;
+}
 
-    case FDCAN_DLC_BYTES_3:
-        u8DataLength = 3;
-        break;
+/**
+ * @brief  Sends the first u32Length bytes of a TX buffer taken with
+ *         pu8AcquireTxBuffer() on channel 1.
+ * @param  pu32OldestCycles  dequeue stamp of the oldest frame in the message,
+ *                           NULL in case it carries no received frame.
+ * @param  u32KickStart  start of the kick stage, includes a copy into the buffer.
+ * @retval false in case the message could not be sent.
+ */
+bool bSendTxBuffer(uint8_t *pu8Buffer, uint32_t u32Length, const uint32_t *pu32OldestCycles, uint32_t u32KickStart) {
 
-    case FDCAN_DLC_BYTES_4:
-        u8DataLength = 4;
-        break;
+    uint32_t u32Kicked;
 
-    case FDCAN_DLC_BYTES_5:
-        u8DataLength = 5;
-        break;
+    if (VIRT_UART_TransmitNoCopy(&huart1, pu8Buffer, (uint16_t)u32Length) != VIRT_UART_OK) {
+        m_u32RpmsgFailed++;
+        return false;
+    }
+    u32Kicked = DWT->CYCCNT;
 
-    case FDCAN_DLC_BYTES_6:
-        u8DataLength = 6;
-        break;
+    vCanLatency_Add(&m_stCanLatency, CANLATENCY_STAGE_KICK, u32Kicked - u32KickStart);
+    if (pu32OldestCycles != NULL) {
+        vCanLatency_Add(&m_stCanLatency, CANLATENCY_STAGE_TOTAL, u32Kicked - *pu32OldestCycles);
+    }
+    return true;
+}
 
-    case FDCAN_DLC_BYTES_7:
-        u8DataLength = 7;
-        break;
+/**
+ * @brief  Sends one message on channel 1 like VIRT_UART_Transmit(), but takes
+ *         the TX buffer and sends it in two steps to measure the wait for a
+ *         free buffer and the copy and kick separately.
+ * @param  pu32OldestCycles  dequeue stamp of the oldest frame in the message,
+ *                           NULL in case it carries no received frame.
+ * @param  bWait  wait for a free TX buffer, otherwise m_bTxBufferBusy is set
+ *                and the message is not sent while Linux holds all buffers.
+ * @retval false in case the message could not be sent.
+ */
+bool bTransmitData(const uint8_t au8Data[], uint32_t u32Length, const uint32_t *pu32OldestCycles, bool bWait) {
 
-    case FDCAN_DLC_BYTES_8:
-        u8DataLength = 8;
-        break;
+    uint32_t u32Acquired;
+    uint8_t *pu8Buffer = pu8AcquireTxBuffer(u32Length, bWait);
 
-    case FDCAN_DLC_BYTES_12:
-        u8DataLength = 12;
-        break;
+    if (pu8Buffer == NULL) {
+        return false;
+    }
+    u32Acquired = DWT->CYCCNT;
 
-    case FDCAN_DLC_BYTES_16:
-        u8DataLength = 16;
-        break;
+    memcpy(pu8Buffer, au8Data, u32Length);
+    return bSendTxBuffer(pu8Buffer, u32Length, pu32OldestCycles, u32Acquired);
+}
 
-    case FDCAN_DLC_BYTES_20:
-        u8DataLength = 20;
-        break;
+/**
+ * @brief  Sends the collected binary records with one RPMsg message on channel 1,
+ *         with CAN_BRIDGE_FREERTOS passes them to the rpmsg task. Records
+ *         collected in a TX buffer are sent without a copy.
+ * @retval void
+ */
+void vSendCanRecordBatch(void) {
 
-    case FDCAN_DLC_BYTES_32:
-        u8DataLength = 32;
-        break;
+    uint32_t u32Length;
+#if !defined(CAN_BRIDGE_FREERTOS)
+    bool bSent;
+#endif
 
-    case FDCAN_DLC_BYTES_48:
-        u8DataLength = 48;
-        break;
+    if (bCanRecord_BatchIsEmpty(&m_stCanRecordBatch) == true) {
+        return;
+    }
 
-    case FDCAN_DLC_BYTES_64:
-        u8DataLength = 64;
-        break;
+    u32Length = u32CanRecord_BatchFinish(&m_stCanRecordBatch);
+#if defined(CAN_BRIDGE_FREERTOS)
+    (void)bCanBridge_Send(m_stCanRecordBatch.au8Buffer, u32Length,
+            (m_bBatchHasRxFrame == true) ? &m_u32BatchOldestCycles : NULL);
+#else
+    if (m_pu8RecordTxBuffer != NULL) {
+        bSent = bSendTxBuffer(m_pu8RecordTxBuffer, u32Length,
+                (m_bBatchHasRxFrame == true) ? &m_u32BatchOldestCycles : NULL, DWT->CYCCNT);
+        m_pu8RecordTxBuffer = NULL;
+        vCanRecord_BatchAttach(&m_stCanRecordBatch, NULL, 0u);
+    } else {
+        bSent = bTransmitData(m_stCanRecordBatch.au8Buffer, u32Length,
+                (m_bBatchHasRxFrame == true) ? &m_u32BatchOldestCycles : NULL, true);
+    }
+    if (bSent == false) {
+        BSP_LED_On(LED_RED);
+    } else {
+        BSP_LED_Off(LED_RED);
+    }
+#endif
+    vCanRecord_BatchReset(&m_stCanRecordBatch);
+    m_bBatchHasRxFrame = false;
+}
 
-    default:
-        u8DataLength = 0;
-        break;
+/**
+ * @brief  Writes the latency statistics to the remoteproc trace buffer, at most
+ *         every m_u32LATENCYLOGMS and only when frames were forwarded.
+ * @retval void
+ */
+void vLogCanLatency(void) {
+
+    const CanLatency_StageStruct_t *pstStage;
+    CanRing_StatsStruct_t stRxStats;
+    uint32_t u32CyclesPerUs = SystemCoreClock / 1000000u;
 
-        return u8DataLength;
+    if (((HAL_GetTick() - m_u32LatencyLogTick) < m_u32LATENCYLOGMS) || (m_u32LatencyLogCount == m_u32RxFrames)) {
+        return;
+    }
+    m_u32LatencyLogTick = HAL_GetTick();
+    m_u32LatencyLogCount = m_u32RxFrames;
+
+    vCanRing_GetStats(&stCanRxRing, &stRxStats);
+    log_info("can: %lu frames, %lu ring overflow, %lu fifo lost, %lu rpmsg failed\r\n",
+            (unsigned long)m_u32RxFrames, (unsigned long)stRxStats.u32RingOverflow,
+            (unsigned long)stRxStats.u32FifoLost, (unsigned long)m_u32RpmsgFailed);
+    for (uint32_t i = 0; i < CANLATENCY_STAGE_COUNT; i++) {
+        pstStage = &m_stCanLatency.astStages[i];
+        if (pstStage->u32Count == 0u) {
+            continue;
+        }
+        log_info("can %s: n %lu min %lu avg %lu max %lu us\r\n", pcCanLatency_StageName((CanLatency_Stage_t)i),
+                (unsigned long)pstStage->u32Count, (unsigned long)(pstStage->u32Min / u32CyclesPerUs),
+                (unsigned long)(u32CanLatency_GetAverage(pstStage) / u32CyclesPerUs),
+                (unsigned long)(pstStage->u32Max / u32CyclesPerUs));
     }
 }
 
 /**
- * @brief  Create readable a ascii string from the raw can data in the same format like a can trace output.
- * @retval false in case of a converting error.
+ * @brief  Takes a TX batch received on channel 1. The RPMsg buffer is held
+ *         until all frames are in the TX FIFO, so Linux runs out of buffers and
+ *         blocks instead of frames being dropped while the CAN bus is busy.
+ * @retval false in case the message is no TX batch.
  */
-bool bCreateCanFdTrace(FDCAN_RxHeaderTypeDef *pstRxHeader, uint32_t u32RxCount, uint8_t au8RxData[], uint8_t au8TraceData[]) {
+bool bHoldCanTxBatch(VIRT_UART_HandleTypeDef *huart) {
+
+    TxBatch_Struct_t *pstBatch;
+
+    if (i32CanRecord_BatchCheck(huart->pRxBuffPtr, huart->RxXferSize) <= 0) {
+        return false;
+    }
+    if (huart->pRxBuffPtr[3] == 0u) {
+        return true;
+    }
+    if (m_u32TxBatchCount == m_u32TXBATCHES) {
+        /* not reached, Linux has no buffer to send while all of them are held */
+        m_u32TxBatchDropped++;
+        return true;
+    }
 
-    /*Field 0 - Message number: start at position 0, right align, max. 7 places*/
-    snprintf((void*) &(au8TraceData[0]), 8, "%07u", u32RxCount);
+    rpmsg_hold_rx_buffer(&huart->ept, huart->pRxBuffPtr);
+    pstBatch = &m_astTxBatch[(m_u32TxBatchTail + m_u32TxBatchCount) % m_u32TXBATCHES];
+    pstBatch->pu8Batch = huart->pRxBuffPtr;
+    pstBatch->u32Offset = m_u32CANRECORD_BATCHHEADERLENGTH;
+    pstBatch->u32Remaining = huart->pRxBuffPtr[3];
+    m_u32TxBatchCount++;
 
-    /*Field 1 - TimeOffset[ms]: start at position 8, right align, max. 9 places for [s] max 3 places for [ms]*/
-    uint32_t u32Timestamp1s = pstRxHeader->RxTimestamp / 1000u;
-    uint32_t u32Timestamp1ms = pstRxHeader->RxTimestamp % 1000u;
-    snprintf((void*) &(au8TraceData[8]), 10, "%09u", u32Timestamp1s);
-    au8TraceData[17] = '.';
-    snprintf((void*) &(au8TraceData[18]), 4, "%03u", u32Timestamp1ms);
+    return true;
+}
 
-    /*Field 2 - Type:  start at position 22, 2 places */
-    snprintf((void*) &(au8TraceData[22]), 3, "%s", "FB");
+/**
+ * @brief  Returns a held RPMsg buffer to Linux.
+ * @retval void
+ */
+void vReleaseRpmsgBuffer(VIRT_UART_HandleTypeDef *huart, void *pvBuffer) {
+    /* notifies Linux, which may wait for a free buffer */
+    rpmsg_release_rx_buffer(&huart->ept, pvBuffer);
+}
 
-    /*Field 3 - CanId:  start at position 25, right align, max 8 places */
-    snprintf((void*) &(au8TraceData[25]), 9, "%08X", pstRxHeader->Identifier);
+/**
+ * @brief  Moves the frames of the held TX batches into the TX FIFO as long as
+ *         it has free elements. Every record gets the next message marker, also
+ *         a record which is no valid frame and is skipped.
+ * @retval void
+ */
+void vTransmitCanBatches(void) {
 
-    /*Field 4 - Rx/Tx:  start at position 34, 2 places */
-    snprintf((void*) &(au8TraceData[34]), 3, "%s", "Rx");
+    TxBatch_Struct_t *pstBatch;
+    CanRecord_RecordStruct_t stRecord;
 
-    /*Field 5 - Data length: start at position 37, 2 places */
-    snprintf((void*) &(au8TraceData[37]), 3, "%02u", u8GetCanHeaderDataLength(pstRxHeader->DataLength));
+    while (m_u32TxBatchCount != 0u) {
+        pstBatch = &m_astTxBatch[m_u32TxBatchTail];
+        while (pstBatch->u32Remaining != 0u) {
+            if (HAL_FDCAN_GetTxFifoFreeLevel(&hfdcan2) == 0u) {
+                return;
+            }
+            pstBatch->u32Offset = u32CanRecord_BatchGetRecord(pstBatch->pu8Batch, pstBatch->u32Offset, &stRecord);
+            if (bFdcan2_Transmit(&stRecord, m_u8TxMarker) == true) {
+                m_u32TxFrames++;
+            } else {
+                m_u32TxInvalid++;
+            }
+            m_u8TxMarker++;
+            pstBatch->u32Remaining--;
+        }
 
-    /*Field 6 - Data: start at position 41, 192 places */
-    for (int i = 0; i < m_u32RXDATALENGTH; i++) {
-        vUint8ToHex(au8RxData[i],
-        (void*) &(au8TraceData[40 + 3 * i]));
+        vReleaseRpmsgBuffer(&huart1, pstBatch->pu8Batch);
+        m_u32TxBatchTail = (m_u32TxBatchTail + 1u) % m_u32TXBATCHES;
+        m_u32TxBatchCount--;
     }
+}
+
+/**
+ * @brief  Reports the transmitted frames in binary mode, in ASCII mode the
+ *         TX events are discarded.
+ * @retval void
+ */
+void vConfirmCanTransmits(void) {
 
-    /* replace null termination from snprintf with space*/
-    for (uint32_t i = 0; i < m_u32CANFDTRACELENGTH; i++) {
-        if (au8TraceData[i] == 0x00) {
-            au8TraceData[i] = 32;
+    CanRing_FrameStruct_t *pstFrame;
+
+    while ((pstFrame = pstCanRing_GetReadSlot(&stCanTxEventRing)) != NULL) {
+        if (m_bBinaryMode == true) {
+            if (bAddCanRecord(pstFrame, true) == false) {
+                vSendCanRecordBatch();
+                bAddCanRecord(pstFrame, true);
+            }
         }
+        vCanRing_Release(&stCanTxEventRing);
+    }
+    vSendCanRecordBatch();
+}
+
+/**
+ * @brief  Token bucket limiting the frames forwarded to Linux to m_u32RateLimit
+ *         frames per second, bursts up to m_u32RATEBURSTMS worth of frames pass.
+ * @retval false in case the frame must be dropped.
+ */
+bool bPassRateLimit(void) {
+
+    uint32_t u32Tick;
+    uint32_t u32Elapsed;
+    uint32_t u32Bucket;
+
+    if (m_u32RateLimit == 0u) {
+        return true;
     }
 
-    /*Line End 1 places*/
-    au8TraceData[m_u32CANFDTRACELENGTH - 1] = '\n';
+    u32Tick = HAL_GetTick();
+    u32Elapsed = u32Tick - m_u32RateTick;
+    m_u32RateTick = u32Tick;
+    if (u32Elapsed > m_u32RATEBURSTMS) {
+        u32Elapsed = m_u32RATEBURSTMS;
+    }
+    /* tokens per ms = frames per s */
+    u32Bucket = m_u32RateLimit * m_u32RATEBURSTMS;
+    if (u32Bucket < m_u32RATETOKENSPERFRAME) {
+        u32Bucket = m_u32RATETOKENSPERFRAME;
+    }
+    m_u32RateTokens += u32Elapsed * m_u32RateLimit;
+    if (m_u32RateTokens > u32Bucket) {
+        m_u32RateTokens = u32Bucket;
+    }
 
+    if (m_u32RateTokens < m_u32RATETOKENSPERFRAME) {
+        m_u32RxRateLimited++;
+        return false;
+    }
+    m_u32RateTokens -= m_u32RATETOKENSPERFRAME;
     return true;
 }
 
+/**
+ * @brief  Handles a "filter" control message and reports the result on channel 0.
+ *         Frames rejected by the programmed filters never reach the RX FIFO.
+ * @retval void
+ */
+void vApplyCanFilter(const uint8_t au8Message[], uint16_t u16Size) {
+
+    static const char s_acPREFIX[] = "filter: ";
+    static const char s_acEND[] = "\n";
+    struct rpmsg_iovec astReply[3];
+    const char *pcText;
+    CanFilter_Result_t eResult = eCanFilter_Parse(&m_stCanFilterTable, au8Message, u16Size);
+
+    if (eResult == CANFILTER_NOCOMMAND) {
+        return;
+    }
+
+    pcText = pcCanFilter_ResultText(eResult);
+    if ((eResult == CANFILTER_APPLY) || (eResult == CANFILTER_CLEARED)) {
+        if (bFdcan2_ApplyFilters(&m_stCanFilterTable) == false) {
+            pcText = "programming failed";
+        }
+    }
+
+    /* prefix, text and line end are gathered in the TX buffer */
+    astReply[0].base = s_acPREFIX;
+    astReply[0].len = (int)sizeof(s_acPREFIX) - 1;
+    astReply[1].base = pcText;
+    astReply[1].len = (int)strlen(pcText);
+    astReply[2].base = s_acEND;
+    astReply[2].len = (int)sizeof(s_acEND) - 1;
+    VIRT_UART_TransmitV(&huart0, astReply, 3u);
+}
+
+/**
+ * @brief  Starts forwarding the received frames to Linux.
+ * @retval CANCOMMAND_OK
+ */
+CanCommand_Status_t eCommandStart(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength) {
+    (void)au8Payload; (void)u16Length; (void)au8Data; (void)pu16DataLength;
+    m_bTxActive = true;
+    return CANCOMMAND_OK;
+}
+
+/**
+ * @brief  Stops forwarding, frames received while stopped are discarded.
+ * @retval CANCOMMAND_OK
+ */
+CanCommand_Status_t eCommandStop(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength) {
+    (void)au8Payload; (void)u16Length; (void)au8Data; (void)pu16DataLength;
+    m_bTxActive = false;
+    return CANCOMMAND_OK;
+}
+
+/**
+ * @brief  Selects ASCII trace lines or binary record batches on channel 1.
+ * @retval CANCOMMAND_ERROR_VALUE for an unknown format.
+ */
+CanCommand_Status_t eCommandSetFormat(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength) {
+    (void)u16Length; (void)au8Data; (void)pu16DataLength;
+
+    if (au8Payload[0] == m_u8CANCOMMAND_FORMAT_BINARY) {
+        m_bBinaryMode = true;
+    } else if (au8Payload[0] == m_u8CANCOMMAND_FORMAT_ASCII) {
+        /* a partly filled batch is sent at the end of the frame pass, before the control messages */
+        m_bBinaryMode = false;
+    } else {
+        return CANCOMMAND_ERROR_VALUE;
+    }
+    return CANCOMMAND_OK;
+}
+
+/**
+ * @brief  Empties the filter table and programs it, all frames are received again.
+ * @retval CANCOMMAND_ERROR_FAILED in case FDCAN2 could not be configured.
+ */
+CanCommand_Status_t eCommandFilterClear(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength) {
+    (void)au8Payload; (void)u16Length; (void)au8Data; (void)pu16DataLength;
+
+    vCanFilter_Init(&m_stCanFilterTable);
+    return (bFdcan2_ApplyFilters(&m_stCanFilterTable) == true) ? CANCOMMAND_OK : CANCOMMAND_ERROR_FAILED;
+}
+
+/**
+ * @brief  Appends a rule to the filter table, it takes effect with FILTERAPPLY.
+ * @retval CANCOMMAND_ERROR_VALUE for an invalid rule, CANCOMMAND_ERROR_NOSPACE
+ *         in case the table is full.
+ */
+CanCommand_Status_t eCommandFilterAdd(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength) {
+
+    CanFilter_RuleStruct_t stRule;
+
+    (void)u16Length; (void)au8Data; (void)pu16DataLength;
+    if (au8Payload[0] > 1u) {
+        return CANCOMMAND_ERROR_VALUE;
+    }
+    stRule.u8Type = au8Payload[1];
+    stRule.u8Config = au8Payload[2];
+    stRule.u32Id1 = u32CanCommand_GetUint32(&au8Payload[4]);
+    stRule.u32Id2 = u32CanCommand_GetUint32(&au8Payload[8]);
+
+    switch (eCanFilter_Add(&m_stCanFilterTable, au8Payload[0] == 1u, &stRule)) {
+    case CANFILTER_ADDED:
+        return CANCOMMAND_OK;
+    case CANFILTER_ERROR_FULL:
+        return CANCOMMAND_ERROR_NOSPACE;
+    default:
+        return CANCOMMAND_ERROR_VALUE;
+    }
+}
+
+/**
+ * @brief  Programs the filter table into FDCAN2.
+ * @retval CANCOMMAND_ERROR_FAILED in case FDCAN2 could not be configured.
+ */
+CanCommand_Status_t eCommandFilterApply(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength) {
+    (void)au8Payload; (void)u16Length; (void)au8Data; (void)pu16DataLength;
+    return (bFdcan2_ApplyFilters(&m_stCanFilterTable) == true) ? CANCOMMAND_OK : CANCOMMAND_ERROR_FAILED;
+}
+
+/**
+ * @brief  Reports the frame counters in CanCommand_Stat_t order.
+ * @retval CANCOMMAND_OK
+ */
+CanCommand_Status_t eCommandGetStats(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength) {
+
+    uint32_t au32Stats[CANCOMMAND_STAT_COUNT];
+    CanRing_StatsStruct_t stRxStats;
+    CanRing_StatsStruct_t stTxEventStats;
+#if defined(CAN_BRIDGE_FREERTOS)
+    CanBridge_StatsStruct_t stBridgeStats;
+#endif
+
+    (void)au8Payload; (void)u16Length;
+    vCanRing_GetStats(&stCanRxRing, &stRxStats);
+    vCanRing_GetStats(&stCanTxEventRing, &stTxEventStats);
+
+    au32Stats[CANCOMMAND_STAT_RXFRAMES] = m_u32RxFrames;
+    au32Stats[CANCOMMAND_STAT_RXRINGOVERFLOW] = stRxStats.u32RingOverflow;
+#if defined(CAN_BRIDGE_FREERTOS)
+    /* frames dropped between the ingest and the format task */
+    vCanBridge_GetStats(&stBridgeStats);
+    au32Stats[CANCOMMAND_STAT_RXRINGOVERFLOW] += stBridgeStats.u32ItemsDropped;
+#endif
+    au32Stats[CANCOMMAND_STAT_RXFIFOLOST] = stRxStats.u32FifoLost;
+    au32Stats[CANCOMMAND_STAT_RXHIGHWATER] = stRxStats.u32HighWater;
+    au32Stats[CANCOMMAND_STAT_RXRATELIMITED] = m_u32RxRateLimited;
+    au32Stats[CANCOMMAND_STAT_TXFRAMES] = m_u32TxFrames;
+    au32Stats[CANCOMMAND_STAT_TXINVALID] = m_u32TxInvalid;
+    au32Stats[CANCOMMAND_STAT_TXBATCHDROPPED] = m_u32TxBatchDropped;
+    au32Stats[CANCOMMAND_STAT_TXEVENTLOST] = stTxEventStats.u32RingOverflow + stTxEventStats.u32FifoLost;
+    au32Stats[CANCOMMAND_STAT_MIRRORSENT] = stUsart3Queue.stStats.u32Sent;
+    au32Stats[CANCOMMAND_STAT_MIRRORDROPPED] = stUsart3Queue.stStats.u32DroppedNewest
+            + stUsart3Queue.stStats.u32DroppedOldest;
+    au32Stats[CANCOMMAND_STAT_RPMSGFAILED] = m_u32RpmsgFailed;
+    au32Stats[CANCOMMAND_STAT_RXBYTES] = m_u32RxBytes;
+    au32Stats[CANCOMMAND_STAT_UPTIMEMS] = HAL_GetTick();
+    au32Stats[CANCOMMAND_STAT_MIRRORFAILED] = stUsart3Queue.stStats.u32Failed;
+
+    for (uint32_t i = 0; i < CANCOMMAND_STAT_COUNT; i++) {
+        vCanCommand_PutUint32(&au8Data[4u * i], au32Stats[i]);
+    }
+    *pu16DataLength = (uint16_t)(4u * CANCOMMAND_STAT_COUNT);
+    return CANCOMMAND_OK;
+}
+
+/**
+ * @brief  Limits the frames forwarded to Linux, 0 removes the limit.
+ * @retval CANCOMMAND_ERROR_VALUE in case the limit exceeds m_u32RATELIMITMAX.
+ */
+CanCommand_Status_t eCommandSetRateLimit(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength) {
+
+    uint32_t u32Limit = u32CanCommand_GetUint32(au8Payload);
+
+    (void)u16Length; (void)au8Data; (void)pu16DataLength;
+    if (u32Limit > m_u32RATELIMITMAX) {
+        return CANCOMMAND_ERROR_VALUE;
+    }
+    m_u32RateLimit = u32Limit;
+    /* start with a full bucket */
+    m_u32RateTokens = u32Limit * m_u32RATEBURSTMS;
+    m_u32RateTick = HAL_GetTick();
+    return CANCOMMAND_OK;
+}
+
+/**
+ * @brief  Reports the protocol version and the binary record format version.
+ * @retval CANCOMMAND_OK
+ */
+CanCommand_Status_t eCommandGetVersion(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength) {
+    (void)au8Payload; (void)u16Length;
+
+    au8Data[0] = m_u8CANCOMMAND_VERSION;
+    au8Data[1] = m_u8CANRECORD_VERSION;
+    *pu16DataLength = 2u;
+    return CANCOMMAND_OK;
+}
+
+/**
+ * @brief  Reports the latency statistics, optionally clears them afterwards.
+ * @retval CANCOMMAND_ERROR_VALUE for an invalid clear flag.
+ */
+CanCommand_Status_t eCommandGetLatency(const uint8_t au8Payload[], uint16_t u16Length, uint8_t au8Data[], uint16_t *pu16DataLength) {
+
+    if ((u16Length == 1u) && (au8Payload[0] > 1u)) {
+        return CANCOMMAND_ERROR_VALUE;
+    }
+    *pu16DataLength = (uint16_t)u32CanLatency_Encode(&m_stCanLatency, SystemCoreClock / 1000000u, au8Data);
+    if ((u16Length == 1u) && (au8Payload[0] == 1u)) {
+        vCanLatency_Init(&m_stCanLatency);
+    }
+    return CANCOMMAND_OK;
+}
+
+/**
+ * @brief  Handles a control message received on channel 0. Binary commands are
+ *         answered on channel 0, the text commands start, stop, binary, ascii
+ *         and filter are still accepted for manual tests from a terminal.
+ * @retval void
+ */
+void vApplicationControl(const uint8_t au8Message[], uint16_t u16Size) {
+
+    uint32_t u32Length;
+
+    if (bCanCommand_IsCommand(au8Message, u16Size) == true) {
+        u32Length = u32CanCommand_Dispatch(m_astCOMMANDS, sizeof(m_astCOMMANDS) / sizeof(m_astCOMMANDS[0]),
+                au8Message, u16Size, m_au8CommandResponse);
+        if (u32Length != 0u) {
+            VIRT_UART_Transmit(&huart0, m_au8CommandResponse, u32Length);
+        }
+        return;
+    }
+
+    if ((u16Size >= sizeof(m_au8CMD_START)) && (memcmp(au8Message, m_au8CMD_START, sizeof(m_au8CMD_START)) == 0)) {
+        m_bTxActive = true;
+    }
+
+    if ((u16Size >= sizeof(m_au8CMD_STOP)) && (memcmp(au8Message, m_au8CMD_STOP, sizeof(m_au8CMD_STOP)) == 0)) {
+        m_bTxActive = false;
+    }
+
+    if ((u16Size >= sizeof(m_au8CMD_BINARY)) && (memcmp(au8Message, m_au8CMD_BINARY, sizeof(m_au8CMD_BINARY)) == 0)) {
+        m_bBinaryMode = true;
+    }
+
+    if ((u16Size >= sizeof(m_au8CMD_ASCII)) && (memcmp(au8Message, m_au8CMD_ASCII, sizeof(m_au8CMD_ASCII)) == 0)) {
+        m_bBinaryMode = false;
+    }
+
+    vApplyCanFilter(au8Message, u16Size);
+}
+
 /**
  * @brief  This is the main application loop called from main periodically
  * @retval void
  */
 void vApplicationDo(void) {
 
-    static uint32_t s_u32RxCount = 0;
+    CanRing_FrameStruct_t *pstFrame;
+    uint8_t *pu8Trace;
+    uint8_t *pu8TxBuffer;
+    uint32_t u32Frames;
+    uint32_t u32Dequeued;
+    uint32_t u32Picked;
+    uint32_t u32Sending;
+    uint32_t u32Mask;
 
     if(m_bTxActive == true) {
         BSP_LED_On(LED_GREEN);
-        if (HAL_FDCAN_GetRxFifoFillLevel(&hfdcan2, FDCAN_RX_FIFO0) != 0) {
-            s_u32RxCount++;
-            /* Retrieve message from Rx FIFO 0 */
-            memset(m_au8RxData, 0u, sizeof(m_au8RxData));
-            memset(m_au8CanFdTrace, 0u, sizeof(m_au8CanFdTrace));
-
-            if (HAL_FDCAN_GetRxMessage(&hfdcan2, FDCAN_RX_FIFO0, &m_stRxHeader, m_au8RxData) == HAL_OK) {
-
-                m_stRxHeader.RxTimestamp = HAL_GetTick();
-                bCreateCanFdTrace(&m_stRxHeader, s_u32RxCount, m_au8RxData,
-                        m_au8CanFdTrace);
+        /* frames are received by the FDCAN2 interrupt, only format and forward them here.
+         * Only the frames queued at entry are handled so the control channels are not starved. */
+        u32Frames = u32CanRing_GetFillLevel(&stCanRxRing);
+        while ((u32Frames-- != 0u) && ((pstFrame = pstCanRing_GetReadSlot(&stCanRxRing)) != NULL)) {
+            if (bPassRateLimit() == false) {
+                vCanRing_Release(&stCanRxRing);
+                continue;
+            }
+            u32Picked = DWT->CYCCNT;
+            u32Dequeued = pstFrame->u32DequeueCycles;
+            vCanLatency_Add(&m_stCanLatency, CANLATENCY_STAGE_QUEUE, u32Picked - u32Dequeued);
+            m_u32RxFrames++;
+            m_u32RxBytes += u8CanTrace_GetDataLength(pstFrame->stHeader.DataLength);
+            pu8Trace = m_au8CanFdTrace;
+            pu8TxBuffer = NULL;
+            if (m_bBinaryMode == false) {
+                /* format the trace line in place, the wait for the buffer is not part of the format stage */
+                u32Sending = DWT->CYCCNT;
+                pu8TxBuffer = pu8AcquireTxBuffer(m_u32CANFDTRACELENGTH, true);
+                u32Picked += DWT->CYCCNT - u32Sending;
+                if (pu8TxBuffer != NULL) {
+                    pu8Trace = pu8TxBuffer;
+                }
+            }
+            bCreateCanFdTrace(pstFrame, m_u32RxFrames, pu8Trace);
+
+            if (m_bBinaryMode == true) {
+                /* pack as many records as possible into one RPMsg buffer */
+                if (bAddCanRecord(pstFrame, false) == false) {
+                    /* the send of the full batch is not part of the format stage */
+                    u32Sending = DWT->CYCCNT;
+                    vSendCanRecordBatch();
+                    u32Picked += DWT->CYCCNT - u32Sending;
+                    bAddCanRecord(pstFrame, false);
+                }
+                if (m_bBatchHasRxFrame == false) {
+                    m_bBatchHasRxFrame = true;
+                    m_u32BatchOldestCycles = u32Dequeued;
+                }
+            }
+            vCanRing_Release(&stCanRxRing);
+            vCanLatency_Add(&m_stCanLatency, CANLATENCY_STAGE_FORMAT, DWT->CYCCNT - u32Picked);
 
-                HAL_UART_Transmit(&huart3, m_au8CanFdTrace, sizeof(m_au8CanFdTrace), 0xFFFF);
+            /* debug mirror, never blocks the forwarding to Linux */
+            bUsart3_MirrorWrite(pu8Trace, m_u32CANFDTRACELENGTH);
 
-                if (VIRT_UART_Transmit(&huart1, m_au8CanFdTrace, sizeof(m_au8CanFdTrace)) != VIRT_UART_OK) {
+            if (m_bBinaryMode == false) {
+                if ((pu8TxBuffer == NULL)
+                        || (bSendTxBuffer(pu8TxBuffer, m_u32CANFDTRACELENGTH, &u32Dequeued, DWT->CYCCNT) == false)) {
                     BSP_LED_On(LED_RED);
                 } else {
                     BSP_LED_Off(LED_RED);
                 }
             }
         }
+        /* do not hold back a partly filled batch until the next frame arrives */
+        vSendCanRecordBatch();
+        vLogCanLatency();
         BSP_LED_Off(LED_GREEN);
+    } else {
+        /* frames received while stopped are not traced */
+        vCanRing_Flush(&stCanRxRing);
     }
 
-    /* call the polling function to check the open AMP messages*/
+    /* frames from Linux to the CAN bus, the held batches are shared with the
+     * channel 1 callback */
+    u32Mask = MAILBOX_Lock();
+    vTransmitCanBatches();
+    MAILBOX_Unlock(u32Mask);
+    vConfirmCanTransmits();
+
+    vApplicationService();
+}
+
+/**
+ * @brief  Processes the OpenAMP messages and the control channel.
+ * @retval void
+ */
+void vApplicationService(void) {
+
+    uint32_t u32Mask;
+
+    /* call the polling function to check the open AMP messages, a no-op
+     * when the mailbox interrupt processes them */
     OPENAMP_check_for_message();
 
     /* check messages on channel0 --> channel 0 is used for control*/
     if (VirtUart0RxMsg) {
+        /* the next message must not overwrite the buffer under way */
+        u32Mask = MAILBOX_Lock();
         VirtUart0RxMsg = RESET;
-        VIRT_UART_Transmit(&huart0, VirtUart0ChannelBuffRx, VirtUart0ChannelRxSize);
+        vApplicationControl(VirtUart0ChannelBuffRx, VirtUart0ChannelRxSize);
+        MAILBOX_Unlock(u32Mask);
+    }
 
-        if (memcmp(VirtUart0ChannelBuffRx, m_au8CMD_START, sizeof(m_au8CMD_START)) == 0) {
-            m_bTxActive = true;
-        }
+    /* channel 1 is used for data only, TX batches are taken in the callback */
+    if (VirtUart1RxMsg) {
+        VirtUart1RxMsg = RESET;
+    }
+}
 
-        if (memcmp(VirtUart0ChannelBuffRx, m_au8CMD_STOP, sizeof(m_au8CMD_STOP)) == 0) {
-            m_bTxActive = false;
+#if defined(CAN_BRIDGE_FREERTOS)
+/**
+ * @brief  Ingest task: takes the next frame to forward or TX event out of the
+ *         interrupt rings. Rate limit and stop apply here, so dropped frames
+ *         never take space in the item stream.
+ * @retval false in case both rings are empty.
+ */
+bool bBridgeIngest(void *pvItem) {
+
+    BridgeItem_Struct_t *pstItem = (BridgeItem_Struct_t *)pvItem;
+    CanRing_FrameStruct_t *pstFrame;
+
+    while ((pstFrame = pstCanRing_GetReadSlot(&stCanRxRing)) != NULL) {
+        /* frames received while stopped are not traced */
+        if ((m_bTxActive == false) || (bPassRateLimit() == false)) {
+            vCanRing_Release(&stCanRxRing);
+            continue;
         }
+        m_u32RxFrames++;
+        m_u32RxBytes += u8CanTrace_GetDataLength(pstFrame->stHeader.DataLength);
+        pstItem->stFrame = *pstFrame;
+        pstItem->u32RxCount = m_u32RxFrames;
+        pstItem->bTxEvent = false;
+        vCanRing_Release(&stCanRxRing);
+        return true;
     }
 
-    /* check messages on channel1 --> channel 1 is used for data but for tests the control is also here active*/
-    if (VirtUart1RxMsg) {
-        VirtUart1RxMsg = RESET;
-        VIRT_UART_Transmit(&huart0, VirtUart1ChannelBuffRx, VirtUart1ChannelBuffRx);
+    if ((pstFrame = pstCanRing_GetReadSlot(&stCanTxEventRing)) != NULL) {
+        pstItem->stFrame = *pstFrame;
+        pstItem->u32RxCount = 0u;
+        pstItem->bTxEvent = true;
+        vCanRing_Release(&stCanTxEventRing);
+        return true;
+    }
+    return false;
+}
 
-        if (memcmp(VirtUart1ChannelBuffRx, m_au8CMD_START, sizeof(m_au8CMD_START)) == 0) {
-            m_bTxActive = true;
+/**
+ * @brief  Format task: formats one item like the frame loop of
+ *         vApplicationDo(). The queue stage includes the wait in the item stream.
+ * @retval void
+ */
+void vBridgeFormat(const void *pvItem) {
+
+    const BridgeItem_Struct_t *pstItem = (const BridgeItem_Struct_t *)pvItem;
+    uint32_t u32Picked = DWT->CYCCNT;
+    uint32_t u32Dequeued = pstItem->stFrame.u32DequeueCycles;
+    uint32_t u32Sending;
+
+    if (pstItem->bTxEvent == true) {
+        /* in ASCII mode the TX events are discarded */
+        if ((m_bBinaryMode == true) && (bAddCanRecord(&pstItem->stFrame, true) == false)) {
+            vSendCanRecordBatch();
+            bAddCanRecord(&pstItem->stFrame, true);
         }
+        return;
+    }
 
-        if (memcmp(VirtUart1ChannelBuffRx, m_au8CMD_STOP, sizeof(m_au8CMD_STOP)) == 0) {
-            m_bTxActive = false;
+    vCanLatency_Add(&m_stCanLatency, CANLATENCY_STAGE_QUEUE, u32Picked - u32Dequeued);
+    bCreateCanFdTrace(&pstItem->stFrame, pstItem->u32RxCount, m_au8CanFdTrace);
+
+    if (m_bBinaryMode == true) {
+        if (bAddCanRecord(&pstItem->stFrame, false) == false) {
+            /* the wait for space in the message buffer is not part of the format stage */
+            u32Sending = DWT->CYCCNT;
+            vSendCanRecordBatch();
+            u32Picked += DWT->CYCCNT - u32Sending;
+            bAddCanRecord(&pstItem->stFrame, false);
+        }
+        if (m_bBatchHasRxFrame == false) {
+            m_bBatchHasRxFrame = true;
+            m_u32BatchOldestCycles = u32Dequeued;
         }
     }
+    vCanLatency_Add(&m_stCanLatency, CANLATENCY_STAGE_FORMAT, DWT->CYCCNT - u32Picked);
+
+    /* debug mirror, never blocks the forwarding to Linux */
+    bUsart3_MirrorWrite(m_au8CanFdTrace, sizeof(m_au8CanFdTrace));
+
+    if (m_bBinaryMode == false) {
+        (void)bCanBridge_Send(m_au8CanFdTrace, sizeof(m_au8CanFdTrace), &u32Dequeued);
+    }
+}
+
+/**
+ * @brief  Format task: no further item is waiting, send the partly filled batch.
+ * @retval void
+ */
+void vBridgeFlush(void) {
+    vSendCanRecordBatch();
+}
+
+/**
+ * @brief  RPMsg task: OpenAMP messages, control channel and CAN TX. The
+ *         trace buffer is only written by this task.
+ * @retval void
+ */
+void vBridgeService(void) {
+
+    vApplicationService();
+    /* frames from Linux to the CAN bus, resumed by the TX events */
+    vTransmitCanBatches();
+    vLogCanLatency();
+}
+
+/**
+ * @brief  RPMsg task: sends one message on channel 1 without waiting for a
+ *         TX buffer.
+ * @retval false while Linux holds all TX buffers, the message is retried
+ *         after the next IPCC interrupt.
+ */
+bool bBridgeTransmit(const uint8_t au8Message[], uint32_t u32Length, const uint32_t *pu32OldestCycles) {
+
+    m_bTxBufferBusy = false;
+    if (bTransmitData(au8Message, u32Length, pu32OldestCycles, false) == true) {
+        BSP_LED_Off(LED_RED);
+        return true;
+    }
+    if (m_bTxBufferBusy == true) {
+        return false;
+    }
+    /* counted in m_u32RpmsgFailed and dropped */
+    BSP_LED_On(LED_RED);
+    return true;
 }
+#endif
 
 /**
  * @brief  This is the application entry point
@@ -284,13 +1059,17 @@ int main(void) {
         SystemClock_Config();
     }
 
-    log_info("Cortex-M4 boot successful with STM32Cube FW version: v%ld.%ld.%ld \r\n",
-            ((HAL_GetHalVersion() >> 24) & 0x000000FF),
-            ((HAL_GetHalVersion() >> 16) & 0x000000FF),
-            ((HAL_GetHalVersion() >> 8) & 0x000000FF));
+    log_info("Cortex-M4 boot successful with STM32Cube FW version: v%lu.%lu.%lu \r\n",
+            (unsigned long)((HAL_GetHalVersion() >> 24) & 0x000000FF),
+            (unsigned long)((HAL_GetHalVersion() >> 16) & 0x000000FF),
+            (unsigned long)((HAL_GetHalVersion() >> 8) & 0x000000FF));
 
+    MX_DMA_Init();
     MX_USART3_UART_Init();
     MX_FDCAN2_Init();
+    vCanRecord_BatchInit(&m_stCanRecordBatch);
+    vCanFilter_Init(&m_stCanFilterTable);
+    vCanLatency_Init(&m_stCanLatency);
 
     BSP_LED_Init(LED_GREEN);
     BSP_LED_Init(LED_RED);
@@ -301,8 +1080,10 @@ int main(void) {
     __HAL_RCC_HSEM_CLK_ENABLE();
     /* IPCC initialisation */
     MX_IPCC_Init();
-    /* OpenAmp initialisation */
-    MX_OPENAMP_Init(RPMSG_REMOTE, NULL);
+    /* OpenAmp initialisation, fails if the vrings do not fit the shared memory */
+    if (MX_OPENAMP_Init(RPMSG_REMOTE, NULL) != 0) {
+        Error_Handler();
+    }
 
     /* Start FDCAN controller (continuous listening CAN bus) */
     if (HAL_FDCAN_Start(&hfdcan2) != HAL_OK) {
@@ -331,10 +1112,16 @@ int main(void) {
         Error_Handler();
     }
 
+#if defined(CAN_BRIDGE_FREERTOS)
+    /* the bridge tasks replace the main loop, bCanBridge_Run() does not return */
+    (void)bCanBridge_Run(&m_stBRIDGE);
+    Error_Handler();
+#else
     /* do the main application loop */
     while (1) {
         vApplicationDo();
     }
+#endif
 }
 
 /**
@@ -469,6 +1256,11 @@ void VIRT_UART0_RxCpltCallback(VIRT_UART_HandleTypeDef *huart) {
  */
 void VIRT_UART1_RxCpltCallback(VIRT_UART_HandleTypeDef *huart) {
 
+    /* binary frames to transmit are no control message */
+    if (bHoldCanTxBatch(huart) == true) {
+        return;
+    }
+
     log_info("Msg received on VIRTUAL UART1 channel:  %s \n\r", (char* ) huart->pRxBuffPtr);
 
     /* copy received msg in a variable to sent it back to master processor in main infinite loop*/
@@ -37,15 +37,17 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN Define */
-
+#include <metal/atomic.h>
+#include "openamp.h"
+#include "can_bridge.h"
 /* USER CODE END Define */
 #define MASTER_CPU_ID    0
 #define REMOTE_CPU_ID    1
 #define IPCC_CPU_A7      MASTER_CPU_ID
 #define IPCC_CPU_M4      REMOTE_CPU_ID
-#define MBOX_NO_MSG       0
-#define MBOX_NEW_MSG       1
-#define MBOX_BUF_FREE      2
+/* Bits of mbox_pending, set by the IPCC interrupt */
+#define MBOX_BUF_FREE      (1U << 0) /* channel 1, vring 0 */
+#define MBOX_NEW_MSG       (1U << 1) /* channel 2, vring 1 */
 
 /* Private variables ---------------------------------------------------------*/
 /* USER CODE BEGIN PFP */
@@ -53,14 +55,18 @@
 /* USER CODE END PFP */
 
 extern IPCC_HandleTypeDef hipcc;
-int msg_received_ch1 = MBOX_NO_MSG;
-int msg_received_ch2 = MBOX_NO_MSG;
+static atomic_uint mbox_pending = ATOMIC_VAR_INIT(0);
+static MAILBOX_StatsTypeDef mbox_stats_ch1;
+static MAILBOX_StatsTypeDef mbox_stats_ch2;
+/* Set by MAILBOX_Attach(), the interrupt then processes the vrings */
+static struct virtio_device *mbox_vdev = NULL;
 uint32_t vring0_id = 0; /* used for channel 1 */
 uint32_t vring1_id = 1; /* used for channel 2 */
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN PFP */
-
+static int MAILBOX_Process(struct virtio_device *vdev);
+static void MAILBOX_Schedule(void);
 /* USER CODE END PFP */
 
 void IPCC_channel1_callback(IPCC_HandleTypeDef * hipcc, uint32_t ChannelIndex, IPCC_CHANNELDirTypeDef ChannelDir);
@@ -91,7 +97,9 @@ int MAILBOX_Init(void)
   }
 
   /* USER CODE BEGIN POST_MAILBOX_INIT */
-
+#if MBOX_PROCESS_MODE == MBOX_PROCESS_PENDSV
+  HAL_NVIC_SetPriority(PendSV_IRQn, (1UL << __NVIC_PRIO_BITS) - 1UL, 0);
+#endif
   /* USER CODE END  POST_MAILBOX_INIT */
   return 0;
 }
@@ -107,33 +115,14 @@ int MAILBOX_Poll(struct virtio_device *vdev)
   int ret = -1;
 
    /* USER CODE BEGIN PRE_MAILBOX_POLL */
-
+#if MBOX_PROCESS_MODE != MBOX_PROCESS_POLL
+  /* Once attached, only the interrupt processes the vrings */
+  if (mbox_vdev != NULL)
+    return -1;
+#endif
    /* USER CODE END  PRE_MAILBOX_POLL */
 
-   if (msg_received_ch1 == MBOX_BUF_FREE) {
-
-   /* USER CODE BEGIN MSG_CHANNEL1 */
-
-   /* USER CODE END  MSG_CHANNEL1 */
-
-    OPENAMP_log_dbg("Running virt0 (ch_1 buf free)\r\n");
-    rproc_virtio_notified(vdev, VRING0_ID);
-    ret = 0;
-    msg_received_ch1 = MBOX_NO_MSG;
-  }
-
-  if (msg_received_ch2 == MBOX_NEW_MSG) {
-
-   /* USER CODE BEGIN MSG_CHANNEL2 */
-
-   /* USER CODE END  MSG_CHANNEL2 */
-
-    OPENAMP_log_dbg("Running virt1 (ch_2 new msg)\r\n");
-    rproc_virtio_notified(vdev, VRING1_ID);
-    msg_received_ch2 = MBOX_NO_MSG;
-
-    ret = 0;
-  }
+  ret = MAILBOX_Process(vdev);
 
   /* USER CODE BEGIN POST_MAILBOX_POLL */
 
@@ -190,7 +179,131 @@ int MAILBOX_Notify(void *priv, uint32_t id)
 
 /* Private function  ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
+/**
+  * @brief  Hands the vrings over to the context of MBOX_PROCESS_MODE, call it
+  *         after the rpmsg device is initialized. Polling only keeps vdev.
+  * @param  virtio device
+  * @retval None
+  */
+void MAILBOX_Attach(struct virtio_device *vdev)
+{
+  mbox_vdev = vdev;
+  /* Notifications of the initialization are still pending */
+  MAILBOX_Schedule();
+}
+
+/**
+  * @brief  Masks the context which processes the vrings, the main loop holds
+  *         it while it touches RX buffers or data of the RPMsg callbacks.
+  *         Nests, no effect with MBOX_PROCESS_POLL.
+  * @param  None
+  * @retval Mask to pass to MAILBOX_Unlock()
+  */
+uint32_t MAILBOX_Lock(void)
+{
+#if MBOX_PROCESS_MODE == MBOX_PROCESS_POLL
+  return 0;
+#else
+  uint32_t mask = __get_BASEPRI();
+
+#if MBOX_PROCESS_MODE == MBOX_PROCESS_PENDSV
+  __set_BASEPRI_MAX(NVIC_GetPriority(PendSV_IRQn) << (8U - __NVIC_PRIO_BITS));
+#else
+  __set_BASEPRI_MAX(NVIC_GetPriority(IPCC_RX1_IRQn) << (8U - __NVIC_PRIO_BITS));
+#endif
+  return mask;
+#endif
+}
+
+/**
+  * @brief  Ends a MAILBOX_Lock() section.
+  * @param  Mask returned by MAILBOX_Lock()
+  * @retval None
+  */
+void MAILBOX_Unlock(uint32_t Mask)
+{
+#if MBOX_PROCESS_MODE == MBOX_PROCESS_POLL
+  (void)Mask;
+#else
+  __set_BASEPRI(Mask);
+#endif
+}
 
+/**
+  * @brief  Counters of an IPCC RX channel.
+  * @param  IPCC_CHANNEL_1 or IPCC_CHANNEL_2
+  * @param  counters, read without masking the interrupt
+  * @retval Operation result
+  */
+int MAILBOX_GetStats(uint32_t ChannelIndex, MAILBOX_StatsTypeDef *pStats)
+{
+  if (ChannelIndex == IPCC_CHANNEL_1)
+    *pStats = mbox_stats_ch1;
+  else if (ChannelIndex == IPCC_CHANNEL_2)
+    *pStats = mbox_stats_ch2;
+  else
+    return -1;
+  return 0;
+}
+
+/**
+  * @brief  PendSV processing of MBOX_PROCESS_PENDSV, called by PendSV_Handler().
+  * @param  None
+  * @retval None
+  */
+void MAILBOX_PendSV_Handler(void)
+{
+  if (mbox_vdev != NULL)
+    (void)MAILBOX_Process(mbox_vdev);
+}
+
+/**
+  * @brief  Runs the vrings of the notifications pending since the last run.
+  *         An interrupt during the run sets its bit again and is processed
+  *         by the next one.
+  * @param  virtio device
+  * @retval 0 in case a vring was processed
+  */
+static int MAILBOX_Process(struct virtio_device *vdev)
+{
+  unsigned int pending = atomic_exchange(&mbox_pending, 0U);
+
+  if (pending & MBOX_BUF_FREE) {
+    OPENAMP_log_dbg("Running virt0 (ch_1 buf free)\r\n");
+    mbox_stats_ch1.Processed++;
+    rproc_virtio_notified(vdev, VRING0_ID);
+  }
+
+  if (pending & MBOX_NEW_MSG) {
+    OPENAMP_log_dbg("Running virt1 (ch_2 new msg)\r\n");
+    mbox_stats_ch2.Processed++;
+    rproc_virtio_notified(vdev, VRING1_ID);
+  }
+
+  return pending ? 0 : -1;
+}
+
+/**
+  * @brief  Starts the processing of MBOX_PROCESS_MODE after a notification.
+  * @param  None
+  * @retval None
+  */
+static void MAILBOX_Schedule(void)
+{
+#if MBOX_PROCESS_MODE == MBOX_PROCESS_PENDSV
+  if (mbox_vdev != NULL)
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+#elif MBOX_PROCESS_MODE == MBOX_PROCESS_IRQ
+  uint32_t mask;
+
+  if (mbox_vdev != NULL) {
+    /* MAILBOX_Attach() may run the pending notifications in thread mode */
+    mask = MAILBOX_Lock();
+    (void)MAILBOX_Process(mbox_vdev);
+    MAILBOX_Unlock(mask);
+  }
+#endif
+}
 /* USER CODE END 0 */
 /* Callback from IPCC Interrupt Handler: Master Processor informs that there are some free buffers */
 void IPCC_channel1_callback(IPCC_HandleTypeDef * hipcc,
@@ -198,20 +311,26 @@ void IPCC_channel1_callback(IPCC_HandleTypeDef * hipcc,
 {
 
   /* USER CODE BEGIN PRE_MAILBOX_CHANNEL1_CALLBACK */
-
+  (void)ChannelDir;
   /* USER CODE END  PRE_MAILBOX_CHANNEL1_CALLBACK */
 
-  if (msg_received_ch1 != MBOX_NO_MSG)
-    OPENAMP_log_dbg("IPCC_channel1_callback: previous IRQ not treated (status = %d)\r\n", msg_received_ch1);
-
-  msg_received_ch1 = MBOX_BUF_FREE;
+  if (atomic_fetch_or(&mbox_pending, MBOX_BUF_FREE) & MBOX_BUF_FREE)
+  {
+    OPENAMP_log_dbg("IPCC_channel1_callback: previous IRQ not treated\r\n");
+  }
+  mbox_stats_ch1.Notified++;
 
   /* Inform A7 that we have received the 'buff free' msg */
   OPENAMP_log_dbg("Ack 'buff free' message on ch1\r\n");
   HAL_IPCC_NotifyCPU(hipcc, ChannelIndex, IPCC_CHANNEL_DIR_RX);
 
   /* USER CODE BEGIN POST_MAILBOX_CHANNEL1_CALLBACK */
-
+  OPENAMP_notify_tx_free();
+#if defined(CAN_BRIDGE_FREERTOS)
+  /* TX buffers returned, a message waiting for one can be sent */
+  vCanBridge_NotifyFromISR(m_u32CANBRIDGE_EVENT_MAILBOX);
+#endif
+  MAILBOX_Schedule();
   /* USER CODE END  POST_MAILBOX_CHANNEL1_CALLBACK */
 }
 
@@ -221,19 +340,23 @@ void IPCC_channel2_callback(IPCC_HandleTypeDef * hipcc,
 {
 
   /* USER CODE BEGIN PRE_MAILBOX_CHANNEL2_CALLBACK */
-
+  (void)ChannelDir;
   /* USER CODE END  PRE_MAILBOX_CHANNEL2_CALLBACK */
 
-  if (msg_received_ch2 != MBOX_NO_MSG)
-    OPENAMP_log_dbg("IPCC_channel2_callback: previous IRQ not treated (status = %d)\r\n", msg_received_ch2);
-
-  msg_received_ch2 = MBOX_NEW_MSG;
+  if (atomic_fetch_or(&mbox_pending, MBOX_NEW_MSG) & MBOX_NEW_MSG)
+  {
+    OPENAMP_log_dbg("IPCC_channel2_callback: previous IRQ not treated\r\n");
+  }
+  mbox_stats_ch2.Notified++;
 
   /* Inform A7 that we have received the new msg */
   OPENAMP_log_dbg("Ack new message on ch2\r\n");
   HAL_IPCC_NotifyCPU(hipcc, ChannelIndex, IPCC_CHANNEL_DIR_RX);
 
   /* USER CODE BEGIN POST_MAILBOX_CHANNEL2_CALLBACK */
-
+#if defined(CAN_BRIDGE_FREERTOS)
+  vCanBridge_NotifyFromISR(m_u32CANBRIDGE_EVENT_MAILBOX);
+#endif
+  MAILBOX_Schedule();
   /* USER CODE END  POST_MAILBOX_CHANNEL2_CALLBACK */
 }
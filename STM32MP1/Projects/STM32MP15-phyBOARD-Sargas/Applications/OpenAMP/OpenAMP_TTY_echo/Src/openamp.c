@@ -25,7 +25,12 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-
+#include "stm32mp1xx_hal.h"
+#include "metal/semaphore.h"
+#if defined(CAN_BRIDGE_FREERTOS)
+#include "FreeRTOS.h"
+#include "task.h"
+#endif
 /* USER CODE END Includes */
 
 /* Private define ------------------------------------------------------------*/
@@ -42,7 +47,8 @@
 
 /* Private variables ---------------------------------------------------------*/
 /* USER CODE BEGIN PV */
-
+/* Posted by the IPCC 'buff free' channel, wakes a sender waiting for a TX buffer */
+static struct metal_sem tx_free_sem;
 /* USER CODE END PV */
 
 static struct metal_io_region *shm_io;
@@ -67,7 +73,56 @@ struct metal_device shm_device = {
 
 /* Private functions ---------------------------------------------------------*/
 /* USER CODE BEGIN PFP */
+/* Clock of the metal_sem_wait() timeout, the generic libmetal one is 0. It
+ * ticks every ms, METAL_TIMESTAMP_RESOLUTION_NS of the project rounds the
+ * timeout up to it */
+unsigned long long metal_get_timestamp(void)
+{
+  return (unsigned long long)HAL_GetTick() * 1000000ULL;
+}
+
+/* Idle of metal_sem_wait() while the semaphore is 0, the generic libmetal one
+ * returns at once and the waiter spins. Called with the interrupts disabled,
+ * a pending interrupt still ends __WFI(), at the latest the next SysTick */
+void metal_generic_default_poll(void)
+{
+#if defined(CAN_BRIDGE_FREERTOS)
+  /* the other tasks run, PendSV is taken when the interrupts are enabled */
+  taskYIELD();
+#else
+  __WFI();
+#endif
+}
+
+void OPENAMP_notify_tx_free(void)
+{
+  metal_sem_post(&tx_free_sem);
+}
 
+/* Checks that the vrings placed by the master and their buffers, of the sizes
+ * of the resource table config space, fit the OpenAMP shared memory */
+static int OPENAMP_check_shm_layout(void)
+{
+  struct fw_rsc_vdev_vring *vring[VRING_COUNT] = { &rsc_table->vring0,
+                                                   &rsc_table->vring1 };
+  uint32_t buf_size[VRING_COUNT] = { rsc_table->config.h2r_buf_size,
+                                     rsc_table->config.r2h_buf_size };
+  size_t used = 0;
+  size_t size;
+  int i;
+
+  for (i = 0; i < VRING_COUNT; i++)
+  {
+    size = vring_size(vring[i]->num, vring[i]->align);
+    if (vring[i]->da < SHM_START_ADDRESS ||
+        vring[i]->da + size > SHM_START_ADDRESS + SHM_SIZE)
+    {
+      return -1;
+    }
+    used += size + (size_t)vring[i]->num * buf_size[i];
+  }
+  return used <= SHM_SIZE ? 0 : -1;
+}
 /* USER CODE END PFP */
 
 static int OPENAMP_shmem_init(int RPMsgRole)
@@ -106,7 +161,9 @@ static int OPENAMP_shmem_init(int RPMsgRole)
   }
 
   /* USER CODE BEGIN POST_SHM_IO_INIT */
-
+  /* Copy the RPMsg buffers in word bursts, the vring index updates are
+   * fenced on their own so acquire/release is enough for the payload. */
+  shm_io->mem_flags |= METAL_IO_BLOCK_BURST | METAL_IO_BLOCK_ACQ_REL;
   /* USER CODE END POST_SHM_IO_INIT */
 
   /* Initialize resources table variables */
@@ -174,7 +231,7 @@ int MX_OPENAMP_Init(int RPMsgRole, rpmsg_ns_bind_cb ns_bind_cb)
   /* USER CODE END POST_VIRTIO_INIT */
   vring_rsc = &rsc_table->vring0;
   status = rproc_virtio_init_vring(vdev, 0, vring_rsc->notifyid,
-                                   (void *)vring_rsc->da, shm_io,
+                                   (void *)(uintptr_t)vring_rsc->da, shm_io,
                                    vring_rsc->num, vring_rsc->align);
   if (status != 0)
   {
@@ -186,7 +243,7 @@ int MX_OPENAMP_Init(int RPMsgRole, rpmsg_ns_bind_cb ns_bind_cb)
   /* USER CODE END POST_VRING0_INIT */
   vring_rsc = &rsc_table->vring1;
   status = rproc_virtio_init_vring(vdev, 1, vring_rsc->notifyid,
-                                   (void *)vring_rsc->da, shm_io,
+                                   (void *)(uintptr_t)vring_rsc->da, shm_io,
                                    vring_rsc->num, vring_rsc->align);
   if (status != 0)
   {
@@ -194,7 +251,12 @@ int MX_OPENAMP_Init(int RPMsgRole, rpmsg_ns_bind_cb ns_bind_cb)
   }
 
   /* USER CODE BEGIN  POST_VRING1_INIT */
-
+  status = OPENAMP_check_shm_layout();
+  if (status != 0)
+  {
+    OPENAMP_log_err("vrings and buffers do not fit the shared memory\r\n");
+    return status;
+  }
   /* USER CODE END POST_VRING1_INIT */
 
   rpmsg_virtio_init_shm_pool(&shpool, (void *)VRING_BUFF_ADDRESS,
@@ -202,7 +264,13 @@ int MX_OPENAMP_Init(int RPMsgRole, rpmsg_ns_bind_cb ns_bind_cb)
   rpmsg_init_vdev(&rvdev, vdev, ns_bind_cb, shm_io, &shpool);
 
   /* USER CODE BEGIN POST_RPMSG_INIT */
-
+  metal_sem_init(&tx_free_sem, 0);
+  rpmsg_virtio_set_tx_free_sem(&rvdev, &tx_free_sem);
+  /* The main loop, or the rpmsg task with CAN_BRIDGE_FREERTOS, sends. The
+   * receive virtqueue belongs to the context of MBOX_PROCESS_MODE, which
+   * the main loop masks while it releases RX buffers. */
+  rpmsg_virtio_set_lockless(&rvdev, 1);
+  MAILBOX_Attach(vdev);
   /* USER CODE END POST_RPMSG_INIT */
 
   return 0;
@@ -212,7 +280,8 @@ void OPENAMP_DeInit()
 {
 
   /* USER CODE BEGIN PRE_OPENAMP_DEINIT */
-
+  rpmsg_virtio_set_tx_free_sem(&rvdev, NULL);
+  metal_sem_deinit(&tx_free_sem);
   /* USER CODE END PRE_OPENAMP_DEINIT */
 
   rpmsg_deinit_vdev(&rvdev);
@@ -230,14 +299,15 @@ int OPENAMP_create_endpoint(struct rpmsg_endpoint *ept, const char *name,
 {
   int ret = 0;
   /* USER CODE BEGIN PRE_EP_CREATE */
-
+  /* the name service of the RX context takes the device lock too */
+  uint32_t mask = MAILBOX_Lock();
   /* USER CODE END PRE_EP_CREATE */
 
   ret = rpmsg_create_ept(ept, &rvdev.rdev, name, RPMSG_ADDR_ANY, dest, cb,
 		          unbind_cb);
 
   /* USER CODE BEGIN POST_EP_CREATE */
-
+  MAILBOX_Unlock(mask);
   /* USER CODE END POST_EP_CREATE */
   return ret;
 }
@@ -73,6 +73,11 @@
 #endif
 
 #define RPMSG_IPU_C0_FEATURES       1
+/* Name service and vring event index, a core only raises the IPCC when the
+ * peer has drained the vring and waits for more. An OpenAMP master also takes
+ * the buffer sizes of the config space, Linux ignores them. */
+#define VDEV_FEATURES               (RPMSG_IPU_C0_FEATURES | VIRTIO_RING_F_EVENT_IDX | \
+                                     (1 << VIRTIO_RPMSG_F_BUFSZ))
 #define VRING_COUNT         		2
 
 /* VirtIO rpmsg device id */
@@ -111,14 +116,17 @@ __root CONST struct shared_resource_table resource_table @ ".resource_table" = {
 
 	/* Virtio device entry */
 	.vdev= {
-		RSC_VDEV, VIRTIO_ID_RPMSG_, 0, RPMSG_IPU_C0_FEATURES, 0, 0, 0,
-		VRING_COUNT, {0, 0},
+		RSC_VDEV, VIRTIO_ID_RPMSG_, 0, VDEV_FEATURES, 0,
+		sizeof(struct virtio_rpmsg_config), 0, VRING_COUNT, {0, 0},
 	},
 
 	/* Vring rsc entry - part of vdev rsc entry */
 	.vring0 = {VRING_TX_ADDRESS, VRING_ALIGNMENT, VRING_NUM_BUFFS, VRING0_ID, 0},
 	.vring1 = {VRING_RX_ADDRESS, VRING_ALIGNMENT, VRING_NUM_BUFFS, VRING1_ID, 0},
 
+	/* Config space - part of vdev rsc entry */
+	.config = {RPMSG_BUFFER_SIZE, RPMSG_BUFFER_SIZE},
+
 #if defined (__LOG_TRACE_IO_)
 	.cm_trace = {
 		RSC_TRACE,
@@ -157,7 +165,10 @@ void resource_table_init(int RPMsgRole, void **table_ptr, int *length)
 	resource_table.vdev.type = RSC_VDEV;
 	resource_table.vdev.id = VIRTIO_ID_RPMSG_;
 	resource_table.vdev.num_of_vrings=VRING_COUNT;
-	resource_table.vdev.dfeatures = RPMSG_IPU_C0_FEATURES;
+	resource_table.vdev.dfeatures = VDEV_FEATURES;
+	resource_table.vdev.config_len = sizeof(struct virtio_rpmsg_config);
+	resource_table.config.h2r_buf_size = RPMSG_BUFFER_SIZE;
+	resource_table.config.r2h_buf_size = RPMSG_BUFFER_SIZE;
 #else
 
 	/* For the slave application let's wait until the resource_table is correctly initialized */
@@ -0,0 +1,134 @@
+/**
+ ******************************************************************************
+ * @author  Thomas Engler
+ * @brief   Non-blocking output queue for trace lines, drained by an
+ *          interrupt driven transmitter (USART3 DMA).
+ *
+ *          The producer (main loop) calls bTraceQueue_Put(), the transmitter
+ *          calls pu8TraceQueue_StartNext() and vTraceQueue_Done() or
+ *          vTraceQueue_Failed(). Both sides move u32Tail
+ *          (TRACEQUEUE_DROP_OLDEST), so the main loop must lock out the
+ *          transmitter interrupt around its calls.
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2023 Thomas Engler.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Includes ------------------------------------------------------------------*/
+#include "trace_queue.h"
+#include "string.h"
+
+/* Private define ------------------------------------------------------------*/
+#define m_u32TRACEQUEUE_MASK (m_u32TRACEQUEUE_SLOTS - 1u)
+
+/**
+ * @brief  Initializes an empty queue with the given drop policy.
+ * @retval void
+ */
+void vTraceQueue_Init(TraceQueue_Struct_t *pstQueue, TraceQueue_Policy_t ePolicy) {
+    pstQueue->u32Head = 0u;
+    pstQueue->u32Tail = 0u;
+    pstQueue->bBusy = false;
+    pstQueue->ePolicy = ePolicy;
+    memset(&pstQueue->stStats, 0u, sizeof(pstQueue->stStats));
+}
+
+/**
+ * @brief  Copies a line into the queue, never waits for the transmitter.
+ * @retval false in case the new line was dropped.
+ */
+bool bTraceQueue_Put(TraceQueue_Struct_t *pstQueue, const uint8_t au8Line[], uint32_t u32Length) {
+
+    uint32_t u32Head = pstQueue->u32Head;
+    uint32_t u32Level;
+
+    if (u32Length > m_u32TRACEQUEUE_SLOTLENGTH) {
+        pstQueue->stStats.u32DroppedNewest++;
+        return false;
+    }
+
+    if ((u32Head - pstQueue->u32Tail) >= m_u32TRACEQUEUE_SLOTS) {
+        if (pstQueue->ePolicy == TRACEQUEUE_DROP_NEWEST) {
+            pstQueue->stStats.u32DroppedNewest++;
+            return false;
+        }
+        pstQueue->u32Tail++;
+        pstQueue->stStats.u32DroppedOldest++;
+    }
+
+    memcpy(pstQueue->au8Slots[u32Head & m_u32TRACEQUEUE_MASK], au8Line, u32Length);
+    pstQueue->au16Length[u32Head & m_u32TRACEQUEUE_MASK] = (uint16_t)u32Length;
+    pstQueue->u32Head = u32Head + 1u;
+
+    u32Level = pstQueue->u32Head - pstQueue->u32Tail;
+    if (u32Level > pstQueue->stStats.u32HighWater) {
+        pstQueue->stStats.u32HighWater = u32Level;
+    }
+    return true;
+}
+
+/**
+ * @brief  Checks if a line is in transmission.
+ * @retval true between pu8TraceQueue_StartNext() and vTraceQueue_Done().
+ */
+bool bTraceQueue_IsBusy(const TraceQueue_Struct_t *pstQueue) {
+    return pstQueue->bBusy;
+}
+
+/**
+ * @brief  Transmitter side: takes the oldest line out of the queue in case
+ *         the transmitter is idle.
+ * @retval line to transmit, NULL in case the transmitter is busy or the queue is empty.
+ */
+const uint8_t *pu8TraceQueue_StartNext(TraceQueue_Struct_t *pstQueue, uint16_t *pu16Length) {
+
+    uint32_t u32Tail = pstQueue->u32Tail;
+    uint16_t u16Length;
+
+    if ((pstQueue->bBusy == true) || (pstQueue->u32Head == u32Tail)) {
+        return NULL;
+    }
+
+    u16Length = pstQueue->au16Length[u32Tail & m_u32TRACEQUEUE_MASK];
+    memcpy(pstQueue->au8TxBuffer, pstQueue->au8Slots[u32Tail & m_u32TRACEQUEUE_MASK], u16Length);
+    pstQueue->u32Tail = u32Tail + 1u;
+    pstQueue->bBusy = true;
+
+    *pu16Length = u16Length;
+    return pstQueue->au8TxBuffer;
+}
+
+/**
+ * @brief  Transmitter side: the line returned by pu8TraceQueue_StartNext() is sent.
+ * @retval void
+ */
+void vTraceQueue_Done(TraceQueue_Struct_t *pstQueue) {
+    pstQueue->stStats.u32Sent++;
+    pstQueue->bBusy = false;
+}
+
+/**
+ * @brief  Transmitter side: the line returned by pu8TraceQueue_StartNext() is
+ *         lost, its transmission could not be started or ended with an error.
+ * @retval void
+ */
+void vTraceQueue_Failed(TraceQueue_Struct_t *pstQueue) {
+    pstQueue->stStats.u32Failed++;
+    pstQueue->bBusy = false;
+}
+
+/**
+ * @brief  Returns the number of waiting lines.
+ * @retval fill level of the queue
+ */
+uint32_t u32TraceQueue_GetFillLevel(const TraceQueue_Struct_t *pstQueue) {
+    return pstQueue->u32Head - pstQueue->u32Tail;
+}
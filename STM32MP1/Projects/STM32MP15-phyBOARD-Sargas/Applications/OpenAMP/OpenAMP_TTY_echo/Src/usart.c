@@ -21,10 +21,14 @@
 #include "usart.h"
 
 /* USER CODE BEGIN 0 */
+/* lines queued for the USART3 trace mirror */
+TraceQueue_Struct_t stUsart3Queue;
 
+static void vUsart3_MirrorKick(void);
 /* USER CODE END 0 */
 
 UART_HandleTypeDef huart3;
+DMA_HandleTypeDef hdma_usart3_tx;
 
 /* USART3 init function */
 
@@ -66,7 +70,7 @@ void MX_USART3_UART_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN USART3_Init 2 */
-
+  vTraceQueue_Init(&stUsart3Queue, TRACEQUEUE_DROP_OLDEST);
   /* USER CODE END USART3_Init 2 */
 
 }
@@ -115,6 +119,28 @@ void HAL_UART_MspInit(UART_HandleTypeDef* uartHandle)
     GPIO_InitStruct.Alternate = GPIO_AF8_USART3;
     HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
 
+    /* USART3 DMA Init */
+    /* USART3_TX Init */
+    hdma_usart3_tx.Instance = DMA2_Stream1;
+    hdma_usart3_tx.Init.Request = DMA_REQUEST_USART3_TX;
+    hdma_usart3_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_usart3_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_usart3_tx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_usart3_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_usart3_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_usart3_tx.Init.Mode = DMA_NORMAL;
+    hdma_usart3_tx.Init.Priority = DMA_PRIORITY_LOW;
+    hdma_usart3_tx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(&hdma_usart3_tx) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    __HAL_LINKDMA(uartHandle,hdmatx,hdma_usart3_tx);
+
+    /* USART3 interrupt Init */
+    HAL_NVIC_SetPriority(USART3_IRQn, DEFAULT_IRQ_PRIO, 0);
+    HAL_NVIC_EnableIRQ(USART3_IRQn);
   /* USER CODE BEGIN USART3_MspInit 1 */
 
   /* USER CODE END USART3_MspInit 1 */
@@ -138,6 +164,11 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* uartHandle)
     */
     HAL_GPIO_DeInit(GPIOB, GPIO_PIN_10|GPIO_PIN_12);
 
+    /* USART3 DMA DeInit */
+    HAL_DMA_DeInit(uartHandle->hdmatx);
+
+    /* USART3 interrupt Deinit */
+    HAL_NVIC_DisableIRQ(USART3_IRQn);
   /* USER CODE BEGIN USART3_MspDeInit 1 */
 
   /* USER CODE END USART3_MspDeInit 1 */
@@ -145,5 +176,74 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* uartHandle)
 }
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief  Starts the DMA for the next queued line in case USART3 is idle.
+  *         Called from the main loop with interrupts locked and from the
+  *         transmit complete interrupt.
+  * @retval None
+  */
+static void vUsart3_MirrorKick(void)
+{
+  const uint8_t *pu8Line;
+  uint16_t u16Length;
+
+  pu8Line = pu8TraceQueue_StartNext(&stUsart3Queue, &u16Length);
+  if (pu8Line != NULL)
+  {
+    if (HAL_UART_Transmit_DMA(&huart3, (uint8_t *)pu8Line, u16Length) != HAL_OK)
+    {
+      vTraceQueue_Failed(&stUsart3Queue);
+    }
+  }
+}
+
+/**
+  * @brief  Queues a line for the USART3 mirror. Never waits for the UART, a
+  *         full queue drops lines according to the queue policy.
+  * @param  pu8Line line to send, copied into the queue.
+  * @param  u32Length number of bytes.
+  * @retval false in case the line was dropped.
+  */
+bool bUsart3_MirrorWrite(const uint8_t *pu8Line, uint32_t u32Length)
+{
+  uint32_t u32Primask = __get_PRIMASK();
+  bool bQueued;
+
+  __disable_irq();
+  bQueued = bTraceQueue_Put(&stUsart3Queue, pu8Line, u32Length);
+  vUsart3_MirrorKick();
+  __set_PRIMASK(u32Primask);
+
+  return bQueued;
+}
+
+/**
+  * @brief  Tx Transfer completed callback, continues with the next queued line.
+  * @param  huart UART handle.
+  * @retval None
+  */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+  if (huart->Instance == USART3)
+  {
+    vTraceQueue_Done(&stUsart3Queue);
+    vUsart3_MirrorKick();
+  }
+}
 
+/**
+  * @brief  UART error callback, the aborted line is counted as failed and the
+  *         mirror continues with the next one.
+  * @param  huart UART handle.
+  * @retval None
+  */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+  if ((huart->Instance == USART3) && (bTraceQueue_IsBusy(&stUsart3Queue) == true)
+      && (huart->gState == HAL_UART_STATE_READY))
+  {
+    vTraceQueue_Failed(&stUsart3Queue);
+    vUsart3_MirrorKick();
+  }
+}
 /* USER CODE END 1 */